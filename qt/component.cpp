@@ -25,6 +25,8 @@
 #include <QUrl>
 #include <QMap>
 #include <QMultiHash>
+#include <QMutex>
+#include <QMutexLocker>
 #include "chelpers.h"
 #include "icon.h"
 #include "screenshot.h"
@@ -37,6 +39,98 @@
 
 using namespace AppStream;
 
+namespace {
+
+/**
+ * Converted values of frequently read properties. They are attached to the
+ * AsComponent as qdata, so all Component wrappers of it share them, including
+ * the ones ComponentView creates on access. The setters of the wrapper and
+ * setActiveLocale() drop them, changes made through the C API are not noticed.
+ */
+class StringCache
+{
+public:
+    enum Field {
+        FieldId,
+        FieldName,
+        FieldSummary,
+        FieldDescription,
+        FieldDeveloperName,
+        FieldPackageNames,
+        FieldCategories,
+        FieldLast
+    };
+
+    static StringCache *forComponent(AsComponent *cpt)
+    {
+        auto cache = static_cast<StringCache*>(g_object_get_qdata(G_OBJECT(cpt), quark()));
+        if (cache != nullptr)
+            return cache;
+
+        // if another thread attached a cache in the meantime, we use that one
+        cache = new StringCache;
+        if (!g_object_replace_qdata(G_OBJECT(cpt), quark(), nullptr, cache, destroy, nullptr)) {
+            delete cache;
+            cache = static_cast<StringCache*>(g_object_get_qdata(G_OBJECT(cpt), quark()));
+        }
+        return cache;
+    }
+
+    static void clear(AsComponent *cpt)
+    {
+        auto cache = static_cast<StringCache*>(g_object_get_qdata(G_OBJECT(cpt), quark()));
+        if (cache == nullptr)
+            return;
+
+        QMutexLocker locker(&cache->m_mutex);
+        for (int i = 0; i < FieldLast; i++) {
+            cache->m_valid[i] = false;
+            cache->m_strings[i].clear();
+            cache->m_lists[i].clear();
+        }
+    }
+
+    template<typename T>
+    QStringList list(Field field, T value)
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_valid[field]) {
+            m_lists[field] = valueWrap(value);
+            m_valid[field] = true;
+        }
+        return m_lists[field];
+    }
+
+    QString string(Field field, const gchar *cstr)
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_valid[field]) {
+            m_strings[field] = valueWrap(cstr);
+            m_valid[field] = true;
+        }
+        return m_strings[field];
+    }
+
+private:
+    static GQuark quark()
+    {
+        static GQuark quark = g_quark_from_static_string("appstreamqt-string-cache");
+        return quark;
+    }
+
+    static void destroy(gpointer data)
+    {
+        delete static_cast<StringCache*>(data);
+    }
+
+    QMutex m_mutex;
+    bool m_valid[FieldLast] = {};
+    QString m_strings[FieldLast];
+    QStringList m_lists[FieldLast];
+};
+
+}
+
 typedef QHash<Component::Kind, QString> KindMap;
 Q_GLOBAL_STATIC_WITH_ARGS(KindMap, kindMap, ( {
     { Component::KindGeneric, QLatin1String("generic") },
@@ -189,6 +283,7 @@ uint AppStream::Component::valueFlags() const
 void AppStream::Component::setValueFlags(uint flags)
 {
     as_component_set_value_flags(m_cpt, (AsValueFlags) flags);
+    StringCache::clear(m_cpt);
 }
 
 QString AppStream::Component::activeLocale() const
@@ -199,6 +294,7 @@ QString AppStream::Component::activeLocale() const
 void AppStream::Component::setActiveLocale(const QString& locale)
 {
     as_component_set_active_locale(m_cpt, qPrintable(locale));
+    StringCache::clear(m_cpt);
 }
 
 Component::Kind Component::kind() const
@@ -223,12 +319,13 @@ void AppStream::Component::setOrigin(const QString& origin)
 
 QString Component::id() const
 {
-    return valueWrap(as_component_get_id(m_cpt));
+    return StringCache::forComponent(m_cpt)->string(StringCache::FieldId, as_component_get_id(m_cpt));
 }
 
 void Component::setId(const QString& id)
 {
     as_component_set_id(m_cpt, qPrintable(id));
+    StringCache::clear(m_cpt);
 }
 
 QString Component::dataId() const
@@ -243,13 +340,14 @@ void Component::setDataId(const QString& cdid)
 
 QStringList Component::packageNames() const
 {
-    return valueWrap(as_component_get_pkgnames(m_cpt));
+    return StringCache::forComponent(m_cpt)->list(StringCache::FieldPackageNames, as_component_get_pkgnames(m_cpt));
 }
 
 void AppStream::Component::setPackageNames(const QStringList& list)
 {
     char **packageList = stringListToCharArray(list);
     as_component_set_pkgnames(m_cpt, packageList);
+    StringCache::clear(m_cpt);
     g_strfreev(packageList);
 }
 
@@ -265,32 +363,35 @@ void AppStream::Component::setSourcePackageName(const QString& sourcePkg)
 
 QString Component::name() const
 {
-    return valueWrap(as_component_get_name(m_cpt));
+    return StringCache::forComponent(m_cpt)->string(StringCache::FieldName, as_component_get_name(m_cpt));
 }
 
 void Component::setName(const QString& name, const QString& lang)
 {
     as_component_set_name(m_cpt, qPrintable(name), lang.isEmpty()? NULL : qPrintable(lang));
+    StringCache::clear(m_cpt);
 }
 
 QString Component::summary() const
 {
-    return valueWrap(as_component_get_summary(m_cpt));
+    return StringCache::forComponent(m_cpt)->string(StringCache::FieldSummary, as_component_get_summary(m_cpt));
 }
 
 void Component::setSummary(const QString& summary, const QString& lang)
 {
     as_component_set_summary(m_cpt, qPrintable(summary), lang.isEmpty()? NULL : qPrintable(lang));
+    StringCache::clear(m_cpt);
 }
 
 QString Component::description() const
 {
-    return valueWrap(as_component_get_description(m_cpt));
+    return StringCache::forComponent(m_cpt)->string(StringCache::FieldDescription, as_component_get_description(m_cpt));
 }
 
 void Component::setDescription(const QString& description, const QString& lang)
 {
     as_component_set_description(m_cpt, qPrintable(description), lang.isEmpty()? NULL : qPrintable(lang));
+    StringCache::clear(m_cpt);
 }
 
 AppStream::Launchable AppStream::Component::launchable(AppStream::Launchable::Kind kind) const
@@ -338,12 +439,13 @@ void Component::setProjectGroup(const QString& group)
 
 QString Component::developerName() const
 {
-    return valueWrap(as_component_get_developer_name(m_cpt));
+    return StringCache::forComponent(m_cpt)->string(StringCache::FieldDeveloperName, as_component_get_developer_name(m_cpt));
 }
 
 void Component::setDeveloperName(const QString& developerName, const QString& lang)
 {
     as_component_set_developer_name(m_cpt, qPrintable(developerName), lang.isEmpty()? NULL : qPrintable(lang));
+    StringCache::clear(m_cpt);
 }
 
 QStringList Component::compulsoryForDesktops() const
@@ -363,12 +465,13 @@ bool Component::isCompulsoryForDesktop(const QString& desktop) const
 
 QStringList Component::categories() const
 {
-    return valueWrap(as_component_get_categories(m_cpt));
+    return StringCache::forComponent(m_cpt)->list(StringCache::FieldCategories, as_component_get_categories(m_cpt));
 }
 
 void AppStream::Component::addCategory(const QString& category)
 {
     as_component_add_category(m_cpt, qPrintable(category));
+    StringCache::clear(m_cpt);
 }
 
 bool Component::hasCategory(const QString& category) const
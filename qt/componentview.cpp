@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2018 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <appstream.h>
+#include "componentview.h"
+
+using namespace AppStream;
+
+ComponentView::ComponentView()
+    : m_array(g_ptr_array_new())
+{}
+
+ComponentView::ComponentView(_GPtrArray *array)
+    : m_array(g_ptr_array_ref(array))
+{}
+
+ComponentView::ComponentView(const ComponentView& other)
+    : m_array(g_ptr_array_ref(other.m_array))
+{}
+
+ComponentView::~ComponentView()
+{
+    g_ptr_array_unref(m_array);
+}
+
+ComponentView& ComponentView::operator=(const ComponentView& other)
+{
+    if (&other != this) {
+        g_ptr_array_unref(m_array);
+        m_array = g_ptr_array_ref(other.m_array);
+    }
+    return *this;
+}
+
+_GPtrArray *ComponentView::asPtrArray() const
+{
+    return m_array;
+}
+
+int ComponentView::size() const
+{
+    return (int) m_array->len;
+}
+
+bool ComponentView::isEmpty() const
+{
+    return m_array->len == 0;
+}
+
+Component ComponentView::at(int index) const
+{
+    Q_ASSERT(index >= 0 && index < size());
+    return Component(AS_COMPONENT(g_ptr_array_index(m_array, index)));
+}
+
+Component ComponentView::operator[](int index) const
+{
+    return at(index);
+}
+
+ComponentView::const_iterator ComponentView::begin() const
+{
+    return const_iterator(this, 0);
+}
+
+ComponentView::const_iterator ComponentView::end() const
+{
+    return const_iterator(this, size());
+}
+
+QList<Component> ComponentView::toList() const
+{
+    QList<Component> res;
+    res.reserve(size());
+    for (uint i = 0; i < m_array->len; i++)
+        res.append(Component(AS_COMPONENT(g_ptr_array_index(m_array, i))));
+    return res;
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2018 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef APPSTREAMQT_COMPONENTVIEW_H
+#define APPSTREAMQT_COMPONENTVIEW_H
+
+#include <QList>
+#include <iterator>
+#include "appstreamqt_export.h"
+#include "component.h"
+
+struct _GPtrArray;
+
+namespace AppStream {
+
+/**
+ * A read-only view on a list of components returned by the pool.
+ *
+ * The view shares the underlying array with the pool result and only
+ * creates Component wrappers when an element is accessed, so copying it
+ * is cheap regardless of the number of components it holds.
+ */
+class APPSTREAMQT_EXPORT ComponentView {
+    public:
+        class const_iterator {
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef Component value_type;
+                typedef int difference_type;
+                typedef const Component *pointer;
+                typedef Component reference;
+
+                const_iterator(const ComponentView *view, int index)
+                    : m_view(view), m_index(index) {}
+
+                Component operator*() const { return m_view->at(m_index); }
+                const_iterator& operator++() { ++m_index; return *this; }
+                const_iterator operator++(int) { const_iterator it(*this); ++m_index; return it; }
+                bool operator==(const const_iterator& other) const { return m_index == other.m_index; }
+                bool operator!=(const const_iterator& other) const { return m_index != other.m_index; }
+
+            private:
+                const ComponentView *m_view;
+                int m_index;
+        };
+
+        ComponentView();
+        /**
+         * Create a view on an array of AsComponent.
+         * The view takes its own reference on @p array.
+         */
+        ComponentView(_GPtrArray *array);
+        ComponentView(const ComponentView& other);
+        ~ComponentView();
+
+        ComponentView& operator=(const ComponentView& other);
+
+        /**
+         * \returns the internally stored GPtrArray
+         */
+        _GPtrArray *asPtrArray() const;
+
+        int size() const;
+        bool isEmpty() const;
+
+        /**
+         * \returns a wrapper for the component at @p index, which must be valid.
+         */
+        Component at(int index) const;
+        Component operator[](int index) const;
+
+        const_iterator begin() const;
+        const_iterator end() const;
+
+        /**
+         * Convert the view into a list, wrapping every component.
+         */
+        QList<Component> toList() const;
+
+    private:
+        _GPtrArray *m_array;
+};
+}
+
+#endif // APPSTREAMQT_COMPONENTVIEW_H
@@ -23,6 +23,11 @@
 #include <QStringList>
 #include <QUrl>
 #include <QLoggingCategory>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrentRun>
 
 Q_LOGGING_CATEGORY(APPSTREAMQT_POOL, "appstreamqt.pool")
 
@@ -31,17 +36,30 @@ using namespace AppStream;
 class AppStream::PoolPrivate {
     public:
         AsPool *m_pool;
+        QString m_lastError;
+
+        // AsPool is not thread-safe, all access to it has to hold this lock
+        QMutex m_mutex;
+        // runs asynchronous operations one after another
+        QThreadPool m_threadPool;
 
         PoolPrivate()
         {
             m_pool = as_pool_new();
+            m_threadPool.setMaxThreadCount(1);
         }
 
         ~PoolPrivate() {
+            // wait for all queued operations, so their futures finish
+            // and the watchers release their cancellables
+            m_threadPool.waitForDone();
             g_object_unref(m_pool);
         }
 };
 
+/**
+ * Convert a pool result into a list, taking ownership of @cpts.
+ */
 static QList<Component> cptArrayToQList(GPtrArray *cpts)
 {
     QList<Component> res;
@@ -51,9 +69,39 @@ static QList<Component> cptArrayToQList(GPtrArray *cpts)
         Component x(cpt);
         res.append(x);
     }
+    g_ptr_array_unref(cpts);
     return res;
 }
 
+/**
+ * Wrap a pool result into a view, taking ownership of @cpts.
+ */
+static ComponentView cptArrayToView(GPtrArray *cpts)
+{
+    ComponentView view(cpts);
+    g_ptr_array_unref(cpts);
+    return view;
+}
+
+/**
+ * Cancel @cancellable when @future is cancelled. The watcher takes
+ * over the reference on the cancellable and drops it when it is
+ * destroyed, which is never before the operation has finished.
+ */
+template<typename T>
+static void watchCancellation(QObject *parent, const QFuture<T>& future, GCancellable *cancellable)
+{
+    auto watcher = new QFutureWatcher<T>(parent);
+    QObject::connect(watcher, &QFutureWatcherBase::canceled, [cancellable]() {
+        g_cancellable_cancel(cancellable);
+    });
+    QObject::connect(watcher, &QFutureWatcherBase::finished, watcher, &QObject::deleteLater);
+    QObject::connect(watcher, &QObject::destroyed, [cancellable]() {
+        g_object_unref(cancellable);
+    });
+    watcher->setFuture(future);
+}
+
 Pool::Pool(QObject *parent)
     : QObject (parent),
       d(new PoolPrivate())
@@ -69,39 +117,81 @@ bool AppStream::Pool::load()
     return load(nullptr);
 }
 
-bool Pool::load(QString* strerror)
+static bool loadInternal(PoolPrivate *priv, GCancellable *cancellable)
 {
     g_autoptr(GError) error = nullptr;
-    bool ret = as_pool_load (d->m_pool, NULL, &error);
-    if (!ret && error && strerror) {
-        *strerror = QString::fromUtf8(error->message);
+    QMutexLocker locker(&priv->m_mutex);
+
+    bool ret = as_pool_load (priv->m_pool, cancellable, &error);
+    if (!ret && error)
+        priv->m_lastError = QString::fromUtf8(error->message);
+    else
+        priv->m_lastError.clear();
+    return ret;
+}
+
+bool Pool::load(QString* strerror)
+{
+    bool ret = loadInternal(d.data(), nullptr);
+    if (!ret && strerror) {
+        *strerror = lastError();
     }
     return ret;
 }
 
+QFuture<bool> Pool::loadAsync()
+{
+    auto priv = d.data();
+    GCancellable *cancellable = g_cancellable_new();
+
+    auto future = QtConcurrent::run(&d->m_threadPool, [priv, cancellable]() {
+        return loadInternal(priv, cancellable);
+    });
+    watchCancellation(this, future, cancellable);
+
+    return future;
+}
+
+QString Pool::lastError() const
+{
+    QMutexLocker locker(&d->m_mutex);
+    return d->m_lastError;
+}
+
 void Pool::clear()
 {
+    QMutexLocker locker(&d->m_mutex);
     return as_pool_clear (d->m_pool);
 }
 
 bool Pool::addComponent(const AppStream::Component& cpt)
 {
+    QMutexLocker locker(&d->m_mutex);
     // FIXME: We ignore errors for now.
     return as_pool_add_component (d->m_pool, cpt.m_cpt, NULL);
 }
 
 QList<Component> Pool::components() const
 {
+    QMutexLocker locker(&d->m_mutex);
     return cptArrayToQList(as_pool_get_components(d->m_pool));
 }
 
+ComponentView Pool::componentsView() const
+{
+    QMutexLocker locker(&d->m_mutex);
+    return cptArrayToView(as_pool_get_components(d->m_pool));
+}
+
 QList<Component> Pool::componentsById(const QString& cid) const
 {
+    QMutexLocker locker(&d->m_mutex);
     return cptArrayToQList(as_pool_get_components_by_id(d->m_pool, qPrintable(cid)));
 }
 
 QList<Component> Pool::componentsByProvided(Provided::Kind kind, const QString& item) const
 {
+    QMutexLocker locker(&d->m_mutex);
     return cptArrayToQList(as_pool_get_components_by_provided_item(d->m_pool,
                                                                    static_cast<AsProvidedKind>(kind),
                                                                    qPrintable(item)));
@@ -109,9 +199,16 @@ QList<Component> Pool::componentsByProvided(Provided::Kind kind, const QString&
 
 QList<AppStream::Component> Pool::componentsByKind(Component::Kind kind) const
 {
+    QMutexLocker locker(&d->m_mutex);
     return cptArrayToQList(as_pool_get_components_by_kind(d->m_pool, static_cast<AsComponentKind>(kind)));
 }
 
+ComponentView Pool::componentsByKindView(Component::Kind kind) const
+{
+    QMutexLocker locker(&d->m_mutex);
+    return cptArrayToView(as_pool_get_components_by_kind(d->m_pool, static_cast<AsComponentKind>(kind)));
+}
+
 QList<AppStream::Component> Pool::componentsByCategories(const QStringList categories) const
 {
     // FIXME: Todo
@@ -122,6 +219,7 @@ QList<AppStream::Component> Pool::componentsByCategories(const QStringList categ
 
 QList<Component> Pool::componentsByLaunchable(Launchable::Kind kind, const QString& value) const
 {
+    QMutexLocker locker(&d->m_mutex);
     return cptArrayToQList(as_pool_get_components_by_launchable(d->m_pool,
                                                                    static_cast<AsLaunchableKind>(kind),
                                                                    qPrintable(value)));
@@ -129,40 +227,73 @@ QList<Component> Pool::componentsByLaunchable(Launchable::Kind kind, const QStri
 
 QList<AppStream::Component> Pool::search(const QString& term) const
 {
+    QMutexLocker locker(&d->m_mutex);
     return cptArrayToQList(as_pool_search(d->m_pool, qPrintable(term)));
 }
 
+ComponentView Pool::searchView(const QString& term) const
+{
+    QMutexLocker locker(&d->m_mutex);
+    return cptArrayToView(as_pool_search(d->m_pool, qPrintable(term)));
+}
+
+QFuture<QList<AppStream::Component>> Pool::searchAsync(const QString& term) const
+{
+    auto priv = d.data();
+    const QByteArray termData = term.toLocal8Bit();
+    GCancellable *cancellable = g_cancellable_new();
+
+    auto future = QtConcurrent::run(&d->m_threadPool, [priv, termData, cancellable]() {
+        QList<Component> res;
+        if (!g_cancellable_is_cancelled(cancellable)) {
+            QMutexLocker locker(&priv->m_mutex);
+            res = cptArrayToQList(as_pool_search(priv->m_pool, termData.constData()));
+        }
+        return res;
+    });
+    watchCancellation(const_cast<Pool*>(this), future, cancellable);
+
+    return future;
+}
+
 void Pool::clearMetadataLocations()
 {
+    QMutexLocker locker(&d->m_mutex);
     as_pool_clear_metadata_locations(d->m_pool);
 }
 
 void Pool::addMetadataLocation(const QString& directory)
 {
+    QMutexLocker locker(&d->m_mutex);
     as_pool_add_metadata_location (d->m_pool, qPrintable(directory));
 }
 
 void Pool::setLocale(const QString& locale)
 {
+    QMutexLocker locker(&d->m_mutex);
     as_pool_set_locale (d->m_pool, qPrintable(locale));
 }
 
 uint Pool::flags() const
 {
+    QMutexLocker locker(&d->m_mutex);
     return (uint) as_pool_get_flags(d->m_pool);
 }
 
 void Pool::setFlags(uint flags)
 {
+    QMutexLocker locker(&d->m_mutex);
     as_pool_set_flags (d->m_pool, (AsPoolFlags) flags);
 }
 
 uint Pool::cacheFlags() const
 {
+    QMutexLocker locker(&d->m_mutex);
     return (uint) as_pool_get_cache_flags(d->m_pool);
 }
 
 void Pool::setCacheFlags(uint flags)
 {
+    QMutexLocker locker(&d->m_mutex);
     as_pool_set_cache_flags (d->m_pool, (AsCacheFlags) flags);
 }
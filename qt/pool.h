@@ -25,7 +25,9 @@
 #include <QString>
 #include <QList>
 #include <QStringList>
+#include <QFuture>
 #include "component.h"
+#include "componentview.h"
 
 namespace AppStream {
 
@@ -83,6 +85,24 @@ Q_OBJECT
          */
         bool load(QString* error);
 
+        /**
+         * Load the pool on a worker thread.
+         *
+         * Operations on the pool are serialized, so other calls made while
+         * the pool is loading will block until loading has completed.
+         * Cancelling the returned future aborts loading as soon as possible,
+         * and the pool keeps the data it had before loadAsync() was called.
+         *
+         * \return a future holding true on success. Use lastError() to
+         * get the error message in case of failure.
+         */
+        QFuture<bool> loadAsync();
+
+        /**
+         * \return the error message of the last failed load operation.
+         */
+        QString lastError() const;
+
         /**
          * Remove all software component information from the pool.
          */
@@ -95,18 +115,38 @@ Q_OBJECT
 
         QList<AppStream::Component> components() const;
 
+        /**
+         * \return all components in the pool as a view, which only
+         * wraps components when they are accessed.
+         */
+        AppStream::ComponentView componentsView() const;
+
         QList<AppStream::Component> componentsById(const QString& cid) const;
 
         QList<AppStream::Component> componentsByProvided(Provided::Kind kind, const QString& item) const;
 
         QList<AppStream::Component> componentsByKind(Component::Kind kind) const;
 
+        AppStream::ComponentView componentsByKindView(Component::Kind kind) const;
+
         QList<AppStream::Component> componentsByCategories(const QStringList categories) const;
 
         QList<AppStream::Component> componentsByLaunchable(Launchable::Kind kind, const QString& value) const;
 
         QList<AppStream::Component> search(const QString& term) const;
 
+        AppStream::ComponentView searchView(const QString& term) const;
+
+        /**
+         * Search the pool on a worker thread.
+         *
+         * The search is queued after any pending asynchronous load, so it
+         * is safe to call this right after loadAsync().
+         * Cancelling the returned future before the search has started
+         * skips it and yields an empty result.
+         */
+        QFuture<QList<AppStream::Component>> searchAsync(const QString& term) const;
+
         void clearMetadataLocations();
         void addMetadataLocation(const QString& directory);
 
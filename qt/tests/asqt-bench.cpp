@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2018 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QtTest>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QTextStream>
+#include <QDir>
+#include "pool.h"
+
+using namespace AppStream;
+
+/*
+ * Benchmarks for the cost the Qt layer adds on top of libappstream.
+ * The pool is filled with synthetic collection data, the number of
+ * components can be changed with the ASQT_BENCH_COMPONENTS environment
+ * variable.
+ */
+class PoolBenchmark : public QObject {
+    Q_OBJECT
+    private Q_SLOTS:
+        void initTestCase();
+
+        void benchLoad();
+        void benchSearch();
+        void benchComponents();
+        void benchComponentsView();
+        void benchComponentsByKind();
+        void benchComponentGetters();
+
+    private:
+        void setupPool(Pool *pool);
+
+        QTemporaryDir m_dataDir;
+        int m_count = 5000;
+        QScopedPointer<Pool> m_pool;
+};
+
+void PoolBenchmark::initTestCase()
+{
+    bool ok = false;
+    int count = qEnvironmentVariableIntValue("ASQT_BENCH_COMPONENTS", &ok);
+    if (ok && count > 0)
+        m_count = count;
+
+    QVERIFY(m_dataDir.isValid());
+    QVERIFY(QDir(m_dataDir.path()).mkpath(QStringLiteral("xml")));
+
+    QFile file(m_dataDir.filePath(QStringLiteral("xml/bench.xml")));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QTextStream out(&file);
+    out.setCodec("UTF-8");
+    out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<components version=\"0.10\" origin=\"bench\">\n";
+    for (int i = 0; i < m_count; i++) {
+        const bool isApp = (i % 2) == 0;
+        out << "  <component type=\"" << (isApp? "desktop-application" : "console-application") << "\">\n"
+            << "    <id>org.example.Bench" << i << "</id>\n"
+            << "    <name>Bench Component " << i << "</name>\n"
+            << "    <name xml:lang=\"de\">Testkomponente Ä" << i << "</name>\n"
+            << "    <summary>Synthetic component number " << i << " for benchmarking</summary>\n"
+            << "    <description><p>A synthetic component used to measure the Qt bindings, with some "
+            << "more text so the description is not tiny. Ünïcödé included.</p></description>\n"
+            << "    <pkgname>bench-pkg" << i << "</pkgname>\n"
+            << "    <categories><category>Utility</category><category>" << (isApp? "Office" : "Development") << "</category></categories>\n"
+            << "  </component>\n";
+    }
+    out << "</components>\n";
+    out.flush();
+    file.close();
+
+    m_pool.reset(new Pool);
+    setupPool(m_pool.data());
+    QVERIFY(m_pool->load());
+    QCOMPARE(m_pool->components().size(), m_count);
+}
+
+void PoolBenchmark::setupPool(Pool *pool)
+{
+    pool->clearMetadataLocations();
+    pool->addMetadataLocation(m_dataDir.path());
+    pool->setLocale("C");
+
+    auto flags = pool->flags();
+    flags &= ~Pool::FlagReadDesktopFiles;
+    pool->setFlags(flags);
+    pool->setCacheFlags(Pool::CacheFlagNone);
+}
+
+void PoolBenchmark::benchLoad()
+{
+    Pool pool;
+    setupPool(&pool);
+
+    QBENCHMARK {
+        QVERIFY(pool.load());
+    }
+}
+
+void PoolBenchmark::benchSearch()
+{
+    QBENCHMARK {
+        auto res = m_pool->search(QStringLiteral("synthetic"));
+        QCOMPARE(res.size(), m_count);
+    }
+}
+
+void PoolBenchmark::benchComponents()
+{
+    QBENCHMARK {
+        auto res = m_pool->components();
+        QCOMPARE(res.size(), m_count);
+    }
+}
+
+void PoolBenchmark::benchComponentsView()
+{
+    QBENCHMARK {
+        auto res = m_pool->componentsView();
+        QCOMPARE(res.size(), m_count);
+    }
+}
+
+void PoolBenchmark::benchComponentsByKind()
+{
+    QBENCHMARK {
+        auto res = m_pool->componentsByKind(Component::KindDesktopApp);
+        QCOMPARE(res.size(), (m_count + 1) / 2);
+    }
+}
+
+void PoolBenchmark::benchComponentGetters()
+{
+    const auto cpts = m_pool->components();
+
+    // simulates a view repainting all its rows
+    QBENCHMARK {
+        int len = 0;
+        for (const auto &cpt : cpts) {
+            len += cpt.id().size();
+            len += cpt.name().size();
+            len += cpt.summary().size();
+            len += cpt.description().size();
+            len += cpt.packageNames().size();
+            len += cpt.categories().size();
+        }
+        QVERIFY(len > 0);
+    }
+}
+
+QTEST_GUILESS_MAIN(PoolBenchmark)
+
+#include "asqt-bench.moc"
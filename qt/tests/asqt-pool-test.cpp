@@ -27,6 +27,7 @@ class PoolReadTest : public QObject {
     Q_OBJECT
     private Q_SLOTS:
         void testRead01();
+        void testReadAsync();
 };
 
 using namespace AppStream;
@@ -62,7 +63,71 @@ void PoolReadTest::testRead01()
 
     QCOMPARE(cpt.name(), QLatin1String("Neverball"));
 
+    // converted values follow changes made through the wrappers
+    Component cptCopy(cpt.asComponent());
+    QCOMPARE(cptCopy.name(), QLatin1String("Neverball"));
+    cptCopy.setName(QStringLiteral("Neverball Deluxe"));
+    QCOMPARE(cptCopy.name(), QLatin1String("Neverball Deluxe"));
+    // all wrappers of a component share the converted values
+    QCOMPARE(cpt.name(), QLatin1String("Neverball Deluxe"));
+    cptCopy.setName(QStringLiteral("Neverball (de)"), QStringLiteral("de"));
+    QCOMPARE(cptCopy.name(), QLatin1String("Neverball Deluxe"));
+    cptCopy.setActiveLocale(QStringLiteral("de"));
+    QCOMPARE(cptCopy.name(), QLatin1String("Neverball (de)"));
+    cptCopy.setActiveLocale(QStringLiteral("C"));
+    cptCopy.setName(QStringLiteral("Neverball"));
+    QCOMPARE(cptCopy.name(), QLatin1String("Neverball"));
+
+    // views share the pool result and wrap components on access
+    auto view = pool->componentsView();
+    QCOMPARE(view.size(), 19);
+    int count = 0;
+    for (const auto &c : view) {
+        QVERIFY(!c.id().isEmpty());
+        count++;
+    }
+    QCOMPARE(count, 19);
+    QCOMPARE(view.toList().size(), 19);
+
+    auto searchView = pool->searchView("kig");
+    QCOMPARE(searchView.size(), 1);
+    QCOMPARE(searchView[0].packageNames(), QStringList() << QLatin1String("kig"));
+
     delete pool;
+
+    // the view keeps its data alive on its own
+    QCOMPARE(searchView.at(0).packageNames(), QStringList() << QLatin1String("kig"));
+}
+
+void PoolReadTest::testReadAsync()
+{
+    Pool pool;
+
+    pool.clearMetadataLocations();
+    pool.addMetadataLocation(AS_SAMPLE_DATA_PATH);
+    pool.setLocale("C");
+
+    auto flags = pool.flags();
+    flags &= ~Pool::FlagReadDesktopFiles;
+    pool.setFlags(flags);
+    pool.setCacheFlags(Pool::CacheFlagNone);
+
+    // the search is queued behind the load, so it sees the loaded data
+    auto loadFuture = pool.loadAsync();
+    auto searchFuture = pool.searchAsync("kig");
+
+    loadFuture.waitForFinished();
+    QVERIFY(loadFuture.result());
+    QVERIFY(pool.lastError().isEmpty());
+
+    searchFuture.waitForFinished();
+    auto cpts = searchFuture.result();
+    QCOMPARE(cpts.size(), 1);
+    QCOMPARE(cpts[0].packageNames(), QStringList() << QLatin1String("kig"));
+
+    // synchronous calls are safe while asynchronous work is pending
+    pool.loadAsync();
+    QCOMPARE(pool.componentsById("org.neverball.Neverball").size(), 1);
 }
 
 QTEST_MAIN(PoolReadTest)
@@ -22,6 +22,7 @@
 #define __AS_COMPONENT_PRIVATE_H
 
 #include "as-component.h"
+#include "as-pool.h"
 #include "as-settings-private.h"
 #include "as-tag.h"
 #include "as-xml.h"
@@ -81,6 +82,7 @@ void			 as_component_set_architecture (AsComponent *cpt,
 							const gchar *arch);
 
 void			 as_component_create_token_cache (AsComponent *cpt);
+AS_INTERNAL_VISIBLE
 GHashTable		*as_component_get_token_cache_table (AsComponent *cpt);
 void			 as_component_set_token_cache_valid (AsComponent *cpt,
 							     gboolean valid);
@@ -96,12 +98,17 @@ AsComponentScope	as_component_get_scope (AsComponent *cpt);
 void			as_component_set_scope (AsComponent *cpt,
 						AsComponentScope scope);
 
+void			as_component_remove_addon (AsComponent *cpt,
+							AsComponent *addon);
+
 AsOriginKind		as_component_get_origin_kind (AsComponent *cpt);
 void			as_component_set_origin_kind (AsComponent *cpt,
 							AsOriginKind okind);
 
 gboolean		as_component_merge (AsComponent *cpt,
 					    AsComponent *source);
+AS_INTERNAL_VISIBLE
+AsComponent		*as_component_clone (AsComponent *cpt);
 void			as_component_merge_with_mode (AsComponent *cpt,
 							AsComponent *source,
 							AsMergeKind merge_kind);
@@ -131,6 +138,15 @@ void			as_component_to_variant (AsComponent *cpt,
 gboolean		as_component_set_from_variant (AsComponent *cpt,
 							GVariant *variant,
 							const gchar *locale);
+gboolean		as_component_set_from_variant_fields (AsComponent *cpt,
+								GVariant *variant,
+								const gchar *locale,
+								AsComponentField fields);
+AS_INTERNAL_VISIBLE
+AsComponentField	as_component_get_deferred_fields (AsComponent *cpt);
+
+void			as_component_count_memory (AsComponent *cpt,
+						   guint64 *usage);
 
 #pragma GCC visibility pop
 G_END_DECLS
@@ -23,6 +23,7 @@
 
 #include <glib.h>
 #include <glib-object.h>
+#include <string.h>
 
 #include "as-utils.h"
 #include "as-utils-private.h"
@@ -105,6 +106,12 @@ typedef struct
 
 	GPtrArray		*icons; /* of AsIcon elements */
 
+	/* icons and screenshots read from a cache are stored in a compact form,
+	 * objects are only created for them once they are requested */
+	GArray			*icons_data; /* of AsIconData */
+	GArray			*screenshots_data; /* of AsScreenshotData */
+	gchar			*screenshots_data_locale;
+
 	gchar			*arch; /* the architecture this data was generated from */
 	gint			priority; /* used internally */
 	AsMergeKind		merge_kind; /* whether and how the component data should be merged */
@@ -118,6 +125,13 @@ typedef struct
 	gboolean		ignored; /* whether we should ignore this component */
 
 	GHashTable		*custom; /* free-form user-defined custom data */
+
+	gchar			*description_plain; /* cached plain-text rendering of the description */
+	gchar			*description_plain_locale;
+
+	GVariant		*deferred_data; /* cache data of fields which were not loaded yet */
+	gchar			*deferred_locale;
+	AsComponentField	deferred_fields;
 } AsComponentPrivate;
 
 typedef enum {
@@ -136,6 +150,8 @@ typedef enum {
 G_DEFINE_TYPE_WITH_PRIVATE (AsComponent, as_component, G_TYPE_OBJECT)
 #define GET_PRIVATE(o) (as_component_get_instance_private (o))
 
+static void as_component_load_deferred (AsComponent *cpt, AsComponentField fields);
+
 enum  {
 	AS_COMPONENT_DUMMY_PROPERTY,
 	AS_COMPONENT_KIND,
@@ -412,6 +428,16 @@ as_component_finalize (GObject* object)
 	g_free (priv->project_group);
 	g_free (priv->active_locale_override);
 	g_free (priv->arch);
+	g_free (priv->description_plain);
+	g_free (priv->description_plain_locale);
+	if (priv->deferred_data != NULL)
+		g_variant_unref (priv->deferred_data);
+	g_free (priv->deferred_locale);
+	if (priv->icons_data != NULL)
+		g_array_unref (priv->icons_data);
+	if (priv->screenshots_data != NULL)
+		g_array_unref (priv->screenshots_data);
+	g_free (priv->screenshots_data_locale);
 
 	g_hash_table_unref (priv->name);
 	g_hash_table_unref (priv->summary);
@@ -535,6 +561,60 @@ as_component_to_string (AsComponent *cpt)
 	return res;
 }
 
+/**
+ * as_component_ensure_screenshots:
+ *
+ * Create the #AsScreenshot objects for screenshots which are
+ * still stored in their compact form.
+ */
+static void
+as_component_ensure_screenshots (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	guint i;
+
+	if (priv->screenshots_data == NULL)
+		return;
+
+	for (i = 0; i < priv->screenshots_data->len; i++) {
+		AsScreenshotData *data = &g_array_index (priv->screenshots_data, AsScreenshotData, i);
+		g_ptr_array_add (priv->screenshots,
+				 as_screenshot_new_from_data (data, priv->screenshots_data_locale));
+	}
+	g_clear_pointer (&priv->screenshots_data, g_array_unref);
+	g_clear_pointer (&priv->screenshots_data_locale, g_free);
+}
+
+/**
+ * as_component_take_screenshot_data:
+ *
+ * Add a screenshot in its compact form, taking over the contents of @data.
+ */
+static void
+as_component_take_screenshot_data (AsComponent *cpt, AsScreenshotData *data, const gchar *locale)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+
+	/* keep the order of screenshots we already created objects for */
+	if (priv->screenshots->len > 0) {
+		g_ptr_array_add (priv->screenshots, as_screenshot_new_from_data (data, locale));
+		as_screenshot_data_clear (data);
+		return;
+	}
+
+	if (priv->screenshots_data == NULL) {
+		priv->screenshots_data = g_array_new (FALSE, FALSE, sizeof (AsScreenshotData));
+		g_array_set_clear_func (priv->screenshots_data, (GDestroyNotify) as_screenshot_data_clear);
+	}
+	if (g_strcmp0 (priv->screenshots_data_locale, locale) != 0) {
+		/* all screenshots of a component are read from the same cache */
+		g_free (priv->screenshots_data_locale);
+		priv->screenshots_data_locale = g_strdup (locale);
+	}
+	g_array_append_val (priv->screenshots_data, *data);
+	memset (data, 0, sizeof (AsScreenshotData));
+}
+
 /**
  * as_component_add_screenshot:
  * @cpt: a #AsComponent instance.
@@ -564,6 +644,7 @@ GPtrArray*
 as_component_get_releases (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_RELEASES);
 	return priv->releases;
 }
 
@@ -698,6 +779,28 @@ as_component_add_addon (AsComponent* cpt, AsComponent *addon)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 	g_ptr_array_add (priv->addons, g_object_ref (addon));
+
+	/* the addon's search tokens are added to ours */
+	as_component_set_token_cache_valid (cpt, FALSE);
+}
+
+/**
+ * as_component_remove_addon:
+ * @cpt: a #AsComponent instance.
+ * @addon: The #AsComponent to remove.
+ *
+ * Drop one reference to @addon from the addons of this component.
+ */
+void
+as_component_remove_addon (AsComponent *cpt, AsComponent *addon)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	if (!g_ptr_array_remove (priv->addons, addon))
+		return;
+
+	/* drop the tokens this addon has contributed */
+	g_hash_table_remove_all (priv->token_cache);
+	as_component_set_token_cache_valid (cpt, FALSE);
 }
 
 /**
@@ -1231,6 +1334,19 @@ as_component_set_summary (AsComponent *cpt, const gchar* value, const gchar *loc
 	g_object_notify ((GObject *) cpt, "summary");
 }
 
+/**
+ * as_component_description_changed:
+ *
+ * Drop the cached plain-text rendering of the description.
+ */
+static void
+as_component_description_changed (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	g_clear_pointer (&priv->description_plain, g_free);
+	g_clear_pointer (&priv->description_plain_locale, g_free);
+}
+
 /**
  * as_component_get_description:
  * @cpt: a #AsComponent instance.
@@ -1243,6 +1359,7 @@ const gchar*
 as_component_get_description (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_DESCRIPTION);
 	return as_component_localized_get (cpt, priv->description);
 }
 
@@ -1259,10 +1376,87 @@ as_component_set_description (AsComponent *cpt, const gchar* value, const gchar
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_DESCRIPTION);
+
 	as_component_localized_set (cpt, priv->description, value, locale);
+	as_component_description_changed (cpt);
 	g_object_notify ((GObject *) cpt, "description");
 }
 
+/**
+ * as_component_get_description_plain:
+ * @cpt: a #AsComponent instance.
+ *
+ * Get the localized long description of this component, converted
+ * to plain text. The text is converted on the first call and kept until
+ * the description or the active locale changes, so this is a lot cheaper
+ * than calling as_markup_convert_simple() on the description every time.
+ *
+ * Returns: the description as plain text.
+ *
+ * Since: 0.12.3
+ */
+const gchar*
+as_component_get_description_plain (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	const gchar *locale;
+
+	/* the locale is set for failed conversions too, so we don't retry them */
+	locale = as_component_get_active_locale (cpt);
+	if ((priv->description_plain_locale != NULL) && (g_strcmp0 (priv->description_plain_locale, locale) == 0))
+		return priv->description_plain;
+	as_component_description_changed (cpt);
+
+	priv->description_plain = as_markup_convert_simple (as_component_get_description (cpt), NULL);
+	priv->description_plain_locale = g_strdup (locale);
+
+	return priv->description_plain;
+}
+
+/**
+ * as_component_get_description_snippet:
+ * @cpt: a #AsComponent instance.
+ * @max_len: the maximum length of the snippet, in characters.
+ *
+ * Get the first paragraph of the plain-text description of this component,
+ * shortened to at most @max_len characters at a word boundary.
+ * This is useful for tooltips and search results.
+ *
+ * Returns: (transfer full) (nullable): the description snippet.
+ *
+ * Since: 0.12.3
+ */
+gchar*
+as_component_get_description_snippet (AsComponent *cpt, guint max_len)
+{
+	const gchar *plain;
+	const gchar *end;
+	g_autofree gchar *snippet = NULL;
+	gchar *cut;
+
+	plain = as_component_get_description_plain (cpt);
+	if (plain == NULL)
+		return NULL;
+
+	end = strchr (plain, '\n');
+	if (end == NULL)
+		end = plain + strlen (plain);
+	if ((guint) g_utf8_strlen (plain, end - plain) <= max_len)
+		return g_strndup (plain, end - plain);
+	if (max_len == 0)
+		return g_strdup ("");
+
+	/* leave room for the ellipsis and cut at the last space */
+	cut = g_utf8_offset_to_pointer (plain, max_len - 1);
+	snippet = g_strndup (plain, cut - plain);
+	cut = strrchr (snippet, ' ');
+	if (cut != NULL && cut != snippet)
+		*cut = '\0';
+
+	return g_strconcat (g_strchomp (snippet), "…", NULL);
+}
+
 /**
  * as_component_get_keywords:
  * @cpt: a #AsComponent instance.
@@ -1308,6 +1502,49 @@ as_component_set_keywords (AsComponent *cpt, gchar **value, const gchar *locale)
 	g_object_notify ((GObject *) cpt, "keywords");
 }
 
+/**
+ * as_component_ensure_icons:
+ *
+ * Create the #AsIcon objects for icons which are still stored in their compact form.
+ */
+static void
+as_component_ensure_icons (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	guint i;
+
+	if (priv->icons_data == NULL)
+		return;
+
+	for (i = 0; i < priv->icons_data->len; i++)
+		g_ptr_array_add (priv->icons, as_icon_new_from_data (&g_array_index (priv->icons_data, AsIconData, i)));
+	g_clear_pointer (&priv->icons_data, g_array_unref);
+}
+
+/**
+ * as_component_take_icon_data:
+ *
+ * Add an icon in its compact form, taking over the contents of @data.
+ */
+static void
+as_component_take_icon_data (AsComponent *cpt, AsIconData *data)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+
+	/* keep the order of icons we already created objects for */
+	if (priv->icons->len > 0) {
+		g_ptr_array_add (priv->icons, as_icon_new_from_data (data));
+		return;
+	}
+
+	if (priv->icons_data == NULL) {
+		priv->icons_data = g_array_new (FALSE, FALSE, sizeof (AsIconData));
+		g_array_set_clear_func (priv->icons_data, (GDestroyNotify) as_icon_data_clear);
+	}
+	g_array_append_val (priv->icons_data, *data);
+	as_icon_data_init (data);
+}
+
 /**
  * as_component_get_icons:
  * @cpt: an #AsComponent instance
@@ -1318,6 +1555,7 @@ GPtrArray*
 as_component_get_icons (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_ensure_icons (cpt);
 	return priv->icons;
 }
 
@@ -1344,6 +1582,7 @@ as_component_get_icon_by_size (AsComponent *cpt, guint width, guint height)
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 	guint i;
 
+	as_component_ensure_icons (cpt);
 	for (i = 0; i < priv->icons->len; i++) {
 		AsIcon *icon = AS_ICON (g_ptr_array_index (priv->icons, i));
 		/* ignore scaled icons */
@@ -1368,6 +1607,7 @@ void
 as_component_add_icon (AsComponent *cpt, AsIcon *icon)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_ensure_icons (cpt);
 	g_ptr_array_add (priv->icons, g_object_ref (icon));
 }
 
@@ -1556,6 +1796,8 @@ GPtrArray*
 as_component_get_screenshots (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_SCREENSHOTS);
+	as_component_ensure_screenshots (cpt);
 	return priv->screenshots;
 }
 
@@ -1723,6 +1965,8 @@ void
 as_component_add_suggested (AsComponent *cpt, AsSuggested *suggested)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_SUGGESTIONS);
+
 	g_ptr_array_add (priv->suggestions,
 			 g_object_ref (suggested));
 }
@@ -1739,6 +1983,7 @@ GPtrArray*
 as_component_get_suggested (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_SUGGESTIONS);
 	return priv->suggestions;
 }
 
@@ -1855,6 +2100,8 @@ as_component_add_language (AsComponent *cpt, const gchar *locale, gint percentag
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_LANGUAGES);
+
 	if (locale == NULL)
 		locale = "C";
 	g_hash_table_insert (priv->languages,
@@ -1880,6 +2127,8 @@ as_component_get_language (AsComponent *cpt, const gchar *locale)
 	gpointer value = NULL;
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_LANGUAGES);
+
 	if (locale == NULL)
 		locale = "C";
 	ret = g_hash_table_lookup_extended (priv->languages,
@@ -1903,6 +2152,7 @@ GList*
 as_component_get_languages (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_LANGUAGES);
 	return g_hash_table_get_keys (priv->languages);
 }
 
@@ -1920,6 +2170,7 @@ GHashTable*
 as_component_get_languages_table (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_LANGUAGES);
 	return priv->languages;
 }
 
@@ -2075,6 +2326,7 @@ as_component_refine_icons (AsComponent *cpt, GPtrArray *icon_paths)
 	g_autoptr(GPtrArray) icons = NULL;
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 
+	as_component_ensure_icons (cpt);
 	if (priv->icons->len == 0)
 		return;
 
@@ -2255,7 +2507,7 @@ as_component_complete (AsComponent *cpt, gchar *scr_service_url, GPtrArray *icon
 		return;
 
 	/* we want screenshot data from 3rd-party screenshot servers, if the component doesn't have screenshots defined already */
-	if ((priv->screenshots->len == 0) && (as_component_has_package (cpt))) {
+	if ((as_component_get_screenshots (cpt)->len == 0) && (as_component_has_package (cpt))) {
 		gchar *url;
 		AsImage *img;
 		g_autoptr(AsScreenshot) sshot = NULL;
@@ -2422,6 +2674,29 @@ as_component_add_tokens (AsComponent *cpt,
 		as_component_add_token (cpt, values_ascii[i], allow_split, match_flag);
 }
 
+/**
+ * as_component_peek_description:
+ *
+ * Get the description of the active locale without loading it,
+ * in case it was not accessed since reading it from the cache.
+ */
+static const gchar*
+as_component_peek_description (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	const gchar *desc = NULL;
+
+	if (!as_flags_contains (priv->deferred_fields, AS_COMPONENT_FIELD_DESCRIPTION) ||
+	    g_strcmp0 (priv->deferred_locale, as_component_get_active_locale (cpt)) != 0)
+		return as_component_get_description (cpt);
+
+	/* the string points into the cache data, which we keep alive */
+	if ((priv->deferred_data == NULL) ||
+	    !g_variant_lookup (priv->deferred_data, "description", "m&s", &desc))
+		return NULL;
+	return desc;
+}
+
 /**
  * as_component_create_token_cache_target:
  */
@@ -2450,7 +2725,7 @@ as_component_create_token_cache_target (AsComponent *cpt, AsComponent *donor)
 		as_component_add_tokens (cpt, tmp, TRUE, AS_TOKEN_MATCH_SUMMARY);
 	}
 
-	tmp = as_component_get_description (cpt);
+	tmp = as_component_peek_description (cpt);
 	if (tmp != NULL) {
 		as_component_add_tokens (cpt, tmp, FALSE, AS_TOKEN_MATCH_DESCRIPTION);
 	}
@@ -2755,6 +3030,7 @@ GHashTable*
 as_component_get_custom (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_CUSTOM);
 	return priv->custom;
 }
 
@@ -2771,6 +3047,7 @@ const gchar*
 as_component_get_custom_value (AsComponent *cpt, const gchar *key)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_CUSTOM);
 	if (key == NULL)
 		return NULL;
 	return g_hash_table_lookup (priv->custom, key);
@@ -2792,6 +3069,7 @@ gboolean
 as_component_insert_custom_value (AsComponent *cpt, const gchar *key, const gchar *value)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_CUSTOM);
 	if (key == NULL)
 		return FALSE;
 	return g_hash_table_insert (priv->custom,
@@ -2813,6 +3091,7 @@ GPtrArray*
 as_component_get_content_ratings (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_CONTENT_RATINGS);
 	return priv->content_ratings;
 }
 
@@ -2833,6 +3112,8 @@ as_component_get_content_rating (AsComponent *cpt, const gchar *kind)
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 	guint i;
 
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_CONTENT_RATINGS);
+
 	for (i = 0; i < priv->content_ratings->len; i++) {
 		AsContentRating *content_rating = AS_CONTENT_RATING (g_ptr_array_index (priv->content_ratings, i));
 		if (g_strcmp0 (as_content_rating_get_kind (content_rating), kind) == 0)
@@ -2854,6 +3135,8 @@ void
 as_component_add_content_rating (AsComponent *cpt, AsContentRating *content_rating)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_CONTENT_RATINGS);
+
 	g_ptr_array_add (priv->content_ratings,
 			 g_object_ref (content_rating));
 }
@@ -2930,6 +3213,7 @@ GPtrArray*
 as_component_get_recommends (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_RELATIONS);
 	return priv->recommends;
 }
 
@@ -2947,6 +3231,7 @@ GPtrArray*
 as_component_get_requires (AsComponent *cpt)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_RELATIONS);
 	return priv->requires;
 }
 
@@ -2966,6 +3251,8 @@ as_component_add_relation (AsComponent *cpt, AsRelation *relation)
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 	AsRelationKind kind = as_relation_get_kind (relation);
 
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_RELATIONS);
+
 	if (kind == AS_RELATION_KIND_RECOMMENDS) {
 		g_ptr_array_add (priv->recommends,
 				g_object_ref (relation));
@@ -2990,6 +3277,8 @@ void
 as_component_add_agreement (AsComponent *cpt, AsAgreement *agreement)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_AGREEMENTS);
+
 	g_ptr_array_add (priv->agreements, g_object_ref (agreement));
 }
 
@@ -3010,6 +3299,8 @@ as_component_get_agreement_by_kind (AsComponent *cpt, AsAgreementKind kind)
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 	guint i;
 
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_AGREEMENTS);
+
 	for (i = 0; i < priv->agreements->len; i++) {
 		AsAgreement *agreement = AS_AGREEMENT (g_ptr_array_index (priv->agreements, i));
 		if (as_agreement_get_kind (agreement) == kind)
@@ -3140,6 +3431,16 @@ as_component_merge_with_mode (AsComponent *cpt, AsComponent *source, AsMergeKind
 	AsComponentPrivate *dest_priv = GET_PRIVATE (dest_cpt);
 	AsComponentPrivate *src_priv = GET_PRIVATE (src_cpt);
 
+	/* lazily loaded data would override the merge result otherwise */
+	as_component_load_deferred (dest_cpt, AS_COMPONENT_FIELD_ALL);
+	as_component_load_deferred (src_cpt, AS_COMPONENT_FIELD_ALL);
+	as_component_ensure_icons (dest_cpt);
+	as_component_ensure_icons (src_cpt);
+
+	/* search tokens loaded from a cache do not include the merged data */
+	g_hash_table_remove_all (dest_priv->token_cache);
+	as_component_set_token_cache_valid (dest_cpt, FALSE);
+
 	/* FIXME/TODO: We need to merge more attributes */
 
 	/* merge stuff in append mode */
@@ -3199,6 +3500,7 @@ as_component_merge_with_mode (AsComponent *cpt, AsComponent *source, AsMergeKind
 
 		/* description */
 		as_copy_l10n_hashtable (src_priv->description, dest_priv->description);
+		as_component_description_changed (dest_cpt);
 
 		/* merge package names */
 		if ((src_priv->pkgnames != NULL) && (src_priv->pkgnames[0] != NULL))
@@ -3242,6 +3544,134 @@ as_component_merge (AsComponent *cpt, AsComponent *source)
 	return TRUE;
 }
 
+/**
+ * as_copy_str_array:
+ *
+ * Helper for as_component_clone()
+ */
+static void
+as_copy_str_array (GPtrArray *src, GPtrArray *dest)
+{
+	guint i;
+
+	for (i = 0; i < src->len; i++)
+		g_ptr_array_add (dest, g_strdup (g_ptr_array_index (src, i)));
+}
+
+/**
+ * as_component_clone:
+ * @cpt: An #AsComponent.
+ *
+ * Create a copy of @cpt which can be modified without affecting @cpt.
+ * Icons are copied as well, as they are rewritten when a pool refines
+ * the component. All other child objects, like releases or screenshots,
+ * are shared with @cpt.
+ *
+ * Returns: (transfer full): A new #AsComponent.
+ */
+AsComponent*
+as_component_clone (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	AsComponent *copy;
+	AsComponentPrivate *cpriv;
+	GHashTableIter iter;
+	gpointer key, value;
+	guint i;
+
+	copy = as_component_new ();
+	cpriv = GET_PRIVATE (copy);
+
+	/* the copy shares the screenshot objects and copies the icon objects */
+	as_component_ensure_icons (cpt);
+	as_component_ensure_screenshots (cpt);
+
+	cpriv->kind = priv->kind;
+	cpriv->scope = priv->scope;
+	cpriv->origin_kind = priv->origin_kind;
+	if (priv->context != NULL)
+		cpriv->context = g_object_ref (priv->context);
+	cpriv->active_locale_override = g_strdup (priv->active_locale_override);
+
+	cpriv->id = g_strdup (priv->id);
+	cpriv->data_id = g_strdup (priv->data_id);
+	cpriv->origin = g_strdup (priv->origin);
+	cpriv->pkgnames = g_strdupv (priv->pkgnames);
+	cpriv->source_pkgname = g_strdup (priv->source_pkgname);
+
+	as_copy_l10n_hashtable (priv->name, cpriv->name);
+	as_copy_l10n_hashtable (priv->summary, cpriv->summary);
+	as_copy_l10n_hashtable (priv->description, cpriv->description);
+	as_copy_l10n_hashtable (priv->developer_name, cpriv->developer_name);
+	g_hash_table_iter_init (&iter, priv->keywords);
+	while (g_hash_table_iter_next (&iter, &key, &value))
+		g_hash_table_insert (cpriv->keywords, g_strdup (key), g_strdupv (value));
+
+	cpriv->metadata_license = g_strdup (priv->metadata_license);
+	cpriv->project_license = g_strdup (priv->project_license);
+	cpriv->project_group = g_strdup (priv->project_group);
+
+	as_copy_str_array (priv->categories, cpriv->categories);
+	as_copy_str_array (priv->compulsory_for_desktops, cpriv->compulsory_for_desktops);
+	as_copy_str_array (priv->extends, cpriv->extends);
+
+	as_copy_gobject_array (priv->launchables, cpriv->launchables);
+	as_copy_gobject_array (priv->addons, cpriv->addons);
+	as_copy_gobject_array (priv->screenshots, cpriv->screenshots);
+	as_copy_gobject_array (priv->releases, cpriv->releases);
+	as_copy_gobject_array (priv->provided, cpriv->provided);
+	as_copy_gobject_array (priv->bundles, cpriv->bundles);
+	as_copy_gobject_array (priv->suggestions, cpriv->suggestions);
+	as_copy_gobject_array (priv->content_ratings, cpriv->content_ratings);
+	as_copy_gobject_array (priv->recommends, cpriv->recommends);
+	as_copy_gobject_array (priv->requires, cpriv->requires);
+	as_copy_gobject_array (priv->agreements, cpriv->agreements);
+	if (priv->translations != NULL) {
+		cpriv->translations = g_ptr_array_new_with_free_func (g_object_unref);
+		as_copy_gobject_array (priv->translations, cpriv->translations);
+	}
+
+	for (i = 0; i < priv->icons->len; i++) {
+		AsIcon *icon = AS_ICON (g_ptr_array_index (priv->icons, i));
+		g_autoptr(AsIcon) icon_copy = as_icon_new ();
+
+		as_icon_set_kind (icon_copy, as_icon_get_kind (icon));
+		as_icon_set_name (icon_copy, as_icon_get_name (icon));
+		as_icon_set_filename (icon_copy, as_icon_get_filename (icon));
+		as_icon_set_url (icon_copy, as_icon_get_url (icon));
+		as_icon_set_width (icon_copy, as_icon_get_width (icon));
+		as_icon_set_height (icon_copy, as_icon_get_height (icon));
+		as_icon_set_scale (icon_copy, as_icon_get_scale (icon));
+		g_ptr_array_add (cpriv->icons, g_steal_pointer (&icon_copy));
+	}
+
+	g_hash_table_iter_init (&iter, priv->urls);
+	while (g_hash_table_iter_next (&iter, &key, &value))
+		g_hash_table_insert (cpriv->urls, key, g_strdup (value));
+	g_hash_table_iter_init (&iter, priv->languages);
+	while (g_hash_table_iter_next (&iter, &key, &value))
+		g_hash_table_insert (cpriv->languages, g_strdup (key), value);
+	as_copy_l10n_hashtable (priv->custom, cpriv->custom);
+
+	cpriv->arch = g_strdup (priv->arch);
+	cpriv->priority = priv->priority;
+	cpriv->merge_kind = priv->merge_kind;
+	cpriv->sort_score = priv->sort_score;
+	cpriv->value_flags = priv->value_flags;
+	cpriv->ignored = priv->ignored;
+
+	cpriv->description_plain = g_strdup (priv->description_plain);
+	cpriv->description_plain_locale = g_strdup (priv->description_plain_locale);
+
+	/* fields which were not loaded yet are loaded from the same data */
+	if (priv->deferred_data != NULL)
+		cpriv->deferred_data = g_variant_ref (priv->deferred_data);
+	cpriv->deferred_locale = g_strdup (priv->deferred_locale);
+	cpriv->deferred_fields = priv->deferred_fields;
+
+	return copy;
+}
+
 /**
  * as_component_set_kind_from_node:
  */
@@ -3893,6 +4323,10 @@ as_component_to_xml_node (AsComponent *cpt, AsContext *ctx, xmlNode *root)
 	xmlNode *cnode;
 	guint i;
 
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_ALL);
+	as_component_ensure_icons (cpt);
+	as_component_ensure_screenshots (cpt);
+
 	/* define component root node properties */
 	if (root == NULL)
 		cnode = xmlNewNode (NULL, (xmlChar*) "component");
@@ -4428,6 +4862,7 @@ as_component_load_from_yaml (AsComponent *cpt, AsContext *ctx, GNode *root, GErr
 			g_object_notify ((GObject *) cpt, "summary");
 		} else if (field_id == AS_TAG_DESCRIPTION) {
 			as_yaml_set_localized_table (ctx, node, priv->description);
+			as_component_description_changed (cpt);
 			g_object_notify ((GObject *) cpt, "description");
 		} else if (field_id == AS_TAG_DEVELOPER_NAME) {
 			as_yaml_set_localized_table (ctx, node, priv->developer_name);
@@ -4856,6 +5291,10 @@ as_component_emit_yaml (AsComponent *cpt, AsContext *ctx, yaml_emitter_t *emitte
 	const gchar *cstr;
 	yaml_event_t event;
 
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_ALL);
+	as_component_ensure_icons (cpt);
+	as_component_ensure_screenshots (cpt);
+
 	/* new document for this component */
 	yaml_document_start_event_initialize (&event, NULL, NULL, NULL, FALSE);
 	res = yaml_emitter_emit (emitter, &event);
@@ -5100,6 +5539,10 @@ as_component_to_variant (AsComponent *cpt, GVariantBuilder *builder)
 	GVariantBuilder cb;
 	guint i;
 
+	as_component_load_deferred (cpt, AS_COMPONENT_FIELD_ALL);
+	as_component_ensure_icons (cpt);
+	as_component_ensure_screenshots (cpt);
+
 	/* start serializing our component */
 	g_variant_builder_init (&cb, G_VARIANT_TYPE_VARDICT);
 
@@ -5132,6 +5575,19 @@ as_component_to_variant (AsComponent *cpt, GVariantBuilder *builder)
 	as_variant_builder_add_kv (&cb, "origin",
 				as_variant_mstring_new (as_component_get_origin (cpt)));
 
+	/* architecture */
+	if (as_component_get_architecture (cpt) != NULL)
+		as_variant_builder_add_kv (&cb, "architecture",
+					g_variant_new_string (as_component_get_architecture (cpt)));
+
+	/* priority and merge kind, needed to merge data from different sources when loading it */
+	if (priv->priority != 0)
+		as_variant_builder_add_kv (&cb, "priority",
+					g_variant_new_int32 (priv->priority));
+	if (priv->merge_kind != AS_MERGE_KIND_NONE)
+		as_variant_builder_add_kv (&cb, "merge_kind",
+					g_variant_new_uint32 (priv->merge_kind));
+
 	/* bundles */
 	if (priv->bundles->len > 0) {
 		GVariantBuilder array_b;
@@ -5383,15 +5839,457 @@ as_component_to_variant (AsComponent *cpt, GVariantBuilder *builder)
 }
 
 /**
- * as_component_set_from_variant:
+ * as_component_load_fields_from_variant:
+ *
+ * Read the optional @fields of this component from the dictionary of
+ * a #GVariant serialization.
+ */
+static void
+as_component_load_fields_from_variant (AsComponent *cpt, GVariantDict *dict, const gchar *locale, AsComponentField fields)
+{
+	GVariant *var;
+	GVariantIter gvi;
+
+	/* long description */
+	if (as_flags_contains (fields, AS_COMPONENT_FIELD_DESCRIPTION)) {
+		as_component_set_description (cpt,
+						as_variant_get_dict_mstr (dict, "description", &var),
+						locale);
+		g_variant_unref (var);
+	}
+
+	/* screenshots */
+	if (as_flags_contains (fields, AS_COMPONENT_FIELD_SCREENSHOTS)) {
+		var = g_variant_dict_lookup_value (dict,
+							"screenshots",
+							G_VARIANT_TYPE_ARRAY);
+		if (var != NULL) {
+			GVariant *child;
+
+			g_variant_iter_init (&gvi, var);
+			while ((child = g_variant_iter_next_value (&gvi))) {
+				AsScreenshotData scr = { 0, };
+				if (as_screenshot_data_set_from_variant (&scr, child))
+					as_component_take_screenshot_data (cpt, &scr, locale);
+				as_screenshot_data_clear (&scr);
+
+				g_variant_unref (child);
+			}
+			g_variant_unref (var);
+		}
+	}
+
+	/* agreements */
+	if (as_flags_contains (fields, AS_COMPONENT_FIELD_AGREEMENTS)) {
+		var = g_variant_dict_lookup_value (dict,
+							"agreements",
+							G_VARIANT_TYPE_ARRAY);
+		if (var != NULL) {
+			GVariant *child;
+
+			g_variant_iter_init (&gvi, var);
+			while ((child = g_variant_iter_next_value (&gvi))) {
+				g_autoptr(AsAgreement) agreement = as_agreement_new ();
+				if (as_agreement_set_from_variant (agreement, child, locale))
+					as_component_add_agreement (cpt, agreement);
+
+				g_variant_unref (child);
+			}
+			g_variant_unref (var);
+		}
+	}
+
+	/* releases */
+	if (as_flags_contains (fields, AS_COMPONENT_FIELD_RELEASES)) {
+		var = g_variant_dict_lookup_value (dict,
+							"releases",
+							G_VARIANT_TYPE_ARRAY);
+		if (var != NULL) {
+			GVariant *child;
+
+			g_variant_iter_init (&gvi, var);
+			while ((child = g_variant_iter_next_value (&gvi))) {
+				g_autoptr(AsRelease) rel = as_release_new ();
+				if (as_release_set_from_variant (rel, child, locale))
+					as_component_add_release (cpt, rel);
+
+				g_variant_unref (child);
+			}
+			g_variant_unref (var);
+		}
+	}
+
+	/* languages */
+	if (as_flags_contains (fields, AS_COMPONENT_FIELD_LANGUAGES)) {
+		var = g_variant_dict_lookup_value (dict,
+						   "languages",
+						   G_VARIANT_TYPE_DICTIONARY);
+		if (var != NULL) {
+			GVariant *child;
+
+			g_variant_iter_init (&gvi, var);
+			while ((child = g_variant_iter_next_value (&gvi))) {
+				guint percentage;
+				g_autofree gchar *lang;
+
+				g_variant_get (child, "{su}", &lang, &percentage);
+				as_component_add_language (cpt, lang, percentage);
+
+				g_variant_unref (child);
+			}
+			g_variant_unref (var);
+		}
+	}
+
+	/* suggestions */
+	if (as_flags_contains (fields, AS_COMPONENT_FIELD_SUGGESTIONS)) {
+		var = g_variant_dict_lookup_value (dict,
+						   "suggestions",
+						   G_VARIANT_TYPE_ARRAY);
+		if (var != NULL) {
+			GVariant *child;
+
+			g_variant_iter_init (&gvi, var);
+			while ((child = g_variant_iter_next_value (&gvi))) {
+				g_autoptr(AsSuggested) suggested = as_suggested_new ();
+				if (as_suggested_set_from_variant (suggested, child))
+					as_component_add_suggested (cpt, suggested);
+
+				g_variant_unref (child);
+			}
+			g_variant_unref (var);
+		}
+	}
+
+	/* content ratings */
+	if (as_flags_contains (fields, AS_COMPONENT_FIELD_CONTENT_RATINGS)) {
+		var = g_variant_dict_lookup_value (dict,
+						   "content_ratings",
+						   G_VARIANT_TYPE_ARRAY);
+		if (var != NULL) {
+			GVariant *child;
+
+			g_variant_iter_init (&gvi, var);
+			while ((child = g_variant_iter_next_value (&gvi))) {
+				g_autoptr(AsContentRating) rating = as_content_rating_new ();
+				if (as_content_rating_set_from_variant (rating, child))
+					as_component_add_content_rating (cpt, rating);
+
+				g_variant_unref (child);
+			}
+			g_variant_unref (var);
+		}
+	}
+
+	/* requires / recommends */
+	if (as_flags_contains (fields, AS_COMPONENT_FIELD_RELATIONS)) {
+		var = g_variant_dict_lookup_value (dict,
+						   "relations",
+						   G_VARIANT_TYPE_ARRAY);
+		if (var != NULL) {
+			GVariant *child;
+
+			g_variant_iter_init (&gvi, var);
+			while ((child = g_variant_iter_next_value (&gvi))) {
+				g_autoptr(AsRelation) relation = as_relation_new ();
+				if (as_relation_set_from_variant (relation, child))
+					as_component_add_relation (cpt, relation);
+
+				g_variant_unref (child);
+			}
+			g_variant_unref (var);
+		}
+	}
+
+	/* custom data */
+	if (as_flags_contains (fields, AS_COMPONENT_FIELD_CUSTOM)) {
+		var = g_variant_dict_lookup_value (dict,
+						   "custom",
+						   G_VARIANT_TYPE_DICTIONARY);
+		if (var != NULL) {
+			GVariant *child;
+
+			g_variant_iter_init (&gvi, var);
+			while ((child = g_variant_iter_next_value (&gvi))) {
+				g_autofree gchar *key = NULL;
+				g_autofree gchar *value = NULL;
+
+				g_variant_get (child, "{ss}", &key, &value);
+				as_component_insert_custom_value (cpt, key, value);
+
+				g_variant_unref (child);
+			}
+			g_variant_unref (var);
+		}
+	}
+}
+
+/* keys of the cache data of the optional fields */
+static const struct {
+	AsComponentField	field;
+	const gchar		*key;
+} as_component_field_keys[] = {
+	{ AS_COMPONENT_FIELD_DESCRIPTION,	"description" },
+	{ AS_COMPONENT_FIELD_SCREENSHOTS,	"screenshots" },
+	{ AS_COMPONENT_FIELD_AGREEMENTS,	"agreements" },
+	{ AS_COMPONENT_FIELD_RELEASES,		"releases" },
+	{ AS_COMPONENT_FIELD_LANGUAGES,		"languages" },
+	{ AS_COMPONENT_FIELD_SUGGESTIONS,	"suggestions" },
+	{ AS_COMPONENT_FIELD_CONTENT_RATINGS,	"content_ratings" },
+	{ AS_COMPONENT_FIELD_RELATIONS,		"relations" },
+	{ AS_COMPONENT_FIELD_CUSTOM,		"custom" },
+	{ AS_COMPONENT_FIELD_NONE,		NULL }
+};
+
+/**
+ * as_component_extract_deferred:
+ *
+ * Copy the serialized data of @fields out of @dict, so the buffer the
+ * whole cache was loaded into does not need to stay alive until the
+ * fields are accessed.
+ *
+ * Returns: (transfer full) (nullable): A dictionary with the data of @fields.
+ */
+static GVariant*
+as_component_extract_deferred (GVariantDict *dict, AsComponentField fields)
+{
+	GVariantBuilder builder;
+	gboolean found = FALSE;
+	guint i;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	for (i = 0; as_component_field_keys[i].key != NULL; i++) {
+		g_autoptr(GVariant) value = NULL;
+		g_autoptr(GBytes) bytes = NULL;
+
+		if (!as_flags_contains (fields, as_component_field_keys[i].field))
+			continue;
+		value = g_variant_dict_lookup_value (dict, as_component_field_keys[i].key, NULL);
+		if (value == NULL)
+			continue;
+
+		/* a child value references the data of its parent, so we need a copy */
+		bytes = g_bytes_new (g_variant_get_data (value), g_variant_get_size (value));
+		g_variant_builder_add (&builder, "{sv}",
+				       as_component_field_keys[i].key,
+				       g_variant_new_from_bytes (g_variant_get_type (value), bytes, TRUE));
+		found = TRUE;
+	}
+
+	if (!found) {
+		g_variant_builder_clear (&builder);
+		return NULL;
+	}
+	return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
+/**
+ * as_component_load_deferred:
+ * @cpt: an #AsComponent.
+ * @fields: The fields which are about to be accessed.
+ *
+ * Load the data of @fields which was skipped when reading this
+ * component from a cache, if there is any.
+ */
+static void
+as_component_load_deferred (AsComponent *cpt, AsComponentField fields)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	AsComponentField todo;
+	GVariantDict dict;
+
+	todo = priv->deferred_fields & fields;
+	if (todo == AS_COMPONENT_FIELD_NONE)
+		return;
+
+	/* unset the fields first, as loading them uses the regular setters */
+	priv->deferred_fields &= ~todo;
+
+	/* none of the fields had any data */
+	if (priv->deferred_data == NULL)
+		return;
+
+	g_variant_dict_init (&dict, priv->deferred_data);
+	as_component_load_fields_from_variant (cpt, &dict, priv->deferred_locale, todo);
+	g_variant_dict_clear (&dict);
+
+	if (priv->deferred_fields == AS_COMPONENT_FIELD_NONE) {
+		g_clear_pointer (&priv->deferred_data, g_variant_unref);
+		g_clear_pointer (&priv->deferred_locale, g_free);
+	}
+}
+
+/**
+ * as_memory_size_object_array:
+ *
+ * Approximate memory used by an array of objects, not including
+ * the data the objects reference.
+ */
+static gsize
+as_memory_size_object_array (GPtrArray *array)
+{
+	gsize size;
+	guint i;
+
+	size = as_memory_size_str_array (array, FALSE);
+	for (i = 0; i < array->len; i++)
+		size += as_memory_size_object (g_ptr_array_index (array, i));
+	return size;
+}
+
+/**
+ * as_component_count_memory:
+ * @cpt: an #AsComponent.
+ * @usage: Array of %AS_POOL_MEMORY_KIND_LAST byte counts to add to.
+ *
+ * Add the approximate amount of memory used by this component
+ * to @usage, sorted by category.
+ */
+void
+as_component_count_memory (AsComponent *cpt, guint64 *usage)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	GHashTableIter iter;
+	gpointer value;
+	guint i, j;
+
+	/* plain data */
+	usage[AS_POOL_MEMORY_KIND_STRINGS] += as_memory_size_object (cpt)
+		+ as_memory_size_str (priv->active_locale_override)
+		+ as_memory_size_str (priv->id)
+		+ as_memory_size_str (priv->data_id)
+		+ as_memory_size_str (priv->origin)
+		+ as_memory_size_strv (priv->pkgnames)
+		+ as_memory_size_str (priv->source_pkgname)
+		+ as_memory_size_str (priv->metadata_license)
+		+ as_memory_size_str (priv->project_license)
+		+ as_memory_size_str (priv->project_group)
+		+ as_memory_size_str (priv->arch)
+		+ as_memory_size_str_array (priv->categories, TRUE)
+		+ as_memory_size_str_array (priv->compulsory_for_desktops, TRUE)
+		+ as_memory_size_str_array (priv->extends, TRUE)
+		+ as_memory_size_str_array (priv->addons, FALSE)
+		+ as_memory_size_str_table (priv->urls, FALSE, TRUE)
+		+ as_memory_size_str_table (priv->custom, TRUE, TRUE)
+		+ as_memory_size_object_array (priv->launchables)
+		+ as_memory_size_object_array (priv->provided)
+		+ as_memory_size_object_array (priv->bundles)
+		+ as_memory_size_object_array (priv->suggestions)
+		+ as_memory_size_object_array (priv->content_ratings)
+		+ as_memory_size_object_array (priv->recommends)
+		+ as_memory_size_object_array (priv->requires)
+		+ as_memory_size_object_array (priv->agreements)
+		+ as_memory_size_object_array (priv->translations);
+	for (i = 0; i < priv->launchables->len; i++) {
+		AsLaunchable *launch = AS_LAUNCHABLE (g_ptr_array_index (priv->launchables, i));
+		usage[AS_POOL_MEMORY_KIND_STRINGS] += as_memory_size_str_array (as_launchable_get_entries (launch), TRUE);
+	}
+	for (i = 0; i < priv->provided->len; i++) {
+		AsProvided *prov = AS_PROVIDED (g_ptr_array_index (priv->provided, i));
+		usage[AS_POOL_MEMORY_KIND_STRINGS] += as_memory_size_str_array (as_provided_get_items (prov), TRUE);
+	}
+	for (i = 0; i < priv->bundles->len; i++) {
+		AsBundle *bundle = AS_BUNDLE (g_ptr_array_index (priv->bundles, i));
+		usage[AS_POOL_MEMORY_KIND_STRINGS] += as_memory_size_str (as_bundle_get_id (bundle));
+	}
+
+	/* translated data */
+	usage[AS_POOL_MEMORY_KIND_LOCALIZED] += as_memory_size_str_table (priv->name, TRUE, TRUE)
+		+ as_memory_size_str_table (priv->summary, TRUE, TRUE)
+		+ as_memory_size_str_table (priv->description, TRUE, TRUE)
+		+ as_memory_size_str_table (priv->developer_name, TRUE, TRUE)
+		+ as_memory_size_str_table (priv->keywords, TRUE, FALSE)
+		+ as_memory_size_str_table (priv->languages, TRUE, FALSE)
+		+ as_memory_size_str (priv->description_plain)
+		+ as_memory_size_str (priv->description_plain_locale);
+	g_hash_table_iter_init (&iter, priv->keywords);
+	while (g_hash_table_iter_next (&iter, NULL, &value))
+		usage[AS_POOL_MEMORY_KIND_LOCALIZED] += as_memory_size_strv ((gchar**) value);
+
+	/* releases */
+	usage[AS_POOL_MEMORY_KIND_RELEASES] += as_memory_size_str_array (priv->releases, FALSE);
+	for (i = 0; i < priv->releases->len; i++) {
+		AsRelease *release = AS_RELEASE (g_ptr_array_index (priv->releases, i));
+		usage[AS_POOL_MEMORY_KIND_RELEASES] += as_release_get_memory_size (release);
+	}
+
+	/* screenshots */
+	usage[AS_POOL_MEMORY_KIND_SCREENSHOTS] += as_memory_size_object_array (priv->screenshots);
+	for (i = 0; i < priv->screenshots->len; i++) {
+		AsScreenshot *sshot = AS_SCREENSHOT (g_ptr_array_index (priv->screenshots, i));
+		GPtrArray *images = as_screenshot_get_images_all (sshot);
+
+		usage[AS_POOL_MEMORY_KIND_SCREENSHOTS] += as_memory_size_str (as_screenshot_get_caption (sshot))
+			+ as_memory_size_object_array (images);
+		for (j = 0; j < images->len; j++) {
+			AsImage *img = AS_IMAGE (g_ptr_array_index (images, j));
+			usage[AS_POOL_MEMORY_KIND_SCREENSHOTS] += as_memory_size_str (as_image_get_url (img))
+				+ as_memory_size_str (as_image_get_locale (img));
+		}
+	}
+	if (priv->screenshots_data != NULL) {
+		usage[AS_POOL_MEMORY_KIND_SCREENSHOTS] += priv->screenshots_data->len * sizeof (AsScreenshotData)
+			+ as_memory_size_str (priv->screenshots_data_locale);
+		for (i = 0; i < priv->screenshots_data->len; i++) {
+			AsScreenshotData *sdata = &g_array_index (priv->screenshots_data, AsScreenshotData, i);
+			usage[AS_POOL_MEMORY_KIND_SCREENSHOTS] += as_screenshot_data_get_memory_size (sdata);
+		}
+	}
+
+	/* icons */
+	usage[AS_POOL_MEMORY_KIND_ICONS] += as_memory_size_object_array (priv->icons);
+	for (i = 0; i < priv->icons->len; i++) {
+		AsIcon *icon = AS_ICON (g_ptr_array_index (priv->icons, i));
+		usage[AS_POOL_MEMORY_KIND_ICONS] += as_memory_size_str (as_icon_get_name (icon))
+			+ as_memory_size_str (as_icon_get_url (icon))
+			+ as_memory_size_str (as_icon_get_filename (icon));
+	}
+	if (priv->icons_data != NULL) {
+		usage[AS_POOL_MEMORY_KIND_ICONS] += priv->icons_data->len * sizeof (AsIconData);
+		for (i = 0; i < priv->icons_data->len; i++) {
+			AsIconData *idata = &g_array_index (priv->icons_data, AsIconData, i);
+			usage[AS_POOL_MEMORY_KIND_ICONS] += as_memory_size_str (idata->name)
+				+ as_memory_size_str (idata->url)
+				+ as_memory_size_str (idata->filename);
+		}
+	}
+
+	/* search tokens */
+	usage[AS_POOL_MEMORY_KIND_TOKENS] += as_memory_size_str_table (priv->token_cache, TRUE, FALSE)
+		+ g_hash_table_size (priv->token_cache) * sizeof (AsTokenType);
+
+	/* data which was not loaded yet */
+	if (priv->deferred_data != NULL)
+		usage[AS_POOL_MEMORY_KIND_CACHE_DATA] += g_variant_get_size (priv->deferred_data)
+			+ as_memory_size_str (priv->deferred_locale);
+}
+
+/**
+ * as_component_get_deferred_fields:
+ * @cpt: an #AsComponent.
+ *
+ * Returns: The fields which were not loaded from the cache yet.
+ */
+AsComponentField
+as_component_get_deferred_fields (AsComponent *cpt)
+{
+	AsComponentPrivate *priv = GET_PRIVATE (cpt);
+	return priv->deferred_fields;
+}
+
+/**
+ * as_component_set_from_variant_fields:
  * @cpt: an #AsComponent.
  * @variant: The #GVariant to read from.
+ * @locale: The locale of the serialized data.
+ * @fields: The optional fields to load right away.
  *
  * Read the active state of this object from a #GVariant serialization.
- * This is used by the on-disk binary cache.
+ * Optional data not included in @fields is only loaded once it is accessed,
+ * a copy of its serialized data is kept around until then.
  */
 gboolean
-as_component_set_from_variant (AsComponent *cpt, GVariant *variant, const gchar *locale)
+as_component_set_from_variant_fields (AsComponent *cpt, GVariant *variant, const gchar *locale, AsComponentField fields)
 {
 	AsComponentPrivate *priv = GET_PRIVATE (cpt);
 	g_auto(GVariantDict) dict;
@@ -5439,6 +6337,17 @@ as_component_set_from_variant (AsComponent *cpt, GVariant *variant, const gchar
 	as_component_set_origin (cpt, as_variant_get_dict_mstr (&dict, "origin", &var));
 	g_variant_unref (var);
 
+	/* architecture */
+	var = g_variant_dict_lookup_value (&dict, "architecture", G_VARIANT_TYPE_STRING);
+	if (var != NULL) {
+		as_component_set_architecture (cpt, g_variant_get_string (var, NULL));
+		g_variant_unref (var);
+	}
+
+	/* priority and merge kind */
+	g_variant_dict_lookup (&dict, "priority", "i", &priv->priority);
+	g_variant_dict_lookup (&dict, "merge_kind", "u", &priv->merge_kind);
+
 	/* bundles */
 	var = g_variant_dict_lookup_value (&dict, "bundles", G_VARIANT_TYPE_ARRAY);
 	if (var != NULL) {
@@ -5504,20 +6413,17 @@ as_component_set_from_variant (AsComponent *cpt, GVariant *variant, const gchar
 		GVariant *child;
 		g_variant_iter_init (&gvi, var);
 		while ((child = g_variant_iter_next_value (&gvi))) {
-			g_autoptr(AsIcon) icon = as_icon_new ();
-			if (as_icon_set_from_variant (icon, child))
-				as_component_add_icon (cpt, icon);
+			AsIconData icon;
+
+			as_icon_data_init (&icon);
+			if (as_icon_data_set_from_variant (&icon, child))
+				as_component_take_icon_data (cpt, &icon);
+			as_icon_data_clear (&icon);
 			g_variant_unref (child);
 		}
 		g_variant_unref (var);
 	}
 
-	/* long description */
-	as_component_set_description (cpt,
-					as_variant_get_dict_mstr (&dict, "description", &var),
-					locale);
-	g_variant_unref (var);
-
 	/* categories */
 	as_variant_to_string_ptrarray_by_dict (&dict,
 						"categories",
@@ -5561,152 +6467,14 @@ as_component_set_from_variant (AsComponent *cpt, GVariant *variant, const gchar
 		g_variant_unref (var);
 	}
 
-	/* screenshots */
-	var = g_variant_dict_lookup_value (&dict,
-						"screenshots",
-						G_VARIANT_TYPE_ARRAY);
-	if (var != NULL) {
-		GVariant *child;
-
-		g_variant_iter_init (&gvi, var);
-		while ((child = g_variant_iter_next_value (&gvi))) {
-			g_autoptr(AsScreenshot) scr = as_screenshot_new ();
-			if (as_screenshot_set_from_variant (scr, child, locale))
-				as_component_add_screenshot (cpt, scr);
-
-			g_variant_unref (child);
-		}
-		g_variant_unref (var);
-	}
-
-	/* agreements */
-	var = g_variant_dict_lookup_value (&dict,
-						"agreements",
-						G_VARIANT_TYPE_ARRAY);
-	if (var != NULL) {
-		GVariant *child;
-
-		g_variant_iter_init (&gvi, var);
-		while ((child = g_variant_iter_next_value (&gvi))) {
-			g_autoptr(AsAgreement) agreement = as_agreement_new ();
-			if (as_agreement_set_from_variant (agreement, child, locale))
-				as_component_add_agreement (cpt, agreement);
-
-			g_variant_unref (child);
-		}
-		g_variant_unref (var);
-	}
-
-	/* releases */
-	var = g_variant_dict_lookup_value (&dict,
-						"releases",
-						G_VARIANT_TYPE_ARRAY);
-	if (var != NULL) {
-		GVariant *child;
-
-		g_variant_iter_init (&gvi, var);
-		while ((child = g_variant_iter_next_value (&gvi))) {
-			g_autoptr(AsRelease) rel = as_release_new ();
-			if (as_release_set_from_variant (rel, child, locale))
-				as_component_add_release (cpt, rel);
-
-			g_variant_unref (child);
-		}
-		g_variant_unref (var);
-	}
-
-	/* languages */
-	var = g_variant_dict_lookup_value (&dict,
-					   "languages",
-					   G_VARIANT_TYPE_DICTIONARY);
-	if (var != NULL) {
-		GVariant *child;
-
-		g_variant_iter_init (&gvi, var);
-		while ((child = g_variant_iter_next_value (&gvi))) {
-			guint percentage;
-			g_autofree gchar *lang;
-
-			g_variant_get (child, "{su}", &lang, &percentage);
-			as_component_add_language (cpt, lang, percentage);
-
-			g_variant_unref (child);
-		}
-		g_variant_unref (var);
-	}
-
-	/* suggestions */
-	var = g_variant_dict_lookup_value (&dict,
-					   "suggestions",
-					   G_VARIANT_TYPE_ARRAY);
-	if (var != NULL) {
-		GVariant *child;
-
-		g_variant_iter_init (&gvi, var);
-		while ((child = g_variant_iter_next_value (&gvi))) {
-			g_autoptr(AsSuggested) suggested = as_suggested_new ();
-			if (as_suggested_set_from_variant (suggested, child))
-				as_component_add_suggested (cpt, suggested);
-
-			g_variant_unref (child);
-		}
-		g_variant_unref (var);
-	}
-
-	/* content ratings */
-	var = g_variant_dict_lookup_value (&dict,
-					   "content_ratings",
-					   G_VARIANT_TYPE_ARRAY);
-	if (var != NULL) {
-		GVariant *child;
-
-		g_variant_iter_init (&gvi, var);
-		while ((child = g_variant_iter_next_value (&gvi))) {
-			g_autoptr(AsContentRating) rating = as_content_rating_new ();
-			if (as_content_rating_set_from_variant (rating, child))
-				as_component_add_content_rating (cpt, rating);
-
-			g_variant_unref (child);
-		}
-		g_variant_unref (var);
-	}
-
-	/* requires / recommends */
-	var = g_variant_dict_lookup_value (&dict,
-					   "relations",
-					   G_VARIANT_TYPE_ARRAY);
-	if (var != NULL) {
-		GVariant *child;
-
-		g_variant_iter_init (&gvi, var);
-		while ((child = g_variant_iter_next_value (&gvi))) {
-			g_autoptr(AsRelation) relation = as_relation_new ();
-			if (as_relation_set_from_variant (relation, child))
-				as_component_add_relation (cpt, relation);
-
-			g_variant_unref (child);
-		}
-		g_variant_unref (var);
-	}
-
-	/* custom data */
-	var = g_variant_dict_lookup_value (&dict,
-					   "custom",
-					   G_VARIANT_TYPE_DICTIONARY);
-	if (var != NULL) {
-		GVariant *child;
-
-		g_variant_iter_init (&gvi, var);
-		while ((child = g_variant_iter_next_value (&gvi))) {
-			g_autofree gchar *key = NULL;
-			g_autofree gchar *value = NULL;
-
-			g_variant_get (child, "{ss}", &key, &value);
-			as_component_insert_custom_value (cpt, key, value);
-
-			g_variant_unref (child);
-		}
-		g_variant_unref (var);
+	/* optional data */
+	as_component_load_fields_from_variant (cpt, &dict, locale, fields);
+	if ((fields & AS_COMPONENT_FIELD_ALL) != AS_COMPONENT_FIELD_ALL) {
+		g_clear_pointer (&priv->deferred_data, g_variant_unref);
+		g_free (priv->deferred_locale);
+		priv->deferred_data = as_component_extract_deferred (&dict, AS_COMPONENT_FIELD_ALL & ~fields);
+		priv->deferred_locale = g_strdup (locale);
+		priv->deferred_fields = AS_COMPONENT_FIELD_ALL & ~fields;
 	}
 
 	/* search tokens */
@@ -5746,6 +6514,20 @@ as_component_set_from_variant (AsComponent *cpt, GVariant *variant, const gchar
 	return TRUE;
 }
 
+/**
+ * as_component_set_from_variant:
+ * @cpt: an #AsComponent.
+ * @variant: The #GVariant to read from.
+ *
+ * Read the active state of this object from a #GVariant serialization.
+ * This is used by the on-disk binary cache.
+ */
+gboolean
+as_component_set_from_variant (AsComponent *cpt, GVariant *variant, const gchar *locale)
+{
+	return as_component_set_from_variant_fields (cpt, variant, locale, AS_COMPONENT_FIELD_ALL);
+}
+
 /**
  * as_component_get_desktop_id:
  * @cpt: a #AsComponent instance.
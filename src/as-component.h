@@ -150,6 +150,41 @@ typedef enum {
 	AS_VALUE_FLAG_NO_TRANSLATION_FALLBACK = 1 << 1
 } AsValueFlags;
 
+/**
+ * AsComponentField:
+ * @AS_COMPONENT_FIELD_NONE:		None of the optional fields.
+ * @AS_COMPONENT_FIELD_DESCRIPTION:	The long description.
+ * @AS_COMPONENT_FIELD_SCREENSHOTS:	Screenshots.
+ * @AS_COMPONENT_FIELD_AGREEMENTS:	Agreements, like privacy policies.
+ * @AS_COMPONENT_FIELD_RELEASES:	Release information.
+ * @AS_COMPONENT_FIELD_LANGUAGES:	Languages the component is translated to.
+ * @AS_COMPONENT_FIELD_SUGGESTIONS:	Suggested other components.
+ * @AS_COMPONENT_FIELD_CONTENT_RATINGS:	Content ratings.
+ * @AS_COMPONENT_FIELD_RELATIONS:	Requirements and recommendations.
+ * @AS_COMPONENT_FIELD_CUSTOM:		Custom data.
+ * @AS_COMPONENT_FIELD_ALL:		All optional fields.
+ *
+ * Optional data of a component, which only needs to be loaded from
+ * a cache once it is accessed. Data which is needed to find and list
+ * components, like IDs, names, summaries, icons and launchables,
+ * is always loaded.
+ *
+ * Since: 0.12.3
+ */
+typedef enum {
+	AS_COMPONENT_FIELD_NONE = 0,
+	AS_COMPONENT_FIELD_DESCRIPTION     = 1 << 0,
+	AS_COMPONENT_FIELD_SCREENSHOTS     = 1 << 1,
+	AS_COMPONENT_FIELD_AGREEMENTS      = 1 << 2,
+	AS_COMPONENT_FIELD_RELEASES        = 1 << 3,
+	AS_COMPONENT_FIELD_LANGUAGES       = 1 << 4,
+	AS_COMPONENT_FIELD_SUGGESTIONS     = 1 << 5,
+	AS_COMPONENT_FIELD_CONTENT_RATINGS = 1 << 6,
+	AS_COMPONENT_FIELD_RELATIONS       = 1 << 7,
+	AS_COMPONENT_FIELD_CUSTOM          = 1 << 8,
+	AS_COMPONENT_FIELD_ALL             = (1 << 9) - 1
+} AsComponentField;
+
 AsComponent		*as_component_new (void);
 
 AsValueFlags		as_component_get_value_flags (AsComponent *cpt);
@@ -199,6 +234,9 @@ const gchar		*as_component_get_description (AsComponent *cpt);
 void			as_component_set_description (AsComponent *cpt,
 							const gchar *value,
 							const gchar *locale);
+const gchar		*as_component_get_description_plain (AsComponent *cpt);
+gchar			*as_component_get_description_snippet (AsComponent *cpt,
+								guint max_len);
 
 GPtrArray		*as_component_get_launchables (AsComponent *cpt);
 AsLaunchable		*as_component_get_launchable (AsComponent *cpt,
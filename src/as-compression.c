@@ -0,0 +1,450 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2018 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include "as-compression.h"
+
+#include <glib.h>
+#include <string.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#ifndef ZSTD_CLEVEL_DEFAULT
+#define ZSTD_CLEVEL_DEFAULT 3
+#endif
+#endif
+#ifdef HAVE_LZMA
+#include <lzma.h>
+#endif
+
+/**
+ * SECTION:as-compression
+ * @short_description: Helpers to read and write compressed metadata.
+ *
+ * GLib only ships a converter for GZip, this file adds decompressors
+ * for Zstandard and xz data (if AppStream was built with support for them)
+ * and detects which one is needed for a given stream.
+ */
+
+#define AS_TYPE_DECOMPRESSOR (as_decompressor_get_type ())
+G_DECLARE_FINAL_TYPE (AsDecompressor, as_decompressor, AS, DECOMPRESSOR, GObject)
+
+struct _AsDecompressor
+{
+	GObject parent_instance;
+
+	AsCompressionKind kind;
+#ifdef HAVE_ZSTD
+	ZSTD_DStream *zstd;
+#endif
+#ifdef HAVE_LZMA
+	lzma_stream lzma;
+#endif
+};
+
+static void as_decompressor_converter_iface_init (GConverterIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (AsDecompressor, as_decompressor, G_TYPE_OBJECT,
+			 G_IMPLEMENT_INTERFACE (G_TYPE_CONVERTER,
+						as_decompressor_converter_iface_init))
+
+/**
+ * as_decompressor_finalize:
+ **/
+static void
+as_decompressor_finalize (GObject *object)
+{
+#if defined (HAVE_ZSTD) || defined (HAVE_LZMA)
+	AsDecompressor *decomp = AS_DECOMPRESSOR (object);
+#endif
+
+#ifdef HAVE_ZSTD
+	if (decomp->zstd != NULL)
+		ZSTD_freeDStream (decomp->zstd);
+#endif
+#ifdef HAVE_LZMA
+	if (decomp->kind == AS_COMPRESSION_KIND_XZ)
+		lzma_end (&decomp->lzma);
+#endif
+
+	G_OBJECT_CLASS (as_decompressor_parent_class)->finalize (object);
+}
+
+/**
+ * as_decompressor_init:
+ **/
+static void
+as_decompressor_init (AsDecompressor *decomp)
+{
+}
+
+/**
+ * as_decompressor_class_init:
+ **/
+static void
+as_decompressor_class_init (AsDecompressorClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	object_class->finalize = as_decompressor_finalize;
+}
+
+/**
+ * as_decompressor_reset_internal:
+ *
+ * (Re)initialize the decoder state.
+ */
+static gboolean
+as_decompressor_reset_internal (AsDecompressor *decomp)
+{
+#ifdef HAVE_ZSTD
+	if (decomp->kind == AS_COMPRESSION_KIND_ZSTD) {
+		if (decomp->zstd == NULL)
+			decomp->zstd = ZSTD_createDStream ();
+		return !ZSTD_isError (ZSTD_initDStream (decomp->zstd));
+	}
+#endif
+#ifdef HAVE_LZMA
+	if (decomp->kind == AS_COMPRESSION_KIND_XZ) {
+		lzma_stream strm = LZMA_STREAM_INIT;
+
+		lzma_end (&decomp->lzma);
+		decomp->lzma = strm;
+		return lzma_stream_decoder (&decomp->lzma, UINT64_MAX, LZMA_CONCATENATED) == LZMA_OK;
+	}
+#endif
+	return FALSE;
+}
+
+/**
+ * as_decompressor_reset:
+ **/
+static void
+as_decompressor_reset (GConverter *converter)
+{
+	as_decompressor_reset_internal (AS_DECOMPRESSOR (converter));
+}
+
+/**
+ * as_decompressor_convert:
+ **/
+static GConverterResult
+as_decompressor_convert (GConverter *converter,
+			 const void *inbuf,
+			 gsize inbuf_size,
+			 void *outbuf,
+			 gsize outbuf_size,
+			 GConverterFlags flags,
+			 gsize *bytes_read,
+			 gsize *bytes_written,
+			 GError **error)
+{
+	AsDecompressor *decomp = AS_DECOMPRESSOR (converter);
+	gboolean finished = FALSE;
+
+	g_return_val_if_fail (decomp->kind != AS_COMPRESSION_KIND_NONE, G_CONVERTER_ERROR);
+	*bytes_read = 0;
+	*bytes_written = 0;
+
+#ifdef HAVE_ZSTD
+	if (decomp->kind == AS_COMPRESSION_KIND_ZSTD) {
+		ZSTD_inBuffer in = { inbuf, inbuf_size, 0 };
+		ZSTD_outBuffer out = { outbuf, outbuf_size, 0 };
+		gsize ret;
+
+		ret = ZSTD_decompressStream (decomp->zstd, &out, &in);
+		if (ZSTD_isError (ret)) {
+			g_set_error (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_INVALID_DATA,
+				     "Unable to decompress Zstandard data: %s",
+				     ZSTD_getErrorName (ret));
+			return G_CONVERTER_ERROR;
+		}
+		*bytes_read = in.pos;
+		*bytes_written = out.pos;
+
+		/* a file may consist of multiple frames, we are only done at the end of the input */
+		finished = (ret == 0) && (in.pos == inbuf_size) && (flags & G_CONVERTER_INPUT_AT_END);
+	}
+#endif
+#ifdef HAVE_LZMA
+	if (decomp->kind == AS_COMPRESSION_KIND_XZ) {
+		lzma_ret ret;
+
+		decomp->lzma.next_in = inbuf;
+		decomp->lzma.avail_in = inbuf_size;
+		decomp->lzma.next_out = outbuf;
+		decomp->lzma.avail_out = outbuf_size;
+
+		ret = lzma_code (&decomp->lzma, (flags & G_CONVERTER_INPUT_AT_END)? LZMA_FINISH : LZMA_RUN);
+		if ((ret != LZMA_OK) && (ret != LZMA_STREAM_END) && (ret != LZMA_BUF_ERROR)) {
+			g_set_error (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_INVALID_DATA,
+				     "Unable to decompress xz data (error %i)", ret);
+			return G_CONVERTER_ERROR;
+		}
+		*bytes_read = inbuf_size - decomp->lzma.avail_in;
+		*bytes_written = outbuf_size - decomp->lzma.avail_out;
+
+		finished = ret == LZMA_STREAM_END;
+	}
+#endif
+
+	if (finished)
+		return G_CONVERTER_FINISHED;
+
+	if ((*bytes_read == 0) && (*bytes_written == 0)) {
+		if (flags & G_CONVERTER_INPUT_AT_END) {
+			g_set_error_literal (error,
+					     G_IO_ERROR,
+					     G_IO_ERROR_INVALID_DATA,
+					     "Compressed data is truncated.");
+		} else {
+			g_set_error_literal (error,
+					     G_IO_ERROR,
+					     G_IO_ERROR_PARTIAL_INPUT,
+					     "Need more input.");
+		}
+		return G_CONVERTER_ERROR;
+	}
+
+	return G_CONVERTER_CONVERTED;
+}
+
+/**
+ * as_decompressor_converter_iface_init:
+ **/
+static void
+as_decompressor_converter_iface_init (GConverterIface *iface)
+{
+	iface->convert = as_decompressor_convert;
+	iface->reset = as_decompressor_reset;
+}
+
+/**
+ * as_decompressor_new:
+ *
+ * Create a new #GConverter to decompress data of type @kind,
+ * or %NULL if that is not supported.
+ */
+static GConverter*
+as_decompressor_new (AsCompressionKind kind)
+{
+	AsDecompressor *decomp;
+
+	decomp = g_object_new (AS_TYPE_DECOMPRESSOR, NULL);
+	decomp->kind = kind;
+	if (!as_decompressor_reset_internal (decomp)) {
+		g_object_unref (decomp);
+		return NULL;
+	}
+
+	return G_CONVERTER (decomp);
+}
+
+/**
+ * as_compression_kind_from_data:
+ * @data: The first bytes of a file.
+ * @len: Length of @data.
+ *
+ * Detect the compression format from the magic bytes at the start of some data.
+ *
+ * Returns: The #AsCompressionKind
+ */
+AsCompressionKind
+as_compression_kind_from_data (const guint8 *data, gsize len)
+{
+	static const guint8 magic_gzip[] = { 0x1f, 0x8b };
+	static const guint8 magic_zstd[] = { 0x28, 0xb5, 0x2f, 0xfd };
+	static const guint8 magic_xz[] = { 0xfd, '7', 'z', 'X', 'Z', 0x00 };
+
+	if ((len >= sizeof (magic_gzip)) && (memcmp (data, magic_gzip, sizeof (magic_gzip)) == 0))
+		return AS_COMPRESSION_KIND_GZIP;
+	if ((len >= sizeof (magic_zstd)) && (memcmp (data, magic_zstd, sizeof (magic_zstd)) == 0))
+		return AS_COMPRESSION_KIND_ZSTD;
+	if ((len >= sizeof (magic_xz)) && (memcmp (data, magic_xz, sizeof (magic_xz)) == 0))
+		return AS_COMPRESSION_KIND_XZ;
+
+	return AS_COMPRESSION_KIND_NONE;
+}
+
+/**
+ * as_compression_kind_is_supported:
+ * @kind: An #AsCompressionKind
+ *
+ * Returns: %TRUE if this build of AppStream can decompress data of type @kind.
+ */
+gboolean
+as_compression_kind_is_supported (AsCompressionKind kind)
+{
+	switch (kind) {
+	case AS_COMPRESSION_KIND_NONE:
+	case AS_COMPRESSION_KIND_GZIP:
+		return TRUE;
+#ifdef HAVE_ZSTD
+	case AS_COMPRESSION_KIND_ZSTD:
+		return TRUE;
+#endif
+#ifdef HAVE_LZMA
+	case AS_COMPRESSION_KIND_XZ:
+		return TRUE;
+#endif
+	default:
+		return FALSE;
+	}
+}
+
+/**
+ * as_compression_open_stream:
+ * @base_stream: The #GInputStream to read (possibly compressed) data from.
+ * @error: A #GError or %NULL
+ *
+ * Detect the compression format of @base_stream and return a stream
+ * that yields the decompressed data. Uncompressed data is passed through.
+ *
+ * Returns: (transfer full): A new #GInputStream, or %NULL on error.
+ */
+GInputStream*
+as_compression_open_stream (GInputStream *base_stream, GError **error)
+{
+	g_autoptr(GInputStream) stream = NULL;
+	g_autoptr(GConverter) conv = NULL;
+	const guint8 *peek;
+	gsize peek_len;
+	AsCompressionKind kind;
+
+	/* we need to look at the first few bytes without consuming them */
+	stream = g_buffered_input_stream_new (base_stream);
+	if (g_buffered_input_stream_fill (G_BUFFERED_INPUT_STREAM (stream), 6, NULL, error) < 0)
+		return NULL;
+	peek = g_buffered_input_stream_peek_buffer (G_BUFFERED_INPUT_STREAM (stream), &peek_len);
+
+	kind = as_compression_kind_from_data (peek, peek_len);
+	switch (kind) {
+	case AS_COMPRESSION_KIND_NONE:
+		return g_steal_pointer (&stream);
+	case AS_COMPRESSION_KIND_GZIP:
+		conv = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP));
+		break;
+	default:
+		conv = as_decompressor_new (kind);
+		break;
+	}
+
+	if (conv == NULL) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_SUPPORTED,
+			     "Unable to read %s compressed data: This AppStream build does not support the format.",
+			     (kind == AS_COMPRESSION_KIND_ZSTD)? "Zstandard" : "xz");
+		return NULL;
+	}
+
+	return g_converter_input_stream_new (stream, conv);
+}
+
+/**
+ * as_compression_open_file:
+ * @file: The #GFile to read.
+ * @error: A #GError or %NULL
+ *
+ * Open @file for reading, transparently decompressing it if needed.
+ *
+ * Returns: (transfer full): A new #GInputStream, or %NULL on error.
+ */
+GInputStream*
+as_compression_open_file (GFile *file, GError **error)
+{
+	g_autoptr(GFileInputStream) file_stream = NULL;
+
+	file_stream = g_file_read (file, NULL, error);
+	if (file_stream == NULL)
+		return NULL;
+
+	return as_compression_open_stream (G_INPUT_STREAM (file_stream), error);
+}
+
+/**
+ * as_compression_get_cache_kind:
+ *
+ * Returns: The compression format used for new cache files.
+ */
+AsCompressionKind
+as_compression_get_cache_kind (void)
+{
+#ifdef HAVE_ZSTD
+	return AS_COMPRESSION_KIND_ZSTD;
+#else
+	return AS_COMPRESSION_KIND_GZIP;
+#endif
+}
+
+/**
+ * as_compression_write_compressed:
+ * @stream: The #GOutputStream to write to.
+ * @kind: The compression format to use, only GZip and Zstandard are supported.
+ * @data: The data to compress.
+ * @len: Length of @data.
+ * @error: A #GError or %NULL
+ *
+ * Compress @data and write it to @stream.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+as_compression_write_compressed (GOutputStream *stream, AsCompressionKind kind, const guint8 *data, gsize len, GError **error)
+{
+	if (kind == AS_COMPRESSION_KIND_GZIP) {
+		g_autoptr(GZlibCompressor) compressor = NULL;
+		g_autoptr(GOutputStream) zout = NULL;
+
+		compressor = g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1);
+		zout = g_converter_output_stream_new (stream, G_CONVERTER (compressor));
+		g_filter_output_stream_set_close_base_stream (G_FILTER_OUTPUT_STREAM (zout), FALSE);
+		if (!g_output_stream_write_all (zout, data, len, NULL, NULL, error))
+			return FALSE;
+		return g_output_stream_close (zout, NULL, error);
+	}
+
+#ifdef HAVE_ZSTD
+	if (kind == AS_COMPRESSION_KIND_ZSTD) {
+		g_autofree guint8 *zdata = NULL;
+		gsize zlen;
+
+		zdata = g_malloc (ZSTD_compressBound (len));
+		zlen = ZSTD_compress (zdata, ZSTD_compressBound (len), data, len, ZSTD_CLEVEL_DEFAULT);
+		if (ZSTD_isError (zlen)) {
+			g_set_error (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_FAILED,
+				     "Unable to compress data: %s",
+				     ZSTD_getErrorName (zlen));
+			return FALSE;
+		}
+		return g_output_stream_write_all (stream, zdata, zlen, NULL, NULL, error);
+	}
+#endif
+
+	g_set_error_literal (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_NOT_SUPPORTED,
+			     "Unsupported compression format.");
+	return FALSE;
+}
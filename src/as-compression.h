@@ -0,0 +1,77 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2018 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 2.1
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 2.1 of the license, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if !defined (__APPSTREAM_H) && !defined (AS_COMPILATION)
+#error "Only <appstream.h> can be included directly."
+#endif
+
+#ifndef __AS_COMPRESSION_H
+#define __AS_COMPRESSION_H
+
+#include <gio/gio.h>
+#include "as-settings-private.h"
+
+G_BEGIN_DECLS
+#pragma GCC visibility push(hidden)
+
+/**
+ * AsCompressionKind:
+ * @AS_COMPRESSION_KIND_NONE:	No compression.
+ * @AS_COMPRESSION_KIND_GZIP:	GZip compression.
+ * @AS_COMPRESSION_KIND_ZSTD:	Zstandard compression.
+ * @AS_COMPRESSION_KIND_XZ:	xz (LZMA2) compression.
+ *
+ * Compression formats we know about.
+ **/
+typedef enum {
+	AS_COMPRESSION_KIND_NONE,
+	AS_COMPRESSION_KIND_GZIP,
+	AS_COMPRESSION_KIND_ZSTD,
+	AS_COMPRESSION_KIND_XZ,
+	/*< private >*/
+	AS_COMPRESSION_KIND_LAST
+} AsCompressionKind;
+
+AS_INTERNAL_VISIBLE
+AsCompressionKind	as_compression_kind_from_data (const guint8 *data,
+							gsize len);
+AS_INTERNAL_VISIBLE
+gboolean		as_compression_kind_is_supported (AsCompressionKind kind);
+
+AS_INTERNAL_VISIBLE
+GInputStream		*as_compression_open_stream (GInputStream *base_stream,
+							GError **error);
+AS_INTERNAL_VISIBLE
+GInputStream		*as_compression_open_file (GFile *file,
+						   GError **error);
+
+AS_INTERNAL_VISIBLE
+AsCompressionKind	as_compression_get_cache_kind (void);
+AS_INTERNAL_VISIBLE
+gboolean		as_compression_write_compressed (GOutputStream *stream,
+							 AsCompressionKind kind,
+							 const guint8 *data,
+							 gsize len,
+							 GError **error);
+
+#pragma GCC visibility pop
+G_END_DECLS
+
+#endif /* __AS_COMPRESSION_H */
@@ -28,6 +28,32 @@
 G_BEGIN_DECLS
 #pragma GCC visibility push(hidden)
 
+/**
+ * AsIconData:
+ *
+ * Compact form of an icon, kept by the component it belongs to
+ * until an #AsIcon object is needed.
+ */
+typedef struct {
+	AsIconKind	kind;
+	gchar		*name;
+	gchar		*url;
+	gchar		*filename;
+	guint		width;
+	guint		height;
+	guint		scale;
+} AsIconData;
+
+void			as_icon_data_init (AsIconData *data);
+void			as_icon_data_clear (AsIconData *data);
+void			as_icon_data_set_filename (AsIconData *data,
+						   const gchar *filename);
+gboolean		as_icon_data_set_from_variant (AsIconData *data,
+						       GVariant *variant);
+void			as_icon_data_set_from_icon (AsIconData *data,
+						    AsIcon *icon);
+AsIcon			*as_icon_new_from_data (AsIconData *data);
+
 gboolean		as_icon_load_from_xml (AsIcon *icon,
 						AsContext *ctx,
 						xmlNode *node,
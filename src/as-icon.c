@@ -25,20 +25,12 @@
  */
 
 #include "config.h"
+#include <string.h>
 
 #include "as-icon-private.h"
 #include "as-variant-cache.h"
 
-typedef struct
-{
-	AsIconKind	kind;
-	gchar		*name;
-	gchar		*url;
-	gchar		*filename;
-	guint		width;
-	guint		height;
-	guint		scale;
-} AsIconPrivate;
+typedef AsIconData AsIconPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (AsIcon, as_icon, G_TYPE_OBJECT)
 #define GET_PRIVATE(o) (as_icon_get_instance_private (o))
@@ -96,9 +88,7 @@ as_icon_finalize (GObject *object)
 	AsIcon *icon = AS_ICON (object);
 	AsIconPrivate *priv = GET_PRIVATE (icon);
 
-	g_free (priv->name);
-	g_free (priv->url);
-	g_free (priv->filename);
+	as_icon_data_clear (priv);
 
 	G_OBJECT_CLASS (as_icon_parent_class)->finalize (object);
 }
@@ -109,8 +99,7 @@ as_icon_finalize (GObject *object)
 static void
 as_icon_init (AsIcon *icon)
 {
-	AsIconPrivate *priv = GET_PRIVATE (icon);
-	priv->scale = 1;
+	as_icon_data_init (GET_PRIVATE (icon));
 }
 
 /**
@@ -249,15 +238,7 @@ as_icon_get_filename (AsIcon *icon)
 void
 as_icon_set_filename (AsIcon *icon, const gchar *filename)
 {
-	AsIconPrivate *priv = GET_PRIVATE (icon);
-	g_free (priv->filename);
-	priv->filename = g_strdup (filename);
-
-	/* invalidate URL */
-	if (priv->url != NULL) {
-		g_free (priv->url);
-		priv->url = NULL;
-	}
+	as_icon_data_set_filename (GET_PRIVATE (icon), filename);
 }
 
 /**
@@ -512,33 +493,134 @@ as_icon_to_variant (AsIcon *icon, GVariantBuilder *builder)
 gboolean
 as_icon_set_from_variant (AsIcon *icon, GVariant *variant)
 {
-	AsIconPrivate *priv = GET_PRIVATE (icon);
+	return as_icon_data_set_from_variant (GET_PRIVATE (icon), variant);
+}
+
+/**
+ * as_icon_data_init:
+ * @data: An #AsIconData.
+ *
+ * Initialize @data with the defaults of a new icon.
+ */
+void
+as_icon_data_init (AsIconData *data)
+{
+	memset (data, 0, sizeof (AsIconData));
+	data->scale = 1;
+}
+
+/**
+ * as_icon_data_clear:
+ * @data: An #AsIconData.
+ *
+ * Free the contents of @data.
+ */
+void
+as_icon_data_clear (AsIconData *data)
+{
+	g_free (data->name);
+	g_free (data->url);
+	g_free (data->filename);
+	data->name = NULL;
+	data->url = NULL;
+	data->filename = NULL;
+}
+
+/**
+ * as_icon_data_set_filename:
+ * @data: An #AsIconData.
+ * @filename: the new icon filename.
+ *
+ * Sets the icon absolute filename, see as_icon_set_filename().
+ */
+void
+as_icon_data_set_filename (AsIconData *data, const gchar *filename)
+{
+	g_free (data->filename);
+	data->filename = g_strdup (filename);
+
+	/* invalidate URL */
+	g_free (data->url);
+	data->url = NULL;
+}
+
+/**
+ * as_icon_data_set_from_variant:
+ * @data: An #AsIconData.
+ * @variant: The #GVariant to read from.
+ *
+ * Read the compact form of an icon from a #GVariant serialization.
+ */
+gboolean
+as_icon_data_set_from_variant (AsIconData *data, GVariant *variant)
+{
 	g_auto(GVariantDict) idict;
 	g_autoptr(GVariant) ival_var = NULL;
 
 	g_variant_dict_init (&idict, variant);
 
-	priv->kind = as_variant_get_dict_uint32 (&idict, "type");
+	data->kind = as_variant_get_dict_uint32 (&idict, "type");
 
-	priv->width = as_variant_get_dict_int32 (&idict, "width");
-	priv->height = as_variant_get_dict_int32 (&idict, "height");
-	priv->scale = as_variant_get_dict_int32 (&idict, "scale");
+	data->width = as_variant_get_dict_int32 (&idict, "width");
+	data->height = as_variant_get_dict_int32 (&idict, "height");
+	data->scale = as_variant_get_dict_int32 (&idict, "scale");
 
-	if (priv->kind == AS_ICON_KIND_STOCK) {
-		as_icon_set_name (icon,
-				  as_variant_get_dict_str (&idict, "name", &ival_var));
-	} else if (priv->kind == AS_ICON_KIND_REMOTE) {
-		as_icon_set_url (icon,
-				  as_variant_get_dict_str (&idict, "url", &ival_var));
+	if (data->kind == AS_ICON_KIND_STOCK) {
+		g_free (data->name);
+		data->name = g_strdup (as_variant_get_dict_str (&idict, "name", &ival_var));
+	} else if (data->kind == AS_ICON_KIND_REMOTE) {
+		g_free (data->url);
+		data->url = g_strdup (as_variant_get_dict_str (&idict, "url", &ival_var));
 	} else {
 		/* cached or local icon */
-		as_icon_set_filename (icon,
-					as_variant_get_dict_str (&idict, "filename", &ival_var));
+		as_icon_data_set_filename (data,
+					   as_variant_get_dict_str (&idict, "filename", &ival_var));
 	}
 
 	return TRUE;
 }
 
+/**
+ * as_icon_data_set_from_icon:
+ * @data: An initialized #AsIconData.
+ * @icon: an #AsIcon
+ *
+ * Copy the state of @icon into @data.
+ */
+void
+as_icon_data_set_from_icon (AsIconData *data, AsIcon *icon)
+{
+	AsIconPrivate *priv = GET_PRIVATE (icon);
+
+	as_icon_data_clear (data);
+	*data = *priv;
+	data->name = g_strdup (priv->name);
+	data->url = g_strdup (priv->url);
+	data->filename = g_strdup (priv->filename);
+}
+
+/**
+ * as_icon_new_from_data:
+ * @data: An #AsIconData.
+ *
+ * Creates a new #AsIcon, taking over the contents of @data.
+ *
+ * Returns: (transfer full): a #AsIcon
+ */
+AsIcon*
+as_icon_new_from_data (AsIconData *data)
+{
+	AsIcon *icon = as_icon_new ();
+	AsIconPrivate *priv = GET_PRIVATE (icon);
+
+	*priv = *data;
+	data->name = NULL;
+	data->url = NULL;
+	data->filename = NULL;
+
+	return icon;
+}
+
 /**
  * as_icon_new:
  *
@@ -28,6 +28,25 @@
 G_BEGIN_DECLS
 #pragma GCC visibility push(hidden)
 
+/**
+ * AsImageData:
+ *
+ * Compact form of an image, kept by the owner of the image
+ * until an #AsImage object is needed.
+ */
+typedef struct {
+	AsImageKind	kind;
+	gchar		*url;
+	guint		width;
+	guint		height;
+	gchar		*locale;
+} AsImageData;
+
+void		as_image_data_clear (AsImageData *data);
+gboolean	as_image_data_set_from_variant (AsImageData *data,
+						GVariant *variant);
+AsImage		*as_image_new_from_data (AsImageData *data);
+
 gboolean	as_image_load_from_xml (AsImage *image,
 					AsContext *ctx,
 					xmlNode *node,
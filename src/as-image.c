@@ -35,14 +35,7 @@
 #include "as-image-private.h"
 #include "as-variant-cache.h"
 
-typedef struct
-{
-	AsImageKind	kind;
-	gchar		*url;
-	guint		width;
-	guint		height;
-	gchar		*locale;
-} AsImagePrivate;
+typedef AsImageData AsImagePrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (AsImage, as_image, G_TYPE_OBJECT)
 #define GET_PRIVATE(o) (as_image_get_instance_private (o))
@@ -56,8 +49,7 @@ as_image_finalize (GObject *object)
 	AsImage *image = AS_IMAGE (object);
 	AsImagePrivate *priv = GET_PRIVATE (image);
 
-	g_free (priv->url);
-	g_free (priv->locale);
+	as_image_data_clear (priv);
 
 	G_OBJECT_CLASS (as_image_parent_class)->finalize (object);
 }
@@ -508,30 +500,80 @@ as_image_to_variant (AsImage *image, GVariantBuilder *builder)
 gboolean
 as_image_set_from_variant (AsImage *image, GVariant *variant)
 {
-	AsImagePrivate *priv = GET_PRIVATE (image);
+	return as_image_data_set_from_variant (GET_PRIVATE (image), variant);
+}
+
+/**
+ * as_image_data_clear:
+ * @data: An #AsImageData.
+ *
+ * Free the contents of @data.
+ */
+void
+as_image_data_clear (AsImageData *data)
+{
+	g_free (data->url);
+	g_free (data->locale);
+	data->url = NULL;
+	data->locale = NULL;
+}
+
+/**
+ * as_image_data_set_from_variant:
+ * @data: An #AsImageData.
+ * @variant: The #GVariant to read from.
+ *
+ * Read the compact form of an image from a #GVariant serialization.
+ */
+gboolean
+as_image_data_set_from_variant (AsImageData *data, GVariant *variant)
+{
 	g_auto(GVariantDict) dict;
 	GVariant *tmp;
 
 	g_variant_dict_init (&dict, variant);
 
 	/* kind */
-	priv->kind = as_variant_get_dict_uint32 (&dict, "type");
+	data->kind = as_variant_get_dict_uint32 (&dict, "type");
 
 	/* locale */
-	as_image_set_locale (image, as_variant_get_dict_mstr (&dict, "locale", &tmp));
+	g_free (data->locale);
+	data->locale = g_strdup (as_variant_get_dict_mstr (&dict, "locale", &tmp));
 	g_variant_unref (tmp);
 
 	/* url */
-	as_image_set_url (image, as_variant_get_dict_str (&dict, "url", &tmp));
+	g_free (data->url);
+	data->url = g_strdup (as_variant_get_dict_str (&dict, "url", &tmp));
 	g_variant_unref (tmp);
 
 	/* sizes */
-	priv->width = as_variant_get_dict_int32 (&dict, "width");
-	priv->height = as_variant_get_dict_int32 (&dict, "height");
+	data->width = as_variant_get_dict_int32 (&dict, "width");
+	data->height = as_variant_get_dict_int32 (&dict, "height");
 
 	return TRUE;
 }
 
+/**
+ * as_image_new_from_data:
+ * @data: An #AsImageData.
+ *
+ * Creates a new #AsImage, taking over the contents of @data.
+ *
+ * Returns: (transfer full): a #AsImage
+ */
+AsImage*
+as_image_new_from_data (AsImageData *data)
+{
+	AsImage *image = as_image_new ();
+	AsImagePrivate *priv = GET_PRIVATE (image);
+
+	*priv = *data;
+	data->url = NULL;
+	data->locale = NULL;
+
+	return image;
+}
+
 /**
  * as_image_class_init:
  **/
@@ -43,10 +43,29 @@
 #include "as-distro-details.h"
 #include "as-desktop-entry.h"
 #include "as-context.h"
+#include "as-compression.h"
 
 #include "as-xml.h"
 #include "as-yaml.h"
 
+/* collections with fewer components are serialized on the calling thread */
+#define AS_METADATA_PARALLEL_MIN_COMPONENTS	512
+/* number of consecutive components a worker thread serializes at once */
+#define AS_METADATA_RENDER_CHUNK_SIZE		32
+
+/* state of a streaming collection write */
+typedef struct
+{
+	AsFormatKind format;
+	gboolean write_header;
+	AsContext *context;
+	GOutputStream *stream;
+	GError *error;
+
+	xmlOutputBufferPtr xml_out;
+	yaml_emitter_t emitter;
+} AsMetadataWriter;
+
 typedef struct
 {
 	AsFormatVersion format_version;
@@ -62,11 +81,14 @@ typedef struct
 	AsParseFlags parse_flags;
 
 	GPtrArray *cpts;
+	AsMetadataWriter *writer;
 } AsMetadataPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (AsMetadata, as_metadata, G_TYPE_OBJECT)
 #define GET_PRIVATE(o) (as_metadata_get_instance_private (o))
 
+static void as_metadata_writer_free (AsMetadataWriter *writer);
+
 /**
  * as_format_kind_to_string:
  * @kind: the #AsFormatKind.
@@ -206,6 +228,8 @@ as_metadata_finalize (GObject *object)
 	g_free (priv->origin);
 	g_free (priv->media_baseurl);
 	g_free (priv->arch);
+	if (priv->writer != NULL)
+		as_metadata_writer_free (priv->writer);
 
 	G_OBJECT_CLASS (as_metadata_parent_class)->finalize (object);
 }
@@ -605,9 +629,7 @@ as_metadata_parse_file (AsMetadata *metad, GFile *file, AsFormatKind format, GEr
 {
 	g_autofree gchar *file_basename = NULL;
 	g_autoptr(GFileInfo) info = NULL;
-	g_autoptr(GInputStream) file_stream = NULL;
 	g_autoptr(GInputStream) stream_data = NULL;
-	g_autoptr(GConverter) conv = NULL;
 	g_autoptr(GString) asdata = NULL;
 	gssize len;
 	const gsize buffer_size = 1024 * 32;
@@ -632,6 +654,10 @@ as_metadata_parse_file (AsMetadata *metad, GFile *file, AsFormatKind format, GEr
 
 		if ((g_str_has_suffix (file_basename, ".yml.gz")) ||
 		    (g_str_has_suffix (file_basename, ".yaml.gz")) ||
+		    (g_str_has_suffix (file_basename, ".yml.zst")) ||
+		    (g_str_has_suffix (file_basename, ".yaml.zst")) ||
+		    (g_str_has_suffix (file_basename, ".yml.xz")) ||
+		    (g_str_has_suffix (file_basename, ".yaml.xz")) ||
 		    (g_str_has_suffix (file_basename, ".yml")) ||
 		    (g_str_has_suffix (file_basename, ".yaml"))) {
 			format = AS_FORMAT_KIND_YAML;
@@ -642,18 +668,11 @@ as_metadata_parse_file (AsMetadata *metad, GFile *file, AsFormatKind format, GEr
 			format = AS_FORMAT_KIND_DESKTOP_ENTRY;
 	}
 
-	file_stream = G_INPUT_STREAM (g_file_read (file, NULL, error));
-	if (file_stream == NULL)
+	/* compressed data is detected by its magic bytes and decompressed transparently */
+	stream_data = as_compression_open_file (file, error);
+	if (stream_data == NULL)
 		return;
 
-	if ((g_strcmp0 (content_type, "application/gzip") == 0) || (g_strcmp0 (content_type, "application/x-gzip") == 0)) {
-		/* decompress the GZip stream */
-		conv = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP));
-		stream_data = g_converter_input_stream_new (file_stream, conv);
-	} else {
-		stream_data = g_object_ref (file_stream);
-	}
-
 	/* Now read the whole file into memory to parse it.
 	 * On memory-contrained systems we could adjust the code later to allow parsing
 	 * a stream of data instead.
@@ -779,23 +798,57 @@ as_metadata_save_metainfo (AsMetadata *metad, const gchar *fname, AsFormatKind f
 }
 
 /**
- * as_metadata_save_collection_xml:
+ * as_metadata_save_collection:
  * @metad: An instance of #AsMetadata.
  * @fname: The filename for the new metadata file.
+ * @format: The format to save the data in (XML or YAML).
+ * @error: A #GError
  *
  * Serialize all #AsComponent instances to XML or YAML metadata and save
- * the data to a file.
+ * the data to a file. If @fname ends with ".gz", the data is compressed.
  * An existing file at the same location will be overridden.
  */
 void
 as_metadata_save_collection (AsMetadata *metad, const gchar *fname, AsFormatKind format, GError **error)
 {
-	g_autofree gchar *data = NULL;
+	AsMetadataPrivate *priv = GET_PRIVATE (metad);
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GFileOutputStream) fos = NULL;
+	g_autoptr(GCancellable) cancellable = NULL;
+	GError *tmp_error = NULL;
 
-	data = as_metadata_components_to_collection (metad, format, error);
-	if ((error != NULL) && (*error != NULL))
+	/* nothing to save */
+	if (priv->cpts->len == 0)
+		return;
+
+	/* the data is streamed to a temporary file which replaces the original once we are done */
+	file = g_file_new_for_path (fname);
+	fos = g_file_replace (file,
+				NULL,
+				FALSE,
+				G_FILE_CREATE_REPLACE_DESTINATION,
+				NULL,
+				&tmp_error);
+	if (tmp_error != NULL) {
+		g_propagate_error (error, tmp_error);
+		return;
+	}
+
+	if (!as_metadata_components_to_collection_stream (metad,
+							  G_OUTPUT_STREAM (fos),
+							  format,
+							  g_str_has_suffix (fname, ".gz"),
+							  &tmp_error)) {
+		/* closing a cancelled stream discards the incomplete data instead of replacing the file */
+		cancellable = g_cancellable_new ();
+		g_cancellable_cancel (cancellable);
+		g_output_stream_close (G_OUTPUT_STREAM (fos), cancellable, NULL);
+		g_propagate_error (error, tmp_error);
 		return;
-	as_metadata_save_data (metad, fname, data, error);
+	}
+
+	if (!g_output_stream_close (G_OUTPUT_STREAM (fos), NULL, &tmp_error))
+		g_propagate_error (error, tmp_error);
 }
 
 /**
@@ -966,6 +1019,21 @@ as_yamldata_write_handler (void *ptr, unsigned char *buffer, size_t size)
 	return 1;
 }
 
+/**
+ * as_metadata_yaml_emitter_init:
+ *
+ * Initialize @emitter with the settings we use for all collection data.
+ */
+static void
+as_metadata_yaml_emitter_init (yaml_emitter_t *emitter, yaml_write_handler_t *handler, void *data)
+{
+	yaml_emitter_initialize (emitter);
+	yaml_emitter_set_indent (emitter, 2);
+	yaml_emitter_set_unicode (emitter, TRUE);
+	yaml_emitter_set_width (emitter, 120);
+	yaml_emitter_set_output (emitter, handler, data);
+}
+
 /**
  * as_yamldata_serialize_to_collection:
  */
@@ -981,14 +1049,9 @@ as_metadata_yaml_serialize_to_collection (AsMetadata *metad, AsContext *context,
 	if (cpts->len == 0)
 		return NULL;
 
-	yaml_emitter_initialize (&emitter);
-	yaml_emitter_set_indent (&emitter, 2);
-	yaml_emitter_set_unicode (&emitter, TRUE);
-	yaml_emitter_set_width (&emitter, 120);
-
 	/* create a GString to receive the output the emitter generates */
 	out_data = g_string_new ("");
-	yaml_emitter_set_output (&emitter, as_yamldata_write_handler, out_data);
+	as_metadata_yaml_emitter_init (&emitter, as_yamldata_write_handler, out_data);
 
 	/* emit start event */
 	yaml_stream_start_event_initialize (&event, YAML_UTF8_ENCODING);
@@ -1076,6 +1139,561 @@ as_metadata_components_to_collection (AsMetadata *metad, AsFormatKind format, GE
 	return data;
 }
 
+/**
+ * as_metadata_writer_free:
+ */
+static void
+as_metadata_writer_free (AsMetadataWriter *writer)
+{
+	if (writer->xml_out != NULL)
+		xmlOutputBufferClose (writer->xml_out);
+	if (writer->format == AS_FORMAT_KIND_YAML)
+		yaml_emitter_delete (&writer->emitter);
+	if (writer->context != NULL)
+		g_object_unref (writer->context);
+	if (writer->stream != NULL)
+		g_object_unref (writer->stream);
+	if (writer->error != NULL)
+		g_error_free (writer->error);
+	g_free (writer);
+}
+
+/**
+ * as_metadata_writer_write:
+ *
+ * Write raw data to the output stream of @writer, remembering the
+ * first error that occurs.
+ */
+static gboolean
+as_metadata_writer_write (AsMetadataWriter *writer, const void *data, gsize len)
+{
+	if (writer->error != NULL)
+		return FALSE;
+	return g_output_stream_write_all (writer->stream, data, len, NULL, NULL, &writer->error);
+}
+
+/**
+ * as_metadata_writer_xml_write_cb:
+ *
+ * Output callback for libxml2.
+ */
+static int
+as_metadata_writer_xml_write_cb (void *context, const char *buffer, int len)
+{
+	AsMetadataWriter *writer = (AsMetadataWriter*) context;
+	if (!as_metadata_writer_write (writer, buffer, len))
+		return -1;
+	return len;
+}
+
+/**
+ * as_metadata_writer_yaml_write_cb:
+ *
+ * Output callback for libyaml.
+ */
+static int
+as_metadata_writer_yaml_write_cb (void *data, unsigned char *buffer, size_t size)
+{
+	AsMetadataWriter *writer = (AsMetadataWriter*) data;
+	return as_metadata_writer_write (writer, buffer, size)? 1 : 0;
+}
+
+/**
+ * as_metadata_writer_new_xml_doc:
+ *
+ * Create a document to serialize nodes with. The encoding needs to be set,
+ * otherwise libxml2 escapes all non-ASCII characters in attributes.
+ */
+static xmlDoc*
+as_metadata_writer_new_xml_doc (void)
+{
+	xmlDoc *doc;
+
+	doc = xmlNewDoc ((xmlChar*) NULL);
+	doc->encoding = xmlStrdup ((const xmlChar*) "utf-8");
+	return doc;
+}
+
+/**
+ * as_metadata_writer_xml_add_prop:
+ *
+ * Write an escaped XML attribute to the output of @writer.
+ */
+static void
+as_metadata_writer_xml_add_prop (AsMetadataWriter *writer, const gchar *name, const gchar *value)
+{
+	xmlBufferPtr buf;
+	xmlDoc *doc;
+
+	buf = xmlBufferCreate ();
+	doc = as_metadata_writer_new_xml_doc ();
+	xmlAttrSerializeTxtContent (buf, doc, NULL, (const xmlChar*) value);
+	xmlFreeDoc (doc);
+	xmlOutputBufferWriteString (writer->xml_out, " ");
+	xmlOutputBufferWriteString (writer->xml_out, name);
+	xmlOutputBufferWriteString (writer->xml_out, "=\"");
+	xmlOutputBufferWriteString (writer->xml_out, (const gchar*) xmlBufferContent (buf));
+	xmlOutputBufferWriteString (writer->xml_out, "\"");
+	xmlBufferFree (buf);
+}
+
+/**
+ * as_metadata_writer_xml_dump_component:
+ *
+ * Serialize @cpt as collection XML to @out.
+ */
+static void
+as_metadata_writer_xml_dump_component (xmlOutputBufferPtr out, AsContext *context, AsComponent *cpt, gboolean write_header)
+{
+	xmlDoc *doc;
+	xmlNode *node;
+
+	node = as_component_to_xml_node (cpt, context, NULL);
+	if (node == NULL)
+		return;
+	doc = as_metadata_writer_new_xml_doc ();
+	xmlDocSetRootElement (doc, node);
+
+	/* indent the same way libxml2 would if the node was a child of the root node */
+	if (write_header) {
+		xmlOutputBufferWriteString (out, "  ");
+		xmlNodeDumpOutput (out, doc, node, 1, 1, "utf-8");
+	} else {
+		xmlNodeDumpOutput (out, doc, node, 0, 1, "utf-8");
+	}
+	xmlOutputBufferWriteString (out, "\n");
+	xmlFreeDoc (doc);
+}
+
+/**
+ * as_metadata_xml_gstring_write_cb:
+ *
+ * Output callback for libxml2, storing the data in a #GString.
+ */
+static int
+as_metadata_xml_gstring_write_cb (void *context, const char *buffer, int len)
+{
+	g_string_append_len ((GString*) context, buffer, len);
+	return len;
+}
+
+/**
+ * as_metadata_writer_render_component:
+ *
+ * Serialize @cpt into @out exactly the way it would be written
+ * to the stream of @writer, using @context instead of the context of
+ * the writer. This function is thread-safe, as long as @cpt and @context
+ * are not accessed from elsewhere at the same time.
+ */
+static void
+as_metadata_writer_render_component (AsMetadataWriter *writer, AsContext *context, AsComponent *cpt, GString *out)
+{
+	if (writer->format == AS_FORMAT_KIND_XML) {
+		xmlOutputBufferPtr xml_out;
+
+		xml_out = xmlOutputBufferCreateIO (as_metadata_xml_gstring_write_cb, NULL, out, NULL);
+		as_metadata_writer_xml_dump_component (xml_out, context, cpt, writer->write_header);
+		xmlOutputBufferClose (xml_out);
+	} else {
+		yaml_emitter_t emitter;
+		yaml_event_t event;
+
+		/* documents don't depend on each other, so we can emit each one into a stream of its own
+		 * and just leave out the stream end marker */
+		as_metadata_yaml_emitter_init (&emitter, as_yamldata_write_handler, out);
+		yaml_stream_start_event_initialize (&event, YAML_UTF8_ENCODING);
+		if (yaml_emitter_emit (&emitter, &event))
+			as_component_emit_yaml (cpt, context, &emitter);
+		yaml_emitter_flush (&emitter);
+		yaml_emitter_delete (&emitter);
+	}
+}
+
+/* a batch of components which is serialized in parallel */
+typedef struct
+{
+	AsMetadataWriter *writer;
+	GPtrArray *cpts;
+	guint offset;
+	GString **results;
+
+	guint pending;
+	GMutex mutex;
+	GCond cond;
+} AsMetadataRenderBatch;
+
+/* a consecutive range of components of a batch, serialized by a single worker */
+typedef struct
+{
+	AsContext *context;
+	guint start;
+	guint len;
+} AsMetadataRenderChunk;
+
+/**
+ * as_metadata_render_batch_worker:
+ */
+static void
+as_metadata_render_batch_worker (gpointer data, gpointer user_data)
+{
+	AsMetadataRenderChunk *chunk = (AsMetadataRenderChunk*) data;
+	AsMetadataRenderBatch *batch = (AsMetadataRenderBatch*) user_data;
+	guint i;
+
+	/* every chunk renders into slots of its own, the batch mutex publishes them */
+	for (i = chunk->start; i < chunk->start + chunk->len; i++) {
+		GString *out = g_string_sized_new (4096);
+		as_metadata_writer_render_component (batch->writer,
+						     chunk->context,
+						     AS_COMPONENT (g_ptr_array_index (batch->cpts, i)),
+						     out);
+		batch->results[i - batch->offset] = out;
+	}
+
+	g_mutex_lock (&batch->mutex);
+	batch->pending--;
+	if (batch->pending == 0)
+		g_cond_signal (&batch->cond);
+	g_mutex_unlock (&batch->mutex);
+}
+
+/**
+ * as_metadata_writer_add_parallel:
+ *
+ * Serialize the first @n_cpts components of @cpts on @n_threads worker threads
+ * and write the results to the stream of @writer in their original order.
+ * Components are processed in batches, so memory usage stays bounded.
+ */
+static gboolean
+as_metadata_writer_add_parallel (AsMetadata *metad, AsMetadataWriter *writer, GPtrArray *cpts, guint n_cpts, guint n_threads, GError **error)
+{
+	AsMetadataRenderBatch batch;
+	AsMetadataRenderChunk *chunks;
+	GThreadPool *pool;
+	guint batch_size;
+	guint i;
+	gboolean ret = TRUE;
+
+	/* libxml2 needs to set up its global state before it is used from multiple threads */
+	xmlInitParser ();
+
+	/* anything pending needs to hit the stream before we append data to it directly */
+	if (writer->format == AS_FORMAT_KIND_XML)
+		xmlOutputBufferFlush (writer->xml_out);
+	else
+		yaml_emitter_flush (&writer->emitter);
+	if (writer->error != NULL)
+		return as_metadata_writer_take_error (writer, error);
+
+	pool = g_thread_pool_new (as_metadata_render_batch_worker,
+				  &batch,
+				  n_threads,
+				  TRUE,
+				  NULL);
+	if (pool == NULL) {
+		g_set_error_literal (error,
+				     AS_METADATA_ERROR,
+				     AS_METADATA_ERROR_FAILED,
+				     "Unable to create thread pool for serialization.");
+		return FALSE;
+	}
+
+	/* every chunk of a batch gets a context of its own, the serialization code may modify it */
+	chunks = g_new0 (AsMetadataRenderChunk, n_threads);
+	for (i = 0; i < n_threads; i++)
+		chunks[i].context = as_metadata_new_context (metad, AS_FORMAT_STYLE_COLLECTION, NULL);
+
+	batch_size = n_threads * AS_METADATA_RENDER_CHUNK_SIZE;
+	batch.writer = writer;
+	batch.cpts = cpts;
+	batch.results = g_new0 (GString*, batch_size);
+	g_mutex_init (&batch.mutex);
+	g_cond_init (&batch.cond);
+
+	for (batch.offset = 0; batch.offset < n_cpts; batch.offset += batch_size) {
+		guint len = MIN (batch_size, n_cpts - batch.offset);
+		guint n_chunks = (len + AS_METADATA_RENDER_CHUNK_SIZE - 1) / AS_METADATA_RENDER_CHUNK_SIZE;
+
+		batch.pending = n_chunks;
+		for (i = 0; i < n_chunks; i++) {
+			chunks[i].start = batch.offset + i * AS_METADATA_RENDER_CHUNK_SIZE;
+			chunks[i].len = MIN (AS_METADATA_RENDER_CHUNK_SIZE, batch.offset + len - chunks[i].start);
+			g_thread_pool_push (pool, &chunks[i], NULL);
+		}
+
+		g_mutex_lock (&batch.mutex);
+		while (batch.pending > 0)
+			g_cond_wait (&batch.cond, &batch.mutex);
+		g_mutex_unlock (&batch.mutex);
+
+		/* write the results in order */
+		for (i = 0; i < len; i++) {
+			if (ret)
+				ret = as_metadata_writer_write (writer, batch.results[i]->str, batch.results[i]->len);
+			g_string_free (batch.results[i], TRUE);
+			batch.results[i] = NULL;
+		}
+		if (!ret)
+			break;
+	}
+
+	g_thread_pool_free (pool, FALSE, TRUE);
+	g_mutex_clear (&batch.mutex);
+	g_cond_clear (&batch.cond);
+	g_free (batch.results);
+	for (i = 0; i < n_threads; i++)
+		g_object_unref (chunks[i].context);
+	g_free (chunks);
+
+	return as_metadata_writer_take_error (writer, error);
+}
+
+/**
+ * as_metadata_writer_take_error:
+ *
+ * Forward a write error of @writer to @error.
+ *
+ * Returns: %TRUE if there was no error.
+ */
+static gboolean
+as_metadata_writer_take_error (AsMetadataWriter *writer, GError **error)
+{
+	if (writer->error == NULL)
+		return TRUE;
+	g_propagate_error (error, writer->error);
+	writer->error = NULL;
+	return FALSE;
+}
+
+/**
+ * as_metadata_collection_stream_begin:
+ * @metad: An instance of #AsMetadata.
+ * @stream: The #GOutputStream to write the collection data to.
+ * @format: The format to serialize the data to (XML or YAML).
+ * @compress: %TRUE to gzip-compress the data.
+ * @error: A #GError
+ *
+ * Start writing a new AppStream collection to @stream.
+ * Components can then be added to the collection one at a time using
+ * as_metadata_collection_stream_add(), they are serialized and written
+ * immediately, so the memory required does not depend on the size of the collection.
+ * The collection has to be completed with as_metadata_collection_stream_end().
+ *
+ * The output is identical to what as_metadata_components_to_collection() would
+ * generate for the same components.
+ *
+ * Returns: %TRUE on success.
+ *
+ * Since: 0.12.3
+ */
+gboolean
+as_metadata_collection_stream_begin (AsMetadata *metad, GOutputStream *stream, AsFormatKind format, gboolean compress, GError **error)
+{
+	AsMetadataPrivate *priv = GET_PRIVATE (metad);
+	AsMetadataWriter *writer;
+
+	g_return_val_if_fail (format == AS_FORMAT_KIND_XML || format == AS_FORMAT_KIND_YAML, FALSE);
+	g_return_val_if_fail (priv->writer == NULL, FALSE);
+
+	writer = g_new0 (AsMetadataWriter, 1);
+	writer->format = format;
+	writer->write_header = priv->write_header;
+	writer->context = as_metadata_new_context (metad, AS_FORMAT_STYLE_COLLECTION, NULL);
+
+	if (compress) {
+		g_autoptr(GZlibCompressor) compressor = NULL;
+
+		compressor = g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1);
+		writer->stream = g_converter_output_stream_new (stream, G_CONVERTER (compressor));
+		g_filter_output_stream_set_close_base_stream (G_FILTER_OUTPUT_STREAM (writer->stream), FALSE);
+	} else {
+		writer->stream = g_object_ref (stream);
+	}
+	priv->writer = writer;
+
+	if (format == AS_FORMAT_KIND_XML) {
+		writer->xml_out = xmlOutputBufferCreateIO (as_metadata_writer_xml_write_cb, NULL, writer, NULL);
+		if (!writer->write_header)
+			return TRUE;
+
+		/* the document header and root node are written by hand, since we never have the full tree */
+		xmlOutputBufferWriteString (writer->xml_out, "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n<components");
+		as_metadata_writer_xml_add_prop (writer, "version", as_format_version_to_string (priv->format_version));
+		if (priv->origin != NULL)
+			as_metadata_writer_xml_add_prop (writer, "origin", priv->origin);
+		if (priv->arch != NULL)
+			as_metadata_writer_xml_add_prop (writer, "architecture", priv->arch);
+		xmlOutputBufferWriteString (writer->xml_out, ">\n");
+	} else {
+		yaml_event_t event;
+
+		as_metadata_yaml_emitter_init (&writer->emitter, as_metadata_writer_yaml_write_cb, writer);
+
+		yaml_stream_start_event_initialize (&event, YAML_UTF8_ENCODING);
+		if (!yaml_emitter_emit (&writer->emitter, &event)) {
+			g_set_error_literal (error,
+					     AS_METADATA_ERROR,
+					     AS_METADATA_ERROR_FAILED,
+					     "Emission of YAML event failed.");
+			as_metadata_writer_free (writer);
+			priv->writer = NULL;
+			return FALSE;
+		}
+
+		if (writer->write_header)
+			as_yamldata_write_header (writer->context, &writer->emitter);
+	}
+
+	if (!as_metadata_writer_take_error (writer, error)) {
+		as_metadata_writer_free (writer);
+		priv->writer = NULL;
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * as_metadata_collection_stream_add:
+ * @metad: An instance of #AsMetadata.
+ * @cpt: The #AsComponent to write.
+ * @error: A #GError
+ *
+ * Serialize @cpt and append it to the collection started with
+ * as_metadata_collection_stream_begin().
+ * The component is not added to the list of components of @metad.
+ *
+ * Returns: %TRUE on success.
+ *
+ * Since: 0.12.3
+ */
+gboolean
+as_metadata_collection_stream_add (AsMetadata *metad, AsComponent *cpt, GError **error)
+{
+	AsMetadataPrivate *priv = GET_PRIVATE (metad);
+	AsMetadataWriter *writer = priv->writer;
+
+	g_return_val_if_fail (writer != NULL, FALSE);
+
+	if (writer->format == AS_FORMAT_KIND_XML)
+		as_metadata_writer_xml_dump_component (writer->xml_out, writer->context, cpt, writer->write_header);
+	else
+		as_component_emit_yaml (cpt, writer->context, &writer->emitter);
+
+	return as_metadata_writer_take_error (writer, error);
+}
+
+/**
+ * as_metadata_collection_stream_end:
+ * @metad: An instance of #AsMetadata.
+ * @error: A #GError
+ *
+ * Finish the collection started with as_metadata_collection_stream_begin()
+ * and flush all pending data to the output stream.
+ * The output stream itself is not closed.
+ *
+ * Returns: %TRUE on success.
+ *
+ * Since: 0.12.3
+ */
+gboolean
+as_metadata_collection_stream_end (AsMetadata *metad, GError **error)
+{
+	AsMetadataPrivate *priv = GET_PRIVATE (metad);
+	AsMetadataWriter *writer = priv->writer;
+	gboolean ret;
+
+	g_return_val_if_fail (writer != NULL, FALSE);
+	priv->writer = NULL;
+
+	if (writer->format == AS_FORMAT_KIND_XML) {
+		if (writer->write_header)
+			xmlOutputBufferWriteString (writer->xml_out, "</components>\n");
+		xmlOutputBufferClose (writer->xml_out);
+		writer->xml_out = NULL;
+	} else {
+		yaml_event_t event;
+
+		yaml_stream_end_event_initialize (&event);
+		if (!yaml_emitter_emit (&writer->emitter, &event) && writer->error == NULL)
+			g_set_error_literal (&writer->error,
+					     AS_METADATA_ERROR,
+					     AS_METADATA_ERROR_FAILED,
+					     "Emission of YAML event failed.");
+		yaml_emitter_flush (&writer->emitter);
+	}
+
+	/* finish the compressed stream, or just push out buffered data */
+	if (writer->error == NULL) {
+		if (G_IS_CONVERTER_OUTPUT_STREAM (writer->stream))
+			g_output_stream_close (writer->stream, NULL, &writer->error);
+		else
+			g_output_stream_flush (writer->stream, NULL, &writer->error);
+	}
+
+	ret = as_metadata_writer_take_error (writer, error);
+	as_metadata_writer_free (writer);
+
+	return ret;
+}
+
+/**
+ * as_metadata_components_to_collection_stream:
+ * @metad: An instance of #AsMetadata.
+ * @stream: The #GOutputStream to write the collection data to.
+ * @format: The format to serialize the data to (XML or YAML).
+ * @compress: %TRUE to gzip-compress the data.
+ * @error: A #GError
+ *
+ * Serialize all #AsComponent instances into AppStream collection
+ * metadata and write it to @stream.
+ * Large collections are serialized on multiple threads if more than one
+ * CPU is available, the output is identical to serializing the components
+ * one by one.
+ *
+ * Returns: %TRUE on success.
+ *
+ * Since: 0.12.3
+ */
+gboolean
+as_metadata_components_to_collection_stream (AsMetadata *metad, GOutputStream *stream, AsFormatKind format, gboolean compress, GError **error)
+{
+	AsMetadataPrivate *priv = GET_PRIVATE (metad);
+	guint n_threads;
+	guint i = 0;
+
+	if (!as_metadata_collection_stream_begin (metad, stream, format, compress, error))
+		return FALSE;
+
+	/* serialize large collections on all available CPUs, for small ones
+	 * setting up the threads costs more than it saves */
+	n_threads = MIN (g_get_num_processors (), 16);
+	if (n_threads > 1 && priv->cpts->len >= AS_METADATA_PARALLEL_MIN_COMPONENTS) {
+		/* the YAML emitter state at the end of the stream depends on the last document,
+		 * so that one always goes through the emitter of the writer */
+		i = priv->cpts->len;
+		if (format == AS_FORMAT_KIND_YAML)
+			i--;
+
+		if (!as_metadata_writer_add_parallel (metad, priv->writer, priv->cpts, i, n_threads, error)) {
+			as_metadata_writer_free (priv->writer);
+			priv->writer = NULL;
+			return FALSE;
+		}
+	}
+
+	for (; i < priv->cpts->len; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (priv->cpts, i));
+		if (!as_metadata_collection_stream_add (metad, cpt, error)) {
+			as_metadata_writer_free (priv->writer);
+			priv->writer = NULL;
+			return FALSE;
+		}
+	}
+
+	return as_metadata_collection_stream_end (metad, error);
+}
+
 /**
  * as_metadata_add_component:
  *
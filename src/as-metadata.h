@@ -191,6 +191,22 @@ void			as_metadata_save_collection (AsMetadata *metad,
 							AsFormatKind format,
 							GError **error);
 
+gboolean		as_metadata_components_to_collection_stream (AsMetadata *metad,
+									GOutputStream *stream,
+									AsFormatKind format,
+									gboolean compress,
+									GError **error);
+gboolean		as_metadata_collection_stream_begin (AsMetadata *metad,
+								GOutputStream *stream,
+								AsFormatKind format,
+								gboolean compress,
+								GError **error);
+gboolean		as_metadata_collection_stream_add (AsMetadata *metad,
+								AsComponent *cpt,
+								GError **error);
+gboolean		as_metadata_collection_stream_end (AsMetadata *metad,
+								GError **error);
+
 AsFormatVersion		as_metadata_get_format_version (AsMetadata *metad);
 void			as_metadata_set_format_version (AsMetadata *metad,
 							AsFormatVersion version);
@@ -29,16 +29,54 @@ G_BEGIN_DECLS
 
 time_t			as_pool_get_cache_age (AsPool *pool);
 
+AS_INTERNAL_VISIBLE
+void			as_pool_override_locations (AsPool *pool,
+						const gchar *cache_dir,
+						const gchar *metainfo_dir,
+						const gchar *apps_dir);
+
+AS_INTERNAL_VISIBLE
+gboolean		as_pool_needs_reload (AsPool *pool);
+
 AS_INTERNAL_VISIBLE
 void			as_cache_file_save (const gchar *fname,
 						const gchar *locale,
 						GPtrArray *cpts,
 						GError **error);
 
+AS_INTERNAL_VISIBLE
+void			as_cache_files_save (const gchar *cache_dir,
+						const gchar * const *locales,
+						GPtrArray *cpts,
+						gchar **checksum_out,
+						GError **error);
+
 AS_INTERNAL_VISIBLE
 GPtrArray		*as_cache_file_read (const gchar *fname,
 						GError **error);
 
+AS_INTERNAL_VISIBLE
+GPtrArray		*as_cache_parse_files (GPtrArray *files,
+						GHashTable *skip_files,
+						const gchar *locale,
+						AsComponentField fields,
+						const gchar *cache_fname,
+						const gchar *fallback_fname,
+						guint *n_parsed);
+
+AS_INTERNAL_VISIBLE
+gboolean		as_cache_shards_update (const gchar *cache_dir,
+						GPtrArray *files,
+						const gchar * const *locales,
+						guint *n_parsed,
+						GError **error);
+
+AS_INTERNAL_VISIBLE
+GPtrArray		*as_cache_shards_read (const gchar *cache_dir,
+						const gchar *locale,
+						AsComponentField fields,
+						GError **error);
+
 #pragma GCC visibility pop
 G_END_DECLS
 
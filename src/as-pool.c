@@ -45,7 +45,9 @@
 #include <gio/gio.h>
 #include <glib/gi18n-lib.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "as-utils.h"
@@ -55,14 +57,19 @@
 #include "as-settings-private.h"
 #include "as-distro-extras.h"
 #include "as-stemmer.h"
+#include "as-compression.h"
 #include "as-variant-cache.h"
 
 #include "as-metadata.h"
 
 typedef struct
 {
+	AsPool *parent;
 	GHashTable *cpt_table;
 	GHashTable *known_cids;
+	GHashTable *addons_index; /* extended AsComponent -> GPtrArray of addons */
+	GHashTable *extends_index; /* addon AsComponent -> GPtrArray of extended components */
+	GHashTable *attached_addons; /* extended AsComponent -> GPtrArray of addons we added to it */
 	gchar *screenshot_service_url;
 	gchar *locale;
 	gchar *current_arch;
@@ -75,11 +82,15 @@ typedef struct
 
 	AsPoolFlags flags;
 	AsCacheFlags cache_flags;
+	AsComponentField load_fields;
 	gboolean prefer_local_metainfo;
 
 	gchar *sys_cache_path;
 	gchar *user_cache_path;
+	gchar *metainfo_dir;
+	gchar *apps_dir;
 	time_t cache_ctime;
+	time_t load_time;
 } AsPoolPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (AsPool, as_pool, G_TYPE_OBJECT)
@@ -110,6 +121,11 @@ static gchar *APPLICATIONS_DIR = "/usr/share/applications";
 static gchar *METAINFO_DIR = "/usr/share/metainfo";
 
 static void as_pool_add_metadata_location_internal (AsPool *pool, const gchar *directory, gboolean add_root);
+static gboolean as_cache_shards_have_locales (const gchar *cache_dir, const gchar * const *locales);
+static GPtrArray *as_cache_file_read_internal (const gchar *fname,
+					       gboolean validate,
+					       AsComponentField fields,
+					       GError **error);
 
 /**
  * as_pool_check_cache_ctime:
@@ -126,13 +142,28 @@ as_pool_check_cache_ctime (AsPool *pool)
 	struct stat cache_sbuf;
 	g_autofree gchar *fname = NULL;
 
-	fname = g_strdup_printf ("%s/%s.gvz", priv->sys_cache_path, priv->locale);
+	fname = g_build_filename (priv->sys_cache_path, "shards.gvz", NULL);
 	if (stat (fname, &cache_sbuf) < 0)
 		priv->cache_ctime = 0;
 	else
 		priv->cache_ctime = cache_sbuf.st_ctime;
 }
 
+/**
+ * as_pool_graph_index_new:
+ *
+ * Create a table mapping an #AsComponent to a #GPtrArray of
+ * related components, for the addon graph.
+ */
+static GHashTable*
+as_pool_graph_index_new (void)
+{
+	return g_hash_table_new_full (g_direct_hash,
+				      g_direct_equal,
+				      g_object_unref,
+				      (GDestroyNotify) g_ptr_array_unref);
+}
+
 /**
  * as_pool_init:
  **/
@@ -158,18 +189,32 @@ as_pool_init (AsPool *pool)
 						  g_free,
 						  NULL);
 
+	/* the addon graph, rebuilt whenever the pool is loaded */
+	priv->addons_index = as_pool_graph_index_new ();
+	priv->extends_index = as_pool_graph_index_new ();
+	priv->attached_addons = as_pool_graph_index_new ();
+
 	priv->xml_dirs = g_ptr_array_new_with_free_func (g_free);
 	priv->yaml_dirs = g_ptr_array_new_with_free_func (g_free);
 	priv->icon_dirs = g_ptr_array_new_with_free_func (g_free);
 
+	/* descriptions are large and rarely displayed, so only load them on demand.
+	 * Deferred data is copied out of the cache, so this doesn't keep the cache buffer alive. */
+	priv->load_fields = AS_COMPONENT_FIELD_ALL & ~AS_COMPONENT_FIELD_DESCRIPTION;
+
 	/* set the current architecture */
 	priv->current_arch = as_get_current_arch ();
 
 	/* set up our localized search-term greylist */
 	priv->term_greylist = g_strsplit (AS_SEARCH_GREYLIST_STR, ";", -1);
 
-	/* system-wide cache locations */
+	/* system-wide and per-user cache locations */
 	priv->sys_cache_path = g_strdup (AS_APPSTREAM_CACHE_PATH);
+	priv->user_cache_path = g_build_filename (g_get_user_cache_dir (), "appstream", NULL);
+
+	/* locations of locally installed metainfo and .desktop files */
+	priv->metainfo_dir = g_strdup (METAINFO_DIR);
+	priv->apps_dir = g_strdup (APPLICATIONS_DIR);
 
 	if (as_utils_is_root ()) {
 		/* users umask shouldn't interfere with us creating new files when we are root */
@@ -215,8 +260,13 @@ as_pool_finalize (GObject *object)
 	AsPoolPrivate *priv = GET_PRIVATE (pool);
 
 	g_free (priv->screenshot_service_url);
+	if (priv->parent != NULL)
+		g_object_unref (priv->parent);
 	g_hash_table_unref (priv->cpt_table);
 	g_hash_table_unref (priv->known_cids);
+	g_hash_table_unref (priv->addons_index);
+	g_hash_table_unref (priv->extends_index);
+	g_hash_table_unref (priv->attached_addons);
 
 	g_ptr_array_unref (priv->xml_dirs);
 	g_ptr_array_unref (priv->yaml_dirs);
@@ -229,6 +279,8 @@ as_pool_finalize (GObject *object)
 
 	g_free (priv->sys_cache_path);
 	g_free (priv->user_cache_path);
+	g_free (priv->metainfo_dir);
+	g_free (priv->apps_dir);
 
 	G_OBJECT_CLASS (as_pool_parent_class)->finalize (object);
 }
@@ -243,6 +295,148 @@ as_pool_class_init (AsPoolClass *klass)
 	object_class->finalize = as_pool_finalize;
 }
 
+/**
+ * AsPoolIter:
+ *
+ * Iterator over all components visible in a pool. For overlay pools, these
+ * are the components of the pool itself and all components of its parent
+ * pools which have not been replaced by a component with the same data-ID.
+ */
+typedef struct {
+	AsPool		*pool;
+	AsPool		*current;
+	GHashTableIter	ht_iter;
+} AsPoolIter;
+
+/**
+ * as_pool_iter_init:
+ * @iter: An uninitialized #AsPoolIter
+ * @pool: An instance of #AsPool
+ *
+ * Initialize @iter to run over all components visible in @pool.
+ * The pools must not be modified while the iterator is in use.
+ */
+static void
+as_pool_iter_init (AsPoolIter *iter, AsPool *pool)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	iter->pool = pool;
+	iter->current = pool;
+	g_hash_table_iter_init (&iter->ht_iter, priv->cpt_table);
+}
+
+/**
+ * as_pool_iter_next:
+ * @iter: An #AsPoolIter
+ * @cpt: (out) (transfer none): Location for the next component.
+ *
+ * Advance @iter to the next visible component.
+ *
+ * Returns: %FALSE if the end of the components was reached.
+ */
+static gboolean
+as_pool_iter_next (AsPoolIter *iter, AsComponent **cpt)
+{
+	gpointer key;
+	gpointer value;
+
+	while (TRUE) {
+		AsPoolPrivate *cpriv;
+
+		while (g_hash_table_iter_next (&iter->ht_iter, &key, &value)) {
+			AsPool *child;
+			gboolean replaced = FALSE;
+
+			/* skip components overridden by one of the pools layered on top */
+			for (child = iter->pool; child != iter->current; child = GET_PRIVATE (child)->parent) {
+				if (g_hash_table_contains (GET_PRIVATE (child)->cpt_table, key)) {
+					replaced = TRUE;
+					break;
+				}
+			}
+			if (replaced)
+				continue;
+
+			*cpt = AS_COMPONENT (value);
+			return TRUE;
+		}
+
+		cpriv = GET_PRIVATE (iter->current);
+		if (cpriv->parent == NULL)
+			return FALSE;
+		iter->current = cpriv->parent;
+		g_hash_table_iter_init (&iter->ht_iter, GET_PRIVATE (iter->current)->cpt_table);
+	}
+}
+
+/**
+ * as_pool_lookup_component:
+ * @pool: An instance of #AsPool
+ * @cdid: The data-ID of the component.
+ *
+ * Find the component with data-ID @cdid in @pool or one of its parents.
+ *
+ * Returns: (transfer none) (nullable): The component.
+ */
+static AsComponent*
+as_pool_lookup_component (AsPool *pool, const gchar *cdid)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	AsComponent *cpt;
+
+	cpt = g_hash_table_lookup (priv->cpt_table, cdid);
+	if ((cpt == NULL) && (priv->parent != NULL))
+		return as_pool_lookup_component (priv->parent, cdid);
+	return cpt;
+}
+
+/**
+ * as_pool_has_known_cid:
+ *
+ * Returns: %TRUE if a component with ID @cid was added to @pool or one of its parents.
+ */
+static gboolean
+as_pool_has_known_cid (AsPool *pool, const gchar *cid)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	if (g_hash_table_contains (priv->known_cids, cid))
+		return TRUE;
+	if (priv->parent != NULL)
+		return as_pool_has_known_cid (priv->parent, cid);
+	return FALSE;
+}
+
+/**
+ * as_pool_claim_component:
+ * @pool: An instance of #AsPool
+ * @cpt: A component visible in @pool.
+ *
+ * Get a version of @cpt which may be modified. Components of parent pools
+ * are never changed, so if @cpt belongs to a parent, a copy of it is added
+ * to @pool which replaces the original.
+ *
+ * Returns: (transfer none): The component owned by @pool.
+ */
+static AsComponent*
+as_pool_claim_component (AsPool *pool, AsComponent *cpt)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	AsComponent *copy;
+
+	if (g_hash_table_lookup (priv->cpt_table, as_component_get_data_id (cpt)) == cpt)
+		return cpt;
+
+	copy = as_component_clone (cpt);
+	g_hash_table_replace (priv->cpt_table,
+			      g_strdup (as_component_get_data_id (copy)),
+			      copy);
+	g_debug ("Copied '%s' from parent pool for modification.", as_component_get_data_id (copy));
+
+	return copy;
+}
+
 /**
  * as_pool_add_component_internal:
  * @pool: An instance of #AsPool
@@ -274,7 +468,7 @@ as_pool_add_component_internal (AsPool *pool, AsComponent *cpt, gboolean pedanti
 
 	new_cpt_orig_kind = as_component_get_origin_kind (cpt);
 
-	existing_cpt = g_hash_table_lookup (priv->cpt_table, cdid);
+	existing_cpt = as_pool_lookup_component (pool, cdid);
 	if (as_component_get_origin_kind (cpt) == AS_ORIGIN_KIND_DESKTOP_ENTRY) {
 		g_autofree gchar *tmp_cdid = NULL;
 
@@ -284,7 +478,7 @@ as_pool_add_component_internal (AsPool *pool, AsComponent *cpt, gboolean pedanti
 		 */
 		if (existing_cpt == NULL) {
 			tmp_cdid = g_strdup_printf ("%s.desktop", cdid);
-			existing_cpt = g_hash_table_lookup (priv->cpt_table, tmp_cdid);
+			existing_cpt = as_pool_lookup_component (pool, tmp_cdid);
 		}
 
 		if (existing_cpt != NULL) {
@@ -331,6 +525,7 @@ as_pool_add_component_internal (AsPool *pool, AsComponent *cpt, gboolean pedanti
 			g_debug ("Replaced '%s' with data from metainfo and desktop-entry file.", cdid);
 			return TRUE;
 		} else {
+			existing_cpt = as_pool_claim_component (pool, existing_cpt);
 			as_component_set_priority (existing_cpt, -G_MAXINT);
 		}
 	}
@@ -339,6 +534,7 @@ as_pool_add_component_internal (AsPool *pool, AsComponent *cpt, gboolean pedanti
 	if (new_cpt_orig_kind == AS_ORIGIN_KIND_DESKTOP_ENTRY) {
 		if (existing_cpt_orig_kind == AS_ORIGIN_KIND_METAINFO) {
 			/* do an append-merge to ensure the metainfo file has an icon */
+			existing_cpt = as_pool_claim_component (pool, existing_cpt);
 			as_component_merge_with_mode (existing_cpt,
 						      cpt,
 						      AS_MERGE_KIND_APPEND);
@@ -372,6 +568,7 @@ as_pool_add_component_internal (AsPool *pool, AsComponent *cpt, gboolean pedanti
 							as_component_get_id (cpt));
 		for (i = 0; i < matches->len; i++) {
 			AsComponent *match = AS_COMPONENT (g_ptr_array_index (matches, i));
+			match = as_pool_claim_component (pool, match);
 			as_component_merge (match, cpt);
 		}
 
@@ -392,6 +589,7 @@ as_pool_add_component_internal (AsPool *pool, AsComponent *cpt, gboolean pedanti
 			GPtrArray *bundles;
 			/* propagate bundle information to existing component */
 			bundles = as_component_get_bundles (cpt);
+			existing_cpt = as_pool_claim_component (pool, existing_cpt);
 			as_component_set_bundles_array (existing_cpt, bundles);
 			return TRUE;
 		}
@@ -454,42 +652,171 @@ as_pool_add_component (AsPool *pool, AsComponent *cpt, GError **error)
 }
 
 /**
- * as_pool_update_addon_info:
+ * as_pool_graph_link:
+ *
+ * Add @item to the array stored for @key in @index, unless it is already there.
+ *
+ * Returns: %TRUE if a new link was added.
+ */
+static gboolean
+as_pool_graph_link (GHashTable *index, AsComponent *key, AsComponent *item)
+{
+	GPtrArray *items;
+
+	items = g_hash_table_lookup (index, key);
+	if (items == NULL) {
+		items = g_ptr_array_new_with_free_func (g_object_unref);
+		g_hash_table_insert (index, g_object_ref (key), items);
+	} else {
+		guint i;
+		for (i = 0; i < items->len; i++) {
+			if (g_ptr_array_index (items, i) == (gpointer) item)
+				return FALSE;
+		}
+	}
+
+	g_ptr_array_add (items, g_object_ref (item));
+	return TRUE;
+}
+
+/**
+ * as_pool_addon_can_extend:
+ *
+ * Check whether an addon of @bundle_kind may extend @extended_cpt.
+ * Addons only extend system components of their own bundling system, so this
+ * matches the "system/os/<bundle>/<cid>" data-ID lookup used originally,
+ * without building a data-ID for every "extends" entry.
+ */
+static gboolean
+as_pool_addon_can_extend (AsBundleKind bundle_kind, AsComponent *extended_cpt)
+{
+	if (as_component_get_scope (extended_cpt) != AS_COMPONENT_SCOPE_SYSTEM)
+		return FALSE;
+	if (as_utils_get_component_bundle_kind (extended_cpt) != bundle_kind)
+		return FALSE;
+
+	/* packages share the "os" origin in their data-ID */
+	return bundle_kind == AS_BUNDLE_KIND_PACKAGE ||
+		g_strcmp0 (as_component_get_origin (extended_cpt), "os") == 0;
+}
+
+/**
+ * as_pool_detach_addons:
  *
- * Populate the "extensions" property of an #AsComponent, using the
- * "extends" information from other components.
+ * Remove all addons the pool added to its components before, leaving
+ * the ones which were added by the user alone.
  */
 static void
-as_pool_update_addon_info (AsPool *pool, AsComponent *cpt)
+as_pool_detach_addons (AsPool *pool)
 {
-	guint i;
-	GPtrArray *extends;
+	GHashTableIter iter;
+	gpointer key, value;
 	AsPoolPrivate *priv = GET_PRIVATE (pool);
 
-	extends = as_component_get_extends (cpt);
-	if ((extends == NULL) || (extends->len == 0))
-		return;
+	g_hash_table_iter_init (&iter, priv->attached_addons);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		guint i;
+		GPtrArray *addons = (GPtrArray*) value;
+
+		for (i = 0; i < addons->len; i++)
+			as_component_remove_addon (AS_COMPONENT (key), AS_COMPONENT (g_ptr_array_index (addons, i)));
+	}
+	g_hash_table_remove_all (priv->attached_addons);
+}
 
-	for (i = 0; i < extends->len; i++) {
-		AsComponent *extended_cpt;
-		g_autofree gchar *extended_cdid = NULL;
-		const gchar *extended_cid = (const gchar*) g_ptr_array_index (extends, i);
+/**
+ * as_pool_update_addon_info:
+ *
+ * Build the addon graph of the pool, linking every extended component
+ * with all of its addons (and vice versa), and populate the "addons"
+ * property of each #AsComponent from it.
+ * This needs to run once after all components have been added to the pool.
+ */
+static void
+as_pool_update_addon_info (AsPool *pool)
+{
+	g_autoptr(GHashTable) cid_index = NULL;
+	AsPoolIter iter;
+	AsComponent *cpt;
+	AsComponent *addon;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
 
-		extended_cdid = as_utils_build_data_id (AS_COMPONENT_SCOPE_SYSTEM, "os",
-							as_utils_get_component_bundle_kind (cpt),
-							extended_cid);
+	/* the graph is the single source of truth for the addons the pool adds */
+	as_pool_detach_addons (pool);
+	g_hash_table_remove_all (priv->addons_index);
+	g_hash_table_remove_all (priv->extends_index);
+
+	/* index components by their ID, so we don't need to construct data-IDs for lookups */
+	cid_index = g_hash_table_new_full (g_str_hash,
+					   g_str_equal,
+					   NULL,
+					   (GDestroyNotify) g_ptr_array_unref);
+	as_pool_iter_init (&iter, pool);
+	while (as_pool_iter_next (&iter, &cpt)) {
+		GPtrArray *cpts;
+
+		if (as_component_get_id (cpt) == NULL)
+			continue;
 
-		extended_cpt = g_hash_table_lookup (priv->cpt_table, extended_cdid);
-		if (extended_cpt == NULL) {
-			g_debug ("%s extends %s, but %s was not found.", as_component_get_data_id (cpt), extended_cdid, extended_cdid);
-			return;
+		cpts = g_hash_table_lookup (cid_index, as_component_get_id (cpt));
+		if (cpts == NULL) {
+			cpts = g_ptr_array_new ();
+			g_hash_table_insert (cid_index, (gchar*) as_component_get_id (cpt), cpts);
 		}
+		g_ptr_array_add (cpts, cpt);
+	}
+
+	as_pool_iter_init (&iter, pool);
+	while (as_pool_iter_next (&iter, &addon)) {
+		guint i;
+		GPtrArray *extends;
+		AsBundleKind bundle_kind;
 
-		/* don't act if we already have addons */
-		if (as_component_get_addons (extended_cpt)->len > 0)
+		extends = as_component_get_extends (addon);
+		if ((extends == NULL) || (extends->len == 0))
 			continue;
+		bundle_kind = as_utils_get_component_bundle_kind (addon);
+
+		for (i = 0; i < extends->len; i++) {
+			guint j;
+			GPtrArray *candidates;
+			gboolean found = FALSE;
+			const gchar *extended_cid = (const gchar*) g_ptr_array_index (extends, i);
+
+			candidates = g_hash_table_lookup (cid_index, extended_cid);
+			for (j = 0; candidates != NULL && j < candidates->len; j++) {
+				guint k;
+				GPtrArray *cpt_addons;
+				gboolean known = FALSE;
+				AsComponent *extended_cpt = AS_COMPONENT (g_ptr_array_index (candidates, j));
+
+				if (!as_pool_addon_can_extend (bundle_kind, extended_cpt))
+					continue;
+				found = TRUE;
 
-		as_component_add_addon (extended_cpt, cpt);
+				if (!as_pool_graph_link (priv->addons_index, extended_cpt, addon))
+					continue;
+				as_pool_graph_link (priv->extends_index, addon, extended_cpt);
+
+				/* we must not modify components of a parent pool */
+				if (g_hash_table_lookup (priv->cpt_table, as_component_get_data_id (extended_cpt)) != extended_cpt)
+					continue;
+
+				/* the addon may have been added by the user already */
+				cpt_addons = as_component_get_addons (extended_cpt);
+				for (k = 0; k < cpt_addons->len && !known; k++)
+					known = g_ptr_array_index (cpt_addons, k) == (gpointer) addon;
+				if (known)
+					continue;
+
+				as_component_add_addon (extended_cpt, addon);
+				as_pool_graph_link (priv->attached_addons, extended_cpt, addon);
+			}
+
+			if (!found)
+				g_debug ("%s extends %s, but %s was not found.",
+					 as_component_get_data_id (addon), extended_cid, extended_cid);
+		}
 	}
 }
 
@@ -542,9 +869,6 @@ as_pool_refine_data (AsPool *pool)
 					priv->screenshot_service_url,
 					priv->icon_dirs);
 
-		/* set the "addons" information */
-		as_pool_update_addon_info (pool, cpt);
-
 		/* add to results table */
 		g_hash_table_insert (refined_cpts,
 					g_strdup (cdid),
@@ -555,6 +879,9 @@ as_pool_refine_data (AsPool *pool)
 	g_hash_table_unref (priv->cpt_table);
 	priv->cpt_table = refined_cpts;
 
+	/* set the "addons" information */
+	as_pool_update_addon_info (pool);
+
 	return ret;
 }
 
@@ -584,45 +911,52 @@ as_pool_clear (AsPool *pool)
 						  g_str_equal,
 						  g_free,
 						  NULL);
+
+	/* addon graph */
+	g_hash_table_remove_all (priv->addons_index);
+	g_hash_table_remove_all (priv->extends_index);
+	g_hash_table_unref (priv->attached_addons);
+	priv->attached_addons = as_pool_graph_index_new ();
 }
 
 /**
  * as_pool_ctime_newer:
  *
- * Returns: %TRUE if ctime of file is newer than the cached time.
+ * Returns: %TRUE if ctime of file is newer than @since.
  */
 static gboolean
-as_pool_ctime_newer (AsPool *pool, const gchar *dir)
+as_pool_ctime_newer (const gchar *dir, time_t since)
 {
 	struct stat sb;
-	AsPoolPrivate *priv = GET_PRIVATE (pool);
 
 	if (stat (dir, &sb) < 0)
 		return FALSE;
 
-	if (sb.st_ctime > priv->cache_ctime)
+	if (sb.st_ctime > since)
 		return TRUE;
 
 	return FALSE;
 }
 
 /**
- * as_pool_appstream_data_changed:
+ * as_pool_metadata_changed_since:
+ *
+ * Returns: %TRUE if any of the collection metadata locations changed after @since.
  */
 static gboolean
-as_pool_metadata_changed (AsPool *pool)
+as_pool_metadata_changed_since (AsPool *pool, time_t since)
 {
 	AsPoolPrivate *priv = GET_PRIVATE (pool);
 	guint i;
 
 	for (i = 0; i < priv->xml_dirs->len; i++) {
 		const gchar *dir = (const gchar*) g_ptr_array_index (priv->xml_dirs, i);
-		if (as_pool_ctime_newer (pool, dir))
+		if (as_pool_ctime_newer (dir, since))
 			return TRUE;
 	}
 	for (i = 0; i < priv->yaml_dirs->len; i++) {
 		const gchar *dir = (const gchar*) g_ptr_array_index (priv->yaml_dirs, i);
-		if (as_pool_ctime_newer (pool, dir))
+		if (as_pool_ctime_newer (dir, since))
 			return TRUE;
 	}
 
@@ -630,50 +964,76 @@ as_pool_metadata_changed (AsPool *pool)
 }
 
 /**
- * as_pool_load_collection_data:
- *
- * Load fresh metadata from AppStream collection data directories.
+ * as_pool_appstream_data_changed:
  */
 static gboolean
-as_pool_load_collection_data (AsPool *pool, gboolean refresh, GError **error)
+as_pool_metadata_changed (AsPool *pool)
 {
-	GPtrArray *cpts;
-	g_autoptr(GPtrArray) merge_cpts = NULL;
-	guint i;
-	gboolean ret;
-	g_autoptr(AsMetadata) metad = NULL;
-	g_autoptr(GPtrArray) mdata_files = NULL;
-	GError *tmp_error = NULL;
 	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	return as_pool_metadata_changed_since (pool, priv->cache_ctime);
+}
 
-	/* see if we can use the caches */
-	if (!refresh) {
-		if (!as_pool_metadata_changed (pool)) {
-			g_autofree gchar *fname = NULL;
-			g_debug ("Caches are up to date.");
+/**
+ * as_pool_needs_reload:
+ * @pool: An instance of #AsPool.
+ *
+ * Check whether any of the data sources this pool was loaded from
+ * via as_pool_load() has changed since, including the system cache.
+ * This is useful for long-lived processes that keep a pool around.
+ *
+ * Returns: %TRUE if the pool should be loaded again.
+ */
+gboolean
+as_pool_needs_reload (AsPool *pool)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	time_t since;
 
-			if (as_flags_contains (priv->cache_flags, AS_CACHE_FLAG_USE_SYSTEM)) {
-				g_debug ("Using cached data.");
+	/* we were never loaded from the system locations */
+	if (priv->load_time == 0)
+		return FALSE;
 
-				fname = g_strdup_printf ("%s/%s.gvz", priv->sys_cache_path, priv->locale);
-				if (g_file_test (fname, G_FILE_TEST_EXISTS)) {
-					return as_pool_load_cache_file (pool, fname, error);
-				} else {
-					g_debug ("Missing cache for language '%s', attempting to load fresh data.", priv->locale);
-				}
-			} else {
-				g_debug ("Not using system cache.");
-			}
-		}
+	/* we use the same ctime check which tells whether the cache is outdated,
+	 * just relative to when we were loaded instead of when the cache was written.
+	 * The ctime only has a granularity of seconds, so changes that happened in
+	 * the second we started loading might not have been seen */
+	since = priv->load_time - 1;
+
+	if (as_pool_metadata_changed_since (pool, since))
+		return TRUE;
+
+	if (as_flags_contains (priv->cache_flags, AS_CACHE_FLAG_USE_SYSTEM)) {
+		g_autofree gchar *fname = NULL;
+
+		fname = g_build_filename (priv->sys_cache_path, "shards.gvz", NULL);
+		if (as_pool_ctime_newer (fname, since))
+			return TRUE;
 	}
 
-	/* prepare metadata parser */
-	metad = as_metadata_new ();
-	as_metadata_set_format_style (metad, AS_FORMAT_STYLE_COLLECTION);
-	as_metadata_set_locale (metad, priv->locale);
+	if (as_flags_contains (priv->flags, AS_POOL_FLAG_READ_METAINFO) &&
+	    as_pool_ctime_newer (priv->metainfo_dir, since))
+		return TRUE;
+	if (as_flags_contains (priv->flags, AS_POOL_FLAG_READ_DESKTOP_FILES) &&
+	    as_pool_ctime_newer (priv->apps_dir, since))
+		return TRUE;
+
+	return FALSE;
+}
+
+/**
+ * as_pool_find_collection_files:
+ *
+ * Find all AppStream collection metadata files in the watched locations.
+ *
+ * Returns: (transfer container) (element-type utf8): The found files.
+ */
+static GPtrArray*
+as_pool_find_collection_files (AsPool *pool)
+{
+	GPtrArray *mdata_files;
+	guint i;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
 
-	/* find AppStream metadata */
-	ret = TRUE;
 	mdata_files = g_ptr_array_new_with_free_func (g_free);
 
 	/* find XML data */
@@ -718,48 +1078,22 @@ as_pool_load_collection_data (AsPool *pool, gboolean refresh, GError **error)
 		}
 	}
 
-	/* parse the found data */
-	for (i = 0; i < mdata_files->len; i++) {
-		g_autoptr(GFile) infile = NULL;
-		const gchar *fname;
-
-		fname = (const gchar*) g_ptr_array_index (mdata_files, i);
-		g_debug ("Reading: %s", fname);
-
-		infile = g_file_new_for_path (fname);
-		if (!g_file_query_exists (infile, NULL)) {
-			g_warning ("Metadata file '%s' does not exist.", fname);
-			continue;
-		}
-
-		as_metadata_parse_file (metad,
-					infile,
-					AS_FORMAT_KIND_UNKNOWN,
-					&tmp_error);
-		if (tmp_error != NULL) {
-			g_debug ("WARNING: %s", tmp_error->message);
-			g_error_free (tmp_error);
-			tmp_error = NULL;
-			ret = FALSE;
-
-			if (error != NULL) {
-				if (*error == NULL)
-					g_set_error_literal (error,
-							     AS_POOL_ERROR,
-							     AS_POOL_ERROR_FAILED,
-							     fname);
-				else
-					g_prefix_error (error, "%s, ", fname);
-			}
-		}
-	}
+	return mdata_files;
+}
 
-	/* finalize error message, if we had errors */
-	if ((error != NULL) && (*error != NULL))
-		g_prefix_error (error, "%s ", _("Metadata files have errors:"));
+/**
+ * as_pool_add_collection_components:
+ *
+ * Add components from collection metadata to the pool, applying
+ * merge components last.
+ */
+static void
+as_pool_add_collection_components (AsPool *pool, GPtrArray *cpts)
+{
+	g_autoptr(GPtrArray) merge_cpts = NULL;
+	GError *tmp_error = NULL;
+	guint i;
 
-	/* add found components to the metadata pool */
-	cpts = as_metadata_get_components (metad);
 	merge_cpts = g_ptr_array_new ();
 	for (i = 0; i < cpts->len; i++) {
 		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (cpts, i));
@@ -793,68 +1127,63 @@ as_pool_load_collection_data (AsPool *pool, gboolean refresh, GError **error)
 			tmp_error = NULL;
 		}
 	}
-
-	return ret;
 }
 
 /**
- * as_pool_load_metainfo_data:
+ * as_pool_load_collection_data:
  *
- * Load fresh metadata from metainfo files.
+ * Load fresh metadata from AppStream collection data directories.
  */
-static void
-as_pool_load_metainfo_data (AsPool *pool)
+static gboolean
+as_pool_load_collection_data (AsPool *pool, GError **error)
 {
 	guint i;
+	gboolean ret;
 	g_autoptr(AsMetadata) metad = NULL;
-	g_autoptr(GPtrArray) mi_files = NULL;
-	GPtrArray *cpts;
-	GError *error = NULL;
+	g_autoptr(GPtrArray) mdata_files = NULL;
+	GError *tmp_error = NULL;
 	AsPoolPrivate *priv = GET_PRIVATE (pool);
 
+	/* see if we can use the caches */
+	if (!as_pool_metadata_changed (pool)) {
+		g_debug ("Caches are up to date.");
+
+		if (as_flags_contains (priv->cache_flags, AS_CACHE_FLAG_USE_SYSTEM)) {
+			g_autoptr(GPtrArray) cpts = NULL;
+			g_autoptr(GError) cache_error = NULL;
+
+			g_debug ("Using cached data.");
+			cpts = as_cache_shards_read (priv->sys_cache_path, priv->locale, priv->load_fields, &cache_error);
+			if (cpts != NULL) {
+				as_pool_add_collection_components (pool, cpts);
+				return TRUE;
+			}
+
+			/* the cache might not contain data for our language yet */
+			g_debug ("Unable to use cache for language '%s', attempting to load fresh data: %s",
+				 priv->locale, cache_error->message);
+		} else {
+			g_debug ("Not using system cache.");
+		}
+	}
+
 	/* prepare metadata parser */
 	metad = as_metadata_new ();
+	as_metadata_set_format_style (metad, AS_FORMAT_STYLE_COLLECTION);
 	as_metadata_set_locale (metad, priv->locale);
 
-	/* find metainfo files */
-	g_debug ("Searching for data in: %s", METAINFO_DIR);
-	mi_files = as_utils_find_files_matching (METAINFO_DIR, "*.xml", FALSE, NULL);
-	if (mi_files == NULL) {
-		g_debug ("Unable find metainfo files.");
-		return;
-	}
+	/* find AppStream metadata */
+	ret = TRUE;
+	mdata_files = as_pool_find_collection_files (pool);
 
 	/* parse the found data */
-	for (i = 0; i < mi_files->len; i++) {
+	for (i = 0; i < mdata_files->len; i++) {
 		g_autoptr(GFile) infile = NULL;
-		const gchar *fname = (const gchar*) g_ptr_array_index (mi_files, i);
-
-		if (!priv->prefer_local_metainfo) {
-			g_autofree gchar *mi_cid = NULL;
-
-			mi_cid = g_path_get_basename (fname);
-			if (g_str_has_suffix (mi_cid, ".metainfo.xml"))
-				mi_cid[strlen (mi_cid) - 13] = '\0';
-			if (g_str_has_suffix (mi_cid, ".appdata.xml")) {
-				g_autofree gchar *mi_cid_desktop = NULL;
-				mi_cid[strlen (mi_cid) - 12] = '\0';
-
-				mi_cid_desktop = g_strdup_printf ("%s.desktop", mi_cid);
-				/* check with .desktop suffix too */
-				if (g_hash_table_contains (priv->known_cids, mi_cid_desktop)) {
-					g_debug ("Skipped: %s (already known)", fname);
-					continue;
-				}
-			}
-
-			/* quickly check if we know the component already */
-			if (g_hash_table_contains (priv->known_cids, mi_cid)) {
-				g_debug ("Skipped: %s (already known)", fname);
-				continue;
-			}
-		}
+		const gchar *fname;
 
+		fname = (const gchar*) g_ptr_array_index (mdata_files, i);
 		g_debug ("Reading: %s", fname);
+
 		infile = g_file_new_for_path (fname);
 		if (!g_file_query_exists (infile, NULL)) {
 			g_warning ("Metadata file '%s' does not exist.", fname);
@@ -864,20 +1193,96 @@ as_pool_load_metainfo_data (AsPool *pool)
 		as_metadata_parse_file (metad,
 					infile,
 					AS_FORMAT_KIND_UNKNOWN,
-					&error);
-		if (error != NULL) {
-			g_debug ("WARNING: %s", error->message);
-			g_error_free (error);
-			error = NULL;
+					&tmp_error);
+		if (tmp_error != NULL) {
+			g_debug ("WARNING: %s", tmp_error->message);
+			g_error_free (tmp_error);
+			tmp_error = NULL;
+			ret = FALSE;
+
+			if (error != NULL) {
+				if (*error == NULL)
+					g_set_error_literal (error,
+							     AS_POOL_ERROR,
+							     AS_POOL_ERROR_FAILED,
+							     fname);
+				else
+					g_prefix_error (error, "%s, ", fname);
+			}
+		}
+	}
+
+	/* finalize error message, if we had errors */
+	if ((error != NULL) && (*error != NULL))
+		g_prefix_error (error, "%s ", _("Metadata files have errors:"));
+
+	/* add found components to the metadata pool */
+	as_pool_add_collection_components (pool, as_metadata_get_components (metad));
+
+	return ret;
+}
+
+/**
+ * as_pool_get_local_cache_fnames:
+ *
+ * Find the cache files to use for local metadata of the given kind.
+ * We update the system cache if we are allowed to, and use a per-user
+ * cache otherwise, which is initialized from the system cache.
+ */
+static void
+as_pool_get_local_cache_fnames (AsPool *pool, const gchar *kind, gchar **cache_fname, gchar **fallback_fname)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	g_autofree gchar *basename = NULL;
+
+	*cache_fname = NULL;
+	*fallback_fname = NULL;
+	basename = g_strdup_printf ("%s-%s.gvz", kind, priv->locale);
+
+	if (as_flags_contains (priv->cache_flags, AS_CACHE_FLAG_USE_SYSTEM)) {
+		g_autofree gchar *sys_fname = g_build_filename (priv->sys_cache_path, basename, NULL);
+
+		if (as_utils_is_writable (priv->sys_cache_path)) {
+			*cache_fname = g_steal_pointer (&sys_fname);
+			return;
 		}
+		*fallback_fname = g_steal_pointer (&sys_fname);
+	}
+
+	if (as_flags_contains (priv->cache_flags, AS_CACHE_FLAG_USE_USER)) {
+		if (g_mkdir_with_parents (priv->user_cache_path, 0755) == 0)
+			*cache_fname = g_build_filename (priv->user_cache_path, basename, NULL);
 	}
+}
+
+/**
+ * as_pool_load_local_files:
+ *
+ * Load components from local metainfo or .desktop files, using the
+ * per-file cache, and add them to the pool. Files in @skip_files are
+ * not loaded, but stay in the cache.
+ */
+static void
+as_pool_load_local_files (AsPool *pool, GPtrArray *files, GHashTable *skip_files, const gchar *kind)
+{
+	g_autoptr(GPtrArray) cpts = NULL;
+	g_autofree gchar *cache_fname = NULL;
+	g_autofree gchar *fallback_fname = NULL;
+	GError *error = NULL;
+	guint n_parsed = 0;
+	guint i;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	as_pool_get_local_cache_fnames (pool, kind, &cache_fname, &fallback_fname);
+	cpts = as_cache_parse_files (files, skip_files, priv->locale, priv->load_fields, cache_fname, fallback_fname, &n_parsed);
+	g_debug ("Loaded %u of %u %s files, %u of which needed to be parsed.",
+		 files->len - g_hash_table_size (skip_files), files->len, kind, n_parsed);
 
 	/* add found components to the metadata pool */
-	cpts = as_metadata_get_components (metad);
 	for (i = 0; i < cpts->len; i++) {
 		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (cpts, i));
 
-		/* We only read metainfo files from system directories */
+		/* We only read metainfo and .desktop files from system directories at time */
 		as_component_set_scope (cpt, AS_COMPONENT_SCOPE_SYSTEM);
 
 		as_pool_add_component_internal (pool, cpt, FALSE, &error);
@@ -889,36 +1294,84 @@ as_pool_load_metainfo_data (AsPool *pool)
 	}
 }
 
+/**
+ * as_pool_load_metainfo_data:
+ *
+ * Load metadata from metainfo files.
+ */
+static void
+as_pool_load_metainfo_data (AsPool *pool)
+{
+	guint i;
+	g_autoptr(GPtrArray) mi_files = NULL;
+	g_autoptr(GHashTable) skip_files = NULL;
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	/* find metainfo files */
+	g_debug ("Searching for data in: %s", priv->metainfo_dir);
+	mi_files = as_utils_find_files_matching (priv->metainfo_dir, "*.xml", FALSE, NULL);
+	if (mi_files == NULL) {
+		g_debug ("Unable find metainfo files.");
+		return;
+	}
+
+	/* find the files we don't need to read */
+	skip_files = g_hash_table_new (g_str_hash, g_str_equal);
+	for (i = 0; i < mi_files->len; i++) {
+		const gchar *fname = (const gchar*) g_ptr_array_index (mi_files, i);
+
+		if (!priv->prefer_local_metainfo) {
+			g_autofree gchar *mi_cid = NULL;
+
+			mi_cid = g_path_get_basename (fname);
+			if (g_str_has_suffix (mi_cid, ".metainfo.xml"))
+				mi_cid[strlen (mi_cid) - 13] = '\0';
+			if (g_str_has_suffix (mi_cid, ".appdata.xml")) {
+				g_autofree gchar *mi_cid_desktop = NULL;
+				mi_cid[strlen (mi_cid) - 12] = '\0';
+
+				mi_cid_desktop = g_strdup_printf ("%s.desktop", mi_cid);
+				/* check with .desktop suffix too */
+				if (as_pool_has_known_cid (pool, mi_cid_desktop)) {
+					g_hash_table_add (skip_files, (gpointer) fname);
+					continue;
+				}
+			}
+
+			/* quickly check if we know the component already */
+			if (as_pool_has_known_cid (pool, mi_cid))
+				g_hash_table_add (skip_files, (gpointer) fname);
+		}
+	}
+
+	/* the cache covers all files, so it is the same no matter what we skip */
+	as_pool_load_local_files (pool, mi_files, skip_files, "metainfo");
+}
+
 /**
  * as_pool_load_desktop_entries:
  *
- * Load fresh metadata from .desktop files.
+ * Load metadata from .desktop files.
  */
 static void
 as_pool_load_desktop_entries (AsPool *pool)
 {
 	guint i;
-	g_autoptr(AsMetadata) metad = NULL;
 	g_autoptr(GPtrArray) de_files = NULL;
-	GPtrArray *cpts;
-	GError *error = NULL;
+	g_autoptr(GHashTable) skip_files = NULL;
 	AsPoolPrivate *priv = GET_PRIVATE (pool);
 
-	/* prepare metadata parser */
-	metad = as_metadata_new ();
-	as_metadata_set_locale (metad, priv->locale);
-
 	/* find .desktop files */
-	g_debug ("Searching for data in: %s", APPLICATIONS_DIR);
-	de_files = as_utils_find_files_matching (APPLICATIONS_DIR, "*.desktop", FALSE, NULL);
+	g_debug ("Searching for data in: %s", priv->apps_dir);
+	de_files = as_utils_find_files_matching (priv->apps_dir, "*.desktop", FALSE, NULL);
 	if (de_files == NULL) {
 		g_debug ("Unable find .desktop files.");
 		return;
 	}
 
-	/* parse the found data */
+	/* find the files we don't need to read */
+	skip_files = g_hash_table_new (g_str_hash, g_str_equal);
 	for (i = 0; i < de_files->len; i++) {
-		g_autoptr(GFile) infile = NULL;
 		const gchar *fname = (const gchar*) g_ptr_array_index (de_files, i);
 
 		/* quickly check if we know the component already
@@ -927,59 +1380,28 @@ as_pool_load_desktop_entries (AsPool *pool)
 		if (!as_flags_contains (priv->flags, AS_POOL_FLAG_READ_METAINFO)) {
 			g_autofree gchar *de_cid = g_path_get_basename (fname);
 
-			if (g_hash_table_contains (priv->known_cids, de_cid)) {
-				g_debug ("Skipped: %s (already known)", fname);
+			if (as_pool_has_known_cid (pool, de_cid)) {
+				g_hash_table_add (skip_files, (gpointer) fname);
 				continue;
 			}
 
 			/* check without .desktop suffix too */
 			if (g_str_has_suffix (de_cid, ".desktop")) {
 				de_cid[strlen (de_cid) - 8] = '\0';
-				if (g_hash_table_contains (priv->known_cids, de_cid)) {
-					g_debug ("Skipped: %s (already known)", fname);
-					continue;
-				}
+				if (as_pool_has_known_cid (pool, de_cid))
+					g_hash_table_add (skip_files, (gpointer) fname);
 			}
 		}
-
-		g_debug ("Reading: %s", fname);
-		infile = g_file_new_for_path (fname);
-		if (!g_file_query_exists (infile, NULL)) {
-			g_warning ("Metadata file '%s' does not exist.", fname);
-			continue;
-		}
-
-		as_metadata_parse_file (metad,
-					infile,
-					AS_FORMAT_KIND_UNKNOWN,
-					&error);
-		if (error != NULL) {
-			g_debug ("WARNING: %s", error->message);
-			g_error_free (error);
-			error = NULL;
-		}
 	}
 
-	/* add found components to the metadata pool */
-	cpts = as_metadata_get_components (metad);
-	for (i = 0; i < cpts->len; i++) {
-		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (cpts, i));
-
-		/* We only read .desktop files from system directories at time */
-		as_component_set_scope (cpt, AS_COMPONENT_SCOPE_SYSTEM);
-
-		as_pool_add_component_internal (pool, cpt, FALSE, &error);
-		if (error != NULL) {
-			g_debug ("Metadata ignored: %s", error->message);
-			g_error_free (error);
-			error = NULL;
-		}
-	}
+	/* the cache covers all files, so it is the same no matter what we skip */
+	as_pool_load_local_files (pool, de_files, skip_files, "desktop");
 }
 
 /**
  * as_pool_load:
  * @pool: An instance of #AsPool.
+ * @cancellable: a #GCancellable.
  * @error: A #GError or %NULL.
  *
  * Builds an index of all found components in the watched locations.
@@ -988,6 +1410,9 @@ as_pool_load_desktop_entries (AsPool *pool)
  *
  * The function will load from all possible data sources, preferring caches if they
  * are up to date.
+ * If @cancellable is cancelled, loading stops before the next data source is read
+ * and %G_IO_ERROR_CANCELLED is returned. The pool then has the same contents it
+ * had before this function was called.
  *
  * Returns: %TRUE if update completed without error.
  **/
@@ -995,22 +1420,43 @@ gboolean
 as_pool_load (AsPool *pool, GCancellable *cancellable, GError **error)
 {
 	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	g_autoptr(GHashTable) old_cpt_table = NULL;
+	g_autoptr(GHashTable) old_known_cids = NULL;
+	g_autoptr(GHashTable) old_attached_addons = NULL;
+	time_t old_load_time = priv->load_time;
 	gboolean ret = TRUE;
 
+	/* keep the old data around, so we can restore it if loading is cancelled */
+	if (g_hash_table_size (priv->cpt_table) > 0) {
+		old_cpt_table = g_hash_table_ref (priv->cpt_table);
+		old_known_cids = g_hash_table_ref (priv->known_cids);
+		old_attached_addons = g_hash_table_ref (priv->attached_addons);
+	}
+
 	/* load means to reload, so we get rid of all the old data */
 	as_pool_clear (pool);
 
+	/* the system cache may have been rebuilt since we were created */
+	as_pool_check_cache_ctime (pool);
+	priv->load_time = time (NULL);
+
 	/* read all AppStream metadata that we can find */
 	if (as_flags_contains (priv->flags, AS_POOL_FLAG_READ_COLLECTION))
-		ret = as_pool_load_collection_data (pool, FALSE, error);
+		ret = as_pool_load_collection_data (pool, error);
+	if (g_cancellable_set_error_if_cancelled (cancellable, ret? error : NULL))
+		goto cancelled;
 
 	/* read all metainfo files that we can find */
 	if (as_flags_contains (priv->flags, AS_POOL_FLAG_READ_METAINFO))
 		as_pool_load_metainfo_data (pool);
+	if (g_cancellable_set_error_if_cancelled (cancellable, ret? error : NULL))
+		goto cancelled;
 
 	/* read all .desktop file data that we can find */
 	if (as_flags_contains (priv->flags, AS_POOL_FLAG_READ_DESKTOP_FILES))
 		as_pool_load_desktop_entries (pool);
+	if (g_cancellable_set_error_if_cancelled (cancellable, ret? error : NULL))
+		goto cancelled;
 
 	/* automatically refine the metadata we have in the pool */
 	ret = as_pool_refine_data (pool) && ret;
@@ -1022,6 +1468,23 @@ as_pool_load (AsPool *pool, GCancellable *cancellable, GError **error)
 					     "Some components are invalid. See debug output for details");
 
 	return ret;
+
+cancelled:
+	/* do not leave a partially loaded pool behind */
+	if (old_cpt_table == NULL) {
+		as_pool_clear (pool);
+	} else {
+		g_hash_table_unref (priv->cpt_table);
+		priv->cpt_table = g_steal_pointer (&old_cpt_table);
+		g_hash_table_unref (priv->known_cids);
+		priv->known_cids = g_steal_pointer (&old_known_cids);
+		g_hash_table_unref (priv->attached_addons);
+		priv->attached_addons = g_steal_pointer (&old_attached_addons);
+		as_pool_update_addon_info (pool);
+	}
+	priv->load_time = old_load_time;
+
+	return FALSE;
 }
 
 /**
@@ -1035,12 +1498,13 @@ as_pool_load (AsPool *pool, GCancellable *cancellable, GError **error)
 gboolean
 as_pool_load_cache_file (AsPool *pool, const gchar *fname, GError **error)
 {
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
 	g_autoptr(GPtrArray) cpts = NULL;
 	guint i;
 	GError *tmp_error = NULL;
 
 	/* load list of components in cache */
-	cpts = as_cache_file_read (fname, &tmp_error);
+	cpts = as_cache_file_read_internal (fname, TRUE, priv->load_fields, &tmp_error);
 	if (tmp_error != NULL) {
 		g_propagate_error (error, tmp_error);
 		return FALSE;
@@ -1063,12 +1527,7 @@ as_pool_load_cache_file (AsPool *pool, const gchar *fname, GError **error)
 	}
 
 	/* find addons for the loaded components */
-	for (i = 0; i < cpts->len; i++) {
-		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (cpts, i));
-
-		/* find and reference addons */
-		as_pool_update_addon_info (pool, cpt);
-	}
+	as_pool_update_addon_info (pool);
 
 	/* NOTE: Caches don't have merge components, so we don't need to special-case them here */
 
@@ -1106,17 +1565,14 @@ as_pool_save_cache_file (AsPool *pool, const gchar *fname, GError **error)
 GPtrArray*
 as_pool_get_components (AsPool *pool)
 {
-	AsPoolPrivate *priv = GET_PRIVATE (pool);
-	GHashTableIter iter;
-	gpointer value;
+	AsPoolIter iter;
+	AsComponent *cpt;
 	GPtrArray *cpts;
 
 	cpts = g_ptr_array_new_with_free_func (g_object_unref);
-	g_hash_table_iter_init (&iter, priv->cpt_table);
-	while (g_hash_table_iter_next (&iter, NULL, &value)) {
-		AsComponent *cpt = AS_COMPONENT (value);
+	as_pool_iter_init (&iter, pool);
+	while (as_pool_iter_next (&iter, &cpt))
 		g_ptr_array_add (cpts, g_object_ref (cpt));
-	}
 
 	return cpts;
 }
@@ -1135,18 +1591,16 @@ as_pool_get_components (AsPool *pool)
 GPtrArray*
 as_pool_get_components_by_id (AsPool *pool, const gchar *cid)
 {
-	AsPoolPrivate *priv = GET_PRIVATE (pool);
 	GPtrArray *result;
-	GHashTableIter iter;
-	gpointer value;
+	AsPoolIter iter;
+	AsComponent *cpt;
 
 	result = g_ptr_array_new_with_free_func (g_object_unref);
 	if (cid == NULL)
 		return result;
 
-	g_hash_table_iter_init (&iter, priv->cpt_table);
-	while (g_hash_table_iter_next (&iter, NULL, &value)) {
-		AsComponent *cpt = AS_COMPONENT (value);
+	as_pool_iter_init (&iter, pool);
+	while (as_pool_iter_next (&iter, &cpt)) {
 		if (g_strcmp0 (as_component_get_id (cpt), cid) == 0)
 			g_ptr_array_add (result,
 					 g_object_ref (cpt));
@@ -1170,20 +1624,18 @@ as_pool_get_components_by_provided_item (AsPool *pool,
 					      AsProvidedKind kind,
 					      const gchar *item)
 {
-	AsPoolPrivate *priv = GET_PRIVATE (pool);
-	GHashTableIter iter;
-	gpointer value;
+	AsPoolIter iter;
+	AsComponent *cpt;
 	GPtrArray *results;
 
 	/* sanity check */
 	g_return_val_if_fail (item != NULL, NULL);
 
 	results = g_ptr_array_new_with_free_func (g_object_unref);
-	g_hash_table_iter_init (&iter, priv->cpt_table);
-	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+	as_pool_iter_init (&iter, pool);
+	while (as_pool_iter_next (&iter, &cpt)) {
 		GPtrArray *provided = NULL;
 		guint i;
-		AsComponent *cpt = AS_COMPONENT (value);
 
 		provided = as_component_get_provided (cpt);
 		for (i = 0; i < provided->len; i++) {
@@ -1214,18 +1666,16 @@ as_pool_get_components_by_provided_item (AsPool *pool,
 GPtrArray*
 as_pool_get_components_by_kind (AsPool *pool, AsComponentKind kind)
 {
-	AsPoolPrivate *priv = GET_PRIVATE (pool);
-	GHashTableIter iter;
-	gpointer value;
+	AsPoolIter iter;
+	AsComponent *cpt;
 	GPtrArray *results;
 
 	/* sanity check */
 	g_return_val_if_fail ((kind < AS_COMPONENT_KIND_LAST) && (kind > AS_COMPONENT_KIND_UNKNOWN), NULL);
 
 	results = g_ptr_array_new_with_free_func (g_object_unref);
-	g_hash_table_iter_init (&iter, priv->cpt_table);
-	while (g_hash_table_iter_next (&iter, NULL, &value)) {
-		AsComponent *cpt = AS_COMPONENT (value);
+	as_pool_iter_init (&iter, pool);
+	while (as_pool_iter_next (&iter, &cpt)) {
 
 		if (as_component_get_kind (cpt) == kind)
 				g_ptr_array_add (results, g_object_ref (cpt));
@@ -1246,9 +1696,8 @@ as_pool_get_components_by_kind (AsPool *pool, AsComponentKind kind)
 GPtrArray*
 as_pool_get_components_by_categories (AsPool *pool, gchar **categories)
 {
-	AsPoolPrivate *priv = GET_PRIVATE (pool);
-	GHashTableIter iter;
-	gpointer value;
+	AsPoolIter iter;
+	AsComponent *cpt;
 	guint i;
 	GPtrArray *results;
 
@@ -1261,9 +1710,8 @@ as_pool_get_components_by_categories (AsPool *pool, gchar **categories)
 		}
 	}
 
-	g_hash_table_iter_init (&iter, priv->cpt_table);
-	while (g_hash_table_iter_next (&iter, NULL, &value)) {
-		AsComponent *cpt = AS_COMPONENT (value);
+	as_pool_iter_init (&iter, pool);
+	while (as_pool_iter_next (&iter, &cpt)) {
 
 		for (i = 0; categories[i] != NULL; i++) {
 			if (as_component_has_category (cpt, categories[i]))
@@ -1292,20 +1740,18 @@ as_pool_get_components_by_launchable (AsPool *pool,
 					      AsLaunchableKind kind,
 					      const gchar *id)
 {
-	AsPoolPrivate *priv = GET_PRIVATE (pool);
-	GHashTableIter iter;
-	gpointer value;
+	AsPoolIter iter;
+	AsComponent *cpt;
 	GPtrArray *results;
 
 	/* sanity check */
 	g_return_val_if_fail (id != NULL, NULL);
 
 	results = g_ptr_array_new_with_free_func (g_object_unref);
-	g_hash_table_iter_init (&iter, priv->cpt_table);
-	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+	as_pool_iter_init (&iter, pool);
+	while (as_pool_iter_next (&iter, &cpt)) {
 		GPtrArray *launchables = NULL;
 		guint i;
-		AsComponent *cpt = AS_COMPONENT (value);
 
 		launchables = as_component_get_launchables (cpt);
 		for (i = 0; i < launchables->len; i++) {
@@ -1427,11 +1873,10 @@ as_sort_components_by_score_cb (gconstpointer a, gconstpointer b)
 GPtrArray*
 as_pool_search (AsPool *pool, const gchar *search)
 {
-	AsPoolPrivate *priv = GET_PRIVATE (pool);
 	g_auto(GStrv) terms = NULL;
 	GPtrArray *results;
-	GHashTableIter iter;
-	gpointer value;
+	AsPoolIter iter;
+	AsComponent *cpt;
 
 	/* sanitize user's search term */
 	terms = as_pool_build_search_terms (pool, search);
@@ -1445,10 +1890,9 @@ as_pool_search (AsPool *pool, const gchar *search)
 		g_debug ("Searching for: %s", tmp_str);
 	}
 
-	g_hash_table_iter_init (&iter, priv->cpt_table);
-	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+	as_pool_iter_init (&iter, pool);
+	while (as_pool_iter_next (&iter, &cpt)) {
 		guint score;
-		AsComponent *cpt = AS_COMPONENT (value);
 
 		score = as_component_search_matches_all (cpt, terms);
 		if (score == 0)
@@ -1464,30 +1908,111 @@ as_pool_search (AsPool *pool, const gchar *search)
 }
 
 /**
- * as_pool_refresh_cache:
+ * as_pool_get_addons:
  * @pool: An instance of #AsPool.
- * @force: Enforce refresh, even if source data has not changed.
+ * @cpt: The #AsComponent to find addons for.
  *
- * Update the AppStream cache. There is normally no need to call this function manually, because cache updates are handled
- * transparently in the background.
+ * Get all addons in the pool which extend @cpt.
+ * Addons only extend system components of their own bundling system.
+ * The addon graph is built when the pool is loaded, so components
+ * added to the pool later are not taken into account until the next load.
  *
- * Returns: %TRUE if the cache was updated, %FALSE on error or if the cache update was not necessary and has been skipped.
+ * Returns: (transfer container) (element-type AsComponent): an array of #AsComponent objects.
+ *
+ * Since: 0.12.3
  */
-gboolean
-as_pool_refresh_cache (AsPool *pool, gboolean force, GError **error)
+GPtrArray*
+as_pool_get_addons (AsPool *pool, AsComponent *cpt)
 {
 	AsPoolPrivate *priv = GET_PRIVATE (pool);
-	gboolean ret = FALSE;
-	gboolean ret_poolupdate;
-	g_autofree gchar *cache_fname = NULL;
-	g_autoptr(GError) data_load_error = NULL;
-	g_autoptr(GError) tmp_error = NULL;
+	GPtrArray *result;
+	GPtrArray *addons;
+	guint i;
 
-	/* try to create cache directory, in case it doesn't exist */
-	g_mkdir_with_parents (priv->sys_cache_path, 0755);
-	if (!as_utils_is_writable (priv->sys_cache_path)) {
-		g_set_error (error,
-				AS_POOL_ERROR,
+	result = g_ptr_array_new_with_free_func (g_object_unref);
+	addons = g_hash_table_lookup (priv->addons_index, cpt);
+	if (addons == NULL)
+		return result;
+
+	for (i = 0; i < addons->len; i++)
+		g_ptr_array_add (result, g_object_ref (g_ptr_array_index (addons, i)));
+	return result;
+}
+
+/**
+ * as_pool_get_extended:
+ * @pool: An instance of #AsPool.
+ * @addon: The addon #AsComponent.
+ *
+ * Get all components in the pool which are extended by @addon.
+ * This is the reverse of as_pool_get_addons().
+ *
+ * Returns: (transfer container) (element-type AsComponent): an array of #AsComponent objects.
+ *
+ * Since: 0.12.3
+ */
+GPtrArray*
+as_pool_get_extended (AsPool *pool, AsComponent *addon)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	GPtrArray *result;
+	GPtrArray *extended;
+	guint i;
+
+	result = g_ptr_array_new_with_free_func (g_object_unref);
+	extended = g_hash_table_lookup (priv->extends_index, addon);
+	if (extended == NULL)
+		return result;
+
+	for (i = 0; i < extended->len; i++)
+		g_ptr_array_add (result, g_object_ref (g_ptr_array_index (extended, i)));
+	return result;
+}
+
+/**
+ * as_pool_cache_outdated_for_locales:
+ *
+ * Returns: %TRUE if the collection metadata changed after the cache was
+ * last updated, or if the cache has no data for one of @locales.
+ */
+static gboolean
+as_pool_cache_outdated_for_locales (AsPool *pool, const gchar * const *locales)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	g_autofree gchar *index_fname = NULL;
+	struct stat cache_sbuf;
+
+	index_fname = g_build_filename (priv->sys_cache_path, "shards.gvz", NULL);
+	if (stat (index_fname, &cache_sbuf) < 0)
+		return TRUE;
+	if (as_pool_metadata_changed_since (pool, cache_sbuf.st_ctime))
+		return TRUE;
+
+	return !as_cache_shards_have_locales (priv->sys_cache_path, locales);
+}
+
+/**
+ * as_pool_refresh_cache_real:
+ *
+ * Update the shards of the system cache whose collection metadata changed,
+ * and write string tables for all @locales.
+ */
+static gboolean
+as_pool_refresh_cache_real (AsPool *pool, const gchar * const *locales, gboolean force, GError **error)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	gboolean ret = FALSE;
+	gboolean ret_poolupdate = TRUE;
+	g_autoptr(GPtrArray) mdata_files = NULL;
+	g_autoptr(GError) data_load_error = NULL;
+	g_autoptr(GError) tmp_error = NULL;
+	guint n_parsed = 0;
+
+	/* try to create cache directory, in case it doesn't exist */
+	g_mkdir_with_parents (priv->sys_cache_path, 0755);
+	if (!as_utils_is_writable (priv->sys_cache_path)) {
+		g_set_error (error,
+				AS_POOL_ERROR,
 				AS_POOL_ERROR_TARGET_NOT_WRITABLE,
 				_("Cache location '%s' is not writable."), priv->sys_cache_path);
 		return FALSE;
@@ -1505,12 +2030,9 @@ as_pool_refresh_cache (AsPool *pool, gboolean force, GError **error)
 	}
 #endif
 
-	/* create the filename of our cache */
-	cache_fname = g_strdup_printf ("%s/%s.gvz", priv->sys_cache_path, priv->locale);
-
 	/* check if we need to refresh the cache
 	 * (which is only necessary if the AppStream data has changed) */
-	if (!as_pool_metadata_changed (pool)) {
+	if (!as_pool_cache_outdated_for_locales (pool, locales)) {
 		g_debug ("Data did not change, no cache refresh needed.");
 		if (force) {
 			g_debug ("Forcing refresh anyway.");
@@ -1520,30 +2042,29 @@ as_pool_refresh_cache (AsPool *pool, gboolean force, GError **error)
 	}
 	g_debug ("Refreshing AppStream cache");
 
-	/* ensure we start with an empty pool */
-	as_pool_clear (pool);
-
-	/* NOTE: we will only cache AppStream metadata, no .desktop file metadata etc. */
-
-	/* load AppStream collection metadata only and refine it */
-	ret = as_pool_load_collection_data (pool, TRUE, &data_load_error);
-	ret_poolupdate = as_pool_refine_data (pool) && ret;
-	if (data_load_error != NULL)
-		g_debug ("Error while updating the in-memory data pool: %s", data_load_error->message);
-
-	/* save the cache object */
-	as_pool_save_cache_file (pool, cache_fname, &tmp_error);
-	if (tmp_error != NULL) {
-		/* the exact error is not forwarded here, since we might be able to partially update the cache */
-		g_warning ("Error while updating the cache: %s", tmp_error->message);
-		g_error_free (tmp_error);
-		tmp_error = NULL;
-		ret = FALSE;
-	} else {
-		ret = TRUE;
+	/* NOTE: we will only cache AppStream collection metadata here, metainfo and .desktop file
+	 * data is cached per-file when the pool is loaded */
+
+	/* only the shards of origins whose data changed are regenerated */
+	mdata_files = as_pool_find_collection_files (pool);
+	ret = as_cache_shards_update (priv->sys_cache_path, mdata_files, locales, &n_parsed, &tmp_error);
+	if (!ret) {
+		if (g_error_matches (tmp_error, AS_POOL_ERROR, AS_POOL_ERROR_INCOMPLETE)) {
+			/* the cache was written, but some data is missing */
+			g_debug ("Error while updating the cache data: %s", tmp_error->message);
+			data_load_error = g_steal_pointer (&tmp_error);
+			ret_poolupdate = FALSE;
+			ret = TRUE;
+		} else {
+			/* the exact error is not forwarded here, since we might be able to partially update the cache */
+			g_warning ("Error while updating the cache: %s", tmp_error->message);
+		}
 	}
+	g_debug ("Parsed %u of %u metadata files for the cache update.", n_parsed, mdata_files->len);
 
 	if (ret) {
+		g_autofree gchar *index_fname = NULL;
+
 		if (!ret_poolupdate) {
 			g_autofree gchar *error_message = NULL;
 			if (data_load_error == NULL)
@@ -1557,7 +2078,8 @@ as_pool_refresh_cache (AsPool *pool, gboolean force, GError **error)
 				error_message);
 		}
 		/* update the cache mtime, to not needlessly rebuild it again */
-		as_touch_location (cache_fname);
+		index_fname = g_build_filename (priv->sys_cache_path, "shards.gvz", NULL);
+		as_touch_location (index_fname);
 		as_pool_check_cache_ctime (pool);
 	} else {
 		g_set_error (error,
@@ -1570,210 +2092,1676 @@ as_pool_refresh_cache (AsPool *pool, gboolean force, GError **error)
 }
 
 /**
- * as_cache_file_save:
- * @fname: The file to save the data to.
- * @locale: The locale this cache file is for.
+ * as_pool_refresh_cache:
+ * @pool: An instance of #AsPool.
+ * @force: Enforce refresh, even if source data has not changed.
+ *
+ * Update the AppStream cache. There is normally no need to call this function manually, because cache updates are handled
+ * transparently in the background.
+ *
+ * Returns: %TRUE if the cache was updated, %FALSE on error or if the cache update was not necessary and has been skipped.
+ */
+gboolean
+as_pool_refresh_cache (AsPool *pool, gboolean force, GError **error)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	const gchar *locales[] = { priv->locale, NULL };
+
+	return as_pool_refresh_cache_real (pool, locales, force, error);
+}
+
+/**
+ * as_pool_refresh_cache_for_locales:
+ * @pool: An instance of #AsPool.
+ * @locales: (array zero-terminated=1): The locales to update the cache for.
+ * @force: Enforce refresh, even if source data has not changed.
+ * @error: A #GError or %NULL.
+ *
+ * Update the AppStream cache for several locales at once.
+ * The metadata is only loaded and refined once, and the localized data for
+ * all locales is generated in a single pass.
+ * This is a lot faster than calling as_pool_refresh_cache() for each locale.
+ *
+ * Returns: %TRUE if the cache was updated, %FALSE on error or if the cache update was not necessary and has been skipped.
+ *
+ * Since: 0.12.3
+ */
+gboolean
+as_pool_refresh_cache_for_locales (AsPool *pool, gchar **locales, gboolean force, GError **error)
+{
+	g_return_val_if_fail (locales != NULL && locales[0] != NULL, FALSE);
+
+	return as_pool_refresh_cache_real (pool, (const gchar * const *) locales, force, error);
+}
+
+/**
+ * as_cache_render_component:
+ * @cpt: The component to serialize.
+ * @locale: The locale to render the component in.
+ *
+ * Serialize a component as it looks in @locale. The search tokens are
+ * regenerated, so they match the localized strings as well.
+ *
+ * Screenshots and releases look up their strings in their own locale,
+ * which would be the process locale for multi-locale refreshes, so
+ * they are switched to @locale too.
+ *
+ * Returns: (transfer full): A GVariant dictionary.
+ */
+static GVariant*
+as_cache_render_component (AsComponent *cpt, const gchar *locale)
+{
+	GVariantBuilder builder;
+	g_autoptr(GVariant) array = NULL;
+	GPtrArray *sshots;
+	GPtrArray *releases;
+	guint i;
+
+	as_component_set_active_locale (cpt, locale);
+	sshots = as_component_get_screenshots (cpt);
+	for (i = 0; i < sshots->len; i++)
+		as_screenshot_set_active_locale (AS_SCREENSHOT (g_ptr_array_index (sshots, i)), locale);
+	releases = as_component_get_releases (cpt);
+	for (i = 0; i < releases->len; i++)
+		as_release_set_active_locale (AS_RELEASE (g_ptr_array_index (releases, i)), locale);
+	g_hash_table_remove_all (as_component_get_token_cache_table (cpt));
+	as_component_set_token_cache_valid (cpt, FALSE);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
+	as_component_to_variant (cpt, &builder);
+	array = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+	return g_variant_get_child_value (array, 0);
+}
+
+/**
+ * as_cache_locale_overrides:
+ * @core_v: The locale-independent serialization of a component.
+ * @locale_v: The serialization of the same component in a specific locale.
+ *
+ * Compute the set of entries which differ between the two serializations.
+ * Entries which only exist in @core_v are recorded with an empty value.
+ *
+ * Returns: An "a{smv}" dictionary, or %NULL if both are equal.
+ */
+static GVariant*
+as_cache_locale_overrides (GVariant *core_v, GVariant *locale_v)
+{
+	GVariantBuilder builder;
+	GVariantIter iter;
+	const gchar *key;
+	GVariant *value;
+	gboolean changed = FALSE;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{smv}"));
+
+	g_variant_iter_init (&iter, locale_v);
+	while (g_variant_iter_next (&iter, "{&sv}", &key, &value)) {
+		g_autoptr(GVariant) core_value = g_variant_lookup_value (core_v, key, NULL);
+
+		if ((core_value == NULL) || (!g_variant_equal (core_value, value))) {
+			g_variant_builder_add (&builder, "{smv}", key, value);
+			changed = TRUE;
+		}
+		g_variant_unref (value);
+	}
+
+	g_variant_iter_init (&iter, core_v);
+	while (g_variant_iter_next (&iter, "{&sv}", &key, &value)) {
+		g_autoptr(GVariant) locale_value = g_variant_lookup_value (locale_v, key, NULL);
+
+		if (locale_value == NULL) {
+			g_variant_builder_add (&builder, "{smv}", key, NULL);
+			changed = TRUE;
+		}
+		g_variant_unref (value);
+	}
+
+	if (!changed) {
+		g_variant_builder_clear (&builder);
+		return NULL;
+	}
+
+	return g_variant_builder_end (&builder);
+}
+
+/**
+ * AsCacheRenderJob:
+ *
+ * State shared by the threads serializing components for the cache.
+ */
+typedef struct {
+	GPtrArray		*cpts;
+	const gchar * const	*locales;
+	guint			n_locales;
+	GVariant		**core;		/* one per component */
+	GVariant		**overrides;	/* n_locales rows of one per component */
+
+	guint			chunk_size;
+	guint			pending;
+	GMutex			mutex;
+	GCond			cond;
+} AsCacheRenderJob;
+
+/**
+ * as_cache_render_job_set_language:
+ *
+ * Make the stemmer used for tokenizing components match @locale.
+ */
+static void
+as_cache_render_job_set_language (AsStemmer *stemmer, const gchar *locale)
+{
+	g_autofree gchar *lang = as_utils_locale_to_language (locale);
+	as_stemmer_reload (stemmer, lang);
+}
+
+/**
+ * as_cache_render_job_range:
+ *
+ * Serialize the components from @start to @end in the "C" locale and
+ * compute their string tables for all requested locales.
+ * The tokens of every locale are stemmed in the language of that locale.
+ */
+static void
+as_cache_render_job_range (AsCacheRenderJob *job, guint start, guint end)
+{
+	g_autoptr(AsStemmer) stemmer = NULL;
+	g_auto(GStrv) prev_locales = NULL;
+	guint i;
+	guint l;
+
+	/* tokenize with our own stemmer, the global one would serialize all threads
+	 * and is set up for the language of the process, not the one we render */
+	stemmer = as_stemmer_new ();
+	as_stemmer_set_thread_default (stemmer);
+
+	prev_locales = g_new0 (gchar*, end - start + 1);
+	for (i = start; i < end; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (job->cpts, i));
+		prev_locales[i - start] = g_strdup (as_component_get_active_locale (cpt));
+	}
+
+	as_cache_render_job_set_language (stemmer, "C");
+	for (i = start; i < end; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (job->cpts, i));
+		job->core[i] = as_cache_render_component (cpt, "C");
+	}
+
+	for (l = 0; l < job->n_locales; l++) {
+		if (g_strcmp0 (job->locales[l], "C") == 0)
+			continue;
+
+		as_cache_render_job_set_language (stemmer, job->locales[l]);
+		for (i = start; i < end; i++) {
+			AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (job->cpts, i));
+			g_autoptr(GVariant) locale_v = NULL;
+			GVariant *overrides;
+
+			locale_v = as_cache_render_component (cpt, job->locales[l]);
+			overrides = as_cache_locale_overrides (job->core[i], locale_v);
+			if (overrides != NULL)
+				job->overrides[l * job->cpts->len + i] = g_variant_ref_sink (overrides);
+		}
+	}
+
+	for (i = start; i < end; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (job->cpts, i));
+		as_component_set_active_locale (cpt, prev_locales[i - start]);
+	}
+
+	as_stemmer_set_thread_default (NULL);
+}
+
+/**
+ * as_cache_render_job_worker:
+ */
+static void
+as_cache_render_job_worker (gpointer data, gpointer user_data)
+{
+	AsCacheRenderJob *job = (AsCacheRenderJob*) user_data;
+	guint start = (GPOINTER_TO_UINT (data) - 1) * job->chunk_size;
+	guint end = MIN (start + job->chunk_size, job->cpts->len);
+
+	as_cache_render_job_range (job, start, end);
+
+	g_mutex_lock (&job->mutex);
+	job->pending--;
+	if (job->pending == 0)
+		g_cond_signal (&job->cond);
+	g_mutex_unlock (&job->mutex);
+}
+
+/**
+ * as_cache_render_job_run:
+ *
+ * Serialize all components of @job, using multiple threads if that is worth it.
+ * Every component is only ever touched by one thread, since rendering it
+ * changes its active locale and token cache.
+ */
+static void
+as_cache_render_job_run (AsCacheRenderJob *job)
+{
+	GThreadPool *pool = NULL;
+	guint n_threads;
+	guint n_chunks;
+	guint i;
+
+	n_threads = MIN (g_get_num_processors (), 16);
+	if ((n_threads > 1) && (job->cpts->len > 64))
+		pool = g_thread_pool_new (as_cache_render_job_worker,
+					  job,
+					  n_threads,
+					  TRUE,
+					  NULL);
+	if (pool == NULL) {
+		as_cache_render_job_range (job, 0, job->cpts->len);
+		return;
+	}
+
+	job->chunk_size = MAX (job->cpts->len / (n_threads * 4), 16);
+	n_chunks = (job->cpts->len + job->chunk_size - 1) / job->chunk_size;
+	job->pending = n_chunks;
+	g_mutex_init (&job->mutex);
+	g_cond_init (&job->cond);
+
+	for (i = 0; i < n_chunks; i++)
+		g_thread_pool_push (pool, GUINT_TO_POINTER (i + 1), NULL);
+
+	g_mutex_lock (&job->mutex);
+	while (job->pending > 0)
+		g_cond_wait (&job->cond, &job->mutex);
+	g_mutex_unlock (&job->mutex);
+
+	g_thread_pool_free (pool, FALSE, TRUE);
+	g_mutex_clear (&job->mutex);
+	g_cond_clear (&job->cond);
+}
+
+/**
+ * as_cache_serialize:
  * @cpts: (element-type AsComponent): The components to serialize.
- * @error: A #GError
+ * @locales: %NULL-terminated list of locales to generate string tables for.
+ * @raw: %TRUE to serialize invalid and merge components as well.
+ * @core_out: (out): The locale-independent component data.
+ * @overrides_out: (out): The string tables, one for each locale in @locales.
+ * @checksum_out: (out): Checksum of the data in @core_out.
+ *
+ * Split the serialized components into a part that is shared between
+ * all locales (the untranslated data) and the entries that are different
+ * in the selected locales.
  *
- * Serialize components to a cache file and store it on disk.
+ * Returns: %TRUE if there was anything to serialize.
  */
-void
-as_cache_file_save (const gchar *fname, const gchar *locale, GPtrArray *cpts, GError **error)
+static gboolean
+as_cache_serialize (GPtrArray *cpts,
+		    const gchar * const *locales,
+		    gboolean raw,
+		    GVariant **core_out,
+		    GVariant ***overrides_out,
+		    gchar **checksum_out)
 {
-	g_autoptr(GVariant) main_gv = NULL;
-	g_autoptr(GVariantBuilder) main_builder = NULL;
-	g_autoptr(GVariantBuilder) builder = NULL;
+	AsCacheRenderJob job = { 0, };
+	g_autoptr(GPtrArray) scpts = NULL;
+	g_autoptr(GVariant) core_gv = NULL;
+	GVariantBuilder core_b;
+	GVariant **overrides;
+	guint i;
+	guint l;
+
+	scpts = g_ptr_array_new ();
+	for (i = 0; i < cpts->len; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (cpts, i));
+
+		if (raw) {
+			g_ptr_array_add (scpts, cpt);
+			continue;
+		}
+
+		/* sanity checks */
+		if (!as_component_is_valid (cpt)) {
+			/* we should *never* get here, all invalid stuff should be filtered out at this point */
+			g_critical ("Skipped component '%s' from inclusion into the cache: The component is invalid.",
+					   as_component_get_id (cpt));
+			continue;
+		}
+
+		if (as_component_get_merge_kind (cpt) != AS_MERGE_KIND_NONE) {
+			g_debug ("Skipping '%s' from cache inclusion, it is a merge component.",
+				 as_component_get_id (cpt));
+			continue;
+		}
+
+		g_ptr_array_add (scpts, cpt);
+	}
+
+	if (scpts->len == 0)
+		return FALSE;
+
+	job.cpts = scpts;
+	job.locales = locales;
+	job.n_locales = g_strv_length ((gchar**) locales);
+	job.core = g_new0 (GVariant*, scpts->len);
+	job.overrides = g_new0 (GVariant*, job.n_locales * scpts->len);
+	as_cache_render_job_run (&job);
+
+	g_variant_builder_init (&core_b, G_VARIANT_TYPE ("aa{sv}"));
+	for (i = 0; i < scpts->len; i++) {
+		g_variant_builder_add_value (&core_b, job.core[i]);
+		g_variant_unref (job.core[i]);
+	}
+	core_gv = g_variant_ref_sink (g_variant_builder_end (&core_b));
+
+	overrides = g_new0 (GVariant*, job.n_locales + 1);
+	for (l = 0; l < job.n_locales; l++) {
+		GVariantBuilder overrides_b;
+
+		g_variant_builder_init (&overrides_b, G_VARIANT_TYPE ("a{ua{smv}}"));
+		for (i = 0; i < scpts->len; i++) {
+			GVariant *ovr = job.overrides[l * scpts->len + i];
+			if (ovr == NULL)
+				continue;
+			g_variant_builder_add (&overrides_b, "{u@a{smv}}", (guint32) i, ovr);
+			g_variant_unref (ovr);
+		}
+		overrides[l] = g_variant_ref_sink (g_variant_builder_end (&overrides_b));
+	}
+
+	g_free (job.core);
+	g_free (job.overrides);
+
+	*checksum_out = g_compute_checksum_for_data (G_CHECKSUM_SHA256,
+						     g_variant_get_data (core_gv),
+						     g_variant_get_size (core_gv));
+	*core_out = g_steal_pointer (&core_gv);
+	*overrides_out = overrides;
+
+	return TRUE;
+}
+
+/**
+ * as_cache_overrides_free:
+ *
+ * Free a %NULL-terminated list of string tables.
+ */
+static void
+as_cache_overrides_free (GVariant **overrides)
+{
+	guint i;
+
+	if (overrides == NULL)
+		return;
+	for (i = 0; overrides[i] != NULL; i++)
+		g_variant_unref (overrides[i]);
+	g_free (overrides);
+}
+
+/**
+ * as_cache_write_variant:
+ *
+ * Write a cache variant to disk, compressed.
+ */
+static gboolean
+as_cache_write_variant (const gchar *fname, GVariant *gv, GError **error)
+{
+	g_autoptr(GFile) ofile = NULL;
+	g_autoptr(GFileOutputStream) file_out = NULL;
+	GError *tmp_error = NULL;
+
+	ofile = g_file_new_for_path (fname);
+	file_out = g_file_replace (ofile,
+				   NULL, /* entity-tag */
+				   FALSE, /* make backup */
+				   G_FILE_CREATE_REPLACE_DESTINATION,
+				   NULL, /* cancellable */
+				   error);
+	if (file_out == NULL)
+		return FALSE;
+
+	/* the reader detects the compression format, so which one we use depends on the build configuration */
+	if (!as_compression_write_compressed (G_OUTPUT_STREAM (file_out),
+					      as_compression_get_cache_kind (),
+					      g_variant_get_data (gv),
+					      g_variant_get_size (gv),
+					      &tmp_error)) {
+		g_set_error (error,
+			     AS_POOL_ERROR,
+			     AS_POOL_ERROR_FAILED,
+			     "Failed to write stream: %s",
+			     tmp_error->message);
+		g_error_free (tmp_error);
+		return FALSE;
+	}
+	if (!g_output_stream_close (G_OUTPUT_STREAM (file_out), NULL, &tmp_error)) {
+		g_set_error (error,
+			     AS_POOL_ERROR,
+			     AS_POOL_ERROR_FAILED,
+			     "Failed to close stream: %s",
+			     tmp_error->message);
+		g_error_free (tmp_error);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * as_cache_file_save:
+ * @fname: The file to save the data to.
+ * @locale: The locale this cache file is for.
+ * @cpts: (element-type AsComponent): The components to serialize.
+ * @error: A #GError
+ *
+ * Serialize components to a self-contained cache file and store it on disk.
+ * The file contains the locale-independent data as well as the string
+ * table for @locale.
+ */
+void
+as_cache_file_save (const gchar *fname, const gchar *locale, GPtrArray *cpts, GError **error)
+{
+	g_autoptr(GVariant) main_gv = NULL;
+	g_autoptr(GVariant) core_gv = NULL;
+	GVariant **overrides = NULL;
+	g_autofree gchar *checksum = NULL;
+	GVariantBuilder main_builder;
+	const gchar *locales[] = { locale != NULL? locale : "C", NULL };
+
+	if (cpts->len == 0) {
+		g_debug ("Skipped writing cache file: No components to serialize.");
+		return;
+	}
+
+	/* check if we actually have some valid components serialized to a GVariant */
+	if (!as_cache_serialize (cpts, locales, FALSE, &core_gv, &overrides, &checksum)) {
+		g_debug ("Skipped writing cache file: No valid components found for serialization.");
+		return;
+	}
+
+	/* write basic information and add components */
+	g_variant_builder_init (&main_builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add (&main_builder, "{sv}",
+				"format_version",
+				g_variant_new_uint32 (CACHE_FORMAT_VERSION));
+	g_variant_builder_add (&main_builder, "{sv}",
+				"locale",
+				as_variant_mstring_new (locale));
+	g_variant_builder_add (&main_builder, "{sv}",
+				"core_checksum",
+				g_variant_new_string (checksum));
+	g_variant_builder_add (&main_builder, "{sv}",
+				"components",
+				core_gv);
+	g_variant_builder_add (&main_builder, "{sv}",
+				"overrides",
+				overrides[0]);
+	main_gv = g_variant_ref_sink (g_variant_builder_end (&main_builder));
+	as_cache_overrides_free (overrides);
+
+	as_cache_write_variant (fname, main_gv, error);
+}
+
+/**
+ * as_cache_files_save:
+ * @cache_dir: The cache directory.
+ * @locales: %NULL-terminated list of locales to write string tables for.
+ * @cpts: (element-type AsComponent): The components to serialize.
+ * @checksum_out: (out) (optional): Checksum of the shared data, or %NULL if nothing was written.
+ * @error: A #GError
+ *
+ * Serialize components into a cache directory. The locale-independent data
+ * is stored in a "core.gvz" file which is shared between all locales, while
+ * "<locale>.gvz" only holds the strings that differ in the respective locale.
+ * String tables of other locales stay valid as long as the core data
+ * does not change.
+ *
+ * The components are stored as they are, including merge components, so
+ * they can be merged with data from other caches when loading them.
+ */
+void
+as_cache_files_save (const gchar *cache_dir,
+		     const gchar * const *locales,
+		     GPtrArray *cpts,
+		     gchar **checksum_out,
+		     GError **error)
+{
+	g_autoptr(GVariant) core_gv = NULL;
+	g_autoptr(GVariant) main_gv = NULL;
+	GVariant **overrides = NULL;
+	g_autofree gchar *checksum = NULL;
+	g_autofree gchar *core_fname = NULL;
+	GVariantBuilder main_builder;
+	guint i;
+
+	if (checksum_out != NULL)
+		*checksum_out = NULL;
+	if (!as_cache_serialize (cpts, locales, TRUE, &core_gv, &overrides, &checksum)) {
+		g_debug ("Skipped writing cache files: No components found for serialization.");
+		return;
+	}
+
+	/* shared core */
+	g_variant_builder_init (&main_builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add (&main_builder, "{sv}",
+				"format_version",
+				g_variant_new_uint32 (CACHE_FORMAT_VERSION));
+	g_variant_builder_add (&main_builder, "{sv}",
+				"core_checksum",
+				g_variant_new_string (checksum));
+	g_variant_builder_add (&main_builder, "{sv}",
+				"components",
+				core_gv);
+	main_gv = g_variant_ref_sink (g_variant_builder_end (&main_builder));
+
+	core_fname = g_build_filename (cache_dir, "core.gvz", NULL);
+	if (!as_cache_write_variant (core_fname, main_gv, error)) {
+		as_cache_overrides_free (overrides);
+		return;
+	}
+
+	/* per-locale string tables */
+	for (i = 0; locales[i] != NULL; i++) {
+		g_autoptr(GVariant) locale_gv = NULL;
+		g_autofree gchar *locale_fname = NULL;
+
+		g_variant_builder_init (&main_builder, G_VARIANT_TYPE_VARDICT);
+		g_variant_builder_add (&main_builder, "{sv}",
+					"format_version",
+					g_variant_new_uint32 (CACHE_FORMAT_VERSION));
+		g_variant_builder_add (&main_builder, "{sv}",
+					"locale",
+					as_variant_mstring_new (locales[i]));
+		g_variant_builder_add (&main_builder, "{sv}",
+					"core_checksum",
+					g_variant_new_string (checksum));
+		g_variant_builder_add (&main_builder, "{sv}",
+					"overrides",
+					overrides[i]);
+		locale_gv = g_variant_ref_sink (g_variant_builder_end (&main_builder));
+
+		locale_fname = g_strdup_printf ("%s/%s.gvz", cache_dir, locales[i]);
+		if (!as_cache_write_variant (locale_fname, locale_gv, error)) {
+			as_cache_overrides_free (overrides);
+			return;
+		}
+	}
+
+	as_cache_overrides_free (overrides);
+	if (checksum_out != NULL)
+		*checksum_out = g_steal_pointer (&checksum);
+}
+
+/**
+ * as_cache_read_variant:
+ *
+ * Load a cache file and check that its format is compatible.
+ */
+static GVariant*
+as_cache_read_variant (const gchar *fname, GError **error)
+{
+	g_autoptr(GFile) ifile = NULL;
+	g_autoptr(GInputStream) stream_data = NULL;
+	g_autoptr(GVariant) main_gv = NULL;
+	g_autoptr(GVariant) gmvar = NULL;
+
+	GByteArray *byte_array;
+	g_autoptr(GBytes) bytes = NULL;
+	gssize len;
+	const gsize buffer_size = 1024 * 32;
+	g_autofree guint8 *buffer = NULL;
+
+	ifile = g_file_new_for_path (fname);
+
+	/* caches may be GZip or Zstandard compressed */
+	stream_data = as_compression_open_file (ifile, error);
+	if (stream_data == NULL)
+		return NULL;
+
+	buffer = g_malloc (buffer_size);
+	byte_array = g_byte_array_new ();
+	while ((len = g_input_stream_read (stream_data, buffer, buffer_size, NULL, error)) > 0) {
+		g_byte_array_append (byte_array, buffer, len);
+	}
+	bytes = g_byte_array_free_to_bytes (byte_array);
+
+	/* check if there was an error */
+	if (len < 0)
+		return NULL;
+
+	main_gv = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE_VARDICT, bytes, TRUE));
+
+	gmvar = g_variant_lookup_value (main_gv,
+					"format_version",
+					G_VARIANT_TYPE_UINT32);
+	if ((gmvar == NULL) || (g_variant_get_uint32 (gmvar) != CACHE_FORMAT_VERSION)) {
+		/* don't try to load incompatible cache versions */
+		if (gmvar == NULL)
+			g_set_error (error,
+				     AS_POOL_ERROR,
+				     AS_POOL_ERROR_FAILED,
+				     "Skipped loading of broken cache file '%s'.",
+				     fname);
+		else
+			g_set_error (error,
+				     AS_POOL_ERROR,
+				     AS_POOL_ERROR_FAILED,
+				     "Skipped loading of incompatible or broken cache file '%s': Format is %i (expected %i)",
+				     fname, g_variant_get_uint32 (gmvar), CACHE_FORMAT_VERSION);
+		return NULL;
+	}
+
+	return g_steal_pointer (&main_gv);
+}
+
+/**
+ * as_cache_file_read_internal:
+ * @fname: The cache file to load.
+ * @validate: %TRUE to drop invalid components.
+ * @fields: The optional component data to load right away.
+ * @error: A #GError
+ *
+ * Load components from a cache file. If @fname only contains a string table,
+ * the locale-independent data is read from the "core.gvz" file next to it.
+ *
+ * Returns: (transfer container) (element-type AsComponent): The deserialized components.
+ */
+static GPtrArray*
+as_cache_file_read_internal (const gchar *fname, gboolean validate, AsComponentField fields, GError **error)
+{
+	GPtrArray *cpts = NULL;
+	g_autoptr(GVariant) main_gv = NULL;
+	g_autoptr(GVariant) core_gv = NULL;
+	g_autoptr(GVariant) cptsv_array = NULL;
+	g_autoptr(GVariant) overrides_gv = NULL;
+	g_autoptr(GVariant) gmvar = NULL;
+	GVariant *cptv;
+	GVariant *ovr_v = NULL;
+	guint32 ovr_index = 0;
+	guint32 index = 0;
+	const gchar *locale = NULL;
+	GVariantIter main_iter;
+	GVariantIter ovr_iter;
+
+	main_gv = as_cache_read_variant (fname, error);
+	if (main_gv == NULL)
+		return NULL;
+
+	gmvar = g_variant_lookup_value (main_gv,
+					"locale",
+					G_VARIANT_TYPE_MAYBE);
+	locale = as_variant_get_mstring (&gmvar);
+
+	cptsv_array = g_variant_lookup_value (main_gv,
+					      "components",
+					      G_VARIANT_TYPE_ARRAY);
+	if (cptsv_array == NULL) {
+		g_autofree gchar *cache_dir = NULL;
+		g_autofree gchar *core_fname = NULL;
+		g_autofree gchar *checksum = NULL;
+		g_autofree gchar *core_checksum = NULL;
+
+		/* we only have a string table, so load the shared data */
+		cache_dir = g_path_get_dirname (fname);
+		core_fname = g_build_filename (cache_dir, "core.gvz", NULL);
+		core_gv = as_cache_read_variant (core_fname, error);
+		if (core_gv == NULL)
+			return NULL;
+
+		g_variant_lookup (main_gv, "core_checksum", "s", &checksum);
+		g_variant_lookup (core_gv, "core_checksum", "s", &core_checksum);
+		if ((checksum == NULL) || (g_strcmp0 (checksum, core_checksum) != 0)) {
+			g_set_error (error,
+				     AS_POOL_ERROR,
+				     AS_POOL_ERROR_FAILED,
+				     "Cache file '%s' is outdated: It does not match the shared data in '%s'.",
+				     fname, core_fname);
+			return NULL;
+		}
+
+		cptsv_array = g_variant_lookup_value (core_gv,
+						      "components",
+						      G_VARIANT_TYPE_ARRAY);
+		if (cptsv_array == NULL) {
+			g_set_error (error,
+				     AS_POOL_ERROR,
+				     AS_POOL_ERROR_FAILED,
+				     "Skipped loading of broken cache file '%s'.",
+				     core_fname);
+			return NULL;
+		}
+	}
+
+	/* the string table is sorted by component index */
+	overrides_gv = g_variant_lookup_value (main_gv,
+					       "overrides",
+					       G_VARIANT_TYPE ("a{ua{smv}}"));
+	if (overrides_gv != NULL) {
+		g_variant_iter_init (&ovr_iter, overrides_gv);
+		if (!g_variant_iter_next (&ovr_iter, "{u@a{smv}}", &ovr_index, &ovr_v))
+			ovr_v = NULL;
+	}
+
+	cpts = g_ptr_array_new_with_free_func (g_object_unref);
+	g_variant_iter_init (&main_iter, cptsv_array);
+	while ((cptv = g_variant_iter_next_value (&main_iter))) {
+		g_autoptr(AsComponent) cpt = as_component_new ();
+
+		if ((ovr_v != NULL) && (ovr_index == index)) {
+			g_auto(GVariantDict) dict;
+			GVariantIter iter;
+			const gchar *key;
+			GVariant *value;
+
+			/* apply the localized data on top of the shared core */
+			g_variant_dict_init (&dict, cptv);
+			g_variant_iter_init (&iter, ovr_v);
+			while (g_variant_iter_next (&iter, "{&smv}", &key, &value)) {
+				if (value == NULL) {
+					g_variant_dict_remove (&dict, key);
+				} else {
+					g_variant_dict_insert_value (&dict, key, value);
+					g_variant_unref (value);
+				}
+			}
+			g_variant_unref (cptv);
+			cptv = g_variant_ref_sink (g_variant_dict_end (&dict));
+
+			g_variant_unref (ovr_v);
+			if (!g_variant_iter_next (&ovr_iter, "{u@a{smv}}", &ovr_index, &ovr_v))
+				ovr_v = NULL;
+		}
+		index++;
+
+		if (as_component_set_from_variant_fields (cpt, cptv, locale, fields)) {
+			/* add to result list */
+			if (!validate || as_component_is_valid (cpt)) {
+				g_ptr_array_add (cpts, g_object_ref (cpt));
+			} else {
+				g_autofree gchar *str = as_component_to_string (cpt);
+				g_warning ("Ignored serialized component: %s", str);
+			}
+		}
+		g_variant_unref (cptv);
+	}
+	if (ovr_v != NULL)
+		g_variant_unref (ovr_v);
+
+	return cpts;
+}
+
+/**
+ * as_cache_file_read:
+ * @fname: The cache file to load.
+ * @error: A #GError
+ *
+ * Load the valid components from a cache file.
+ *
+ * Returns: (transfer container) (element-type AsComponent): The deserialized components.
+ */
+GPtrArray*
+as_cache_file_read (const gchar *fname, GError **error)
+{
+	return as_cache_file_read_internal (fname, TRUE, AS_COMPONENT_FIELD_ALL, error);
+}
+
+/**
+ * as_cache_parse_files:
+ * @files: (element-type utf8): All metainfo or .desktop files of the directory.
+ * @skip_files: (nullable): Set of files in @files whose components are not needed, or %NULL.
+ * @locale: The locale to parse the files for.
+ * @fields: The optional component data to load right away from the cache.
+ * @cache_fname: (nullable): The cache file to use and update, or %NULL.
+ * @fallback_fname: (nullable): Cache file to read if @cache_fname does not exist yet, or %NULL.
+ * @n_parsed: (out) (optional): Number of files which actually had to be parsed.
+ *
+ * Load components from local metadata files. For every file, the cache records
+ * its modification and change time in nanoseconds and its size together with
+ * the components and search tokens it contained, so only files which were added
+ * or changed since the cache was written need to be parsed again.
+ *
+ * The cache always describes the whole directory: Files in @skip_files are
+ * neither parsed nor returned, but their cache entries are kept, so the cache
+ * does not depend on which other metadata was loaded before.
+ *
+ * Returns: (transfer container) (element-type AsComponent): The components, in the order of @files.
+ */
+GPtrArray*
+as_cache_parse_files (GPtrArray *files,
+		      GHashTable *skip_files,
+		      const gchar *locale,
+		      AsComponentField fields,
+		      const gchar *cache_fname,
+		      const gchar *fallback_fname,
+		      guint *n_parsed)
+{
+	GPtrArray *cpts;
+	g_autoptr(GVariant) cache_gv = NULL;
+	g_autoptr(GVariant) entries_gv = NULL;
+	g_autoptr(GHashTable) entries = NULL;
+	g_autoptr(AsMetadata) metad = NULL;
+	GVariantBuilder entries_b;
+	gboolean changed = FALSE;
+	guint n_kept = 0;
+	guint parsed = 0;
+	guint i;
+
+	/* load the fingerprints of the files we know */
+	if ((cache_fname != NULL) && g_file_test (cache_fname, G_FILE_TEST_EXISTS)) {
+		g_autoptr(GError) tmp_error = NULL;
+
+		cache_gv = as_cache_read_variant (cache_fname, &tmp_error);
+		if (cache_gv == NULL)
+			g_debug ("Ignoring local metadata cache: %s", tmp_error->message);
+	}
+	if ((cache_gv == NULL) && (fallback_fname != NULL) && g_file_test (fallback_fname, G_FILE_TEST_EXISTS)) {
+		g_autoptr(GError) tmp_error = NULL;
+
+		cache_gv = as_cache_read_variant (fallback_fname, &tmp_error);
+		if (cache_gv == NULL)
+			g_debug ("Ignoring local metadata cache: %s", tmp_error->message);
+	}
+
+	entries = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) g_variant_unref);
+	if (cache_gv != NULL) {
+		g_autofree gchar *cache_locale = NULL;
+
+		g_variant_lookup (cache_gv, "locale", "s", &cache_locale);
+		if (g_strcmp0 (cache_locale, locale) == 0)
+			entries_gv = g_variant_lookup_value (cache_gv, "files", G_VARIANT_TYPE ("a{s(xxta(ua{sv}))}"));
+	}
+	if (entries_gv != NULL) {
+		GVariantIter iter;
+		const gchar *fname;
+		GVariant *entry;
+
+		/* the strings point into entries_gv, which outlives the table */
+		g_variant_iter_init (&iter, entries_gv);
+		while (g_variant_iter_next (&iter, "{&s@(xxta(ua{sv}))}", &fname, &entry))
+			g_hash_table_insert (entries, (gpointer) fname, entry);
+	}
+
+	cpts = g_ptr_array_new_with_free_func (g_object_unref);
+	g_variant_builder_init (&entries_b, G_VARIANT_TYPE ("a{s(xxta(ua{sv}))}"));
+	for (i = 0; i < files->len; i++) {
+		const gchar *fname = (const gchar*) g_ptr_array_index (files, i);
+		g_autoptr(GFile) infile = NULL;
+		g_autoptr(GError) tmp_error = NULL;
+		GVariantBuilder cpts_b;
+		GPtrArray *parsed_cpts;
+		GVariant *entry;
+		struct stat sbuf;
+		gint64 file_mtime;
+		gint64 file_ctime;
+		gboolean skip;
+		guint j;
+
+		if (stat (fname, &sbuf) != 0) {
+			g_warning ("Metadata file '%s' does not exist.", fname);
+			continue;
+		}
+		/* whole seconds are too coarse to notice quick successive edits */
+		file_mtime = (gint64) sbuf.st_mtim.tv_sec * G_GINT64_CONSTANT (1000000000) + sbuf.st_mtim.tv_nsec;
+		file_ctime = (gint64) sbuf.st_ctim.tv_sec * G_GINT64_CONSTANT (1000000000) + sbuf.st_ctim.tv_nsec;
+		skip = (skip_files != NULL) && g_hash_table_contains (skip_files, fname);
+
+		entry = g_hash_table_lookup (entries, fname);
+		if (entry != NULL) {
+			gint64 mtime;
+			gint64 ctime;
+			guint64 size;
+			g_autoptr(GVariant) cptsv_array = NULL;
+
+			g_variant_get (entry, "(xxt@a(ua{sv}))", &mtime, &ctime, &size, &cptsv_array);
+			if ((mtime == file_mtime) && (ctime == file_ctime) && (size == (guint64) sbuf.st_size)) {
+				GVariantIter iter;
+				GVariant *cptv;
+				guint32 origin_kind;
+
+				g_variant_builder_add (&entries_b, "{s@(xxta(ua{sv}))}", fname, entry);
+				n_kept++;
+				if (skip) {
+					g_debug ("Skipped: %s (already known)", fname);
+					continue;
+				}
+
+				g_debug ("Reading: %s (cached)", fname);
+				g_variant_iter_init (&iter, cptsv_array);
+				while (g_variant_iter_next (&iter, "(u@a{sv})", &origin_kind, &cptv)) {
+					g_autoptr(AsComponent) cpt = as_component_new ();
+
+					if (as_component_set_from_variant_fields (cpt, cptv, locale, fields)) {
+						/* the pool merges metainfo and .desktop data depending on where it came from */
+						as_component_set_origin_kind (cpt, (AsOriginKind) origin_kind);
+						g_ptr_array_add (cpts, g_object_ref (cpt));
+					}
+					g_variant_unref (cptv);
+				}
+				continue;
+			}
+		}
+
+		/* we don't parse files we don't need, they are cached once they are loaded */
+		if (skip) {
+			g_debug ("Skipped: %s (already known)", fname);
+			continue;
+		}
+
+		/* the file is new or was changed, so we need to parse it */
+		if (metad == NULL) {
+			metad = as_metadata_new ();
+			as_metadata_set_locale (metad, locale);
+		}
+		as_metadata_clear_components (metad);
+
+		g_debug ("Reading: %s", fname);
+		infile = g_file_new_for_path (fname);
+		as_metadata_parse_file (metad,
+					infile,
+					AS_FORMAT_KIND_UNKNOWN,
+					&tmp_error);
+		if (tmp_error != NULL)
+			g_debug ("WARNING: %s", tmp_error->message);
+		parsed++;
+		changed = TRUE;
+
+		/* we also remember files without valid data, so we don't parse them again */
+		g_variant_builder_init (&cpts_b, G_VARIANT_TYPE ("a(ua{sv})"));
+		parsed_cpts = as_metadata_get_components (metad);
+		for (j = 0; j < parsed_cpts->len; j++) {
+			AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (parsed_cpts, j));
+			g_autoptr(GVariant) cptv = as_cache_render_component (cpt, locale);
+
+			g_variant_builder_add (&cpts_b, "(u@a{sv})",
+					       (guint32) as_component_get_origin_kind (cpt),
+					       cptv);
+			g_ptr_array_add (cpts, g_object_ref (cpt));
+		}
+		g_variant_builder_add (&entries_b, "{s(xxt@a(ua{sv}))}",
+				       fname,
+				       file_mtime,
+				       file_ctime,
+				       (guint64) sbuf.st_size,
+				       g_variant_builder_end (&cpts_b));
+	}
+
+	/* files might have been removed or changed without being needed */
+	if (n_kept != g_hash_table_size (entries))
+		changed = TRUE;
+
+	if (changed && (cache_fname != NULL)) {
+		g_autoptr(GVariant) main_gv = NULL;
+		g_autoptr(GError) tmp_error = NULL;
+		GVariantBuilder main_builder;
+
+		g_variant_builder_init (&main_builder, G_VARIANT_TYPE_VARDICT);
+		g_variant_builder_add (&main_builder, "{sv}",
+					"format_version",
+					g_variant_new_uint32 (CACHE_FORMAT_VERSION));
+		g_variant_builder_add (&main_builder, "{sv}",
+					"locale",
+					g_variant_new_string (locale));
+		g_variant_builder_add (&main_builder, "{sv}",
+					"files",
+					g_variant_builder_end (&entries_b));
+		main_gv = g_variant_ref_sink (g_variant_builder_end (&main_builder));
+
+		if (!as_cache_write_variant (cache_fname, main_gv, &tmp_error))
+			g_debug ("Unable to update local metadata cache: %s", tmp_error->message);
+	} else {
+		g_variant_builder_clear (&entries_b);
+	}
+
+	if (n_parsed != NULL)
+		*n_parsed = parsed;
+	return cpts;
+}
+
+/**
+ * AsCacheSource:
+ *
+ * A metadata file with the fingerprint it had when its data was cached.
+ */
+typedef struct {
+	gchar		*fname;
+	gint64		mtime;		/* in nanoseconds */
+	gint64		ctime;		/* in nanoseconds */
+	guint64		size;
+} AsCacheSource;
+
+/**
+ * AsCacheShard:
+ *
+ * The cached data of all collection metadata files of one origin.
+ */
+typedef struct {
+	gchar		*origin;
+	gchar		*checksum;	/* of the shared data, %NULL if the shard holds no components */
+	GPtrArray	*files;		/* of AsCacheSource */
+	GPtrArray	*locales;	/* of utf8 */
+	gboolean	valid;
+} AsCacheShard;
+
+static AsCacheSource*
+as_cache_source_new (const gchar *fname, gint64 mtime, gint64 ctime, guint64 size)
+{
+	AsCacheSource *src = g_new0 (AsCacheSource, 1);
+	src->fname = g_strdup (fname);
+	src->mtime = mtime;
+	src->ctime = ctime;
+	src->size = size;
+	return src;
+}
+
+static void
+as_cache_source_free (AsCacheSource *src)
+{
+	g_free (src->fname);
+	g_free (src);
+}
+
+static AsCacheShard*
+as_cache_shard_new (const gchar *origin)
+{
+	AsCacheShard *shard = g_new0 (AsCacheShard, 1);
+	shard->origin = g_strdup (origin);
+	shard->files = g_ptr_array_new_with_free_func ((GDestroyNotify) as_cache_source_free);
+	shard->locales = g_ptr_array_new_with_free_func (g_free);
+	return shard;
+}
+
+static void
+as_cache_shard_free (AsCacheShard *shard)
+{
+	g_free (shard->origin);
+	g_free (shard->checksum);
+	g_ptr_array_unref (shard->files);
+	g_ptr_array_unref (shard->locales);
+	g_free (shard);
+}
+
+/**
+ * as_cache_shard_get_dir:
+ *
+ * Returns: The directory the data of the shard for @origin is stored in.
+ */
+static gchar*
+as_cache_shard_get_dir (const gchar *cache_dir, const gchar *origin)
+{
+	g_autofree gchar *origin_esc = NULL;
+	g_autofree gchar *dirname = NULL;
+
+	origin_esc = g_uri_escape_string (origin, NULL, FALSE);
+	dirname = g_strdup_printf ("origin-%s", origin_esc);
+	return g_build_filename (cache_dir, "shards", dirname, NULL);
+}
+
+/**
+ * as_cache_shard_has_locale:
+ */
+static gboolean
+as_cache_shard_has_locale (AsCacheShard *shard, const gchar *locale)
+{
+	guint i;
+
+	for (i = 0; i < shard->locales->len; i++) {
+		if (g_strcmp0 (g_ptr_array_index (shard->locales, i), locale) == 0)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/**
+ * as_cache_locales_add:
+ *
+ * Add @locale to @locales, unless it is already in the list.
+ */
+static void
+as_cache_locales_add (GPtrArray *locales, const gchar *locale)
+{
+	guint i;
+
+	for (i = 0; i < locales->len; i++) {
+		if (g_strcmp0 (g_ptr_array_index (locales, i), locale) == 0)
+			return;
+	}
+	g_ptr_array_add (locales, (gpointer) locale);
+}
+
+/**
+ * as_cache_shard_remove_stale_tables:
+ *
+ * Delete the per-locale string tables in @shard_dir which are not
+ * for one of @locales.
+ */
+static void
+as_cache_shard_remove_stale_tables (const gchar *shard_dir, GPtrArray *locales)
+{
+	g_autoptr(GDir) dir = NULL;
+	const gchar *fname;
+
+	dir = g_dir_open (shard_dir, 0, NULL);
+	if (dir == NULL)
+		return;
+	while ((fname = g_dir_read_name (dir)) != NULL) {
+		g_autofree gchar *locale = NULL;
+		g_autofree gchar *path = NULL;
+		gboolean known = FALSE;
+		guint i;
+
+		if (!g_str_has_suffix (fname, ".gvz") || g_strcmp0 (fname, "core.gvz") == 0)
+			continue;
+		locale = g_strndup (fname, strlen (fname) - strlen (".gvz"));
+		for (i = 0; i < locales->len; i++) {
+			if (g_strcmp0 (g_ptr_array_index (locales, i), locale) == 0) {
+				known = TRUE;
+				break;
+			}
+		}
+		if (known)
+			continue;
+
+		path = g_build_filename (shard_dir, fname, NULL);
+		g_debug ("Removing stale string table: %s", path);
+		g_remove (path);
+	}
+}
+
+/**
+ * as_cache_shards_index_load:
+ *
+ * Load the index of the shards in @cache_dir.
+ *
+ * Returns: (transfer full): Hash table of origin to #AsCacheShard, or %NULL if no
+ * valid index exists.
+ */
+static GHashTable*
+as_cache_shards_index_load (const gchar *cache_dir, GError **error)
+{
+	GHashTable *shards;
+	g_autoptr(GVariant) index_gv = NULL;
+	g_autoptr(GVariant) shards_gv = NULL;
+	g_autofree gchar *index_fname = NULL;
+	GVariantIter iter;
+	const gchar *origin;
+	GVariant *entry;
+
+	index_fname = g_build_filename (cache_dir, "shards.gvz", NULL);
+	index_gv = as_cache_read_variant (index_fname, error);
+	if (index_gv == NULL)
+		return NULL;
+
+	shards_gv = g_variant_lookup_value (index_gv, "shards", G_VARIANT_TYPE ("a{s(msa(sxxt)as)}"));
+	if (shards_gv == NULL) {
+		g_set_error (error,
+			     AS_POOL_ERROR,
+			     AS_POOL_ERROR_FAILED,
+			     "Cache index '%s' is invalid.", index_fname);
+		return NULL;
+	}
+
+	shards = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) as_cache_shard_free);
+	g_variant_iter_init (&iter, shards_gv);
+	while (g_variant_iter_next (&iter, "{&s@(msa(sxxt)as)}", &origin, &entry)) {
+		AsCacheShard *shard = as_cache_shard_new (origin);
+		g_autoptr(GVariantIter) files_iter = NULL;
+		g_autoptr(GVariantIter) locales_iter = NULL;
+		const gchar *fname;
+		const gchar *locale;
+		gint64 mtime;
+		gint64 ctime;
+		guint64 size;
+
+		g_variant_get (entry, "(msa(sxxt)as)", &shard->checksum, &files_iter, &locales_iter);
+		while (g_variant_iter_next (files_iter, "(&sxxt)", &fname, &mtime, &ctime, &size))
+			g_ptr_array_add (shard->files, as_cache_source_new (fname, mtime, ctime, size));
+		while (g_variant_iter_next (locales_iter, "&s", &locale))
+			g_ptr_array_add (shard->locales, g_strdup (locale));
+
+		g_hash_table_replace (shards, shard->origin, shard);
+		g_variant_unref (entry);
+	}
+
+	return shards;
+}
+
+/**
+ * as_cache_shards_index_save:
+ *
+ * Write the index of the shards in @cache_dir.
+ */
+static gboolean
+as_cache_shards_index_save (const gchar *cache_dir, GHashTable *shards, GError **error)
+{
+	g_autoptr(GVariant) index_gv = NULL;
+	g_autofree gchar *index_fname = NULL;
+	g_autoptr(GList) origins = NULL;
+	GVariantBuilder shards_b;
+	GVariantBuilder main_builder;
+	GList *l;
+
+	g_variant_builder_init (&shards_b, G_VARIANT_TYPE ("a{s(msa(sxxt)as)}"));
+	origins = g_list_sort (g_hash_table_get_keys (shards), (GCompareFunc) g_strcmp0);
+	for (l = origins; l != NULL; l = l->next) {
+		AsCacheShard *shard = g_hash_table_lookup (shards, l->data);
+		GVariantBuilder files_b;
+		GVariantBuilder locales_b;
+		guint j;
+
+		g_variant_builder_init (&files_b, G_VARIANT_TYPE ("a(sxxt)"));
+		for (j = 0; j < shard->files->len; j++) {
+			AsCacheSource *src = (AsCacheSource*) g_ptr_array_index (shard->files, j);
+			g_variant_builder_add (&files_b, "(sxxt)", src->fname, src->mtime, src->ctime, src->size);
+		}
+		g_variant_builder_init (&locales_b, G_VARIANT_TYPE ("as"));
+		for (j = 0; j < shard->locales->len; j++)
+			g_variant_builder_add (&locales_b, "s", (const gchar*) g_ptr_array_index (shard->locales, j));
+
+		g_variant_builder_add (&shards_b, "{s(msa(sxxt)as)}",
+				       shard->origin,
+				       shard->checksum,
+				       &files_b,
+				       &locales_b);
+	}
+
+	g_variant_builder_init (&main_builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add (&main_builder, "{sv}",
+				"format_version",
+				g_variant_new_uint32 (CACHE_FORMAT_VERSION));
+	g_variant_builder_add (&main_builder, "{sv}",
+				"shards",
+				g_variant_builder_end (&shards_b));
+	index_gv = g_variant_ref_sink (g_variant_builder_end (&main_builder));
+
+	index_fname = g_build_filename (cache_dir, "shards.gvz", NULL);
+	return as_cache_write_variant (index_fname, index_gv, error);
+}
+
+/**
+ * as_cache_shards_have_locales:
+ *
+ * Returns: %TRUE if all shards in @cache_dir have string tables for @locales.
+ */
+static gboolean
+as_cache_shards_have_locales (const gchar *cache_dir, const gchar * const *locales)
+{
+	g_autoptr(GHashTable) shards = NULL;
+	GHashTableIter iter;
+	gpointer value;
+	guint i;
+
+	shards = as_cache_shards_index_load (cache_dir, NULL);
+	if (shards == NULL)
+		return FALSE;
+
+	g_hash_table_iter_init (&iter, shards);
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		for (i = 0; locales[i] != NULL; i++) {
+			if (!as_cache_shard_has_locale ((AsCacheShard*) value, locales[i]))
+				return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * as_cache_shards_update:
+ * @cache_dir: The cache directory.
+ * @files: (element-type utf8): The collection metadata files to cache.
+ * @locales: %NULL-terminated list of locales to write string tables for.
+ * @n_parsed: (out) (optional): Number of files which actually had to be parsed.
+ * @error: A #GError
+ *
+ * Update the cache of collection metadata in @cache_dir. The data is split
+ * into one shard per origin, and a shard is only regenerated if one of the
+ * files it was built from changed, if a new file provides data for its origin,
+ * or if it lacks string tables for one of @locales. All other shards
+ * are left untouched.
+ * A rebuilt shard gets string tables for @locales as well as for all locales
+ * it already had tables for.
+ *
+ * If some of the data could not be read, the cache is updated anyway and
+ * %AS_POOL_ERROR_INCOMPLETE is returned.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+as_cache_shards_update (const gchar *cache_dir,
+			GPtrArray *files,
+			const gchar * const *locales,
+			guint *n_parsed,
+			GError **error)
+{
+	g_autoptr(GHashTable) shards = NULL;
+	g_autoptr(GHashTable) current = NULL;
+	g_autoptr(GHashTable) owners = NULL;
+	g_autoptr(GHashTable) parsed = NULL;
+	g_autoptr(GHashTable) groups = NULL;
+	g_autoptr(GPtrArray) queue = NULL;
+	g_autoptr(AsMetadata) metad = NULL;
+	g_autoptr(GString) data_errors = NULL;
+	g_autoptr(GPtrArray) all_locales = NULL;
+	g_autofree gchar *shards_dir = NULL;
+	gboolean data_valid = TRUE;
+	GHashTableIter ht_iter;
+	gpointer ht_key;
+	gpointer ht_value;
+	guint i;
+
+	if (n_parsed != NULL)
+		*n_parsed = 0;
+
+	shards = as_cache_shards_index_load (cache_dir, NULL);
+	if (shards == NULL)
+		shards = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) as_cache_shard_free);
+
+	/* fingerprints of the current files */
+	current = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) as_cache_source_free);
+	for (i = 0; i < files->len; i++) {
+		const gchar *fname = (const gchar*) g_ptr_array_index (files, i);
+		AsCacheSource *src;
+		GStatBuf sbuf;
+
+		if (g_stat (fname, &sbuf) != 0) {
+			g_warning ("Metadata file '%s' does not exist.", fname);
+			continue;
+		}
+		/* like for the per-file cache, whole seconds are too coarse to notice quick successive edits */
+		src = as_cache_source_new (fname,
+					   (gint64) sbuf.st_mtim.tv_sec * G_GINT64_CONSTANT (1000000000) + sbuf.st_mtim.tv_nsec,
+					   (gint64) sbuf.st_ctim.tv_sec * G_GINT64_CONSTANT (1000000000) + sbuf.st_ctim.tv_nsec,
+					   (guint64) sbuf.st_size);
+		g_hash_table_replace (current, src->fname, src);
+	}
+
+	/* check which shards are still up to date */
+	owners = g_hash_table_new (g_str_hash, g_str_equal);
+	g_hash_table_iter_init (&ht_iter, shards);
+	while (g_hash_table_iter_next (&ht_iter, NULL, &ht_value)) {
+		AsCacheShard *shard = (AsCacheShard*) ht_value;
+
+		shard->valid = TRUE;
+		for (i = 0; i < shard->files->len; i++) {
+			AsCacheSource *src = (AsCacheSource*) g_ptr_array_index (shard->files, i);
+			AsCacheSource *csrc = g_hash_table_lookup (current, src->fname);
+
+			if ((csrc == NULL) ||
+			    (csrc->mtime != src->mtime) ||
+			    (csrc->ctime != src->ctime) ||
+			    (csrc->size != src->size))
+				shard->valid = FALSE;
+			g_hash_table_insert (owners, src->fname, shard);
+		}
+		for (i = 0; locales[i] != NULL; i++) {
+			if (!as_cache_shard_has_locale (shard, locales[i]))
+				shard->valid = FALSE;
+		}
+	}
+
+	/* parse all files which are new or belong to an outdated shard */
+	queue = g_ptr_array_new ();
+	for (i = 0; i < files->len; i++) {
+		AsCacheSource *src = g_hash_table_lookup (current, g_ptr_array_index (files, i));
+		AsCacheShard *shard;
+
+		if (src == NULL)
+			continue;
+		shard = g_hash_table_lookup (owners, src->fname);
+		if ((shard == NULL) || !shard->valid)
+			g_ptr_array_add (queue, src->fname);
+	}
+
+	/* rebuilt shards keep the string tables they already had, so we need to
+	 * know about all locales any shard has data for */
+	all_locales = g_ptr_array_new ();
+	for (i = 0; locales[i] != NULL; i++)
+		as_cache_locales_add (all_locales, locales[i]);
+	g_hash_table_iter_init (&ht_iter, shards);
+	while (g_hash_table_iter_next (&ht_iter, NULL, &ht_value)) {
+		AsCacheShard *shard = (AsCacheShard*) ht_value;
+		guint j;
+
+		for (j = 0; j < shard->locales->len; j++)
+			as_cache_locales_add (all_locales, g_ptr_array_index (shard->locales, j));
+	}
+
+	metad = as_metadata_new ();
+	as_metadata_set_format_style (metad, AS_FORMAT_STYLE_COLLECTION);
+	/* we need all translations if we write string tables for more than one locale */
+	as_metadata_set_locale (metad, (all_locales->len == 1)? g_ptr_array_index (all_locales, 0) : "ALL");
+
+	parsed = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) g_ptr_array_unref);
+	groups = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+	data_errors = g_string_new ("");
+
+	/* the queue grows while we iterate over it, in case we need to rebuild more shards */
+	for (i = 0; i < queue->len; i++) {
+		const gchar *fname = (const gchar*) g_ptr_array_index (queue, i);
+		const gchar *origin = "";
+		g_autoptr(GFile) infile = NULL;
+		g_autoptr(GError) tmp_error = NULL;
+		GPtrArray *fcpts;
+		GPtrArray *group;
+		AsCacheShard *shard;
+		guint j;
+
+		if (g_hash_table_contains (parsed, fname))
+			continue;
+
+		g_debug ("Reading: %s", fname);
+		as_metadata_clear_components (metad);
+		infile = g_file_new_for_path (fname);
+		as_metadata_parse_file (metad,
+					infile,
+					AS_FORMAT_KIND_UNKNOWN,
+					&tmp_error);
+		if (tmp_error != NULL) {
+			g_debug ("WARNING: %s", tmp_error->message);
+			if (data_errors->len > 0)
+				g_string_append (data_errors, ", ");
+			g_string_append (data_errors, fname);
+			data_valid = FALSE;
+		}
+		if (n_parsed != NULL)
+			(*n_parsed)++;
 
-	g_autoptr(GFile) ofile = NULL;
-	g_autoptr(GFileOutputStream) file_out = NULL;
-	g_autoptr(GOutputStream) zout = NULL;
-	g_autoptr(GZlibCompressor) compressor = NULL;
-	gboolean serializable_components_found = FALSE;
-	GError *tmp_error = NULL;
-	guint cindex;
+		fcpts = g_ptr_array_new_with_free_func (g_object_unref);
+		for (j = 0; j < as_metadata_get_components (metad)->len; j++) {
+			AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (as_metadata_get_components (metad), j));
 
-	if (cpts->len == 0) {
-		g_debug ("Skipped writing cache file: No components to serialize.");
-		return;
+			if ((as_component_get_merge_kind (cpt) == AS_MERGE_KIND_NONE) && !as_component_is_valid (cpt)) {
+				g_debug ("Ignored '%s': The component (from '%s') is invalid.",
+					 as_component_get_id (cpt), fname);
+				data_valid = FALSE;
+				continue;
+			}
+			g_ptr_array_add (fcpts, g_object_ref (cpt));
+		}
+		g_hash_table_insert (parsed, (gpointer) fname, fcpts);
+
+		/* all components of a collection file share the origin of the file */
+		if ((fcpts->len > 0) && (as_component_get_origin (AS_COMPONENT (g_ptr_array_index (fcpts, 0))) != NULL))
+			origin = as_component_get_origin (AS_COMPONENT (g_ptr_array_index (fcpts, 0)));
+
+		group = g_hash_table_lookup (groups, origin);
+		if (group == NULL) {
+			group = g_ptr_array_new ();
+			g_hash_table_insert (groups, g_strdup (origin), group);
+		}
+		g_ptr_array_add (group, (gpointer) fname);
+
+		/* the shard of this origin needs to be rebuilt completely now */
+		shard = g_hash_table_lookup (shards, origin);
+		if ((shard != NULL) && shard->valid) {
+			shard->valid = FALSE;
+			for (j = 0; j < shard->files->len; j++) {
+				AsCacheSource *src = (AsCacheSource*) g_ptr_array_index (shard->files, j);
+				AsCacheSource *csrc = g_hash_table_lookup (current, src->fname);
+
+				if (csrc != NULL)
+					g_ptr_array_add (queue, csrc->fname);
+			}
+		}
 	}
 
-	main_builder = g_variant_builder_new (G_VARIANT_TYPE_VARDICT);
-	builder = g_variant_builder_new (G_VARIANT_TYPE_ARRAY);
+	/* write the shards which were rebuilt */
+	shards_dir = g_build_filename (cache_dir, "shards", NULL);
+	g_hash_table_iter_init (&ht_iter, groups);
+	while (g_hash_table_iter_next (&ht_iter, &ht_key, &ht_value)) {
+		const gchar *origin = (const gchar*) ht_key;
+		GPtrArray *group = (GPtrArray*) ht_value;
+		AsCacheShard *old_shard;
+		AsCacheShard *shard;
+		g_autoptr(GPtrArray) cpts = NULL;
+		g_autoptr(GPtrArray) shard_locales = NULL;
+		g_autofree gchar *shard_dir = NULL;
+		g_autoptr(GError) tmp_error = NULL;
+
+		/* write tables for the requested locales as well as for all the
+		 * ones the shard already had, so refreshing the cache for one set
+		 * of locales does not throw away the data of another */
+		shard_locales = g_ptr_array_new ();
+		for (i = 0; locales[i] != NULL; i++)
+			as_cache_locales_add (shard_locales, locales[i]);
+		old_shard = g_hash_table_lookup (shards, origin);
+		if (old_shard != NULL) {
+			for (i = 0; i < old_shard->locales->len; i++)
+				as_cache_locales_add (shard_locales, g_ptr_array_index (old_shard->locales, i));
+		}
 
-	for (cindex = 0; cindex < cpts->len; cindex++) {
-		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (cpts, cindex));
+		shard = as_cache_shard_new (origin);
+		cpts = g_ptr_array_new ();
+		for (i = 0; i < group->len; i++) {
+			const gchar *fname = (const gchar*) g_ptr_array_index (group, i);
+			AsCacheSource *src = g_hash_table_lookup (current, fname);
+			GPtrArray *fcpts = g_hash_table_lookup (parsed, fname);
+			guint j;
 
-		/* sanity checks */
-		if (!as_component_is_valid (cpt)) {
-			/* we should *never* get here, all invalid stuff should be filtered out at this point */
-			g_critical ("Skipped component '%s' from inclusion into the cache: The component is invalid.",
-					   as_component_get_id (cpt));
-			continue;
+			g_ptr_array_add (shard->files, as_cache_source_new (src->fname, src->mtime, src->ctime, src->size));
+			for (j = 0; j < fcpts->len; j++)
+				g_ptr_array_add (cpts, g_ptr_array_index (fcpts, j));
 		}
 
-		if (as_component_get_merge_kind (cpt) != AS_MERGE_KIND_NONE) {
-			g_debug ("Skipping '%s' from cache inclusion, it is a merge component.",
-				 as_component_get_id (cpt));
-			continue;
+		shard_dir = as_cache_shard_get_dir (cache_dir, origin);
+		g_mkdir_with_parents (shard_dir, 0755);
+		g_debug ("Writing cache for origin '%s'", origin);
+		g_ptr_array_add (shard_locales, NULL);
+		as_cache_files_save (shard_dir,
+				     (const gchar * const *) shard_locales->pdata,
+				     cpts,
+				     &shard->checksum,
+				     &tmp_error);
+		g_ptr_array_remove_index (shard_locales, shard_locales->len - 1);
+		if (tmp_error != NULL) {
+			as_cache_shard_free (shard);
+			g_set_error (error,
+				     AS_POOL_ERROR,
+				     AS_POOL_ERROR_FAILED,
+				     "Unable to write cache for origin '%s': %s", origin, tmp_error->message);
+			return FALSE;
 		}
-		serializable_components_found = TRUE;
+		if (shard->checksum == NULL)
+			as_utils_delete_dir_recursive (shard_dir);
+		else
+			as_cache_shard_remove_stale_tables (shard_dir, shard_locales);
 
-		as_component_to_variant (cpt, builder);
-	}
+		for (i = 0; i < shard_locales->len; i++)
+			g_ptr_array_add (shard->locales, g_strdup (g_ptr_array_index (shard_locales, i)));
 
-	/* check if we actually have some valid components serialized to a GVariant */
-	if (!serializable_components_found) {
-		g_debug ("Skipped writing cache file: No valid components found for serialization.");
-		return;
+		g_hash_table_replace (shards, shard->origin, shard);
 	}
 
-	/* write basic information and add components */
-	g_variant_builder_add (main_builder, "{sv}",
-				"format_version",
-				g_variant_new_uint32 (CACHE_FORMAT_VERSION));
-	g_variant_builder_add (main_builder, "{sv}",
-				"locale",
-				as_variant_mstring_new (locale));
-
-	g_variant_builder_add (main_builder, "{sv}",
-				"components",
-				g_variant_builder_end (builder));
-	main_gv = g_variant_builder_end (main_builder);
+	/* drop shards which no longer have any data */
+	g_hash_table_iter_init (&ht_iter, shards);
+	while (g_hash_table_iter_next (&ht_iter, &ht_key, &ht_value)) {
+		AsCacheShard *shard = (AsCacheShard*) ht_value;
+		g_autofree gchar *shard_dir = NULL;
 
-	ofile = g_file_new_for_path (fname);
-	compressor = g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1);
-	file_out = g_file_replace (ofile,
-				   NULL, /* entity-tag */
-				   FALSE, /* make backup */
-				   G_FILE_CREATE_REPLACE_DESTINATION,
-				   NULL, /* cancellable */
-				   error);
-	if ((error != NULL) && (*error != NULL))
-		return;
+		if (shard->valid || g_hash_table_contains (groups, shard->origin))
+			continue;
 
-	zout = g_converter_output_stream_new (G_OUTPUT_STREAM (file_out), G_CONVERTER (compressor));
-	if (!g_output_stream_write_all (zout,
-					g_variant_get_data (main_gv),
-					g_variant_get_size (main_gv),
-					NULL, NULL, &tmp_error)) {
-		g_set_error (error,
-			     AS_POOL_ERROR,
-			     AS_POOL_ERROR_FAILED,
-			     "Failed to write stream: %s",
-			     tmp_error->message);
-		g_error_free (tmp_error);
-		return;
+		g_debug ("Removing cache for origin '%s'", shard->origin);
+		shard_dir = as_cache_shard_get_dir (cache_dir, shard->origin);
+		as_utils_delete_dir_recursive (shard_dir);
+		g_hash_table_iter_remove (&ht_iter);
 	}
-	if (!g_output_stream_close (zout, NULL, &tmp_error)) {
-		g_set_error (error,
-			     AS_POOL_ERROR,
-			     AS_POOL_ERROR_FAILED,
-			     "Failed to close stream: %s",
-			     tmp_error->message);
-		g_error_free (tmp_error);
-		return;
+
+	if (!as_cache_shards_index_save (cache_dir, shards, error))
+		return FALSE;
+
+	if (!data_valid) {
+		if (data_errors->len > 0)
+			g_set_error (error,
+				     AS_POOL_ERROR,
+				     AS_POOL_ERROR_INCOMPLETE,
+				     "%s %s", _("Metadata files have errors:"), data_errors->str);
+		else
+			g_set_error_literal (error,
+					     AS_POOL_ERROR,
+					     AS_POOL_ERROR_INCOMPLETE,
+					     _("Some components were invalid and have been ignored."));
+		return FALSE;
 	}
+
+	return TRUE;
 }
 
 /**
- * as_cache_read:
- * @fname: The file to save the data to.
- * @locale: The locale this cache file is for.
- * @cpts: (element-type AsComponent): The components to serialize.
+ * as_cache_shards_read:
+ * @cache_dir: The cache directory.
+ * @locale: The locale to load the data for.
+ * @fields: The optional component data to load right away.
  * @error: A #GError
  *
- * Serialize components to a cache file and store it on disk.
+ * Load the components of all shards in @cache_dir. The components are
+ * returned as they were read from the metadata, merge components have
+ * not been applied yet.
+ *
+ * Returns: (transfer container) (element-type AsComponent): The components, or %NULL on error.
  */
 GPtrArray*
-as_cache_file_read (const gchar *fname, GError **error)
+as_cache_shards_read (const gchar *cache_dir, const gchar *locale, AsComponentField fields, GError **error)
 {
-	GPtrArray *cpts = NULL;
-	g_autoptr(GFile) ifile = NULL;
-	g_autoptr(GInputStream) file_stream = NULL;
-	g_autoptr(GInputStream) stream_data = NULL;
-	g_autoptr(GConverter) conv = NULL;
-
-	GByteArray *byte_array;
-	g_autoptr(GBytes) bytes = NULL;
-	gssize len;
-	const gsize buffer_size = 1024 * 32;
-	g_autofree guint8 *buffer = NULL;
-
-	g_autoptr(GVariant) main_gv = NULL;
-	g_autoptr(GVariant) cptsv_array = NULL;
-	g_autoptr(GVariant) cptv = NULL;
-	g_autoptr(GVariant) gmvar = NULL;
-	const gchar *locale = NULL;
-	GVariantIter main_iter;
-
-	ifile = g_file_new_for_path (fname);
-
-	file_stream = G_INPUT_STREAM (g_file_read (ifile, NULL, error));
-	if (file_stream == NULL)
-		return NULL;
-
-	/* decompress the GZip stream */
-	conv = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP));
-	stream_data = g_converter_input_stream_new (file_stream, conv);
-
-	buffer = g_malloc (buffer_size);
-	byte_array = g_byte_array_new ();
-	while ((len = g_input_stream_read (stream_data, buffer, buffer_size, NULL, error)) > 0) {
-		g_byte_array_append (byte_array, buffer, len);
-	}
-	bytes = g_byte_array_free_to_bytes (byte_array);
+	g_autoptr(GHashTable) shards = NULL;
+	g_autoptr(GPtrArray) cpts = NULL;
+	g_autoptr(GList) origins = NULL;
+	GList *l;
 
-	/* check if there was an error */
-	if (len < 0)
-		return NULL;
-	if ((error != NULL) && (*error != NULL))
+	shards = as_cache_shards_index_load (cache_dir, error);
+	if (shards == NULL)
 		return NULL;
 
-	main_gv = g_variant_new_from_bytes (G_VARIANT_TYPE_VARDICT, bytes, TRUE);
 	cpts = g_ptr_array_new_with_free_func (g_object_unref);
+	/* load in a stable order, so components of equal priority always replace each other the same way */
+	origins = g_list_sort (g_hash_table_get_keys (shards), (GCompareFunc) g_strcmp0);
+	for (l = origins; l != NULL; l = l->next) {
+		AsCacheShard *shard = g_hash_table_lookup (shards, l->data);
+		g_autoptr(GPtrArray) shard_cpts = NULL;
+		g_autofree gchar *shard_dir = NULL;
+		g_autofree gchar *fname = NULL;
+		guint j;
 
-	gmvar = g_variant_lookup_value (main_gv,
-					"format_version",
-					G_VARIANT_TYPE_UINT32);
-	if ((gmvar == NULL) || (g_variant_get_uint32 (gmvar) != CACHE_FORMAT_VERSION)) {
-		/* don't try to load incompatible cache versions */
-		if (gmvar == NULL)
-			g_warning ("Skipped loading of broken cache file '%s'.", fname);
-		else
-			g_warning ("Skipped loading of incompatible or broken cache file '%s': Format is %i (expected %i)",
-					fname, g_variant_get_uint32 (gmvar), CACHE_FORMAT_VERSION);
-
-		/* TODO: Maybe emit a proper GError? */
-		return NULL;
-	}
+		/* nothing to load */
+		if (shard->checksum == NULL)
+			continue;
 
-	g_variant_unref (gmvar);
-	gmvar = g_variant_lookup_value (main_gv,
-					"locale",
-					G_VARIANT_TYPE_MAYBE);
-	locale = as_variant_get_mstring (&gmvar);
+		if (!as_cache_shard_has_locale (shard, locale)) {
+			g_set_error (error,
+				     AS_POOL_ERROR,
+				     AS_POOL_ERROR_FAILED,
+				     "The cache for origin '%s' has no data for locale '%s'.", shard->origin, locale);
+			return NULL;
+		}
 
-	cptsv_array = g_variant_lookup_value (main_gv,
-					      "components",
-					      G_VARIANT_TYPE_ARRAY);
+		shard_dir = as_cache_shard_get_dir (cache_dir, shard->origin);
+		fname = g_strdup_printf ("%s/%s.gvz", shard_dir, locale);
+		shard_cpts = as_cache_file_read_internal (fname, FALSE, fields, error);
+		if (shard_cpts == NULL)
+			return NULL;
 
-	g_variant_iter_init (&main_iter, cptsv_array);
-	while ((cptv = g_variant_iter_next_value (&main_iter))) {
-		g_autoptr(AsComponent) cpt = as_component_new ();
-		if (as_component_set_from_variant (cpt, cptv, locale)) {
-			/* add to result list */
-			if (as_component_is_valid (cpt)) {
-				g_ptr_array_add (cpts, g_object_ref (cpt));
-			} else {
-				g_autofree gchar *str = as_component_to_string (cpt);
-				g_warning ("Ignored serialized component: %s", str);
-			}
-		}
-		g_variant_unref (cptv);
+		for (j = 0; j < shard_cpts->len; j++)
+			g_ptr_array_add (cpts, g_object_ref (g_ptr_array_index (shard_cpts, j)));
 	}
 
-	return cpts;
+	return g_steal_pointer (&cpts);
 }
 
 /**
@@ -1806,6 +3794,60 @@ as_pool_get_locale (AsPool *pool)
 	return priv->locale;
 }
 
+/**
+ * as_pool_get_parent:
+ * @pool: An instance of #AsPool.
+ *
+ * Gets the pool @pool is layered on, see as_pool_set_parent().
+ *
+ * Returns: (transfer none) (nullable): The parent pool, or %NULL.
+ *
+ * Since: 0.12.3
+ **/
+AsPool*
+as_pool_get_parent (AsPool *pool)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	return priv->parent;
+}
+
+/**
+ * as_pool_set_parent:
+ * @pool: An instance of #AsPool.
+ * @parent: (nullable): The pool to layer @pool on, or %NULL.
+ *
+ * Turn @pool into an overlay of @parent. All queries on @pool will also
+ * return the components of @parent, unless @pool contains a component with
+ * the same data-ID. Components added to @pool are checked against the ones
+ * of @parent using the usual priority and merge rules, but @parent itself
+ * is never modified: if a component of @parent needs to be changed, e.g. to
+ * apply a merge, @pool stores a modified copy of it instead.
+ *
+ * This allows sharing one pool with the system data between multiple
+ * overlay pools which only hold additional data, for example for
+ * per-user installations.
+ * Overlay pools should usually only load data from their own metadata
+ * locations, see as_pool_clear_metadata_locations() and as_pool_set_flags().
+ *
+ * Since: 0.12.3
+ **/
+void
+as_pool_set_parent (AsPool *pool, AsPool *parent)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	AsPool *tmp;
+
+	/* refuse to create loops */
+	for (tmp = parent; tmp != NULL; tmp = as_pool_get_parent (tmp))
+		g_return_if_fail (tmp != pool);
+
+	if (parent != NULL)
+		g_object_ref (parent);
+	if (priv->parent != NULL)
+		g_object_unref (priv->parent);
+	priv->parent = parent;
+}
+
 /**
  * as_pool_add_metadata_location_internal:
  * @pool: An instance of #AsPool.
@@ -1931,6 +3973,167 @@ as_pool_set_cache_flags (AsPool *pool, AsCacheFlags flags)
 	priv->cache_flags = flags;
 }
 
+/**
+ * as_pool_get_load_fields:
+ * @pool: An instance of #AsPool.
+ *
+ * Get the optional component data which is loaded from caches right away.
+ *
+ * Returns: The #AsComponentField flags.
+ *
+ * Since: 0.12.3
+ */
+AsComponentField
+as_pool_get_load_fields (AsPool *pool)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	return priv->load_fields;
+}
+
+/**
+ * as_pool_set_load_fields:
+ * @pool: An instance of #AsPool.
+ * @fields: The #AsComponentField flags.
+ *
+ * Set which optional component data should be loaded from caches
+ * right away. Applications which only need a subset of the data,
+ * like launchers or search providers, can use this to speed up
+ * loading the pool and to reduce its memory usage.
+ * Data which was skipped is loaded transparently once it is accessed.
+ *
+ * Since loading skipped data modifies the component, reading a component
+ * which still has skipped fields is not thread-safe: if the components of
+ * the pool are accessed from multiple threads, either load all fields or
+ * protect the access with a lock.
+ *
+ * Defaults to all fields except for %AS_COMPONENT_FIELD_DESCRIPTION.
+ *
+ * Since: 0.12.3
+ */
+void
+as_pool_set_load_fields (AsPool *pool, AsComponentField fields)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	priv->load_fields = fields;
+}
+
+/**
+ * as_pool_memory_kind_to_string:
+ * @kind: the #AsPoolMemoryKind.
+ *
+ * Converts the enumerated value to a text representation.
+ *
+ * Returns: string version of @kind
+ *
+ * Since: 0.12.3
+ **/
+const gchar*
+as_pool_memory_kind_to_string (AsPoolMemoryKind kind)
+{
+	if (kind == AS_POOL_MEMORY_KIND_TOTAL)
+		return "total";
+	if (kind == AS_POOL_MEMORY_KIND_STRINGS)
+		return "strings";
+	if (kind == AS_POOL_MEMORY_KIND_LOCALIZED)
+		return "localized";
+	if (kind == AS_POOL_MEMORY_KIND_RELEASES)
+		return "releases";
+	if (kind == AS_POOL_MEMORY_KIND_SCREENSHOTS)
+		return "screenshots";
+	if (kind == AS_POOL_MEMORY_KIND_ICONS)
+		return "icons";
+	if (kind == AS_POOL_MEMORY_KIND_TOKENS)
+		return "tokens";
+	if (kind == AS_POOL_MEMORY_KIND_INDEXES)
+		return "indexes";
+	if (kind == AS_POOL_MEMORY_KIND_CACHE_DATA)
+		return "cache-data";
+	return "unknown";
+}
+
+/**
+ * as_pool_memory_size_index:
+ *
+ * Approximate memory used by a table of component arrays.
+ */
+static gsize
+as_pool_memory_size_index (GHashTable *index)
+{
+	GHashTableIter iter;
+	gpointer value;
+	gsize size;
+
+	size = as_memory_size_str_table (index, FALSE, FALSE);
+	g_hash_table_iter_init (&iter, index);
+	while (g_hash_table_iter_next (&iter, NULL, &value))
+		size += as_memory_size_str_array ((GPtrArray*) value, FALSE);
+	return size;
+}
+
+/**
+ * as_pool_get_memory_usage_all:
+ * @pool: An instance of #AsPool.
+ * @usage: (out caller-allocates) (array fixed-size=9): return location for
+ *         %AS_POOL_MEMORY_KIND_LAST counters, indexed by #AsPoolMemoryKind.
+ *
+ * Get the approximate amount of heap memory the data of this pool uses,
+ * for all categories at once. Memory of a parent pool is not included.
+ *
+ * This has to look at all components of the pool, so it should not be
+ * called in performance-critical code.
+ *
+ * Since: 0.12.3
+ */
+void
+as_pool_get_memory_usage_all (AsPool *pool, guint64 *usage)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+	GHashTableIter iter;
+	gpointer value;
+	guint i;
+
+	memset (usage, 0, sizeof (guint64) * AS_POOL_MEMORY_KIND_LAST);
+
+	g_hash_table_iter_init (&iter, priv->cpt_table);
+	while (g_hash_table_iter_next (&iter, NULL, &value))
+		as_component_count_memory (AS_COMPONENT (value), usage);
+
+	usage[AS_POOL_MEMORY_KIND_INDEXES] = as_memory_size_str_table (priv->cpt_table, TRUE, FALSE)
+		+ as_memory_size_str_table (priv->known_cids, TRUE, FALSE)
+		+ as_pool_memory_size_index (priv->addons_index)
+		+ as_pool_memory_size_index (priv->extends_index);
+
+	for (i = AS_POOL_MEMORY_KIND_TOTAL + 1; i < AS_POOL_MEMORY_KIND_LAST; i++)
+		usage[AS_POOL_MEMORY_KIND_TOTAL] += usage[i];
+}
+
+/**
+ * as_pool_get_memory_usage:
+ * @pool: An instance of #AsPool.
+ * @kind: The #AsPoolMemoryKind to query.
+ *
+ * Get the approximate amount of heap memory the data of this pool
+ * uses for the category @kind. Memory of a parent pool is not included.
+ *
+ * This has to look at all components of the pool, so it should not be
+ * called in performance-critical code. Use as_pool_get_memory_usage_all()
+ * to query multiple categories.
+ *
+ * Returns: The amount of memory in bytes.
+ *
+ * Since: 0.12.3
+ */
+guint64
+as_pool_get_memory_usage (AsPool *pool, AsPoolMemoryKind kind)
+{
+	guint64 usage[AS_POOL_MEMORY_KIND_LAST];
+
+	g_return_val_if_fail (kind < AS_POOL_MEMORY_KIND_LAST, 0);
+
+	as_pool_get_memory_usage_all (pool, usage);
+	return usage[kind];
+}
+
 /**
  * as_pool_get_flags:
  * @pool: An instance of #AsPool.
@@ -1971,6 +4174,40 @@ as_pool_get_cache_age (AsPool *pool)
 	return priv->cache_ctime;
 }
 
+/**
+ * as_pool_override_locations:
+ * @pool: An instance of #AsPool.
+ * @cache_dir: (nullable): Directory to use for all caches, or %NULL.
+ * @metainfo_dir: (nullable): Directory to read metainfo files from, or %NULL.
+ * @apps_dir: (nullable): Directory to read .desktop files from, or %NULL.
+ *
+ * Use different locations than the system ones, e.g. for testing.
+ * Locations which are %NULL are left unchanged.
+ *
+ * This is internal API.
+ */
+void
+as_pool_override_locations (AsPool *pool, const gchar *cache_dir, const gchar *metainfo_dir, const gchar *apps_dir)
+{
+	AsPoolPrivate *priv = GET_PRIVATE (pool);
+
+	if (cache_dir != NULL) {
+		g_free (priv->sys_cache_path);
+		g_free (priv->user_cache_path);
+		priv->sys_cache_path = g_strdup (cache_dir);
+		priv->user_cache_path = g_strdup (cache_dir);
+		as_pool_check_cache_ctime (pool);
+	}
+	if (metainfo_dir != NULL) {
+		g_free (priv->metainfo_dir);
+		priv->metainfo_dir = g_strdup (metainfo_dir);
+	}
+	if (apps_dir != NULL) {
+		g_free (priv->apps_dir);
+		priv->apps_dir = g_strdup (apps_dir);
+	}
+}
+
 /**
  * as_pool_error_quark:
  *
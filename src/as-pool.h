@@ -94,11 +94,43 @@ typedef enum {
 	AS_POOL_ERROR_LAST
 } AsPoolError;
 
+/**
+ * AsPoolMemoryKind:
+ * @AS_POOL_MEMORY_KIND_TOTAL:		All memory used by the pool.
+ * @AS_POOL_MEMORY_KIND_STRINGS:	Plain component data, like IDs, package names, URLs and small objects.
+ * @AS_POOL_MEMORY_KIND_LOCALIZED:	Tables of translated component data.
+ * @AS_POOL_MEMORY_KIND_RELEASES:	Release information.
+ * @AS_POOL_MEMORY_KIND_SCREENSHOTS:	Screenshots and their images.
+ * @AS_POOL_MEMORY_KIND_ICONS:		Icons.
+ * @AS_POOL_MEMORY_KIND_TOKENS:		Search token caches.
+ * @AS_POOL_MEMORY_KIND_INDEXES:	Lookup tables of the pool.
+ * @AS_POOL_MEMORY_KIND_CACHE_DATA:	Cache data kept around for component data which was not loaded yet.
+ *
+ * Categories of memory used by a metadata pool.
+ **/
+typedef enum {
+	AS_POOL_MEMORY_KIND_TOTAL,
+	AS_POOL_MEMORY_KIND_STRINGS,
+	AS_POOL_MEMORY_KIND_LOCALIZED,
+	AS_POOL_MEMORY_KIND_RELEASES,
+	AS_POOL_MEMORY_KIND_SCREENSHOTS,
+	AS_POOL_MEMORY_KIND_ICONS,
+	AS_POOL_MEMORY_KIND_TOKENS,
+	AS_POOL_MEMORY_KIND_INDEXES,
+	AS_POOL_MEMORY_KIND_CACHE_DATA,
+	/*< private >*/
+	AS_POOL_MEMORY_KIND_LAST
+} AsPoolMemoryKind;
+
 #define AS_POOL_ERROR	as_pool_error_quark ()
 GQuark			as_pool_error_quark (void);
 
 AsPool			*as_pool_new (void);
 
+AsPool			*as_pool_get_parent (AsPool *pool);
+void			as_pool_set_parent (AsPool *pool,
+						AsPool *parent);
+
 const gchar 		*as_pool_get_locale (AsPool *pool);
 void			as_pool_set_locale (AsPool *pool,
 						const gchar *locale);
@@ -135,6 +167,11 @@ GPtrArray		*as_pool_get_components_by_launchable (AsPool *pool,
 GPtrArray		*as_pool_search (AsPool *pool,
 					 const gchar *search);
 
+GPtrArray		*as_pool_get_addons (AsPool *pool,
+					     AsComponent *cpt);
+GPtrArray		*as_pool_get_extended (AsPool *pool,
+					       AsComponent *addon);
+
 void			as_pool_clear_metadata_locations (AsPool *pool);
 void			as_pool_add_metadata_location (AsPool *pool,
 						       const gchar *directory);
@@ -143,6 +180,16 @@ AsCacheFlags		as_pool_get_cache_flags (AsPool *pool);
 void			as_pool_set_cache_flags (AsPool *pool,
 						      AsCacheFlags flags);
 
+AsComponentField	as_pool_get_load_fields (AsPool *pool);
+void			as_pool_set_load_fields (AsPool *pool,
+						 AsComponentField fields);
+
+const gchar		*as_pool_memory_kind_to_string (AsPoolMemoryKind kind);
+guint64			as_pool_get_memory_usage (AsPool *pool,
+						  AsPoolMemoryKind kind);
+void			as_pool_get_memory_usage_all (AsPool *pool,
+						  guint64 *usage);
+
 AsPoolFlags		as_pool_get_flags (AsPool *pool);
 void			as_pool_set_flags (AsPool *pool,
 						AsPoolFlags flags);
@@ -150,6 +197,10 @@ void			as_pool_set_flags (AsPool *pool,
 gboolean		as_pool_refresh_cache (AsPool *pool,
 						gboolean force,
 						GError **error);
+gboolean		as_pool_refresh_cache_for_locales (AsPool *pool,
+							    gchar **locales,
+							    gboolean force,
+							    GError **error);
 
 G_END_DECLS
 
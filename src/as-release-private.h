@@ -54,6 +54,8 @@ gboolean		as_release_set_from_variant (AsRelease *release,
 						     GVariant *variant,
 						     const gchar *locale);
 
+gsize			as_release_get_memory_size (AsRelease *release);
+
 #pragma GCC visibility pop
 G_END_DECLS
 
@@ -36,6 +36,8 @@
 
 #include "as-release-private.h"
 
+#include <string.h>
+
 #include "as-utils.h"
 #include "as-utils-private.h"
 #include "as-checksum-private.h"
@@ -45,7 +47,10 @@ typedef struct
 {
 	AsReleaseKind	kind;
 	gchar		*version;
+	GBytes		*version_key;
 	GHashTable	*description;
+	GBytes		*description_data; /* description read from a cache, not converted yet */
+	gchar		*description_data_locale;
 	guint64		timestamp;
 
 	AsContext	*context;
@@ -153,10 +158,8 @@ as_release_init (AsRelease *release)
 	/* we assume a stable release by default */
 	priv->kind = AS_RELEASE_KIND_STABLE;
 
-	priv->description = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-	priv->locations = g_ptr_array_new_with_free_func (g_free);
-
-	priv->checksums = g_ptr_array_new_with_free_func (g_object_unref);
+	/* releases are numerous and usually only have a few fields set,
+	 * so the containers are only allocated once they are needed */
 	priv->urgency = AS_URGENCY_KIND_UNKNOWN;
 
 	for (i = 0; i < AS_SIZE_KIND_LAST; i++)
@@ -173,10 +176,18 @@ as_release_finalize (GObject *object)
 	AsReleasePrivate *priv = GET_PRIVATE (release);
 
 	g_free (priv->version);
+	if (priv->version_key != NULL)
+		g_bytes_unref (priv->version_key);
 	g_free (priv->active_locale_override);
-	g_hash_table_unref (priv->description);
-	g_ptr_array_unref (priv->locations);
-	g_ptr_array_unref (priv->checksums);
+	if (priv->description != NULL)
+		g_hash_table_unref (priv->description);
+	if (priv->description_data != NULL)
+		g_bytes_unref (priv->description_data);
+	g_free (priv->description_data_locale);
+	if (priv->locations != NULL)
+		g_ptr_array_unref (priv->locations);
+	if (priv->checksums != NULL)
+		g_ptr_array_unref (priv->checksums);
 	if (priv->context != NULL)
 		g_object_unref (priv->context);
 
@@ -254,6 +265,30 @@ as_release_set_version (AsRelease *release, const gchar *version)
 	AsReleasePrivate *priv = GET_PRIVATE (release);
 	g_free (priv->version);
 	priv->version = g_strdup (version);
+	g_clear_pointer (&priv->version_key, g_bytes_unref);
+}
+
+/**
+ * as_release_get_version_key:
+ * @release: a #AsRelease instance.
+ *
+ * Gets a binary key for the release version, which sorts like the
+ * version itself when compared using g_bytes_compare().
+ * The key is only built once, which makes it useful for sorting or
+ * comparing many releases.
+ * See as_utils_build_version_key() for details.
+ *
+ * Returns: (transfer none): the version key
+ *
+ * Since: 0.12.3
+ **/
+GBytes*
+as_release_get_version_key (AsRelease *release)
+{
+	AsReleasePrivate *priv = GET_PRIVATE (release);
+	if (priv->version_key == NULL)
+		priv->version_key = as_utils_build_version_key (priv->version);
+	return priv->version_key;
 }
 
 /**
@@ -268,8 +303,15 @@ as_release_set_version (AsRelease *release, const gchar *version)
 gint
 as_release_vercmp (AsRelease *rel1, AsRelease *rel2)
 {
-	return as_utils_compare_versions (as_release_get_version (rel1),
-					  as_release_get_version (rel2));
+	gint ret;
+
+	ret = g_bytes_compare (as_release_get_version_key (rel1),
+			       as_release_get_version_key (rel2));
+	if (ret > 0)
+		return 1;
+	if (ret < 0)
+		return -1;
+	return 0;
 }
 
 /**
@@ -374,6 +416,42 @@ as_release_set_size (AsRelease *release, guint64 size, AsSizeKind kind)
 	priv->size[kind] = size;
 }
 
+/**
+ * as_release_get_description_table:
+ * @release: a #AsRelease instance.
+ *
+ * Get the table of localized descriptions, creating it if needed.
+ **/
+static GHashTable*
+as_release_get_description_table (AsRelease *release)
+{
+	AsReleasePrivate *priv = GET_PRIVATE (release);
+	if (priv->description == NULL)
+		priv->description = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	return priv->description;
+}
+
+/**
+ * as_release_load_description:
+ * @release: a #AsRelease instance.
+ *
+ * Move a description which was read from the cache, but not
+ * accessed yet, into the table of descriptions.
+ **/
+static void
+as_release_load_description (AsRelease *release)
+{
+	AsReleasePrivate *priv = GET_PRIVATE (release);
+
+	if (priv->description_data == NULL)
+		return;
+
+	/* we own the only reference, so this does not copy the string again */
+	g_hash_table_insert (as_release_get_description_table (release),
+				g_steal_pointer (&priv->description_data_locale),
+				g_bytes_unref_to_data (g_steal_pointer (&priv->description_data), NULL));
+}
+
 /**
  * as_release_get_description:
  * @release: a #AsRelease instance.
@@ -388,6 +466,10 @@ as_release_get_description (AsRelease *release)
 	const gchar *desc;
 	AsReleasePrivate *priv = GET_PRIVATE (release);
 
+	as_release_load_description (release);
+	if (priv->description == NULL)
+		return NULL;
+
 	desc = g_hash_table_lookup (priv->description, as_release_get_active_locale (release));
 	if (desc == NULL) {
 		/* fall back to untranslated / default */
@@ -407,12 +489,11 @@ as_release_get_description (AsRelease *release)
 void
 as_release_set_description (AsRelease *release, const gchar *description, const gchar *locale)
 {
-	AsReleasePrivate *priv = GET_PRIVATE (release);
-
 	if (locale == NULL)
 		locale = as_release_get_active_locale (release);
 
-	g_hash_table_insert (priv->description,
+	as_release_load_description (release);
+	g_hash_table_insert (as_release_get_description_table (release),
 				g_strdup (locale),
 				g_strdup (description));
 }
@@ -473,6 +554,8 @@ GPtrArray*
 as_release_get_locations (AsRelease *release)
 {
 	AsReleasePrivate *priv = GET_PRIVATE (release);
+	if (priv->locations == NULL)
+		priv->locations = g_ptr_array_new_with_free_func (g_free);
 	return priv->locations;
 }
 
@@ -487,8 +570,7 @@ as_release_get_locations (AsRelease *release)
 void
 as_release_add_location (AsRelease *release, const gchar *location)
 {
-	AsReleasePrivate *priv = GET_PRIVATE (release);
-	g_ptr_array_add (priv->locations, g_strdup (location));
+	g_ptr_array_add (as_release_get_locations (release), g_strdup (location));
 }
 
 /**
@@ -504,6 +586,8 @@ GPtrArray*
 as_release_get_checksums (AsRelease *release)
 {
 	AsReleasePrivate *priv = GET_PRIVATE (release);
+	if (priv->checksums == NULL)
+		priv->checksums = g_ptr_array_new_with_free_func (g_object_unref);
 	return priv->checksums;
 }
 
@@ -522,6 +606,8 @@ as_release_get_checksum (AsRelease *release, AsChecksumKind kind)
 	AsReleasePrivate *priv = GET_PRIVATE (release);
 	guint i;
 
+	if (priv->checksums == NULL)
+		return NULL;
 	for (i = 0; i < priv->checksums->len; i++) {
 		AsChecksum *cs = AS_CHECKSUM (g_ptr_array_index (priv->checksums, i));
 		if (as_checksum_get_kind (cs) == kind)
@@ -542,8 +628,7 @@ as_release_get_checksum (AsRelease *release, AsChecksumKind kind)
 void
 as_release_add_checksum (AsRelease *release, AsChecksum *cs)
 {
-	AsReleasePrivate *priv = GET_PRIVATE (release);
-	g_ptr_array_add (priv->checksums, g_object_ref (cs));
+	g_ptr_array_add (as_release_get_checksums (release), g_object_ref (cs));
 }
 
 /**
@@ -748,13 +833,13 @@ as_release_to_xml_node (AsRelease *release, AsContext *ctx, xmlNode *root)
 	}
 
 	/* add location urls */
-	for (j = 0; j < priv->locations->len; j++) {
+	for (j = 0; priv->locations != NULL && j < priv->locations->len; j++) {
 		const gchar *lurl = (const gchar*) g_ptr_array_index (priv->locations, j);
 		xmlNewTextChild (subnode, NULL, (xmlChar*) "location", (xmlChar*) lurl);
 	}
 
 	/* add checksum node */
-	for (j = 0; j < priv->checksums->len; j++) {
+	for (j = 0; priv->checksums != NULL && j < priv->checksums->len; j++) {
 		AsChecksum *cs = AS_CHECKSUM (g_ptr_array_index (priv->checksums, j));
 		as_checksum_to_xml_node (cs, ctx, subnode);
 	}
@@ -777,7 +862,9 @@ as_release_to_xml_node (AsRelease *release, AsContext *ctx, xmlNode *root)
 	}
 
 	/* add description */
-	as_xml_add_description_node (ctx, subnode, priv->description);
+	as_release_load_description (release);
+	if (priv->description != NULL)
+		as_xml_add_description_node (ctx, subnode, priv->description);
 }
 
 /**
@@ -819,7 +906,7 @@ as_release_load_from_yaml (AsRelease *release, AsContext *ctx, GNode *node, GErr
 		} else if (g_strcmp0 (key, "urgency") == 0) {
 			priv->urgency = as_urgency_kind_from_string (value);
 		} else if (g_strcmp0 (key, "description") == 0) {
-			as_yaml_set_localized_table (ctx, n, priv->description);
+			as_yaml_set_localized_table (ctx, n, as_release_get_description_table (release));
 		} else {
 			as_yaml_print_unknown ("release", key);
 		}
@@ -876,12 +963,14 @@ as_release_emit_yaml (AsRelease *release, AsContext *ctx, yaml_emitter_t *emitte
 	}
 
 	/* description */
-	as_yaml_emit_long_localized_entry (emitter,
-					   "description",
-					   priv->description);
+	as_release_load_description (release);
+	if (priv->description != NULL)
+		as_yaml_emit_long_localized_entry (emitter,
+						   "description",
+						   priv->description);
 
 	/* location URLs */
-	if (priv->locations->len > 0) {
+	if (priv->locations != NULL && priv->locations->len > 0) {
 		as_yaml_emit_scalar (emitter, "locations");
 		as_yaml_sequence_start (emitter);
 		for (j = 0; j < priv->locations->len; j++) {
@@ -923,7 +1012,7 @@ as_release_to_variant (AsRelease *release, GVariantBuilder *builder)
 
 	/* build checksum info */
 	g_variant_builder_init (&checksum_b, (const GVariantType *) "a{us}");
-	for (j = 0; j < priv->checksums->len; j++) {
+	for (j = 0; priv->checksums != NULL && j < priv->checksums->len; j++) {
 		AsChecksum *cs = AS_CHECKSUM (g_ptr_array_index (priv->checksums, j));
 		as_checksum_to_variant (cs, &checksum_b);
 	}
@@ -950,7 +1039,7 @@ as_release_to_variant (AsRelease *release, GVariantBuilder *builder)
 	if (locations_var)
 		g_variant_builder_add_parsed (&rel_b, "{'locations', %v}", locations_var);
 
-	checksums_var = priv->checksums->len > 0? g_variant_builder_end (&checksum_b) : NULL;
+	checksums_var = (priv->checksums != NULL && priv->checksums->len > 0)? g_variant_builder_end (&checksum_b) : NULL;
 	if (checksums_var)
 		g_variant_builder_add_parsed (&rel_b, "{'checksums', %v}", checksums_var);
 
@@ -974,6 +1063,7 @@ as_release_set_from_variant (AsRelease *release, GVariant *variant, const gchar
 {
 	AsReleasePrivate *priv = GET_PRIVATE (release);
 	GVariant *tmp;
+	const gchar *desc;
 	g_auto(GVariantDict) rdict;
 	GVariantIter riter;
 	GVariant *inner_child;;
@@ -992,15 +1082,21 @@ as_release_set_from_variant (AsRelease *release, GVariant *variant, const gchar
 
 	priv->urgency = as_variant_get_dict_uint32 (&rdict, "urgency");
 
-	as_release_set_description (release,
-					as_variant_get_dict_mstr (&rdict, "description", &tmp),
-					locale);
+	/* release notes are rarely looked at, so we only keep a copy of the
+	 * string here and add it to the description table on first access */
+	desc = as_variant_get_dict_mstr (&rdict, "description", &tmp);
+	if (desc != NULL) {
+		as_release_load_description (release);
+		priv->description_data = g_bytes_new (desc, strlen (desc) + 1);
+		priv->description_data_locale = g_strdup (locale != NULL? locale : as_release_get_active_locale (release));
+	}
 	g_variant_unref (tmp);
 
 	/* locations */
-	as_variant_to_string_ptrarray_by_dict (&rdict,
-						"locations",
-						priv->locations);
+	if (g_variant_dict_contains (&rdict, "locations"))
+		as_variant_to_string_ptrarray_by_dict (&rdict,
+							"locations",
+							as_release_get_locations (release));
 
 	/* sizes */
 	tmp = g_variant_dict_lookup_value (&rdict, "sizes", G_VARIANT_TYPE_DICTIONARY);
@@ -1049,3 +1145,36 @@ as_release_new (void)
 	release = g_object_new (AS_TYPE_RELEASE, NULL);
 	return AS_RELEASE (release);
 }
+
+/**
+ * as_release_get_memory_size:
+ * @release: an #AsRelease
+ *
+ * Returns: The approximate amount of memory used by this release, in bytes.
+ */
+gsize
+as_release_get_memory_size (AsRelease *release)
+{
+	AsReleasePrivate *priv = GET_PRIVATE (release);
+	gsize size;
+	guint i;
+
+	size = as_memory_size_object (release);
+	size += as_memory_size_str (priv->version);
+	if (priv->version_key != NULL)
+		size += g_bytes_get_size (priv->version_key);
+	size += as_memory_size_str_table (priv->description, TRUE, TRUE);
+	if (priv->description_data != NULL)
+		size += g_bytes_get_size (priv->description_data);
+	size += as_memory_size_str (priv->description_data_locale);
+	size += as_memory_size_str (priv->active_locale_override);
+	size += as_memory_size_str_array (priv->locations, TRUE);
+
+	size += as_memory_size_str_array (priv->checksums, FALSE);
+	for (i = 0; priv->checksums != NULL && i < priv->checksums->len; i++) {
+		AsChecksum *cs = AS_CHECKSUM (g_ptr_array_index (priv->checksums, i));
+		size += as_memory_size_object (cs) + as_memory_size_str (as_checksum_get_value (cs));
+	}
+
+	return size;
+}
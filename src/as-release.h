@@ -102,6 +102,8 @@ const gchar	*as_release_get_version (AsRelease *release);
 void		as_release_set_version (AsRelease *release,
 					const gchar *version);
 
+GBytes		*as_release_get_version_key (AsRelease *release);
+
 gint		as_release_vercmp (AsRelease *rel1,
 				   AsRelease *rel2);
 
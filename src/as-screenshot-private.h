@@ -28,6 +28,25 @@
 G_BEGIN_DECLS
 #pragma GCC visibility push(hidden)
 
+/**
+ * AsScreenshotData:
+ *
+ * Compact form of a screenshot read from the cache, kept by the component
+ * it belongs to until an #AsScreenshot object is needed.
+ */
+typedef struct {
+	AsScreenshotKind	kind;
+	gchar			*caption;
+	GArray			*images; /* of AsImageData */
+} AsScreenshotData;
+
+void			as_screenshot_data_clear (AsScreenshotData *data);
+gboolean		as_screenshot_data_set_from_variant (AsScreenshotData *data,
+							     GVariant *variant);
+gsize			as_screenshot_data_get_memory_size (AsScreenshotData *data);
+AsScreenshot		*as_screenshot_new_from_data (AsScreenshotData *data,
+						      const gchar *locale);
+
 AsContext		*as_screenshot_get_context (AsScreenshot *screenshot);
 void			as_screenshot_set_context (AsScreenshot *screenshot,
 						   AsContext *context);
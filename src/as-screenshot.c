@@ -610,6 +610,32 @@ as_screenshot_to_variant (AsScreenshot *screenshot, GVariantBuilder *builder)
 	return TRUE;
 }
 
+/**
+ * as_screenshot_take_data:
+ *
+ * Set the state of @screenshot from the compact form @data,
+ * taking over the images of @data.
+ */
+static void
+as_screenshot_take_data (AsScreenshot *screenshot, AsScreenshotData *data, const gchar *locale)
+{
+	AsScreenshotPrivate *priv = GET_PRIVATE (screenshot);
+	guint i;
+
+	as_screenshot_set_active_locale (screenshot, locale);
+	priv->kind = data->kind;
+	as_screenshot_set_caption (screenshot, data->caption, locale);
+
+	if (data->images == NULL)
+		return;
+	for (i = 0; i < data->images->len; i++) {
+		g_autoptr(AsImage) img = NULL;
+
+		img = as_image_new_from_data (&g_array_index (data->images, AsImageData, i));
+		as_screenshot_add_image (screenshot, img);
+	}
+}
+
 /**
  * as_screenshot_set_from_variant:
  * @screenshot: an #AsScreenshot instance.
@@ -622,34 +648,118 @@ gboolean
 as_screenshot_set_from_variant (AsScreenshot *screenshot, GVariant *variant, const gchar *locale)
 {
 	AsScreenshotPrivate *priv = GET_PRIVATE (screenshot);
+	AsScreenshotData data = { 0, };
+
+	as_screenshot_data_set_from_variant (&data, variant);
+	as_screenshot_take_data (screenshot, &data, locale);
+	as_screenshot_data_clear (&data);
+
+	return priv->images->len != 0;
+}
+
+/**
+ * as_screenshot_data_clear:
+ * @data: An #AsScreenshotData.
+ *
+ * Free the contents of @data.
+ */
+void
+as_screenshot_data_clear (AsScreenshotData *data)
+{
+	g_free (data->caption);
+	data->caption = NULL;
+	if (data->images != NULL)
+		g_array_unref (data->images);
+	data->images = NULL;
+}
+
+/**
+ * as_screenshot_data_set_from_variant:
+ * @data: An empty #AsScreenshotData.
+ * @variant: The #GVariant to read from.
+ *
+ * Read the compact form of a screenshot from a #GVariant serialization.
+ *
+ * Returns: %TRUE if the screenshot has images.
+ */
+gboolean
+as_screenshot_data_set_from_variant (AsScreenshotData *data, GVariant *variant)
+{
 	GVariantIter inner_iter;
 	g_auto(GVariantDict) idict;
 	GVariant *tmp;
 	g_autoptr(GVariant) images_var = NULL;
 
-	as_screenshot_set_active_locale (screenshot, locale);
 	g_variant_dict_init (&idict, variant);
 
-	priv->kind = as_variant_get_dict_uint32 (&idict, "type");
-	as_screenshot_set_caption (screenshot,
-				   as_variant_get_dict_mstr (&idict, "caption", &tmp),
-				   locale);
+	data->kind = as_variant_get_dict_uint32 (&idict, "type");
+	data->caption = g_strdup (as_variant_get_dict_mstr (&idict, "caption", &tmp));
 	g_variant_unref (tmp);
 
 	images_var = g_variant_dict_lookup_value (&idict, "images", G_VARIANT_TYPE_ARRAY);
 	if (images_var != NULL) {
 		GVariant *img_child;
-		g_variant_iter_init (&inner_iter, images_var);
 
+		data->images = g_array_sized_new (FALSE,
+						  TRUE,
+						  sizeof (AsImageData),
+						  g_variant_n_children (images_var));
+		g_array_set_clear_func (data->images, (GDestroyNotify) as_image_data_clear);
+
+		g_variant_iter_init (&inner_iter, images_var);
 		while ((img_child = g_variant_iter_next_value (&inner_iter))) {
-			g_autoptr(AsImage) img = as_image_new ();
-			if (as_image_set_from_variant (img, img_child))
-				as_screenshot_add_image (screenshot, img);
+			AsImageData img = { 0, };
+			if (as_image_data_set_from_variant (&img, img_child))
+				g_array_append_val (data->images, img);
+			else
+				as_image_data_clear (&img);
 			g_variant_unref (img_child);
 		}
 	}
 
-	return priv->images->len != 0;
+	return (data->images != NULL) && (data->images->len != 0);
+}
+
+/**
+ * as_screenshot_data_get_memory_size:
+ * @data: An #AsScreenshotData.
+ *
+ * Returns: The approximate heap memory used by @data, excluding the struct itself.
+ */
+gsize
+as_screenshot_data_get_memory_size (AsScreenshotData *data)
+{
+	gsize size;
+	guint i;
+
+	size = as_memory_size_str (data->caption);
+	if (data->images == NULL)
+		return size;
+
+	size += data->images->len * sizeof (AsImageData);
+	for (i = 0; i < data->images->len; i++) {
+		AsImageData *img = &g_array_index (data->images, AsImageData, i);
+		size += as_memory_size_str (img->url) + as_memory_size_str (img->locale);
+	}
+
+	return size;
+}
+
+/**
+ * as_screenshot_new_from_data:
+ * @data: An #AsScreenshotData.
+ * @locale: The locale the caption of @data is in.
+ *
+ * Creates a new #AsScreenshot, taking over the contents of @data.
+ *
+ * Returns: (transfer full): a #AsScreenshot
+ */
+AsScreenshot*
+as_screenshot_new_from_data (AsScreenshotData *data, const gchar *locale)
+{
+	AsScreenshot *screenshot = as_screenshot_new ();
+	as_screenshot_take_data (screenshot, data, locale);
+	return screenshot;
 }
 
 /**
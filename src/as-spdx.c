@@ -25,9 +25,17 @@
 #include <string.h>
 #include <gio/gio.h>
 
-#include "as-resources.h"
 #include "as-utils-private.h"
 
+#pragma GCC visibility push(hidden)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#pragma GCC diagnostic ignored "-Wsign-conversion"
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+#include "as-spdx-ids-private.h"
+#pragma GCC diagnostic pop
+#pragma GCC visibility pop
+
 /**
  * SECTION:as-spdx
  * @short_description: Helper functions to work with SPDX license descriptions.
@@ -148,9 +156,6 @@ as_spdx_license_tokenize_drop (AsSpdxHelper *helper)
 gboolean
 as_is_spdx_license_id (const gchar *license_id)
 {
-	g_autoptr(GBytes) data = NULL;
-	g_autofree gchar *key = NULL;
-
 	/* handle invalid */
 	if (license_id == NULL || license_id[0] == '\0')
 		return FALSE;
@@ -159,16 +164,8 @@ as_is_spdx_license_id (const gchar *license_id)
 	if (g_str_has_prefix (license_id, "LicenseRef-"))
 		return TRUE;
 
-	/* load the readonly data section and look for the icon name */
-	data = g_resource_lookup_data (as_get_resource (),
-				       "/org/freedesktop/appstream/spdx-license-ids.txt",
-				       G_RESOURCE_LOOKUP_FLAGS_NONE,
-				       NULL);
-	if (data == NULL)
-		return FALSE;
-	key = g_strdup_printf ("\n%s\n", license_id);
-
-	return g_strstr_len (g_bytes_get_data (data, NULL), -1, key) != NULL;
+	/* use a perfect hash of the known license IDs */
+	return _as_spdx_license_id_lookup (license_id, strlen (license_id)) != NULL;
 }
 
 /**
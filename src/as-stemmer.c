@@ -46,6 +46,7 @@ struct _AsStemmer
 G_DEFINE_TYPE (AsStemmer, as_stemmer, G_TYPE_OBJECT)
 
 static gpointer as_stemmer_object = NULL;
+static GPrivate as_stemmer_thread_default;
 
 /**
  * as_stemmer_finalize:
@@ -147,16 +148,50 @@ as_stemmer_class_init (AsStemmerClass *klass)
 	object_class->finalize = as_stemmer_finalize;
 }
 
+/**
+ * as_stemmer_new:
+ *
+ * Creates a new #AsStemmer for the current locale, which is independent
+ * of the global instance.
+ *
+ * Returns: (transfer full): an #AsStemmer
+ **/
+AsStemmer*
+as_stemmer_new (void)
+{
+	return AS_STEMMER (g_object_new (AS_TYPE_STEMMER, NULL));
+}
+
+/**
+ * as_stemmer_set_thread_default:
+ * @stemmer: (nullable): A #AsStemmer, or %NULL to unset.
+ *
+ * Makes as_stemmer_get() return @stemmer in the calling thread,
+ * so worker threads can stem without contending for the lock of the
+ * global instance. The caller needs to keep a reference to @stemmer
+ * until it is unset again.
+ **/
+void
+as_stemmer_set_thread_default (AsStemmer *stemmer)
+{
+	g_private_set (&as_stemmer_thread_default, stemmer);
+}
+
 /**
  * as_stemmer_get:
  *
- * Gets the global #AsStemmer instance.
+ * Gets the #AsStemmer instance of the calling thread, or the
+ * global instance if none was set.
  *
  * Returns: (transfer none): an #AsStemmer
  **/
 AsStemmer*
 as_stemmer_get (void)
 {
+	AsStemmer *stemmer = g_private_get (&as_stemmer_thread_default);
+	if (stemmer != NULL)
+		return stemmer;
+
 	if (as_stemmer_object == NULL) {
 		as_stemmer_object = g_object_new (AS_TYPE_STEMMER, NULL);
 		g_object_add_weak_pointer (as_stemmer_object, &as_stemmer_object);
@@ -33,6 +33,8 @@ G_BEGIN_DECLS
 G_DECLARE_FINAL_TYPE (AsStemmer, as_stemmer, AS, STEMMER, GObject)
 
 AsStemmer		*as_stemmer_get (void);
+AsStemmer		*as_stemmer_new (void);
+void			as_stemmer_set_thread_default (AsStemmer *stemmer);
 
 void			as_stemmer_reload (AsStemmer *stemmer,
 						const gchar *lang);
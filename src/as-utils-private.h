@@ -63,6 +63,15 @@ const gchar		*as_ptr_array_find_string (GPtrArray *array,
 void			as_hash_table_string_keys_to_array (GHashTable *table,
 							    GPtrArray *array);
 
+gsize			as_memory_size_str (const gchar *str);
+gsize			as_memory_size_strv (gchar **strv);
+gsize			as_memory_size_str_table (GHashTable *table,
+						  gboolean str_keys,
+						  gboolean str_values);
+gsize			as_memory_size_str_array (GPtrArray *array,
+						  gboolean str_elements);
+gsize			as_memory_size_object (gpointer object);
+
 gboolean		as_touch_location (const gchar *fname);
 void			as_reset_umask (void);
 
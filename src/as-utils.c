@@ -26,6 +26,7 @@
 #include <glib.h>
 #include <glib-object.h>
 #include <stdlib.h>
+#include <string.h>
 #include <gio/gio.h>
 #include <glib/gstdio.h>
 #include <glib/gi18n-lib.h>
@@ -38,11 +39,21 @@
 #include <sys/stat.h>
 #include <errno.h>
 
-#include "as-resources.h"
 #include "as-category.h"
 #include "as-component.h"
 #include "as-component-private.h"
 
+#pragma GCC visibility push(hidden)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#pragma GCC diagnostic ignored "-Wsign-conversion"
+#pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+#include "as-xdg-categories-private.h"
+#include "as-tlds-private.h"
+#include "as-desktop-envs-private.h"
+#pragma GCC diagnostic pop
+#pragma GCC visibility pop
+
 /**
  * SECTION:as-utils
  * @short_description: Helper functions that are used inside libappstream
@@ -763,6 +774,111 @@ as_hash_table_string_keys_to_array (GHashTable *table, GPtrArray *array)
 	}
 }
 
+/**
+ * as_memory_size_str:
+ *
+ * Approximate heap memory used by a string.
+ */
+gsize
+as_memory_size_str (const gchar *str)
+{
+	if (str == NULL)
+		return 0;
+	return strlen (str) + 1;
+}
+
+/**
+ * as_memory_size_strv:
+ *
+ * Approximate heap memory used by a %NULL-terminated string array.
+ */
+gsize
+as_memory_size_strv (gchar **strv)
+{
+	gsize size;
+	guint i;
+
+	if (strv == NULL)
+		return 0;
+	size = sizeof (gchar*);
+	for (i = 0; strv[i] != NULL; i++)
+		size += sizeof (gchar*) + as_memory_size_str (strv[i]);
+	return size;
+}
+
+/**
+ * as_memory_size_str_table:
+ *
+ * Approximate heap memory used by a hash table, including
+ * its keys and values if they are strings.
+ */
+gsize
+as_memory_size_str_table (GHashTable *table, gboolean str_keys, gboolean str_values)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+	gsize size;
+
+	if (table == NULL)
+		return 0;
+
+	/* the table itself, plus its key, value and hash arrays */
+	size = 64 + g_hash_table_size (table) * (2 * sizeof (gpointer) + sizeof (guint));
+	if (!str_keys && !str_values)
+		return size;
+
+	g_hash_table_iter_init (&iter, table);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		if (str_keys)
+			size += as_memory_size_str ((const gchar*) key);
+		if (str_values)
+			size += as_memory_size_str ((const gchar*) value);
+	}
+
+	return size;
+}
+
+/**
+ * as_memory_size_str_array:
+ *
+ * Approximate heap memory used by a #GPtrArray, including
+ * its elements if they are strings.
+ */
+gsize
+as_memory_size_str_array (GPtrArray *array, gboolean str_elements)
+{
+	gsize size;
+	guint i;
+
+	if (array == NULL)
+		return 0;
+
+	size = sizeof (GPtrArray) + array->len * sizeof (gpointer);
+	if (!str_elements)
+		return size;
+	for (i = 0; i < array->len; i++)
+		size += as_memory_size_str ((const gchar*) g_ptr_array_index (array, i));
+
+	return size;
+}
+
+/**
+ * as_memory_size_object:
+ *
+ * Approximate heap memory used by the instance of a #GObject,
+ * not including the data it references.
+ */
+gsize
+as_memory_size_object (gpointer object)
+{
+	GTypeQuery query;
+
+	if (object == NULL)
+		return 0;
+	g_type_query (G_OBJECT_TYPE (object), &query);
+	return query.instance_size;
+}
+
 /**
  * as_utils_locale_is_compatible:
  * @locale1: a locale string, or %NULL
@@ -872,22 +988,15 @@ as_utils_search_token_valid (const gchar *token)
 gboolean
 as_utils_is_category_name (const gchar *category_name)
 {
-	g_autoptr(GBytes) data = NULL;
-	g_autofree gchar *key = NULL;
+	if (category_name == NULL)
+		return FALSE;
 
 	/* custom spec-extensions are generally valid if prefixed correctly */
 	if (g_str_has_prefix (category_name, "X-"))
 		return TRUE;
 
-	/* load the readonly data section and look for the category name */
-	data = g_resource_lookup_data (as_get_resource (),
-				       "/org/freedesktop/appstream/xdg-category-names.txt",
-				       G_RESOURCE_LOOKUP_FLAGS_NONE,
-				       NULL);
-	if (data == NULL)
-		return FALSE;
-	key = g_strdup_printf ("\n%s\n", category_name);
-	return g_strstr_len (g_bytes_get_data (data, NULL), -1, key) != NULL;
+	/* use a perfect hash of the known category names */
+	return _as_xdg_category_lookup (category_name, strlen (category_name)) != NULL;
 }
 
 /**
@@ -904,18 +1013,11 @@ as_utils_is_category_name (const gchar *category_name)
 gboolean
 as_utils_is_tld (const gchar *tld)
 {
-	g_autoptr(GBytes) data = NULL;
-	g_autofree gchar *key = NULL;
-
-	/* load the readonly data section and look for the TLD */
-	data = g_resource_lookup_data (as_get_resource (),
-				       "/org/freedesktop/appstream/iana-filtered-tld-list.txt",
-				       G_RESOURCE_LOOKUP_FLAGS_NONE,
-				       NULL);
-	if (data == NULL)
+	if (tld == NULL)
 		return FALSE;
-	key = g_strdup_printf ("\n%s\n", tld);
-	return g_strstr_len (g_bytes_get_data (data, NULL), -1, key) != NULL;
+
+	/* use a perfect hash of the known TLDs */
+	return _as_tld_lookup (tld, strlen (tld)) != NULL;
 }
 
 /**
@@ -932,18 +1034,145 @@ as_utils_is_tld (const gchar *tld)
 gboolean
 as_utils_is_desktop_environment (const gchar *desktop)
 {
-	g_autoptr(GBytes) data = NULL;
-	g_autofree gchar *key = NULL;
-
-	/* load the readonly data section and look for the TLD */
-	data = g_resource_lookup_data (as_get_resource (),
-				       "/org/freedesktop/appstream/desktop-environments.txt",
-				       G_RESOURCE_LOOKUP_FLAGS_NONE,
-				       NULL);
-	if (data == NULL)
+	if (desktop == NULL)
 		return FALSE;
-	key = g_strdup_printf ("\n%s\n", desktop);
-	return g_strstr_len (g_bytes_get_data (data, NULL), -1, key) != NULL;
+
+	/* use a perfect hash of the known desktop-environment IDs */
+	return _as_desktop_env_lookup (desktop, strlen (desktop)) != NULL;
+}
+
+/**
+ * AsCategoryMatcher:
+ *
+ * The desktop groups of a category, as bitmasks over the ids of all
+ * category names known while sorting components into categories.
+ */
+typedef struct {
+	AsCategory	*category;
+	GArray		*masks;		/* of guint64, n_words for each desktop group */
+	GHashTable	*members;	/* (not owned) components in the category */
+	GPtrArray	*children;
+} AsCategoryMatcher;
+
+static void
+as_category_matcher_free (AsCategoryMatcher *matcher)
+{
+	g_array_unref (matcher->masks);
+	if (matcher->children != NULL)
+		g_ptr_array_unref (matcher->children);
+	g_free (matcher);
+}
+
+/**
+ * as_category_collect_names:
+ *
+ * Assign an id to every category name used by the desktop groups of @category.
+ */
+static void
+as_category_collect_names (AsCategory *category, GHashTable *name_ids)
+{
+	GPtrArray *groups = as_category_get_desktop_groups (category);
+	guint i, j;
+
+	for (i = 0; i < groups->len; i++) {
+		g_auto(GStrv) split = g_strsplit ((const gchar*) g_ptr_array_index (groups, i), "::", -1);
+		for (j = 0; split[j] != NULL; j++) {
+			if (g_hash_table_contains (name_ids, split[j]))
+				continue;
+			g_hash_table_insert (name_ids,
+					     g_strdup (split[j]),
+					     GUINT_TO_POINTER (g_hash_table_size (name_ids)));
+		}
+	}
+}
+
+/**
+ * as_category_matcher_new:
+ *
+ * Build the bitmasks for @category. A component is a member of the category
+ * if it has all the category names of any of its desktop groups.
+ */
+static AsCategoryMatcher*
+as_category_matcher_new (AsCategory *category, GHashTable *name_ids, guint n_words, GHashTable *members_by_cat)
+{
+	AsCategoryMatcher *matcher;
+	GPtrArray *groups = as_category_get_desktop_groups (category);
+	GHashTable *members;
+	guint i, j;
+
+	matcher = g_new0 (AsCategoryMatcher, 1);
+	matcher->category = category;
+	matcher->masks = g_array_sized_new (FALSE, TRUE, sizeof (guint64), groups->len * n_words);
+
+	for (i = 0; i < groups->len; i++) {
+		guint64 *mask;
+		g_auto(GStrv) split = g_strsplit ((const gchar*) g_ptr_array_index (groups, i), "::", -1);
+
+		g_array_set_size (matcher->masks, (i + 1) * n_words);
+		mask = &g_array_index (matcher->masks, guint64, i * n_words);
+		for (j = 0; split[j] != NULL; j++) {
+			guint id = GPOINTER_TO_UINT (g_hash_table_lookup (name_ids, split[j]));
+			mask[id / 64] |= G_GUINT64_CONSTANT (1) << (id % 64);
+		}
+	}
+
+	/* the same category may be listed more than once, share the set of its members */
+	members = g_hash_table_lookup (members_by_cat, category);
+	if (members == NULL) {
+		GPtrArray *cpts = as_category_get_components (category);
+
+		members = g_hash_table_new (g_direct_hash, g_direct_equal);
+		for (i = 0; i < cpts->len; i++)
+			g_hash_table_add (members, g_ptr_array_index (cpts, i));
+		g_hash_table_insert (members_by_cat, category, members);
+	}
+	matcher->members = members;
+
+	return matcher;
+}
+
+/**
+ * as_category_matcher_matches:
+ */
+static gboolean
+as_category_matcher_matches (AsCategoryMatcher *matcher, const guint64 *cpt_bits, guint n_words)
+{
+	guint i, j;
+
+	for (i = 0; i < matcher->masks->len; i += n_words) {
+		const guint64 *mask = &g_array_index (matcher->masks, guint64, i);
+		gboolean match = TRUE;
+
+		for (j = 0; j < n_words; j++) {
+			if ((cpt_bits[j] & mask[j]) != mask[j]) {
+				match = FALSE;
+				break;
+			}
+		}
+		if (match)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/**
+ * as_category_matcher_has_component:
+ */
+static gboolean
+as_category_matcher_has_component (AsCategoryMatcher *matcher, AsComponent *cpt)
+{
+	return g_hash_table_contains (matcher->members, cpt);
+}
+
+/**
+ * as_category_matcher_add_component:
+ */
+static void
+as_category_matcher_add_component (AsCategoryMatcher *matcher, AsComponent *cpt)
+{
+	as_category_add_component (matcher->category, cpt);
+	g_hash_table_add (matcher->members, cpt);
 }
 
 /**
@@ -957,41 +1186,82 @@ as_utils_is_desktop_environment (const gchar *desktop)
 void
 as_utils_sort_components_into_categories (GPtrArray *cpts, GPtrArray *categories, gboolean check_duplicates)
 {
-	guint i;
+	guint n_words;
+	g_autofree guint64 *cpt_bits = NULL;
+	g_autoptr(GHashTable) name_ids = NULL;
+	g_autoptr(GHashTable) members_by_cat = NULL;
+	g_autoptr(GPtrArray) matchers = NULL;
+	guint i, j, k;
+
+	/* map all category names we need to look at to bits */
+	name_ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	for (i = 0; i < categories->len; i++) {
+		AsCategory *main_cat = AS_CATEGORY (g_ptr_array_index (categories, i));
+		GPtrArray *children = as_category_get_children (main_cat);
+
+		as_category_collect_names (main_cat, name_ids);
+		for (j = 0; j < children->len; j++)
+			as_category_collect_names (AS_CATEGORY (g_ptr_array_index (children, j)), name_ids);
+	}
+	n_words = MAX (1, (g_hash_table_size (name_ids) + 63) / 64);
+
+	/* fortunately, categories are only nested one level deep in all known cases.
+	 * if this will ever change, we will need to adjust this code to go through
+	 * a whole tree of categories, eww... */
+	members_by_cat = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+						NULL, (GDestroyNotify) g_hash_table_unref);
+	matchers = g_ptr_array_new_with_free_func ((GDestroyNotify) as_category_matcher_free);
+	for (i = 0; i < categories->len; i++) {
+		AsCategory *main_cat = AS_CATEGORY (g_ptr_array_index (categories, i));
+		GPtrArray *children = as_category_get_children (main_cat);
+		AsCategoryMatcher *matcher;
+
+		matcher = as_category_matcher_new (main_cat, name_ids, n_words, members_by_cat);
+		matcher->children = g_ptr_array_new_with_free_func ((GDestroyNotify) as_category_matcher_free);
+		for (j = 0; j < children->len; j++) {
+			AsCategory *subcat = AS_CATEGORY (g_ptr_array_index (children, j));
+			g_ptr_array_add (matcher->children,
+					 as_category_matcher_new (subcat, name_ids, n_words, members_by_cat));
+		}
+		g_ptr_array_add (matchers, matcher);
+	}
 
+	cpt_bits = g_new0 (guint64, n_words);
 	for (i = 0; i < cpts->len; i++) {
-		guint j;
 		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (cpts, i));
+		GPtrArray *cpt_cats = as_component_get_categories (cpt);
+
+		/* compute the set of relevant categories of this component once */
+		memset (cpt_bits, 0, n_words * sizeof (guint64));
+		for (j = 0; j < cpt_cats->len; j++) {
+			gpointer id;
+			if (g_hash_table_lookup_extended (name_ids, g_ptr_array_index (cpt_cats, j), NULL, &id))
+				cpt_bits[GPOINTER_TO_UINT (id) / 64] |= G_GUINT64_CONSTANT (1) << (GPOINTER_TO_UINT (id) % 64);
+		}
 
-		for (j = 0; j < categories->len; j++) {
-			guint k;
-			GPtrArray *children;
+		for (j = 0; j < matchers->len; j++) {
+			AsCategoryMatcher *main_matcher = (AsCategoryMatcher*) g_ptr_array_index (matchers, j);
 			gboolean added_to_main = FALSE;
-			AsCategory *main_cat = AS_CATEGORY (g_ptr_array_index (categories, j));
 
-			if (as_component_is_member_of_category (cpt, main_cat)) {
-				if (!check_duplicates || !as_category_has_component (main_cat, cpt)) {
-					as_category_add_component (main_cat, cpt);
+			if (as_category_matcher_matches (main_matcher, cpt_bits, n_words)) {
+				if (!check_duplicates || !as_category_matcher_has_component (main_matcher, cpt)) {
+					as_category_matcher_add_component (main_matcher, cpt);
 					added_to_main = TRUE;
 				}
 			}
 
-			/* fortunately, categories are only nested one level deep in all known cases.
-			 * if this will ever change, we will need to adjust this code to go through
-			 * a whole tree of categories, eww... */
-			children = as_category_get_children (main_cat);
-			for (k = 0; k < children->len; k++) {
-				AsCategory *subcat = AS_CATEGORY (g_ptr_array_index (children, k));
+			for (k = 0; k < main_matcher->children->len; k++) {
+				AsCategoryMatcher *sub_matcher = (AsCategoryMatcher*) g_ptr_array_index (main_matcher->children, k);
 
 				/* skip duplicates */
-				if (check_duplicates && as_category_has_component (subcat, cpt))
+				if (check_duplicates && as_category_matcher_has_component (sub_matcher, cpt))
 					continue;
 
-				if (as_component_is_member_of_category (cpt, subcat)) {
-					as_category_add_component (subcat, cpt);
+				if (as_category_matcher_matches (sub_matcher, cpt_bits, n_words)) {
+					as_category_matcher_add_component (sub_matcher, cpt);
 					if (!added_to_main) {
-						if (!check_duplicates || !as_category_has_component (main_cat, cpt)) {
-							as_category_add_component (main_cat, cpt);
+						if (!check_duplicates || !as_category_matcher_has_component (main_matcher, cpt)) {
+							as_category_matcher_add_component (main_matcher, cpt);
 						}
 					}
 				}
@@ -1119,6 +1389,95 @@ as_utils_compare_versions (const gchar* a, const gchar *b)
 	if (!*one) return -1; else return 1;
 }
 
+/* markers for the segments of a version key, in sort order */
+#define AS_VERSION_KEY_TILDE	0x01
+#define AS_VERSION_KEY_END	0x02
+#define AS_VERSION_KEY_ALPHA	0x03
+#define AS_VERSION_KEY_NUMERIC	0x04
+
+/**
+ * as_utils_build_version_key:
+ * @version: (nullable): a version string.
+ *
+ * Build a binary key for @version which sorts bytewise exactly like
+ * as_utils_compare_versions() orders the version strings, so the
+ * comparison only has to be paid for once per version when many
+ * versions are compared or sorted.
+ *
+ * Keys can be compared using g_bytes_compare().
+ *
+ * Returns: (transfer full): the version key
+ *
+ * Since: 0.12.3
+ */
+GBytes*
+as_utils_build_version_key (const gchar *version)
+{
+	GByteArray *key;
+	const guint8 end_marker = AS_VERSION_KEY_END;
+	const gchar *p = version == NULL? "" : version;
+
+	key = g_byte_array_sized_new (strlen (p) + 8);
+	while (TRUE) {
+		guint8 marker;
+		const gchar *start;
+
+		/* separators are not significant */
+		while (*p && !g_ascii_isalnum (*p) && *p != '~') p++;
+
+		/* the tilde sorts before everything, even the end of the version */
+		if (*p == '~') {
+			marker = AS_VERSION_KEY_TILDE;
+			g_byte_array_append (key, &marker, 1);
+			p++;
+			continue;
+		}
+		if (*p == '\0')
+			break;
+
+		if (g_ascii_isdigit (*p)) {
+			gsize len;
+
+			/* numbers with more digits are larger, leading zeros don't count */
+			while (*p == '0') p++;
+			start = p;
+			while (g_ascii_isdigit (*p)) p++;
+			len = p - start;
+
+			marker = AS_VERSION_KEY_NUMERIC;
+			g_byte_array_append (key, &marker, 1);
+			if (len < 0xff) {
+				guint8 len8 = (guint8) len;
+				g_byte_array_append (key, &len8, 1);
+			} else {
+				guint8 len_be[5] = { 0xff,
+						     (len >> 24) & 0xff,
+						     (len >> 16) & 0xff,
+						     (len >> 8) & 0xff,
+						     len & 0xff };
+				g_byte_array_append (key, len_be, sizeof (len_be));
+			}
+			g_byte_array_append (key, (const guint8*) start, len);
+		} else {
+			/* alpha segments compare like strcmp(), so terminate them */
+			guint8 term = 0x00;
+
+			start = p;
+			while (g_ascii_isalpha (*p)) p++;
+
+			marker = AS_VERSION_KEY_ALPHA;
+			g_byte_array_append (key, &marker, 1);
+			g_byte_array_append (key, (const guint8*) start, p - start);
+			g_byte_array_append (key, &term, 1);
+		}
+	}
+
+	/* the version with segments left is newer, unless they start with a tilde */
+	g_byte_array_append (key, &end_marker, 1);
+
+	return g_byte_array_free_to_bytes (key);
+}
+
 /**
  * as_utils_build_data_id:
  *
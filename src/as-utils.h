@@ -40,6 +40,7 @@ void		as_utils_sort_components_into_categories (GPtrArray *cpts,
 
 gint		as_utils_compare_versions (const gchar* a,
 					   const gchar *b);
+GBytes		*as_utils_build_version_key (const gchar *version);
 
 const gchar	*as_get_appstream_version (void);
 
@@ -37,6 +37,7 @@
 #include <string.h>
 
 #include "as-validator.h"
+#include "as-validator-private.h"
 #include "as-validator-issue.h"
 
 #include "as-utils.h"
@@ -44,6 +45,32 @@
 #include "as-spdx.h"
 #include "as-component.h"
 #include "as-component-private.h"
+#include "as-compression.h"
+
+typedef enum {
+	AS_URL_STATUS_UNKNOWN,
+	AS_URL_STATUS_CHECKING,
+	AS_URL_STATUS_OK,
+	AS_URL_STATUS_FAILED
+} AsUrlStatus;
+
+/* the maximum number of remote URLs which are checked at the same time */
+#define AS_VALIDATOR_URL_JOBS 8
+
+/**
+ * AsValidatorUrlState:
+ *
+ * Results of remote URL checks, which may be shared by multiple validators.
+ */
+typedef struct {
+	gint		ref_count;
+	GMutex		mutex;
+	GCond		cond;
+
+	GHashTable	*status; /* of utf8:AsUrlStatus */
+	GHashTable	*reachable; /* of utf8:gint64, when we last reached the URL */
+	guint		n_running;
+} AsValidatorUrlState;
 
 typedef struct
 {
@@ -52,11 +79,88 @@ typedef struct
 	AsComponent *current_cpt;
 	gchar *current_fname;
 	gboolean check_urls;
+	guint max_jobs;
+
+	GPtrArray *url_checks; /* of AsValidatorUrlCheck */
+	AsValidatorUrlState *url_state;
+	gchar *url_cache_fname;
+	guint64 url_cache_max_age;
 } AsValidatorPrivate;
 
+/**
+ * AsValidatorUrlCheck:
+ *
+ * A remote URL which still needs to be checked, and the location
+ * an issue should be reported at in case it can not be reached.
+ */
+typedef struct {
+	gchar	*url;
+	gchar	*message;
+
+	gchar	*fname;
+	gchar	*cid;
+	gint	line;
+} AsValidatorUrlCheck;
+
 G_DEFINE_TYPE_WITH_PRIVATE (AsValidator, as_validator, G_TYPE_OBJECT)
 #define GET_PRIVATE(o) (as_validator_get_instance_private (o))
 
+/**
+ * as_validator_url_check_free:
+ **/
+static void
+as_validator_url_check_free (AsValidatorUrlCheck *check)
+{
+	g_free (check->url);
+	g_free (check->message);
+	g_free (check->fname);
+	g_free (check->cid);
+	g_free (check);
+}
+
+/**
+ * as_validator_url_state_new:
+ **/
+static AsValidatorUrlState*
+as_validator_url_state_new (void)
+{
+	AsValidatorUrlState *state = g_new0 (AsValidatorUrlState, 1);
+
+	state->ref_count = 1;
+	g_mutex_init (&state->mutex);
+	g_cond_init (&state->cond);
+	state->status = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	state->reachable = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+	return state;
+}
+
+/**
+ * as_validator_url_state_ref:
+ **/
+static AsValidatorUrlState*
+as_validator_url_state_ref (AsValidatorUrlState *state)
+{
+	g_atomic_int_inc (&state->ref_count);
+	return state;
+}
+
+/**
+ * as_validator_url_state_unref:
+ **/
+static void
+as_validator_url_state_unref (AsValidatorUrlState *state)
+{
+	if (!g_atomic_int_dec_and_test (&state->ref_count))
+		return;
+
+	g_hash_table_unref (state->status);
+	g_hash_table_unref (state->reachable);
+	g_mutex_clear (&state->mutex);
+	g_cond_clear (&state->cond);
+	g_free (state);
+}
+
 /**
  * as_validator_finalize:
  **/
@@ -67,6 +171,9 @@ as_validator_finalize (GObject *object)
 	AsValidatorPrivate *priv = GET_PRIVATE (validator);
 
 	g_hash_table_unref (priv->issues);
+	g_ptr_array_unref (priv->url_checks);
+	as_validator_url_state_unref (priv->url_state);
+	g_free (priv->url_cache_fname);
 	g_free (priv->current_fname);
 	if (priv->current_cpt != NULL)
 		g_object_unref (priv->current_cpt);
@@ -87,6 +194,33 @@ as_validator_init (AsValidator *validator)
 	priv->current_fname = NULL;
 	priv->current_cpt = NULL;
 	priv->check_urls = FALSE;
+	priv->max_jobs = 1;
+
+	priv->url_checks = g_ptr_array_new_with_free_func ((GDestroyNotify) as_validator_url_check_free);
+	priv->url_state = as_validator_url_state_new ();
+	priv->url_cache_fname = NULL;
+	priv->url_cache_max_age = 0;
+}
+
+/**
+ * as_validator_insert_issue:
+ *
+ * Add an issue with complete location information to the issue list.
+ * Takes ownership of @issue.
+ **/
+static void
+as_validator_insert_issue (AsValidator *validator, AsValidatorIssue *issue)
+{
+	AsValidatorPrivate *priv = GET_PRIVATE (validator);
+	g_autofree gchar *location = NULL;
+	gchar *id_str;
+
+	location = as_validator_issue_get_location (issue);
+	id_str = g_strdup_printf ("%s - %s",
+					location,
+					as_validator_issue_get_message (issue));
+	/* str ownership is transferred to the hashtable */
+	g_hash_table_insert (priv->issues, id_str, issue);
 }
 
 /**
@@ -97,8 +231,6 @@ as_validator_add_issue (AsValidator *validator, xmlNode *node, AsIssueImportance
 {
 	va_list args;
 	gchar *buffer;
-	gchar *id_str;
-	g_autofree gchar *location = NULL;
 	AsValidatorIssue *issue;
 	AsValidatorPrivate *priv = GET_PRIVATE (validator);
 
@@ -122,12 +254,7 @@ as_validator_add_issue (AsValidator *validator, xmlNode *node, AsIssueImportance
 	if (node != NULL)
 		as_validator_issue_set_line (issue, node->line);
 
-	location = as_validator_issue_get_location (issue);
-	id_str = g_strdup_printf ("%s - %s",
-					location,
-					as_validator_issue_get_message (issue));
-	/* str ownership is transferred to the hashtable */
-	g_hash_table_insert (priv->issues, id_str, issue);
+	as_validator_insert_issue (validator, issue);
 }
 
 /**
@@ -195,6 +322,36 @@ as_validator_clear_issues (AsValidator *validator)
 {
 	AsValidatorPrivate *priv = GET_PRIVATE (validator);
 	g_hash_table_remove_all (priv->issues);
+	g_ptr_array_set_size (priv->url_checks, 0);
+}
+
+/**
+ * as_validator_merge_issues:
+ *
+ * Add all issues found by @other to the issue list of @validator,
+ * and take over its URL checks which have not been run yet.
+ **/
+static void
+as_validator_merge_issues (AsValidator *validator, AsValidator *other)
+{
+	AsValidatorPrivate *priv = GET_PRIVATE (validator);
+	AsValidatorPrivate *opriv = GET_PRIVATE (other);
+	GHashTableIter iter;
+	gpointer key, value;
+	guint i;
+
+	g_hash_table_iter_init (&iter, opriv->issues);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		g_hash_table_insert (priv->issues,
+				     g_strdup ((const gchar*) key),
+				     g_object_ref (AS_VALIDATOR_ISSUE (value)));
+	}
+
+	for (i = 0; i < opriv->url_checks->len; i++)
+		g_ptr_array_add (priv->url_checks, g_ptr_array_index (opriv->url_checks, i));
+	g_ptr_array_set_free_func (opriv->url_checks, NULL);
+	g_ptr_array_set_size (opriv->url_checks, 0);
+	g_ptr_array_set_free_func (opriv->url_checks, (GDestroyNotify) as_validator_url_check_free);
 }
 
 /**
@@ -209,22 +366,17 @@ as_validator_can_check_urls (AsValidator *validator)
 }
 
 /**
- * as_validator_web_url_exists:
+ * as_curl_url_exists:
  *
  * Check if an URL exists using curl.
  */
 static gboolean
-as_validator_web_url_exists (AsValidator *validator, const gchar *url)
+as_curl_url_exists (const gchar *url)
 {
-	AsValidatorPrivate *priv = GET_PRIVATE (validator);
 	/* we use absolute paths here to avoid someone injecting malicious curl/wget into our environment */
 	const gchar *curl_bin = "/usr/bin/curl";
 	gint exit_status = 0;
 
-	/* do nothing and assume the URL exists if we shouldn't check URLs */
-	if (!priv->check_urls)
-		return TRUE;
-
 	if (g_file_test (curl_bin, G_FILE_TEST_EXISTS)) {
 		/* Normally we would use the --head option of curl here to only fetch the server headers.
 		 * However, there is quite a bunch of unfriendly/misconfigured servers out there that simply
@@ -261,6 +413,295 @@ as_validator_web_url_exists (AsValidator *validator, const gchar *url)
 	}
 }
 
+/**
+ * as_validator_url_reachable_unlocked:
+ *
+ * Returns: %TRUE if we could reach @url recently enough to not check it again.
+ */
+static gboolean
+as_validator_url_reachable_unlocked (AsValidator *validator, const gchar *url)
+{
+	AsValidatorPrivate *priv = GET_PRIVATE (validator);
+	gint64 *timestamp;
+
+	timestamp = g_hash_table_lookup (priv->url_state->reachable, url);
+	if (timestamp == NULL)
+		return FALSE;
+	if (priv->url_cache_max_age == 0)
+		return TRUE;
+	if ((guint64) (g_get_real_time () / G_USEC_PER_SEC - *timestamp) <= priv->url_cache_max_age)
+		return TRUE;
+
+	g_hash_table_remove (priv->url_state->reachable, url);
+	return FALSE;
+}
+
+/**
+ * as_validator_url_set_reachable_unlocked:
+ */
+static void
+as_validator_url_set_reachable_unlocked (AsValidator *validator, const gchar *url, gint64 timestamp)
+{
+	AsValidatorPrivate *priv = GET_PRIVATE (validator);
+	gint64 *value = g_new (gint64, 1);
+
+	*value = timestamp;
+	g_hash_table_insert (priv->url_state->reachable, g_strdup (url), value);
+}
+
+/**
+ * as_validator_url_exists:
+ *
+ * Check if an URL exists, reusing results of earlier checks by this validator
+ * or the validators it shares results with, and waiting for checks of the same
+ * URL which are already in progress.
+ */
+static gboolean
+as_validator_url_exists (AsValidator *validator, const gchar *url)
+{
+	AsValidatorPrivate *priv = GET_PRIVATE (validator);
+	AsValidatorUrlState *state = priv->url_state;
+	AsUrlStatus status;
+	gboolean ret;
+
+	g_mutex_lock (&state->mutex);
+	if (as_validator_url_reachable_unlocked (validator, url)) {
+		g_mutex_unlock (&state->mutex);
+		return TRUE;
+	}
+	while ((status = GPOINTER_TO_INT (g_hash_table_lookup (state->status, url))) == AS_URL_STATUS_CHECKING)
+		g_cond_wait (&state->cond, &state->mutex);
+	if (status != AS_URL_STATUS_UNKNOWN) {
+		g_mutex_unlock (&state->mutex);
+		return status == AS_URL_STATUS_OK;
+	}
+	g_hash_table_insert (state->status, g_strdup (url), GINT_TO_POINTER (AS_URL_STATUS_CHECKING));
+
+	/* limit the requests in flight, no matter how many validators share these results */
+	while (state->n_running >= AS_VALIDATOR_URL_JOBS)
+		g_cond_wait (&state->cond, &state->mutex);
+	state->n_running++;
+	g_mutex_unlock (&state->mutex);
+
+	ret = as_curl_url_exists (url);
+
+	g_mutex_lock (&state->mutex);
+	state->n_running--;
+	g_hash_table_insert (state->status,
+			     g_strdup (url),
+			     GINT_TO_POINTER (ret? AS_URL_STATUS_OK : AS_URL_STATUS_FAILED));
+	if (ret)
+		as_validator_url_set_reachable_unlocked (validator, url, g_get_real_time () / G_USEC_PER_SEC);
+	g_cond_broadcast (&state->cond);
+	g_mutex_unlock (&state->mutex);
+
+	return ret;
+}
+
+/**
+ * as_validator_check_web_url:
+ * @msg_format: message to emit if the URL is unreachable, with a "%s" placeholder for the URL.
+ *
+ * Schedule a check whether @url exists. The check is run later, together with all other
+ * URL checks, by as_validator_process_url_checks().
+ */
+static void
+as_validator_check_web_url (AsValidator *validator, xmlNode *node, const gchar *url, const gchar *msg_format)
+{
+	AsValidatorPrivate *priv = GET_PRIVATE (validator);
+	AsValidatorUrlCheck *check;
+
+	/* do nothing and assume the URL exists if we shouldn't check URLs */
+	if (!priv->check_urls)
+		return;
+	if (as_str_empty (url))
+		return;
+
+	check = g_new0 (AsValidatorUrlCheck, 1);
+	check->url = g_strdup (url);
+	check->message = g_strdup_printf (msg_format, url);
+	check->fname = g_strdup (priv->current_fname);
+	if (priv->current_cpt != NULL)
+		check->cid = g_strdup (as_component_get_id (priv->current_cpt));
+	check->line = node != NULL? node->line : -1;
+
+	g_ptr_array_add (priv->url_checks, check);
+}
+
+/**
+ * as_validator_url_cache_load:
+ *
+ * Load the URLs which were reachable recently from the on-disk cache.
+ */
+static void
+as_validator_url_cache_load (AsValidator *validator)
+{
+	AsValidatorPrivate *priv = GET_PRIVATE (validator);
+	g_autofree gchar *data = NULL;
+	g_auto(GStrv) lines = NULL;
+	gint64 now;
+	guint i;
+
+	if (priv->url_cache_fname == NULL)
+		return;
+	if (!g_file_get_contents (priv->url_cache_fname, &data, NULL, NULL))
+		return;
+
+	now = g_get_real_time () / G_USEC_PER_SEC;
+	lines = g_strsplit (data, "\n", -1);
+
+	g_mutex_lock (&priv->url_state->mutex);
+	for (i = 0; lines[i] != NULL; i++) {
+		gchar *url;
+		gint64 timestamp;
+
+		/* each line is "<timestamp> <url>" */
+		url = g_strstr_len (lines[i], -1, " ");
+		if (url == NULL)
+			continue;
+		*url = '\0';
+		url++;
+		timestamp = g_ascii_strtoll (lines[i], NULL, 10);
+		if (timestamp <= 0 || as_str_empty (url))
+			continue;
+		if ((guint64) (now - timestamp) > priv->url_cache_max_age)
+			continue;
+
+		/* we might have reached the URL more recently already */
+		if (!as_validator_url_reachable_unlocked (validator, url))
+			as_validator_url_set_reachable_unlocked (validator, url, timestamp);
+	}
+	g_mutex_unlock (&priv->url_state->mutex);
+}
+
+/**
+ * as_validator_url_cache_save:
+ *
+ * Persist the URLs which were reachable recently.
+ */
+static void
+as_validator_url_cache_save (AsValidator *validator)
+{
+	AsValidatorPrivate *priv = GET_PRIVATE (validator);
+	g_autoptr(GString) data = NULL;
+	g_autofree gchar *cache_dir = NULL;
+	g_autoptr(GError) error = NULL;
+	GHashTableIter iter;
+	gpointer key, value;
+
+	if (priv->url_cache_fname == NULL)
+		return;
+
+	data = g_string_new ("");
+	g_mutex_lock (&priv->url_state->mutex);
+	g_hash_table_iter_init (&iter, priv->url_state->reachable);
+	while (g_hash_table_iter_next (&iter, &key, &value)) {
+		g_string_append_printf (data, "%" G_GINT64_FORMAT " %s\n",
+					*((gint64*) value),
+					(const gchar*) key);
+	}
+	g_mutex_unlock (&priv->url_state->mutex);
+
+	cache_dir = g_path_get_dirname (priv->url_cache_fname);
+	g_mkdir_with_parents (cache_dir, 0755);
+	if (!g_file_set_contents (priv->url_cache_fname, data->str, data->len, &error))
+		g_warning ("Unable to write URL check cache: %s", error->message);
+}
+
+/**
+ * as_validator_url_check_job_run:
+ */
+static void
+as_validator_url_check_job_run (const gchar *url, AsValidator *validator)
+{
+	as_validator_url_exists (validator, url);
+}
+
+/**
+ * as_validator_process_url_checks:
+ *
+ * Run all pending URL checks concurrently, and emit issues for the
+ * URLs which could not be reached.
+ */
+static void
+as_validator_process_url_checks (AsValidator *validator)
+{
+	AsValidatorPrivate *priv = GET_PRIVATE (validator);
+	g_autoptr(GHashTable) urls = NULL;
+	g_autoptr(GPtrArray) checks = NULL;
+	GHashTableIter iter;
+	gpointer key;
+	guint n_jobs;
+	guint i;
+
+	if (priv->url_checks->len == 0)
+		return;
+
+	/* take the pending checks, we may be called again while validating */
+	checks = priv->url_checks;
+	priv->url_checks = g_ptr_array_new_with_free_func ((GDestroyNotify) as_validator_url_check_free);
+
+	as_validator_url_cache_load (validator);
+
+	/* deduplicate the URLs */
+	urls = g_hash_table_new (g_str_hash, g_str_equal);
+	for (i = 0; i < checks->len; i++) {
+		AsValidatorUrlCheck *check = (AsValidatorUrlCheck*) g_ptr_array_index (checks, i);
+		g_hash_table_add (urls, check->url);
+	}
+
+	/* checking URLs mostly means waiting for the network, so we do not
+	 * bound this by the number of files we validate in parallel */
+	n_jobs = AS_VALIDATOR_URL_JOBS;
+	if (n_jobs > g_hash_table_size (urls))
+		n_jobs = g_hash_table_size (urls);
+	if (n_jobs > 1) {
+		GThreadPool *pool;
+
+		pool = g_thread_pool_new ((GFunc) as_validator_url_check_job_run,
+					  validator,
+					  (gint) n_jobs,
+					  TRUE,
+					  NULL);
+		g_hash_table_iter_init (&iter, urls);
+		while (g_hash_table_iter_next (&iter, &key, NULL))
+			g_thread_pool_push (pool, key, NULL);
+		g_thread_pool_free (pool, FALSE, TRUE);
+	}
+
+	/* emit issues in the order they were found */
+	for (i = 0; i < checks->len; i++) {
+		AsValidatorUrlCheck *check = (AsValidatorUrlCheck*) g_ptr_array_index (checks, i);
+		AsValidatorIssue *issue;
+
+		if (as_validator_url_exists (validator, check->url))
+			continue;
+
+		issue = as_validator_issue_new ();
+		as_validator_issue_set_kind (issue, AS_ISSUE_KIND_REMOTE_ERROR);
+		as_validator_issue_set_importance (issue, AS_ISSUE_IMPORTANCE_WARNING);
+		as_validator_issue_set_message (issue, check->message);
+		if (check->fname != NULL)
+			as_validator_issue_set_filename (issue, check->fname);
+		if (check->cid != NULL)
+			as_validator_issue_set_cid (issue, check->cid);
+		if (check->line >= 0)
+			as_validator_issue_set_line (issue, check->line);
+
+		as_validator_insert_issue (validator, issue);
+	}
+
+	/* only remember the URLs we could reach, failed checks are repeated next time;
+	 * while other validators use our results, they may still be checking URLs */
+	if (g_atomic_int_get (&priv->url_state->ref_count) == 1) {
+		g_mutex_lock (&priv->url_state->mutex);
+		g_hash_table_remove_all (priv->url_state->status);
+		g_mutex_unlock (&priv->url_state->mutex);
+	}
+
+	as_validator_url_cache_save (validator);
+}
+
 /**
  * as_validator_get_check_urls:
  * @validator: a #AsValidator instance.
@@ -288,6 +729,90 @@ as_validator_set_check_urls (AsValidator *validator, gboolean value)
 	priv->check_urls = value;
 }
 
+/**
+ * as_validator_get_max_jobs:
+ * @validator: a #AsValidator instance.
+ *
+ * Returns: The maximum number of files validated in parallel.
+ *
+ * Since: 0.12.3
+ */
+guint
+as_validator_get_max_jobs (AsValidator *validator)
+{
+	AsValidatorPrivate *priv = GET_PRIVATE (validator);
+	return priv->max_jobs;
+}
+
+/**
+ * as_validator_set_max_jobs:
+ * @validator: a #AsValidator instance.
+ * @max_jobs: the maximum number of parallel jobs, or 0 to use all processors.
+ *
+ * Set the maximum number of metadata files the #AsValidator may validate
+ * concurrently when validating a whole directory tree.
+ * The generated report does not depend on this value.
+ *
+ * Since: 0.12.3
+ */
+void
+as_validator_set_max_jobs (AsValidator *validator, guint max_jobs)
+{
+	AsValidatorPrivate *priv = GET_PRIVATE (validator);
+	priv->max_jobs = max_jobs;
+}
+
+/**
+ * as_validator_set_url_cache:
+ * @validator: a #AsValidator instance.
+ * @fname: (nullable): location of the cache file, or %NULL to disable the cache.
+ * @max_age: time in seconds for which a cached result remains valid.
+ *
+ * Persist the results of remote URL checks in @fname, so URLs which
+ * were reachable within the last @max_age seconds are not checked again.
+ * Only reachable URLs are stored, so failed checks are always repeated.
+ *
+ * The validator also remembers reachable URLs for @max_age seconds when
+ * it is used to validate multiple documents, even if @fname is %NULL.
+ * A @max_age of 0 means they are remembered as long as the validator exists.
+ *
+ * Since: 0.12.3
+ */
+void
+as_validator_set_url_cache (AsValidator *validator, const gchar *fname, guint64 max_age)
+{
+	AsValidatorPrivate *priv = GET_PRIVATE (validator);
+	g_free (priv->url_cache_fname);
+	priv->url_cache_fname = g_strdup (fname);
+	priv->url_cache_max_age = max_age;
+}
+
+/**
+ * as_validator_share_url_checks:
+ * @validator: a #AsValidator instance.
+ * @source: the #AsValidator to share URL check results with.
+ *
+ * Make @validator use the results of remote URL checks of @source, including
+ * its URL cache settings, so an URL is only checked once for both of them.
+ * Failed checks are remembered as long as the results are shared.
+ * Both validators may be used from different threads.
+ */
+void
+as_validator_share_url_checks (AsValidator *validator, AsValidator *source)
+{
+	AsValidatorPrivate *priv = GET_PRIVATE (validator);
+	AsValidatorPrivate *spriv = GET_PRIVATE (source);
+
+	if (priv->url_state == spriv->url_state)
+		return;
+	as_validator_url_state_unref (priv->url_state);
+	priv->url_state = as_validator_url_state_ref (spriv->url_state);
+
+	as_validator_set_url_cache (validator,
+				    spriv->url_cache_fname,
+				    spriv->url_cache_max_age);
+}
+
 /**
  * as_validator_check_type_property:
  **/
@@ -806,13 +1331,8 @@ as_validator_check_screenshots (AsValidator *validator, xmlNode *node, AsCompone
 
 				image_found = TRUE;
 
-				if (!as_validator_web_url_exists (validator, image_url)) {
-					as_validator_add_issue (validator, iter2,
-							AS_ISSUE_IMPORTANCE_WARNING,
-							AS_ISSUE_KIND_REMOTE_ERROR,
-							"Unable to reach screenshot image on remote location '%s' - does the image exist?",
-							image_url);
-				}
+				as_validator_check_web_url (validator, iter2, image_url,
+							    "Unable to reach screenshot image on remote location '%s' - does the image exist?");
 			} else if (g_strcmp0 (node_name, "caption") == 0) {
 				caption_found = TRUE;
 			} else {
@@ -1110,13 +1630,8 @@ as_validator_validate_component_node (AsValidator *validator, AsContext *ctx, xm
 								AS_ISSUE_KIND_VALUE_WRONG,
 								"Icons of type 'remote' must contain an URL to the referenced icon.");
 				} else {
-					if (!as_validator_web_url_exists (validator, node_content)) {
-						as_validator_add_issue (validator, iter,
-									AS_ISSUE_IMPORTANCE_WARNING,
-									AS_ISSUE_KIND_REMOTE_ERROR,
-									"Unable to reach remote icon at '%s' - does it exist?",
-									node_content);
-					}
+					as_validator_check_web_url (validator, iter, node_content,
+								    "Unable to reach remote icon at '%s' - does it exist?");
 				}
 			}
 
@@ -1141,13 +1656,8 @@ as_validator_validate_component_node (AsValidator *validator, AsContext *ctx, xm
 			}
 			g_free (prop);
 
-			if (!as_validator_web_url_exists (validator, node_content)) {
-				as_validator_add_issue (validator, iter,
-							AS_ISSUE_IMPORTANCE_WARNING,
-							AS_ISSUE_KIND_REMOTE_ERROR,
-							"Unable to reach remote location '%s' - does it exist?",
-							node_content);
-			}
+			as_validator_check_web_url (validator, iter, node_content,
+						    "Unable to reach remote location '%s' - does it exist?");
 		} else if (g_strcmp0 (node_name, "categories") == 0) {
 			as_validator_check_appear_once (validator, iter, found_tags, cpt);
 			as_validator_check_children_quick (validator, iter, "category", cpt);
@@ -1472,30 +1982,19 @@ as_validator_validate_component_node (AsValidator *validator, AsContext *ctx, xm
 gboolean
 as_validator_validate_file (AsValidator *validator, GFile *metadata_file)
 {
-	g_autoptr(GFileInfo) info = NULL;
-	g_autoptr(GInputStream) file_stream = NULL;
 	g_autoptr(GInputStream) stream_data = NULL;
-	g_autoptr(GConverter) conv = NULL;
 	g_autoptr(GString) asxmldata = NULL;
 	g_autofree gchar *fname = NULL;
 	gssize len;
 	const gsize buffer_size = 1024 * 32;
 	g_autofree gchar *buffer = NULL;
-	const gchar *content_type = NULL;
 	g_autoptr(GError) tmp_error = NULL;
 	gboolean ret;
 
-	info = g_file_query_info (metadata_file,
-				G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE,
-				G_FILE_QUERY_INFO_NONE,
-				NULL, NULL);
-	if (info != NULL)
-		content_type = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE);
-
 	fname = g_file_get_basename (metadata_file);
 	as_validator_set_current_fname (validator, fname);
 
-	file_stream = G_INPUT_STREAM (g_file_read (metadata_file, NULL, &tmp_error));
+	stream_data = as_compression_open_file (metadata_file, &tmp_error);
 	if (tmp_error != NULL) {
 		as_validator_add_issue (validator, NULL,
 					AS_ISSUE_IMPORTANCE_ERROR,
@@ -1503,17 +2002,9 @@ as_validator_validate_file (AsValidator *validator, GFile *metadata_file)
 					"Unable to read file: %s", tmp_error->message);
 		return FALSE;
 	}
-	if (file_stream == NULL)
+	if (stream_data == NULL)
 		return FALSE;
 
-	if ((g_strcmp0 (content_type, "application/gzip") == 0) || (g_strcmp0 (content_type, "application/x-gzip") == 0)) {
-		/* decompress the GZip stream */
-		conv = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP));
-		stream_data = g_converter_input_stream_new (file_stream, conv);
-	} else {
-		stream_data = g_object_ref (file_stream);
-	}
-
 	asxmldata = g_string_new ("");
 	buffer = g_malloc (buffer_size);
 	while ((len = g_input_stream_read (stream_data, buffer, buffer_size, NULL, &tmp_error)) > 0) {
@@ -1642,6 +2133,8 @@ as_validator_validate_data (AsValidator *validator, const gchar *metadata)
 	}
 
 	xmlFreeDoc (doc);
+	as_validator_process_url_checks (validator);
+
 	return ret;
 }
 
@@ -1772,6 +2265,142 @@ as_validator_analyze_component_metainfo_relation_cb (const gchar *fname, AsCompo
 	as_validator_clear_current_fname (data->validator);
 }
 
+/**
+ * as_validator_validate_tree_metainfo:
+ *
+ * Validate a single metainfo file which is part of a filesystem tree.
+ * Returns the validated component in @cpt_out, if there was one.
+ **/
+static gboolean
+as_validator_validate_tree_metainfo (AsValidator *validator, AsContext *ctx, const gchar *fname, AsComponent **cpt_out)
+{
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GInputStream) file_stream = NULL;
+	g_autoptr(GError) tmp_error = NULL;
+	g_autoptr(GString) asdata = NULL;
+	gssize len;
+	const gsize buffer_size = 1024 * 24;
+	g_autofree gchar *buffer = NULL;
+	xmlNode *root;
+	xmlDoc *doc;
+	g_autofree gchar *fname_basename = NULL;
+	gboolean ret = TRUE;
+
+	file = g_file_new_for_path (fname);
+	if (!g_file_query_exists (file, NULL)) {
+		g_warning ("File '%s' suddenly vanished.", fname);
+		return TRUE;
+	}
+
+	fname_basename = g_path_get_basename (fname);
+	as_validator_set_current_fname (validator, fname_basename);
+
+	/* load a plaintext file */
+	file_stream = G_INPUT_STREAM (g_file_read (file, NULL, &tmp_error));
+	if (tmp_error != NULL) {
+		as_validator_add_issue (validator, NULL,
+					AS_ISSUE_IMPORTANCE_ERROR,
+					AS_ISSUE_KIND_READ_ERROR,
+					"Unable to read file: %s", tmp_error->message);
+		return TRUE;
+	}
+
+	asdata = g_string_new ("");
+	buffer = g_malloc (buffer_size);
+	while ((len = g_input_stream_read (file_stream, buffer, buffer_size, NULL, &tmp_error)) > 0) {
+		g_string_append_len (asdata, buffer, len);
+	}
+	/* check if there was an error */
+	if (tmp_error != NULL) {
+		as_validator_add_issue (validator, NULL,
+					AS_ISSUE_IMPORTANCE_ERROR,
+					AS_ISSUE_KIND_READ_ERROR,
+					"Unable to read file: %s", tmp_error->message);
+		return TRUE;
+	}
+
+	/* now read the XML */
+	doc = as_validator_open_xml_document (validator, asdata->str);
+	if (doc == NULL) {
+		as_validator_clear_current_fname (validator);
+		return TRUE;
+	}
+	root = xmlDocGetRootElement (doc);
+
+	if (g_strcmp0 ((gchar*) root->name, "component") == 0) {
+		*cpt_out = as_validator_validate_component_node (validator,
+								 ctx,
+								 root);
+	} else if (g_strcmp0 ((gchar*) root->name, "components") == 0) {
+		as_validator_add_issue (validator, root,
+				AS_ISSUE_IMPORTANCE_ERROR,
+				AS_ISSUE_KIND_TAG_NOT_ALLOWED,
+				"The metainfo file specifies multiple components. This is not allowed.");
+		ret = FALSE;
+	} else if (g_str_has_prefix ((gchar*) root->name, "application")) {
+		as_validator_add_issue (validator, root,
+				AS_ISSUE_IMPORTANCE_ERROR,
+				AS_ISSUE_KIND_LEGACY,
+				"The metainfo file uses an ancient version of the AppStream specification, which can not be validated. Please migrate it to version 0.6 (or higher).");
+		ret = FALSE;
+	}
+
+	as_validator_clear_current_fname (validator);
+	xmlFreeDoc (doc);
+
+	return ret;
+}
+
+/**
+ * AsValidatorTreeJob:
+ *
+ * Validation of a single metainfo file in a tree, possibly
+ * running on a worker thread with its own validator state.
+ */
+typedef struct {
+	gchar		*fname;
+	gboolean	check_urls;
+
+	AsValidator	*validator;
+	AsComponent	*cpt;
+	gboolean	ret;
+} AsValidatorTreeJob;
+
+/**
+ * as_validator_tree_job_free:
+ **/
+static void
+as_validator_tree_job_free (AsValidatorTreeJob *job)
+{
+	g_free (job->fname);
+	if (job->validator != NULL)
+		g_object_unref (job->validator);
+	if (job->cpt != NULL)
+		g_object_unref (job->cpt);
+	g_free (job);
+}
+
+/**
+ * as_validator_tree_job_run:
+ **/
+static void
+as_validator_tree_job_run (AsValidatorTreeJob *job, gpointer user_data)
+{
+	g_autoptr(AsContext) ctx = NULL;
+
+	job->validator = as_validator_new ();
+	as_validator_set_check_urls (job->validator, job->check_urls);
+
+	ctx = as_context_new ();
+	as_context_set_locale (ctx, "C");
+	as_context_set_style (ctx, AS_FORMAT_STYLE_METAINFO);
+
+	job->ret = as_validator_validate_tree_metainfo (job->validator,
+							ctx,
+							job->fname,
+							&job->cpt);
+}
+
 /**
  * as_validator_validate_tree:
  * @validator: An instance of #AsValidator.
@@ -1791,9 +2420,10 @@ as_validator_validate_tree (AsValidator *validator, const gchar *root_dir)
 	g_autoptr(GPtrArray) dfiles = NULL;
 	GHashTable *dfilenames = NULL;
 	GHashTable *validated_cpts = NULL;
+	g_autoptr(GPtrArray) jobs = NULL;
+	guint n_jobs;
 	guint i;
 	gboolean ret = TRUE;
-	g_autoptr(AsContext) ctx = NULL;
 	struct MInfoCheckData ht_helper;
 
 	/* cleanup */
@@ -1838,11 +2468,6 @@ as_validator_validate_tree (AsValidator *validator, const gchar *root_dir)
 						g_free,
 						g_object_unref);
 
-	/* set up XML parser */
-	ctx = as_context_new ();
-	as_context_set_locale (ctx, "C");
-	as_context_set_style (ctx, AS_FORMAT_STYLE_METAINFO);
-
 	/* validate all metainfo files */
 	mfiles = as_utils_find_files_matching (metainfo_dir, "*.xml", FALSE, NULL);
 	mfiles_legacy = as_utils_find_files_matching (legacy_metainfo_dir, "*.xml", FALSE, NULL);
@@ -1870,87 +2495,49 @@ as_validator_validate_tree (AsValidator *validator, const gchar *root_dir)
 		}
 	}
 
-	for (i = 0; i < mfiles->len; i++) {
-		const gchar *fname;
-		g_autoptr(GFile) file = NULL;
-		g_autoptr(GInputStream) file_stream = NULL;
-		g_autoptr(GError) tmp_error = NULL;
-		g_autoptr(GString) asdata = NULL;
-		gssize len;
-		const gsize buffer_size = 1024 * 24;
-		g_autofree gchar *buffer = NULL;
-		xmlNode *root;
-		xmlDoc *doc;
-		g_autofree gchar *fname_basename = NULL;
-
-		fname = (const gchar*) g_ptr_array_index (mfiles, i);
-		file = g_file_new_for_path (fname);
-		if (!g_file_query_exists (file, NULL)) {
-			g_warning ("File '%s' suddenly vanished.", fname);
-			g_object_unref (file);
-			continue;
-		}
+	/* validate the individual files, in parallel if we are allowed to */
+	n_jobs = priv->max_jobs;
+	if (n_jobs == 0)
+		n_jobs = g_get_num_processors ();
+	if (n_jobs > mfiles->len)
+		n_jobs = mfiles->len;
 
-		fname_basename = g_path_get_basename (fname);
-		as_validator_set_current_fname (validator, fname_basename);
+	jobs = g_ptr_array_new_with_free_func ((GDestroyNotify) as_validator_tree_job_free);
+	for (i = 0; i < mfiles->len; i++) {
+		AsValidatorTreeJob *job = g_new0 (AsValidatorTreeJob, 1);
+		job->fname = g_strdup ((const gchar*) g_ptr_array_index (mfiles, i));
+		job->check_urls = priv->check_urls;
+		g_ptr_array_add (jobs, job);
+	}
 
-		/* load a plaintext file */
-		file_stream = G_INPUT_STREAM (g_file_read (file, NULL, &tmp_error));
-		if (tmp_error != NULL) {
-			as_validator_add_issue (validator, NULL,
-						AS_ISSUE_IMPORTANCE_ERROR,
-						AS_ISSUE_KIND_READ_ERROR,
-						"Unable to read file: %s", tmp_error->message);
-			continue;
-		}
+	if (n_jobs > 1) {
+		GThreadPool *pool;
+
+		pool = g_thread_pool_new ((GFunc) as_validator_tree_job_run,
+					  NULL,
+					  (gint) n_jobs,
+					  TRUE,
+					  NULL);
+		for (i = 0; i < jobs->len; i++)
+			g_thread_pool_push (pool, g_ptr_array_index (jobs, i), NULL);
+		/* wait for all jobs to complete */
+		g_thread_pool_free (pool, FALSE, TRUE);
+	} else {
+		for (i = 0; i < jobs->len; i++)
+			as_validator_tree_job_run (g_ptr_array_index (jobs, i), NULL);
+	}
 
-		asdata = g_string_new ("");
-		buffer = g_malloc (buffer_size);
-		while ((len = g_input_stream_read (file_stream, buffer, buffer_size, NULL, &tmp_error)) > 0) {
-			g_string_append_len (asdata, buffer, len);
-		}
-		/* check if there was an error */
-		if (tmp_error != NULL) {
-			as_validator_add_issue (validator, NULL,
-						AS_ISSUE_IMPORTANCE_ERROR,
-						AS_ISSUE_KIND_READ_ERROR,
-						"Unable to read file: %s", tmp_error->message);
-			continue;
-		}
+	/* collect the results in file order, so the report does not depend on scheduling */
+	for (i = 0; i < jobs->len; i++) {
+		AsValidatorTreeJob *job = (AsValidatorTreeJob*) g_ptr_array_index (jobs, i);
 
-		/* now read the XML */
-		doc = as_validator_open_xml_document (validator, asdata->str);
-		if (doc == NULL) {
-			as_validator_clear_current_fname (validator);
-			continue;
-		}
-		root = xmlDocGetRootElement (doc);
-
-		if (g_strcmp0 ((gchar*) root->name, "component") == 0) {
-			AsComponent *cpt;
-			cpt = as_validator_validate_component_node (validator,
-								    ctx,
-								    root);
-			if (cpt != NULL)
-				g_hash_table_insert (validated_cpts,
-							g_strdup (fname_basename),
-							cpt);
-		} else if (g_strcmp0 ((gchar*) root->name, "components") == 0) {
-			as_validator_add_issue (validator, root,
-					AS_ISSUE_IMPORTANCE_ERROR,
-					AS_ISSUE_KIND_TAG_NOT_ALLOWED,
-					"The metainfo file specifies multiple components. This is not allowed.");
+		as_validator_merge_issues (validator, job->validator);
+		if (!job->ret)
 			ret = FALSE;
-		} else if (g_str_has_prefix ((gchar*) root->name, "application")) {
-			as_validator_add_issue (validator, root,
-					AS_ISSUE_IMPORTANCE_ERROR,
-					AS_ISSUE_KIND_LEGACY,
-					"The metainfo file uses an ancient version of the AppStream specification, which can not be validated. Please migrate it to version 0.6 (or higher).");
-			ret = FALSE;
-		}
-
-		as_validator_clear_current_fname (validator);
-		xmlFreeDoc (doc);
+		if (job->cpt != NULL)
+			g_hash_table_insert (validated_cpts,
+					     g_path_get_basename (job->fname),
+					     g_object_ref (job->cpt));
 	}
 
 	/* check if we have matching .desktop files */
@@ -1976,6 +2563,9 @@ as_validator_validate_tree (AsValidator *validator, const gchar *root_dir)
 				(GHFunc) as_validator_analyze_component_metainfo_relation_cb,
 				&ht_helper);
 
+	/* check all remote URLs we found at once */
+	as_validator_process_url_checks (validator);
+
 out:
 	if (dfilenames != NULL)
 		g_hash_table_unref (dfilenames);
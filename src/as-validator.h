@@ -60,6 +60,14 @@ gboolean	as_validator_get_check_urls (AsValidator *validator);
 void		as_validator_set_check_urls (AsValidator *validator,
 						gboolean value);
 
+guint		as_validator_get_max_jobs (AsValidator *validator);
+void		as_validator_set_max_jobs (AsValidator *validator,
+						guint max_jobs);
+
+void		as_validator_set_url_cache (AsValidator *validator,
+						const gchar *fname,
+						guint64 max_age);
+
 G_END_DECLS
 
 #endif /* __AS_VALIDATOR_H */
@@ -30,7 +30,7 @@
  * @include: appstream.h
  */
 
-#define CACHE_FORMAT_VERSION 1
+#define CACHE_FORMAT_VERSION 2
 
 /**
  * as_variant_get_dict_uint32:
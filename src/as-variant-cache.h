@@ -31,7 +31,7 @@ G_BEGIN_DECLS
 #pragma GCC visibility push(hidden)
 
 /* version of the cache the current implementation supports */
-#define CACHE_FORMAT_VERSION 1
+#define CACHE_FORMAT_VERSION 2
 
 guint32			as_variant_get_dict_uint32 (GVariantDict *dict,
 						    const gchar *key);
@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2018 Matthias Klumpp <matthias@tenstral.net>
+#
+# Licensed under the GNU Lesser General Public License Version 2.1
+#
+# This library is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation, either version 2.1 of the license, or
+# (at your option) any later version.
+#
+# This library is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU Lesser General Public License
+# along with this library.  If not, see <http://www.gnu.org/licenses/>.
+
+#
+# This is a helper script for Meson and intended to be called by the
+# AppStream buildsystem. You do not want to run this manually.
+#
+# It converts one of our static word lists in data/ into a gperf
+# keyword file, so we can match against the list using a perfect hash.
+#
+
+import sys
+import argparse
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate gperf input from a word list.')
+    parser.add_argument('--name', required=True,
+                        help='Name prefix to use for the generated functions.')
+    parser.add_argument('input', help='The word list to read.')
+    parser.add_argument('output', help='The gperf file to write.')
+    options = parser.parse_args(sys.argv[1:])
+
+    words = set()
+    with open(options.input, 'r', encoding='utf-8') as f:
+        for line in f:
+            line = line.strip()
+            if not line or line.startswith('#'):
+                continue
+            words.add(line)
+
+    with open(options.output, 'w', encoding='utf-8') as f:
+        f.write('%language=ANSI-C\n')
+        f.write('%enum\n')
+        f.write('%readonly-tables\n')
+        f.write('%includes\n')
+        f.write('%pic\n')
+        f.write('%define hash-function-name _as_{}_hash\n'.format(options.name))
+        f.write('%define lookup-function-name _as_{}_lookup\n'.format(options.name))
+        f.write('%define string-pool-name {}_stringpool\n'.format(options.name))
+        f.write('%%\n')
+        for word in sorted(words):
+            f.write(word + '\n')
+        f.write('%%\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -18,9 +18,12 @@
  * along with this library.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "config.h"
 #include <glib.h>
+#include <string.h>
 #include "appstream.h"
 #include "as-component-private.h"
+#include "as-compression.h"
 
 #include "as-test-utils.h"
 
@@ -57,6 +60,74 @@ test_simplemarkup ()
 	g_assert (g_strcmp0 (str, "Test!\n\nBlah.\n • A\n • B\n\nEnd.") == 0);
 }
 
+/**
+ * test_description_plain:
+ *
+ * Test the cached plain-text rendering of component descriptions.
+ */
+static void
+test_description_plain ()
+{
+	g_autoptr(AsComponent) cpt = NULL;
+	g_autofree gchar *snippet = NULL;
+	const gchar *plain;
+
+	cpt = as_component_new ();
+	as_component_set_active_locale (cpt, "C");
+	g_assert_null (as_component_get_description_plain (cpt));
+
+	as_component_set_description (cpt, "<p>Test!</p><p>Blah.</p><ul><li>A</li><li>B</li></ul><p>End.</p>", NULL);
+	plain = as_component_get_description_plain (cpt);
+	g_assert_cmpstr (plain, ==, "Test!\n\nBlah.\n • A\n • B\n\nEnd.");
+	g_assert_true (as_component_get_description_plain (cpt) == plain);
+
+	/* the cached value must be dropped when the description changes */
+	as_component_set_description (cpt, "<p>A rather long first paragraph.</p><p>Second.</p>", NULL);
+	g_assert_cmpstr (as_component_get_description_plain (cpt), ==, "A rather long first paragraph.\n\nSecond.");
+
+	snippet = as_component_get_description_snippet (cpt, 100);
+	g_assert_cmpstr (snippet, ==, "A rather long first paragraph.");
+	g_free (snippet);
+	snippet = as_component_get_description_snippet (cpt, 16);
+	g_assert_cmpstr (snippet, ==, "A rather long…");
+
+	/* invalid markup can not be converted, and is not retried */
+	as_component_set_description (cpt, "<p>Unclosed", NULL);
+	g_assert_null (as_component_get_description_plain (cpt));
+	g_assert_null (as_component_get_description_plain (cpt));
+}
+
+/**
+ * test_release_empty:
+ *
+ * Test that an #AsRelease without optional data behaves like one with empty data.
+ */
+static void
+test_release_empty ()
+{
+	g_autoptr(AsRelease) rel = NULL;
+	g_autoptr(AsChecksum) cs = NULL;
+
+	rel = as_release_new ();
+	g_assert_null (as_release_get_description (rel));
+	g_assert_null (as_release_get_checksum (rel, AS_CHECKSUM_KIND_SHA256));
+	g_assert_nonnull (as_release_get_locations (rel));
+	g_assert_cmpint (as_release_get_locations (rel)->len, ==, 0);
+	g_assert_nonnull (as_release_get_checksums (rel));
+	g_assert_cmpint (as_release_get_checksums (rel)->len, ==, 0);
+
+	as_release_set_description (rel, "<p>Fixed.</p>", "C");
+	as_release_add_location (rel, "https://example.org/foo-1.0.tar.xz");
+	cs = as_checksum_new ();
+	as_checksum_set_kind (cs, AS_CHECKSUM_KIND_SHA256);
+	as_checksum_set_value (cs, "abcdef");
+	as_release_add_checksum (rel, cs);
+
+	g_assert_cmpstr (as_release_get_description (rel), ==, "<p>Fixed.</p>");
+	g_assert_cmpint (as_release_get_locations (rel)->len, ==, 1);
+	g_assert_true (as_release_get_checksum (rel, AS_CHECKSUM_KIND_SHA256) == cs);
+}
+
 /**
  * _get_dummy_strv:
  */
@@ -294,6 +365,42 @@ test_spdx (void)
 	g_assert (as_license_is_metadata_license ("0BSD"));
 	g_assert (as_license_is_metadata_license ("MIT AND FSFAP"));
 	g_assert (!as_license_is_metadata_license ("GPL-2.0 AND FSFAP"));
+
+	/* single license IDs */
+	g_assert (as_is_spdx_license_id ("0BSD"));
+	g_assert (as_is_spdx_license_id ("GPL-3.0+"));
+	g_assert (as_is_spdx_license_id ("Zlib"));
+	g_assert (!as_is_spdx_license_id ("GPL"));
+	g_assert (!as_is_spdx_license_id ("Zlib\nMIT"));
+	g_assert (!as_is_spdx_license_id (""));
+	g_assert (!as_is_spdx_license_id (NULL));
+}
+
+/**
+ * test_static_data_lists:
+ *
+ * Test lookups in our static lists of known names.
+ */
+static void
+test_static_data_lists ()
+{
+	g_assert (as_utils_is_category_name ("2DGraphics"));
+	g_assert (as_utils_is_category_name ("AudioVideo"));
+	g_assert (as_utils_is_category_name ("X-Custom"));
+	g_assert (!as_utils_is_category_name ("audiovideo"));
+	g_assert (!as_utils_is_category_name ("Audio\nVideo"));
+	g_assert (!as_utils_is_category_name (""));
+
+	g_assert (as_utils_is_tld ("org"));
+	g_assert (as_utils_is_tld ("de"));
+	g_assert (!as_utils_is_tld ("ORG"));
+	g_assert (!as_utils_is_tld ("notatld"));
+	g_assert (!as_utils_is_tld (""));
+
+	g_assert (as_utils_is_desktop_environment ("GNOME"));
+	g_assert (as_utils_is_desktop_environment ("Pantheon"));
+	g_assert (!as_utils_is_desktop_environment ("gnome"));
+	g_assert (!as_utils_is_desktop_environment ("# List of desktop environments"));
 }
 
 /**
@@ -405,6 +512,156 @@ test_version_compare ()
 	/* g_assert_cmpint (as_utils_compare_versions ("1:1.0-4", "3:0.8-2"), <, 0); */
 }
 
+/**
+ * test_version_keys:
+ *
+ * Test that binary version keys sort like version strings.
+ */
+static void
+test_version_keys ()
+{
+	guint i, j;
+	g_autoptr(AsRelease) rel1 = NULL;
+	g_autoptr(AsRelease) rel2 = NULL;
+	const gchar *versions[] = { "", "0", "00", "1", "1.0", "1.0.0", "1-0", "1.0~rc1", "1.0~~",
+				    "1.0~rc1~1", "1.0a", "1.0b", "1.0A", "1.01", "1.1", "1.10", "1.9",
+				    "2.79", "2.79a", "3.0.rc2", "3.0.0", "3.0.0~rc2", "5.9.1+dfsg-5",
+				    "5.9.1+dfsg-5pureos1", "0.6.12b-d", "0.6.12a", "ab.d", "ab.f", "~",
+				    "123456789012345678901234567890", "123456789012345678901234567891",
+				    "1.ä", NULL };
+
+	for (i = 0; versions[i] != NULL; i++) {
+		g_autoptr(GBytes) key1 = as_utils_build_version_key (versions[i]);
+
+		for (j = 0; versions[j] != NULL; j++) {
+			g_autoptr(GBytes) key2 = as_utils_build_version_key (versions[j]);
+			gint vcmp = as_utils_compare_versions (versions[i], versions[j]);
+			gint kcmp = g_bytes_compare (key1, key2);
+
+			if (vcmp != (kcmp > 0? 1 : (kcmp < 0? -1 : 0)))
+				g_error ("Version key ordering of '%s' and '%s' is wrong (%i vs %i)",
+					 versions[i], versions[j], vcmp, kcmp);
+		}
+	}
+
+	/* keys are rebuilt if the version changes */
+	rel1 = as_release_new ();
+	rel2 = as_release_new ();
+	as_release_set_version (rel1, "1.2");
+	as_release_set_version (rel2, "1.10");
+	g_assert_cmpint (as_release_vercmp (rel1, rel2), ==, -1);
+	as_release_set_version (rel2, "1.2.0~beta");
+	g_assert_cmpint (as_release_vercmp (rel1, rel2), ==, 1);
+	as_release_set_version (rel2, "1.2");
+	g_assert_cmpint (as_release_vercmp (rel1, rel2), ==, 0);
+}
+
+/**
+ * test_read_compressed_stream:
+ *
+ * Helper to read all data from a (compressed) input stream.
+ */
+static gchar*
+test_read_compressed_stream (GInputStream *base_stream)
+{
+	g_autoptr(GInputStream) stream = NULL;
+	g_autoptr(GOutputStream) out = NULL;
+	g_autoptr(GError) error = NULL;
+
+	stream = as_compression_open_stream (base_stream, &error);
+	g_assert_no_error (error);
+
+	out = g_memory_output_stream_new_resizable ();
+	g_output_stream_splice (out, stream, G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET, NULL, &error);
+	g_assert_no_error (error);
+
+	return g_strndup (g_memory_output_stream_get_data (G_MEMORY_OUTPUT_STREAM (out)),
+			  g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (out)));
+}
+
+/**
+ * test_compression:
+ *
+ * Test transparent decompression of metadata.
+ */
+static void
+test_compression ()
+{
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *fname = NULL;
+	g_autofree gchar *expected = NULL;
+	const gchar *suffixes[] = {
+		"",
+		".gz",
+#ifdef HAVE_ZSTD
+		".zst",
+#endif
+#ifdef HAVE_LZMA
+		".xz",
+#endif
+	};
+	AsCompressionKind write_kinds[] = {
+		AS_COMPRESSION_KIND_GZIP,
+#ifdef HAVE_ZSTD
+		AS_COMPRESSION_KIND_ZSTD,
+#endif
+	};
+	guint i;
+
+	fname = g_build_filename (datadir, "appstream-dxml.xml", NULL);
+	g_file_get_contents (fname, &expected, NULL, &error);
+	g_assert_no_error (error);
+
+	/* read sample data */
+	for (i = 0; i < G_N_ELEMENTS (suffixes); i++) {
+		g_autoptr(GFile) file = NULL;
+		g_autoptr(GFileInputStream) fstream = NULL;
+		g_autofree gchar *path = NULL;
+		g_autofree gchar *data = NULL;
+
+		path = g_strconcat (fname, suffixes[i], NULL);
+		file = g_file_new_for_path (path);
+		fstream = g_file_read (file, NULL, &error);
+		g_assert_no_error (error);
+
+		data = test_read_compressed_stream (G_INPUT_STREAM (fstream));
+		g_assert_cmpstr (data, ==, expected);
+	}
+
+	/* roundtrip through the formats we can write */
+	for (i = 0; i < G_N_ELEMENTS (write_kinds); i++) {
+		g_autoptr(GOutputStream) out = NULL;
+		g_autoptr(GInputStream) in = NULL;
+		g_autofree gchar *data = NULL;
+		GMemoryOutputStream *mout;
+
+		g_assert (as_compression_kind_is_supported (write_kinds[i]));
+		out = g_memory_output_stream_new_resizable ();
+		mout = G_MEMORY_OUTPUT_STREAM (out);
+		as_compression_write_compressed (out, write_kinds[i], (const guint8*) expected, strlen (expected), &error);
+		g_assert_no_error (error);
+		g_output_stream_close (out, NULL, &error);
+		g_assert_no_error (error);
+
+		g_assert_cmpint (as_compression_kind_from_data (g_memory_output_stream_get_data (mout),
+								g_memory_output_stream_get_data_size (mout)), ==, write_kinds[i]);
+
+		in = g_memory_input_stream_new_from_data (g_memory_output_stream_get_data (mout),
+							  g_memory_output_stream_get_data_size (mout),
+							  NULL);
+		data = test_read_compressed_stream (in);
+		g_assert_cmpstr (data, ==, expected);
+	}
+
+	/* new caches use the best format we were built with */
+#ifdef HAVE_ZSTD
+	g_assert_cmpint (as_compression_get_cache_kind (), ==, AS_COMPRESSION_KIND_ZSTD);
+#else
+	g_assert_cmpint (as_compression_get_cache_kind (), ==, AS_COMPRESSION_KIND_GZIP);
+	g_assert (!as_compression_kind_is_supported (AS_COMPRESSION_KIND_ZSTD));
+#endif
+}
+
 int
 main (int argc, char **argv)
 {
@@ -427,11 +684,16 @@ main (int argc, char **argv)
 
 	g_test_add_func ("/AppStream/Categories", test_categories);
 	g_test_add_func ("/AppStream/SimpleMarkupConvert", test_simplemarkup);
+	g_test_add_func ("/AppStream/DescriptionPlain", test_description_plain);
 	g_test_add_func ("/AppStream/Component", test_component);
+	g_test_add_func ("/AppStream/ReleaseEmpty", test_release_empty);
 	g_test_add_func ("/AppStream/SPDX", test_spdx);
+	g_test_add_func ("/AppStream/StaticDataLists", test_static_data_lists);
 	g_test_add_func ("/AppStream/TranslationFallback", test_translation_fallback);
 	g_test_add_func ("/AppStream/DesktopEntry", test_desktop_entry);
 	g_test_add_func ("/AppStream/VersionCompare", test_version_compare);
+	g_test_add_func ("/AppStream/VersionKeys", test_version_keys);
+	g_test_add_func ("/AppStream/Compression", test_compression);
 
 	ret = g_test_run ();
 	g_free (datadir);
@@ -20,12 +20,14 @@
 
 #include <glib.h>
 #include <glib/gprintf.h>
+#include <glib/gstdio.h>
 
 #include "appstream.h"
 #include "as-pool-private.h"
 #include "as-test-utils.h"
 #include "../src/as-utils-private.h"
 #include "../src/as-component-private.h"
+#include "../src/as-stemmer.h"
 
 
 static gchar *datadir = NULL;
@@ -278,6 +280,786 @@ test_cache_complex ()
 	g_assert (as_test_compare_lines (xmldata_precache, xmldata_postcache));
 }
 
+/**
+ * test_cache_locales:
+ *
+ * Test the shared cache data with per-locale string tables.
+ */
+static void
+test_cache_locales ()
+{
+	g_autoptr(GPtrArray) cpts = NULL;
+	g_autoptr(GPtrArray) cpts_de = NULL;
+	g_autoptr(GPtrArray) cpts_fr = NULL;
+	g_autoptr(GPtrArray) cpts_single = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autofree gchar *core_fname = NULL;
+	g_autofree gchar *de_fname = NULL;
+	g_autofree gchar *fr_fname = NULL;
+	AsComponent *cpt;
+	GStatBuf sb_core;
+	GStatBuf sb_de;
+	guint i;
+	const gchar *locales_de[] = { "de_DE", NULL };
+	const gchar *locales_fr[] = { "fr_FR", NULL };
+	const gchar *locales_all[] = { "de_DE", "fr_FR", NULL };
+
+	tmpdir = g_dir_make_tmp ("as-unittest-XXXXXX", &error);
+	g_assert_no_error (error);
+	core_fname = g_build_filename (tmpdir, "core.gvz", NULL);
+	de_fname = g_build_filename (tmpdir, "de_DE.gvz", NULL);
+	fr_fname = g_build_filename (tmpdir, "fr_FR.gvz", NULL);
+
+	cpts = g_ptr_array_new_with_free_func (g_object_unref);
+	for (i = 0; i < 100; i++) {
+		g_autofree gchar *cid = g_strdup_printf ("org.example.App%u", i);
+		g_autoptr(AsScreenshot) scr = as_screenshot_new ();
+		g_autoptr(AsImage) img = as_image_new ();
+		g_autoptr(AsRelease) rel = as_release_new ();
+
+		cpt = as_component_new ();
+		as_component_set_id (cpt, cid);
+		as_component_set_kind (cpt, AS_COMPONENT_KIND_DESKTOP_APP);
+		as_component_set_name (cpt, "Example", "C");
+		as_component_set_summary (cpt, "An example application", "C");
+		as_component_set_description (cpt, "<p>A long description which is not translated.</p>", "C");
+
+		as_image_set_kind (img, AS_IMAGE_KIND_SOURCE);
+		as_image_set_url (img, "https://example.org/screenshot.png");
+		as_screenshot_add_image (scr, img);
+		as_screenshot_set_caption (scr, "The main window", "C");
+		as_component_add_screenshot (cpt, scr);
+		as_release_set_version (rel, "1.0");
+		as_release_set_description (rel, "<p>The first release.</p>", "C");
+		as_component_add_release (cpt, rel);
+
+		/* only some components are translated */
+		if (i % 2 == 0) {
+			as_component_set_name (cpt, "Beispiel", "de_DE");
+			as_component_set_name (cpt, "Exemple", "fr_FR");
+			as_screenshot_set_caption (scr, "Das Hauptfenster", "de_DE");
+			as_screenshot_set_caption (scr, "La fenêtre principale", "fr_FR");
+			as_release_set_description (rel, "<p>Die erste Version.</p>", "de_DE");
+			as_release_set_description (rel, "<p>La première version.</p>", "fr_FR");
+		}
+		g_ptr_array_add (cpts, cpt);
+	}
+
+	/* write one locale at a time, the core data is shared */
+	as_cache_files_save (tmpdir, locales_de, cpts, NULL, &error);
+	g_assert_no_error (error);
+	as_cache_files_save (tmpdir, locales_fr, cpts, NULL, &error);
+	g_assert_no_error (error);
+	cpts_single = as_cache_file_read (de_fname, &error);
+	g_assert_no_error (error);
+
+	/* generating all locales in one pass has the same result */
+	as_cache_files_save (tmpdir, locales_all, cpts, NULL, &error);
+	g_assert_no_error (error);
+
+	/* the string tables only contain the localized data */
+	g_assert_cmpint (g_stat (core_fname, &sb_core), ==, 0);
+	g_assert_cmpint (g_stat (de_fname, &sb_de), ==, 0);
+	g_assert_cmpint (sb_de.st_size, <, sb_core.st_size);
+
+	/* both locales share the same core data */
+	cpts_de = as_cache_file_read (de_fname, &error);
+	g_assert_no_error (error);
+	cpts_fr = as_cache_file_read (fr_fname, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (cpts_de->len, ==, 100);
+	g_assert_cmpint (cpts_fr->len, ==, 100);
+	as_assert_component_lists_equal (cpts_de, cpts_single);
+
+	for (i = 0; i < cpts_de->len; i++) {
+		AsComponent *cpt_de = AS_COMPONENT (g_ptr_array_index (cpts_de, i));
+		AsComponent *cpt_fr = AS_COMPONENT (g_ptr_array_index (cpts_fr, i));
+		AsScreenshot *scr_de;
+		AsScreenshot *scr_fr;
+		AsRelease *rel_de;
+		AsRelease *rel_fr;
+		gboolean translated = (i % 2 == 0);
+
+		g_assert_cmpstr (as_component_get_id (cpt_de), ==, as_component_get_id (cpt_fr));
+		g_assert_cmpstr (as_component_get_name (cpt_de), ==, translated? "Beispiel" : "Example");
+		g_assert_cmpstr (as_component_get_name (cpt_fr), ==, translated? "Exemple" : "Example");
+		g_assert_cmpstr (as_component_get_summary (cpt_de), ==, "An example application");
+		g_assert_cmpstr (as_component_get_description (cpt_fr), ==, "<p>A long description which is not translated.</p>");
+
+		/* screenshots and releases are rendered in each locale as well */
+		scr_de = AS_SCREENSHOT (g_ptr_array_index (as_component_get_screenshots (cpt_de), 0));
+		scr_fr = AS_SCREENSHOT (g_ptr_array_index (as_component_get_screenshots (cpt_fr), 0));
+		g_assert_cmpstr (as_screenshot_get_caption (scr_de), ==, translated? "Das Hauptfenster" : "The main window");
+		g_assert_cmpstr (as_screenshot_get_caption (scr_fr), ==, translated? "La fenêtre principale" : "The main window");
+		rel_de = AS_RELEASE (g_ptr_array_index (as_component_get_releases (cpt_de), 0));
+		rel_fr = AS_RELEASE (g_ptr_array_index (as_component_get_releases (cpt_fr), 0));
+		g_assert_cmpstr (as_release_get_description (rel_de), ==, translated? "<p>Die erste Version.</p>" : "<p>The first release.</p>");
+		g_assert_cmpstr (as_release_get_description (rel_fr), ==, translated? "<p>La première version.</p>" : "<p>The first release.</p>");
+	}
+
+	/* changing the shared data invalidates the other string tables */
+	as_component_set_summary (AS_COMPONENT (g_ptr_array_index (cpts, 0)), "Changed", "C");
+	as_cache_files_save (tmpdir, locales_fr, cpts, NULL, &error);
+	g_assert_no_error (error);
+
+	g_clear_pointer (&cpts_de, g_ptr_array_unref);
+	cpts_de = as_cache_file_read (de_fname, &error);
+	g_assert_error (error, AS_POOL_ERROR, AS_POOL_ERROR_FAILED);
+	g_assert_null (cpts_de);
+	g_clear_error (&error);
+
+	g_remove (core_fname);
+	g_remove (de_fname);
+	g_remove (fr_fname);
+	g_remove (tmpdir);
+}
+
+/**
+ * test_cache_locales_stemming:
+ *
+ * Test that the search tokens of each locale are stemmed in its language.
+ */
+static void
+test_cache_locales_stemming ()
+{
+	g_autoptr(GPtrArray) cpts = NULL;
+	g_autoptr(GPtrArray) cpts_de = NULL;
+	g_autoptr(AsStemmer) stemmer = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autofree gchar *core_fname = NULL;
+	g_autofree gchar *de_fname = NULL;
+	g_autofree gchar *fr_fname = NULL;
+	g_autofree gchar *stem_de = NULL;
+	g_autofree gchar *stem_en = NULL;
+	AsComponent *cpt;
+	const gchar *locales[] = { "de_DE", "fr_FR", NULL };
+
+	tmpdir = g_dir_make_tmp ("as-unittest-XXXXXX", &error);
+	g_assert_no_error (error);
+	core_fname = g_build_filename (tmpdir, "core.gvz", NULL);
+	de_fname = g_build_filename (tmpdir, "de_DE.gvz", NULL);
+	fr_fname = g_build_filename (tmpdir, "fr_FR.gvz", NULL);
+
+	cpts = g_ptr_array_new_with_free_func (g_object_unref);
+	cpt = as_component_new ();
+	as_component_set_id (cpt, "org.example.Library");
+	as_component_set_kind (cpt, AS_COMPONENT_KIND_DESKTOP_APP);
+	as_component_set_name (cpt, "Library", "C");
+	as_component_set_name (cpt, "Bücher", "de_DE");
+	as_component_set_summary (cpt, "Manage your books", "C");
+	g_ptr_array_add (cpts, cpt);
+
+	as_cache_files_save (tmpdir, locales, cpts, NULL, &error);
+	g_assert_no_error (error);
+
+	cpts_de = as_cache_file_read (de_fname, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (cpts_de->len, ==, 1);
+	cpt = AS_COMPONENT (g_ptr_array_index (cpts_de, 0));
+	g_assert_cmpstr (as_component_get_name (cpt), ==, "Bücher");
+
+	/* the token must have been stemmed in German, no matter which locale we run in */
+	stemmer = as_stemmer_new ();
+	as_stemmer_reload (stemmer, "de");
+	stem_de = as_stemmer_stem (stemmer, "bücher");
+	as_stemmer_reload (stemmer, "en");
+	stem_en = as_stemmer_stem (stemmer, "bücher");
+	g_assert_true (g_hash_table_contains (as_component_get_token_cache_table (cpt), stem_de));
+	if (g_strcmp0 (stem_de, stem_en) != 0)
+		g_assert_false (g_hash_table_contains (as_component_get_token_cache_table (cpt), stem_en));
+
+	g_remove (core_fname);
+	g_remove (de_fname);
+	g_remove (fr_fname);
+	g_remove (tmpdir);
+}
+
+/**
+ * test_cache_load_fields:
+ *
+ * Test loading optional component data from the cache on demand.
+ */
+static void
+test_cache_load_fields ()
+{
+	g_autoptr(AsPool) pool = NULL;
+	g_autoptr(AsPool) lazy_pool = NULL;
+	g_autoptr(GPtrArray) cpts = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autofree gchar *cache_fname = NULL;
+	guint n_deferred = 0;
+	guint i;
+
+	tmpdir = g_dir_make_tmp ("as-unittest-XXXXXX", &error);
+	g_assert_no_error (error);
+	cache_fname = g_build_filename (tmpdir, "fields.gvz", NULL);
+
+	pool = test_get_sampledata_pool (FALSE);
+	as_pool_load (pool, NULL, &error);
+	g_assert_no_error (error);
+	as_pool_save_cache_file (pool, cache_fname, &error);
+	g_assert_no_error (error);
+	g_clear_object (&pool);
+
+	pool = as_pool_new ();
+	as_pool_load_cache_file (pool, cache_fname, &error);
+	g_assert_no_error (error);
+
+	lazy_pool = as_pool_new ();
+	as_pool_set_load_fields (lazy_pool, AS_COMPONENT_FIELD_NONE);
+	g_assert_cmpint (as_pool_get_load_fields (lazy_pool), ==, AS_COMPONENT_FIELD_NONE);
+	as_pool_load_cache_file (lazy_pool, cache_fname, &error);
+	g_assert_no_error (error);
+
+	cpts = as_pool_get_components (pool);
+	g_assert_cmpint (cpts->len, >, 0);
+	for (i = 0; i < cpts->len; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (cpts, i));
+		g_autoptr(AsComponent) lazy_cpt = NULL;
+
+		lazy_cpt = _as_get_single_component_by_cid (lazy_pool, as_component_get_id (cpt));
+		g_assert_nonnull (lazy_cpt);
+		g_assert_cmpstr (as_component_get_name (lazy_cpt), ==, as_component_get_name (cpt));
+		if (as_component_get_deferred_fields (lazy_cpt) != AS_COMPONENT_FIELD_ALL)
+			continue;
+		n_deferred++;
+
+		/* skipped data is loaded once it is requested */
+		g_assert_cmpstr (as_component_get_description (lazy_cpt), ==, as_component_get_description (cpt));
+		g_assert_cmpint (as_component_get_deferred_fields (lazy_cpt), ==, AS_COMPONENT_FIELD_ALL & ~AS_COMPONENT_FIELD_DESCRIPTION);
+		g_assert_cmpint (as_component_get_releases (lazy_cpt)->len, ==, as_component_get_releases (cpt)->len);
+		g_assert_cmpint (as_component_get_screenshots (lazy_cpt)->len, ==, as_component_get_screenshots (cpt)->len);
+	}
+	g_assert_cmpint (n_deferred, >, 0);
+
+	as_utils_delete_dir_recursive (tmpdir);
+}
+
+/**
+ * test_cache_lazy_descriptions:
+ *
+ * Test that descriptions read from the cache are only converted when they are used.
+ */
+static void
+test_cache_lazy_descriptions ()
+{
+	g_autoptr(AsPool) pool = NULL;
+	g_autoptr(AsPool) cpool = NULL;
+	g_autoptr(GPtrArray) cpts = NULL;
+	g_autoptr(GPtrArray) result = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autofree gchar *cache_fname = NULL;
+	guint i;
+
+	tmpdir = g_dir_make_tmp ("as-unittest-XXXXXX", &error);
+	g_assert_no_error (error);
+	cache_fname = g_build_filename (tmpdir, "lazydesc.gvz", NULL);
+
+	pool = test_get_sampledata_pool (FALSE);
+	as_pool_load (pool, NULL, &error);
+	g_assert_no_error (error);
+	as_pool_save_cache_file (pool, cache_fname, &error);
+	g_assert_no_error (error);
+
+	cpool = as_pool_new ();
+	g_assert_cmpint (as_pool_get_load_fields (cpool), ==, AS_COMPONENT_FIELD_ALL & ~AS_COMPONENT_FIELD_DESCRIPTION);
+	as_pool_load_cache_file (cpool, cache_fname, &error);
+	g_assert_no_error (error);
+
+	/* searching must not require the descriptions to be loaded */
+	result = as_pool_search (cpool, "logic");
+	g_assert_cmpint (result->len, ==, 2);
+	for (i = 0; i < result->len; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (result, i));
+		g_assert_true (as_flags_contains (as_component_get_deferred_fields (cpt), AS_COMPONENT_FIELD_DESCRIPTION));
+	}
+
+	cpts = as_pool_get_components (pool);
+	for (i = 0; i < cpts->len; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (cpts, i));
+		g_autoptr(AsComponent) ccpt = NULL;
+		GPtrArray *rels;
+		GPtrArray *crels;
+		guint j;
+
+		ccpt = _as_get_single_component_by_cid (cpool, as_component_get_id (cpt));
+		g_assert_nonnull (ccpt);
+		g_assert_cmpstr (as_component_get_description (ccpt), ==, as_component_get_description (cpt));
+		g_assert_false (as_flags_contains (as_component_get_deferred_fields (ccpt), AS_COMPONENT_FIELD_DESCRIPTION));
+
+		rels = as_component_get_releases (cpt);
+		crels = as_component_get_releases (ccpt);
+		g_assert_cmpint (crels->len, ==, rels->len);
+		for (j = 0; j < rels->len; j++) {
+			AsRelease *rel = AS_RELEASE (g_ptr_array_index (rels, j));
+			AsRelease *crel = AS_RELEASE (g_ptr_array_index (crels, j));
+			g_assert_cmpstr (as_release_get_description (crel), ==, as_release_get_description (rel));
+		}
+	}
+
+	as_utils_delete_dir_recursive (tmpdir);
+}
+
+/**
+ * test_cache_compact_media:
+ *
+ * Test icons and screenshots read from a cache, which are only
+ * turned into objects once they are requested.
+ */
+static void
+test_cache_compact_media ()
+{
+	g_autoptr(AsPool) pool = NULL;
+	g_autoptr(AsPool) cpool = NULL;
+	g_autoptr(GPtrArray) cpts = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autofree gchar *cache_fname = NULL;
+	guint n_icons = 0;
+	guint n_screenshots = 0;
+	guint i;
+
+	tmpdir = g_dir_make_tmp ("as-unittest-XXXXXX", &error);
+	g_assert_no_error (error);
+	cache_fname = g_build_filename (tmpdir, "media.gvz", NULL);
+
+	pool = test_get_sampledata_pool (FALSE);
+	as_pool_load (pool, NULL, &error);
+	g_assert_no_error (error);
+	as_pool_save_cache_file (pool, cache_fname, &error);
+	g_assert_no_error (error);
+
+	cpool = as_pool_new ();
+	as_pool_set_load_fields (cpool, AS_COMPONENT_FIELD_ALL);
+	as_pool_load_cache_file (cpool, cache_fname, &error);
+	g_assert_no_error (error);
+
+	cpts = as_pool_get_components (pool);
+	for (i = 0; i < cpts->len; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (cpts, i));
+		g_autoptr(AsComponent) ccpt = NULL;
+		GPtrArray *icons;
+		GPtrArray *cicons;
+		GPtrArray *sshots;
+		GPtrArray *csshots;
+		guint j;
+
+		ccpt = _as_get_single_component_by_cid (cpool, as_component_get_id (cpt));
+		g_assert_nonnull (ccpt);
+
+		icons = as_component_get_icons (cpt);
+		cicons = as_component_get_icons (ccpt);
+		g_assert_cmpint (cicons->len, ==, icons->len);
+		for (j = 0; j < icons->len; j++) {
+			AsIcon *icon = AS_ICON (g_ptr_array_index (icons, j));
+			AsIcon *cicon = AS_ICON (g_ptr_array_index (cicons, j));
+			g_assert_cmpint (as_icon_get_kind (cicon), ==, as_icon_get_kind (icon));
+			g_assert_cmpstr (as_icon_get_name (cicon), ==, as_icon_get_name (icon));
+			g_assert_cmpstr (as_icon_get_filename (cicon), ==, as_icon_get_filename (icon));
+			g_assert_cmpstr (as_icon_get_url (cicon), ==, as_icon_get_url (icon));
+			g_assert_cmpint (as_icon_get_width (cicon), ==, as_icon_get_width (icon));
+			g_assert_cmpint (as_icon_get_height (cicon), ==, as_icon_get_height (icon));
+			g_assert_cmpint (as_icon_get_scale (cicon), ==, as_icon_get_scale (icon));
+		}
+		n_icons += icons->len;
+
+		sshots = as_component_get_screenshots (cpt);
+		csshots = as_component_get_screenshots (ccpt);
+		g_assert_cmpint (csshots->len, ==, sshots->len);
+		for (j = 0; j < sshots->len; j++) {
+			AsScreenshot *sshot = AS_SCREENSHOT (g_ptr_array_index (sshots, j));
+			AsScreenshot *csshot = AS_SCREENSHOT (g_ptr_array_index (csshots, j));
+			GPtrArray *imgs = as_screenshot_get_images_all (sshot);
+			GPtrArray *cimgs = as_screenshot_get_images_all (csshot);
+			guint k;
+
+			g_assert_cmpint (as_screenshot_get_kind (csshot), ==, as_screenshot_get_kind (sshot));
+			g_assert_cmpstr (as_screenshot_get_caption (csshot), ==, as_screenshot_get_caption (sshot));
+			g_assert_cmpint (cimgs->len, ==, imgs->len);
+			for (k = 0; k < imgs->len; k++) {
+				AsImage *img = AS_IMAGE (g_ptr_array_index (imgs, k));
+				AsImage *cimg = AS_IMAGE (g_ptr_array_index (cimgs, k));
+				g_assert_cmpint (as_image_get_kind (cimg), ==, as_image_get_kind (img));
+				g_assert_cmpstr (as_image_get_url (cimg), ==, as_image_get_url (img));
+				g_assert_cmpint (as_image_get_width (cimg), ==, as_image_get_width (img));
+				g_assert_cmpint (as_image_get_height (cimg), ==, as_image_get_height (img));
+			}
+		}
+		n_screenshots += sshots->len;
+
+		/* the objects are created once and kept afterwards */
+		g_assert_true (as_component_get_icons (ccpt) == cicons);
+		for (j = 0; j < cicons->len; j++)
+			g_assert_true (g_ptr_array_index (as_component_get_icons (ccpt), j) == g_ptr_array_index (cicons, j));
+		for (j = 0; j < csshots->len; j++)
+			g_assert_true (g_ptr_array_index (as_component_get_screenshots (ccpt), j) == g_ptr_array_index (csshots, j));
+	}
+	g_assert_cmpint (n_icons, >, 0);
+	g_assert_cmpint (n_screenshots, >, 0);
+
+	as_utils_delete_dir_recursive (tmpdir);
+}
+
+/**
+ * test_pool_memory_usage:
+ *
+ * Test the memory accounting of a pool.
+ */
+static void
+test_pool_memory_usage ()
+{
+	g_autoptr(AsPool) pool = NULL;
+	g_autoptr(AsPool) cpool = NULL;
+	g_autoptr(GError) error = NULL;
+	guint64 usage[AS_POOL_MEMORY_KIND_LAST];
+	guint64 sum = 0;
+	guint i;
+
+	pool = test_get_sampledata_pool (FALSE);
+	as_pool_load (pool, NULL, &error);
+	g_assert_no_error (error);
+
+	/* all counters at once match the individual queries */
+	as_pool_get_memory_usage_all (pool, usage);
+	for (i = AS_POOL_MEMORY_KIND_TOTAL + 1; i < AS_POOL_MEMORY_KIND_LAST; i++) {
+		g_assert_cmpuint (usage[i], ==, as_pool_get_memory_usage (pool, (AsPoolMemoryKind) i));
+		sum += usage[i];
+	}
+	g_assert_cmpuint (usage[AS_POOL_MEMORY_KIND_TOTAL], ==, sum);
+	g_assert_cmpuint (as_pool_get_memory_usage (pool, AS_POOL_MEMORY_KIND_TOTAL), ==, sum);
+	g_assert_cmpuint (as_pool_get_memory_usage (pool, AS_POOL_MEMORY_KIND_STRINGS), >, 0);
+	g_assert_cmpuint (as_pool_get_memory_usage (pool, AS_POOL_MEMORY_KIND_LOCALIZED), >, 0);
+	g_assert_cmpuint (as_pool_get_memory_usage (pool, AS_POOL_MEMORY_KIND_RELEASES), >, 0);
+	g_assert_cmpuint (as_pool_get_memory_usage (pool, AS_POOL_MEMORY_KIND_INDEXES), >, 0);
+	g_assert_cmpuint (as_pool_get_memory_usage (pool, AS_POOL_MEMORY_KIND_CACHE_DATA), ==, 0);
+	g_assert_cmpstr (as_pool_memory_kind_to_string (AS_POOL_MEMORY_KIND_TOKENS), ==, "tokens");
+
+	/* data which was not loaded from the cache yet is accounted separately */
+	as_pool_save_cache_file (pool, "/tmp/as-unittest-memory.gvz", &error);
+	g_assert_no_error (error);
+	cpool = as_pool_new ();
+	as_pool_set_load_fields (cpool, AS_COMPONENT_FIELD_NONE);
+	as_pool_load_cache_file (cpool, "/tmp/as-unittest-memory.gvz", &error);
+	g_assert_no_error (error);
+	g_assert_cmpuint (as_pool_get_memory_usage (cpool, AS_POOL_MEMORY_KIND_CACHE_DATA), >, 0);
+	g_remove ("/tmp/as-unittest-memory.gvz");
+
+	/* the memory of a parent pool does not belong to the overlay */
+	g_clear_object (&cpool);
+	cpool = as_pool_new ();
+	as_pool_set_parent (cpool, pool);
+	g_assert_cmpuint (as_pool_get_memory_usage (cpool, AS_POOL_MEMORY_KIND_STRINGS), ==, 0);
+}
+
+/**
+ * as_test_cmp_data_id:
+ */
+static gint
+as_test_cmp_data_id (gconstpointer a, gconstpointer b)
+{
+	AsComponent *cpt1 = *((AsComponent **) a);
+	AsComponent *cpt2 = *((AsComponent **) b);
+	return g_strcmp0 (as_component_get_data_id (cpt1), as_component_get_data_id (cpt2));
+}
+
+/**
+ * as_test_pool_dump:
+ *
+ * Render the contents of a pool, so pools can be compared.
+ */
+static gchar*
+as_test_pool_dump (AsPool *pool)
+{
+	g_autoptr(GPtrArray) cpts = NULL;
+	g_autoptr(AsMetadata) metad = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *xml = NULL;
+	GString *str;
+	guint i;
+
+	cpts = as_pool_get_components (pool);
+	g_ptr_array_sort (cpts, as_test_cmp_data_id);
+
+	str = g_string_new (NULL);
+	metad = as_metadata_new ();
+	for (i = 0; i < cpts->len; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (cpts, i));
+
+		g_string_append_printf (str, "%s %i\n",
+					as_component_get_data_id (cpt),
+					(gint) as_component_get_origin_kind (cpt));
+		as_metadata_add_component (metad, cpt);
+	}
+
+	xml = as_metadata_components_to_collection (metad, AS_FORMAT_KIND_XML, &error);
+	g_assert_no_error (error);
+	g_string_append (str, xml);
+
+	return g_string_free (str, FALSE);
+}
+
+/**
+ * test_cache_local_files:
+ *
+ * Test that loading metainfo and .desktop files from the per-file cache
+ * gives the same pool as parsing them.
+ */
+static void
+test_cache_local_files ()
+{
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autofree gchar *cache_dir = NULL;
+	g_autofree gchar *mi_dir = NULL;
+	g_autofree gchar *apps_dir = NULL;
+	g_autofree gchar *fname = NULL;
+	g_autofree gchar *cold_dump = NULL;
+	g_autofree gchar *warm_dump = NULL;
+	gboolean ret;
+	guint i;
+
+	tmpdir = g_dir_make_tmp ("as-unittest-XXXXXX", &error);
+	g_assert_no_error (error);
+	cache_dir = g_build_filename (tmpdir, "cache", NULL);
+	mi_dir = g_build_filename (tmpdir, "metainfo", NULL);
+	apps_dir = g_build_filename (tmpdir, "applications", NULL);
+	g_mkdir_with_parents (cache_dir, 0755);
+	g_mkdir_with_parents (mi_dir, 0755);
+	g_mkdir_with_parents (apps_dir, 0755);
+
+	/* an application with metainfo data, which .desktop data is merged into */
+	fname = g_build_filename (mi_dir, "org.example.Foo.metainfo.xml", NULL);
+	g_file_set_contents (fname,
+			     "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+			     "<component type=\"desktop-application\">\n"
+			     "  <id>org.example.Foo</id>\n"
+			     "  <name>Foo</name>\n"
+			     "  <summary>Foo from metainfo</summary>\n"
+			     "</component>\n", -1, &error);
+	g_assert_no_error (error);
+	g_free (fname);
+	fname = g_build_filename (apps_dir, "org.example.Foo.desktop", NULL);
+	g_file_set_contents (fname,
+			     "[Desktop Entry]\n"
+			     "Type=Application\n"
+			     "Name=Foo\n"
+			     "Comment=Foo from desktop\n"
+			     "Icon=foo\n"
+			     "Exec=foo\n"
+			     "Categories=Utility;\n", -1, &error);
+	g_assert_no_error (error);
+	g_free (fname);
+
+	/* an application with only .desktop data */
+	fname = g_build_filename (apps_dir, "org.example.Bar.desktop", NULL);
+	g_file_set_contents (fname,
+			     "[Desktop Entry]\n"
+			     "Type=Application\n"
+			     "Name=Bar\n"
+			     "Comment=Bar from desktop\n"
+			     "Icon=bar\n"
+			     "Exec=bar\n", -1, &error);
+	g_assert_no_error (error);
+	g_free (fname);
+
+	/* invalid .desktop data is ignored without an error */
+	fname = g_build_filename (apps_dir, "org.example.Broken.desktop", NULL);
+	g_file_set_contents (fname,
+			     "[Desktop Entry]\n"
+			     "Type=Application\n"
+			     "Name=Broken\n", -1, &error);
+	g_assert_no_error (error);
+
+	/* load cold, then warm from the cache the first load wrote */
+	for (i = 0; i < 2; i++) {
+		g_autoptr(AsPool) pool = as_pool_new ();
+		g_autoptr(GPtrArray) cpts = NULL;
+		g_autoptr(AsComponent) foo_cpt = NULL;
+		g_autoptr(AsComponent) bar_cpt = NULL;
+
+		as_pool_override_locations (pool, cache_dir, mi_dir, apps_dir);
+		as_pool_clear_metadata_locations (pool);
+		as_pool_set_locale (pool, "C");
+		as_pool_set_cache_flags (pool, AS_CACHE_FLAG_USE_SYSTEM);
+		as_pool_set_flags (pool, AS_POOL_FLAG_READ_METAINFO | AS_POOL_FLAG_READ_DESKTOP_FILES);
+
+		ret = as_pool_load (pool, NULL, &error);
+		g_assert_no_error (error);
+		g_assert (ret);
+
+		cpts = as_pool_get_components (pool);
+		g_assert_cmpint (cpts->len, ==, 2);
+		foo_cpt = _as_get_single_component_by_cid (pool, "org.example.Foo");
+		g_assert_cmpint (as_component_get_origin_kind (foo_cpt), ==, AS_ORIGIN_KIND_METAINFO);
+		g_assert_cmpstr (as_component_get_summary (foo_cpt), ==, "Foo from metainfo");
+		g_assert_cmpint (as_component_get_categories (foo_cpt)->len, ==, 1);
+		bar_cpt = _as_get_single_component_by_cid (pool, "org.example.Bar");
+		g_assert_cmpint (as_component_get_origin_kind (bar_cpt), ==, AS_ORIGIN_KIND_DESKTOP_ENTRY);
+
+		if (i == 0) {
+			g_autofree gchar *mi_cache_fname = g_build_filename (cache_dir, "metainfo-C.gvz", NULL);
+			g_autofree gchar *de_cache_fname = g_build_filename (cache_dir, "desktop-C.gvz", NULL);
+
+			cold_dump = as_test_pool_dump (pool);
+			g_assert (g_file_test (mi_cache_fname, G_FILE_TEST_EXISTS));
+			g_assert (g_file_test (de_cache_fname, G_FILE_TEST_EXISTS));
+		} else {
+			warm_dump = as_test_pool_dump (pool);
+		}
+	}
+	g_assert_cmpstr (warm_dump, ==, cold_dump);
+
+	as_utils_delete_dir_recursive (tmpdir);
+}
+
+/**
+ * test_cache_shards:
+ *
+ * Test updating the per-origin shards of the collection metadata cache.
+ */
+static void
+test_cache_shards ()
+{
+	g_autoptr(GPtrArray) files = NULL;
+	g_autoptr(GPtrArray) cpts = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autofree gchar *cache_dir = NULL;
+	g_autofree gchar *fname1 = NULL;
+	g_autofree gchar *fname2 = NULL;
+	g_autofree gchar *stale_fname = NULL;
+	g_autofree gchar *data = NULL;
+	const gchar *locales[] = { "C", NULL };
+	const gchar *locales_de[] = { "C", "de", NULL };
+	const gchar *locales_fr[] = { "fr", NULL };
+	AsComponent *mcpt = NULL;
+	guint n_parsed;
+	guint i;
+	const gchar *coll_tmpl = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+				 "<components version=\"0.10\" origin=\"%s\">\n"
+				 "  <component type=\"desktop-application\">\n"
+				 "    <id>%s</id>\n"
+				 "    <name>%s</name>\n"
+				 "    <summary>Unit test dummy</summary>\n"
+				 "  </component>\n"
+				 "  %s\n"
+				 "</components>\n";
+
+	tmpdir = g_dir_make_tmp ("as-unittest-XXXXXX", &error);
+	g_assert_no_error (error);
+	cache_dir = g_build_filename (tmpdir, "cache", NULL);
+	g_mkdir_with_parents (cache_dir, 0755);
+	fname1 = g_build_filename (tmpdir, "foo.xml", NULL);
+	fname2 = g_build_filename (tmpdir, "bar.xml", NULL);
+
+	files = g_ptr_array_new ();
+	g_ptr_array_add (files, fname1);
+	g_ptr_array_add (files, fname2);
+
+	data = g_strdup_printf (coll_tmpl, "foo", "org.example.Foo", "Foo", "");
+	g_file_set_contents (fname1, data, -1, &error);
+	g_assert_no_error (error);
+	g_free (data);
+	data = g_strdup_printf (coll_tmpl, "bar", "org.example.Bar", "Bar",
+				"<component merge=\"append\"><id>org.example.Foo</id><categories><category>Game</category></categories></component>");
+	g_file_set_contents (fname2, data, -1, &error);
+	g_assert_no_error (error);
+
+	/* nothing is cached yet */
+	as_cache_shards_update (cache_dir, files, locales, &n_parsed, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (n_parsed, ==, 2);
+
+	/* nothing has changed */
+	as_cache_shards_update (cache_dir, files, locales, &n_parsed, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (n_parsed, ==, 0);
+
+	/* only the shard of the changed origin is rebuilt */
+	g_free (data);
+	data = g_strdup_printf (coll_tmpl, "foo", "org.example.Foo", "Foo, changed", "");
+	g_file_set_contents (fname1, data, -1, &error);
+	g_assert_no_error (error);
+	as_cache_shards_update (cache_dir, files, locales, &n_parsed, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (n_parsed, ==, 1);
+
+	/* an edit right after the last one which keeps the file size is noticed as well */
+	g_free (data);
+	data = g_strdup_printf (coll_tmpl, "foo", "org.example.Foo", "Foo, CHANGED", "");
+	g_file_set_contents (fname1, data, -1, &error);
+	g_assert_no_error (error);
+	as_cache_shards_update (cache_dir, files, locales, &n_parsed, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (n_parsed, ==, 1);
+
+	/* the components are read back as they were, merge components are kept */
+	cpts = as_cache_shards_read (cache_dir, "C", AS_COMPONENT_FIELD_ALL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (cpts->len, ==, 3);
+	for (i = 0; i < cpts->len; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (cpts, i));
+
+		if (as_component_get_merge_kind (cpt) == AS_MERGE_KIND_APPEND)
+			mcpt = cpt;
+		else if (g_strcmp0 (as_component_get_id (cpt), "org.example.Foo") == 0)
+			g_assert_cmpstr (as_component_get_name (cpt), ==, "Foo, CHANGED");
+	}
+	g_assert_nonnull (mcpt);
+	g_assert_cmpstr (as_component_get_id (mcpt), ==, "org.example.Foo");
+	g_clear_pointer (&cpts, g_ptr_array_unref);
+
+	/* there is no data for other locales yet */
+	cpts = as_cache_shards_read (cache_dir, "de", AS_COMPONENT_FIELD_ALL, &error);
+	g_assert_error (error, AS_POOL_ERROR, AS_POOL_ERROR_FAILED);
+	g_assert_null (cpts);
+	g_clear_error (&error);
+
+	/* adding a locale regenerates all shards */
+	as_cache_shards_update (cache_dir, files, locales_de, &n_parsed, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (n_parsed, ==, 2);
+	cpts = as_cache_shards_read (cache_dir, "de", AS_COMPONENT_FIELD_ALL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (cpts->len, ==, 3);
+	g_clear_pointer (&cpts, g_ptr_array_unref);
+
+	/* a disjoint set of locales is added to the existing tables, stale tables are removed */
+	stale_fname = g_build_filename (cache_dir, "shards", "origin-foo", "xx.gvz", NULL);
+	g_file_set_contents (stale_fname, "stale", -1, &error);
+	g_assert_no_error (error);
+	as_cache_shards_update (cache_dir, files, locales_fr, &n_parsed, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (n_parsed, ==, 2);
+	g_assert_false (g_file_test (stale_fname, G_FILE_TEST_EXISTS));
+	cpts = as_cache_shards_read (cache_dir, "fr", AS_COMPONENT_FIELD_ALL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (cpts->len, ==, 3);
+	g_clear_pointer (&cpts, g_ptr_array_unref);
+	cpts = as_cache_shards_read (cache_dir, "de", AS_COMPONENT_FIELD_ALL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (cpts->len, ==, 3);
+	g_clear_pointer (&cpts, g_ptr_array_unref);
+	as_cache_shards_update (cache_dir, files, locales_de, &n_parsed, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (n_parsed, ==, 0);
+
+	/* shards of removed origins are dropped */
+	g_ptr_array_remove_index (files, 1);
+	as_cache_shards_update (cache_dir, files, locales, &n_parsed, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (n_parsed, ==, 0);
+	cpts = as_cache_shards_read (cache_dir, "C", AS_COMPONENT_FIELD_ALL, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (cpts->len, ==, 1);
+
+	as_utils_delete_dir_recursive (tmpdir);
+}
+
 /**
  * test_pool_read:
  *
@@ -427,6 +1209,21 @@ test_pool_read ()
 		}
 	}
 
+	/* sorting again with duplicate checks must not change anything */
+	{
+		g_autoptr(GArray) counts = g_array_new (FALSE, FALSE, sizeof (guint));
+		for (i = 0; i < categories->len; i++) {
+			AsCategory *cat = AS_CATEGORY (g_ptr_array_index (categories, i));
+			guint count = as_category_get_components (cat)->len;
+			g_array_append_val (counts, count);
+		}
+		as_utils_sort_components_into_categories (all_cpts, categories, TRUE);
+		for (i = 0; i < categories->len; i++) {
+			AsCategory *cat = AS_CATEGORY (g_ptr_array_index (categories, i));
+			g_assert_cmpuint (as_category_get_components (cat)->len, ==, g_array_index (counts, guint, i));
+		}
+	}
+
 	/* test fetching components by launchable */
 	result = as_pool_get_components_by_launchable (dpool, AS_LAUNCHABLE_KIND_DESKTOP_ID, "linuxdcpp.desktop");
 	g_assert_cmpint (result->len, ==, 1);
@@ -491,6 +1288,336 @@ test_merge_components ()
 	g_assert_cmpstr (as_component_get_name (cpt), ==, "Kiki (name changed by merge)");
 }
 
+/**
+ * as_test_pool_wait_next_second:
+ *
+ * Wait until the clock entered a new second, as the ctime of files can
+ * not be moved into the past and only has a granularity of seconds.
+ */
+static void
+as_test_pool_wait_next_second (void)
+{
+	g_usleep (G_USEC_PER_SEC - g_get_real_time () % G_USEC_PER_SEC + G_USEC_PER_SEC / 20);
+}
+
+/**
+ * test_pool_needs_reload:
+ *
+ * Test detection of changed metadata for long-lived pools.
+ */
+static void
+test_pool_needs_reload ()
+{
+	g_autoptr(AsPool) pool = NULL;
+	g_autoptr(GPtrArray) result = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autofree gchar *xmldir = NULL;
+	g_autofree gchar *fname1 = NULL;
+	g_autofree gchar *fname2 = NULL;
+	AsPoolFlags flags;
+	const gchar *xmldata = "<components version=\"0.10\" origin=\"%s\">\n"
+				"  <component>\n"
+				"    <id>org.example.%s</id>\n"
+				"    <name>Test</name>\n"
+				"    <summary>Unit test dummy</summary>\n"
+				"  </component>\n"
+				"</components>\n";
+	g_autofree gchar *data1 = g_strdup_printf (xmldata, "test1", "Test1");
+	g_autofree gchar *data2 = g_strdup_printf (xmldata, "test2", "Test2");
+
+	tmpdir = g_dir_make_tmp ("as-unittest-XXXXXX", &error);
+	g_assert_no_error (error);
+	xmldir = g_build_filename (tmpdir, "xml", NULL);
+	g_assert_cmpint (g_mkdir (xmldir, 0755), ==, 0);
+
+	fname1 = g_build_filename (xmldir, "test1.xml", NULL);
+	g_file_set_contents (fname1, data1, -1, &error);
+	g_assert_no_error (error);
+
+	pool = as_pool_new ();
+	as_pool_clear_metadata_locations (pool);
+	as_pool_add_metadata_location (pool, tmpdir);
+	as_pool_set_locale (pool, "C");
+	as_pool_set_cache_flags (pool, AS_CACHE_FLAG_NONE);
+	flags = as_pool_get_flags (pool);
+	as_flags_remove (flags, AS_POOL_FLAG_READ_DESKTOP_FILES);
+	as_pool_set_flags (pool, flags);
+
+	/* a pool that was never loaded has nothing to reload */
+	g_assert (!as_pool_needs_reload (pool));
+
+	/* changes made in the second the pool was loaded in are always considered new */
+	as_test_pool_wait_next_second ();
+
+	as_pool_load (pool, NULL, &error);
+	g_assert_no_error (error);
+	result = as_pool_get_components (pool);
+	g_assert_cmpint (result->len, ==, 1);
+	g_clear_pointer (&result, g_ptr_array_unref);
+	g_assert (!as_pool_needs_reload (pool));
+
+	fname2 = g_build_filename (xmldir, "test2.xml", NULL);
+	g_file_set_contents (fname2, data2, -1, &error);
+	g_assert_no_error (error);
+	g_assert (as_pool_needs_reload (pool));
+
+	as_test_pool_wait_next_second ();
+	as_pool_load (pool, NULL, &error);
+	g_assert_no_error (error);
+	result = as_pool_get_components (pool);
+	g_assert_cmpint (result->len, ==, 2);
+	g_assert (!as_pool_needs_reload (pool));
+
+	g_remove (fname1);
+	g_remove (fname2);
+	g_remove (xmldir);
+	g_remove (tmpdir);
+}
+
+/**
+ * test_pool_addon_graph:
+ *
+ * Test the addon graph of the pool.
+ */
+static void
+test_pool_addon_graph ()
+{
+	g_autoptr(AsPool) pool = NULL;
+	g_autoptr(GPtrArray) cpts = NULL;
+	g_autoptr(GPtrArray) result = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(AsComponent) app = NULL;
+	g_autoptr(AsComponent) addon1 = NULL;
+	g_autoptr(AsComponent) addon2 = NULL;
+	g_autoptr(AsComponent) user_addon = NULL;
+	g_autoptr(AsComponent) other = NULL;
+	guint i;
+	const gchar *cids[] = { "org.example.App", "org.example.App.Plugin1", "org.example.App.Plugin2", NULL };
+
+	cpts = g_ptr_array_new_with_free_func (g_object_unref);
+	for (i = 0; cids[i] != NULL; i++) {
+		AsComponent *cpt = as_component_new ();
+		as_component_set_id (cpt, cids[i]);
+		as_component_set_kind (cpt, i == 0? AS_COMPONENT_KIND_DESKTOP_APP : AS_COMPONENT_KIND_ADDON);
+		as_component_set_name (cpt, cids[i], "C");
+		as_component_set_summary (cpt, "Unit test dummy", "C");
+		g_ptr_array_add (cpts, cpt);
+	}
+
+	/* the first addon extends a component we don't have, which must not hide the second one */
+	as_component_add_extends (AS_COMPONENT (g_ptr_array_index (cpts, 1)), "org.example.Missing");
+	as_component_add_extends (AS_COMPONENT (g_ptr_array_index (cpts, 1)), "org.example.App");
+	as_component_add_extends (AS_COMPONENT (g_ptr_array_index (cpts, 2)), "org.example.App");
+
+	as_cache_file_save ("/tmp/as-unittest-addons.gvz", "C", cpts, &error);
+	g_assert_no_error (error);
+
+	pool = as_pool_new ();
+	as_pool_load_cache_file (pool, "/tmp/as-unittest-addons.gvz", &error);
+	g_assert_no_error (error);
+
+	app = _as_get_single_component_by_cid (pool, "org.example.App");
+	addon1 = _as_get_single_component_by_cid (pool, "org.example.App.Plugin1");
+	addon2 = _as_get_single_component_by_cid (pool, "org.example.App.Plugin2");
+	g_assert_nonnull (app);
+	g_assert_nonnull (addon1);
+	g_assert_nonnull (addon2);
+
+	/* the extended component knows about all of its addons */
+	result = as_pool_get_addons (pool, app);
+	g_assert_cmpint (result->len, ==, 2);
+	g_assert_cmpint (as_component_get_addons (app)->len, ==, 2);
+	g_clear_pointer (&result, g_ptr_array_unref);
+
+	/* reverse lookup */
+	result = as_pool_get_extended (pool, addon1);
+	g_assert_cmpint (result->len, ==, 1);
+	g_assert (g_ptr_array_index (result, 0) == app);
+	g_clear_pointer (&result, g_ptr_array_unref);
+
+	result = as_pool_get_addons (pool, addon1);
+	g_assert_cmpint (result->len, ==, 0);
+	g_clear_pointer (&result, g_ptr_array_unref);
+
+	/* rebuilding the graph replaces the addons the pool added, but keeps the ones added by the user */
+	user_addon = as_component_new ();
+	as_component_set_id (user_addon, "org.example.App.UserPlugin");
+	as_component_add_addon (app, user_addon);
+	g_ptr_array_set_size (cpts, 0);
+	other = as_component_new ();
+	as_component_set_id (other, "org.example.Other");
+	as_component_set_kind (other, AS_COMPONENT_KIND_DESKTOP_APP);
+	as_component_set_name (other, "Other", "C");
+	as_component_set_summary (other, "Unit test dummy", "C");
+	g_ptr_array_add (cpts, g_object_ref (other));
+	as_cache_file_save ("/tmp/as-unittest-addons2.gvz", "C", cpts, &error);
+	g_assert_no_error (error);
+	as_pool_load_cache_file (pool, "/tmp/as-unittest-addons2.gvz", &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (as_component_get_addons (app)->len, ==, 3);
+	g_assert (g_ptr_array_index (as_component_get_addons (app), 0) == user_addon);
+	result = as_pool_get_addons (pool, app);
+	g_assert_cmpint (result->len, ==, 2);
+	g_clear_pointer (&result, g_ptr_array_unref);
+	g_remove ("/tmp/as-unittest-addons2.gvz");
+
+	/* clearing the pool drops the graph */
+	as_pool_clear (pool);
+	result = as_pool_get_addons (pool, app);
+	g_assert_cmpint (result->len, ==, 0);
+
+	g_remove ("/tmp/as-unittest-addons.gvz");
+}
+
+/**
+ * test_pool_overlay:
+ *
+ * Test layering a pool on top of a read-only parent pool.
+ */
+static void
+test_pool_overlay ()
+{
+	g_autoptr(AsPool) parent = NULL;
+	g_autoptr(AsPool) overlay = NULL;
+	g_autoptr(GPtrArray) result = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(AsComponent) cpt = NULL;
+	AsComponent *tmp;
+	guint i;
+	const gchar *cids[] = { "org.example.Foo", "org.example.Bar", NULL };
+
+	parent = as_pool_new ();
+	for (i = 0; cids[i] != NULL; i++) {
+		g_autoptr(AsComponent) pcpt = as_component_new ();
+		g_autofree gchar *name_de = g_strdup_printf ("%s (de)", cids[i]);
+		as_component_set_id (pcpt, cids[i]);
+		as_component_set_kind (pcpt, AS_COMPONENT_KIND_DESKTOP_APP);
+		as_component_set_scope (pcpt, AS_COMPONENT_SCOPE_SYSTEM);
+		as_component_set_origin_kind (pcpt, AS_ORIGIN_KIND_COLLECTION);
+		as_component_set_name (pcpt, cids[i], "C");
+		as_component_set_name (pcpt, name_de, "de");
+		as_component_set_summary (pcpt, "Unit test dummy", "C");
+		as_pool_add_component (parent, pcpt, &error);
+		g_assert_no_error (error);
+	}
+
+	overlay = as_pool_new ();
+	as_pool_set_parent (overlay, parent);
+	g_assert (as_pool_get_parent (overlay) == parent);
+
+	/* the overlay sees the parent's data */
+	result = as_pool_get_components (overlay);
+	g_assert_cmpint (result->len, ==, 2);
+	g_clear_pointer (&result, g_ptr_array_unref);
+
+	/* the usual priority rules apply across layers */
+	cpt = as_component_new ();
+	as_component_set_id (cpt, "org.example.Bar");
+	as_component_set_kind (cpt, AS_COMPONENT_KIND_DESKTOP_APP);
+	as_component_set_scope (cpt, AS_COMPONENT_SCOPE_SYSTEM);
+	as_component_set_name (cpt, "Bar (duplicate)", "C");
+	as_component_set_summary (cpt, "Unit test dummy", "C");
+	g_assert (!as_pool_add_component (overlay, cpt, &error));
+	g_assert_error (error, AS_POOL_ERROR, AS_POOL_ERROR_COLLISION);
+	g_clear_error (&error);
+
+	as_component_set_id (cpt, "org.example.Foo");
+	as_component_set_name (cpt, "Foo (user)", "C");
+	as_component_set_priority (cpt, 10);
+	as_pool_add_component (overlay, cpt, &error);
+	g_assert_no_error (error);
+	g_clear_object (&cpt);
+
+	/* merges are applied to a copy of the parent's component */
+	cpt = as_component_new ();
+	as_component_set_id (cpt, "org.example.Bar");
+	as_component_set_kind (cpt, AS_COMPONENT_KIND_DESKTOP_APP);
+	as_component_set_merge_kind (cpt, AS_MERGE_KIND_APPEND);
+	as_component_add_category (cpt, "Game");
+	as_pool_add_component (overlay, cpt, &error);
+	g_assert_no_error (error);
+	g_clear_object (&cpt);
+
+	/* new data is only added to the overlay */
+	cpt = as_component_new ();
+	as_component_set_id (cpt, "org.example.Baz");
+	as_component_set_kind (cpt, AS_COMPONENT_KIND_DESKTOP_APP);
+	as_component_set_name (cpt, "Baz", "C");
+	as_component_set_summary (cpt, "Unit test dummy", "C");
+	as_pool_add_component (overlay, cpt, &error);
+	g_assert_no_error (error);
+	g_clear_object (&cpt);
+
+	result = as_pool_get_components (overlay);
+	g_assert_cmpint (result->len, ==, 3);
+	g_clear_pointer (&result, g_ptr_array_unref);
+
+	tmp = _as_get_single_component_by_cid (overlay, "org.example.Foo");
+	g_assert_cmpstr (as_component_get_name (tmp), ==, "Foo (user)");
+	g_object_unref (tmp);
+	tmp = _as_get_single_component_by_cid (overlay, "org.example.Bar");
+	g_assert (as_component_has_category (tmp, "Game"));
+	/* the copy keeps everything which makes up its identity, and all translations */
+	g_assert_cmpint (as_component_get_scope (tmp), ==, AS_COMPONENT_SCOPE_SYSTEM);
+	g_assert_cmpint (as_component_get_origin_kind (tmp), ==, AS_ORIGIN_KIND_COLLECTION);
+	g_assert (g_str_has_prefix (as_component_get_data_id (tmp), "system/"));
+	as_component_set_active_locale (tmp, "de");
+	g_assert_cmpstr (as_component_get_name (tmp), ==, "org.example.Bar (de)");
+	g_object_unref (tmp);
+
+	/* the parent pool is unchanged */
+	result = as_pool_get_components (parent);
+	g_assert_cmpint (result->len, ==, 2);
+	g_clear_pointer (&result, g_ptr_array_unref);
+
+	tmp = _as_get_single_component_by_cid (parent, "org.example.Foo");
+	g_assert_cmpstr (as_component_get_name (tmp), ==, "org.example.Foo");
+	g_object_unref (tmp);
+	tmp = _as_get_single_component_by_cid (parent, "org.example.Bar");
+	g_assert (!as_component_has_category (tmp, "Game"));
+	g_object_unref (tmp);
+
+	/* searches span both layers */
+	result = as_pool_get_components_by_categories (overlay, (gchar*[]) { "Game", NULL });
+	g_assert_cmpint (result->len, ==, 1);
+	g_clear_pointer (&result, g_ptr_array_unref);
+	result = as_pool_search (overlay, "foo");
+	g_assert_cmpint (result->len, ==, 1);
+}
+
+/**
+ * test_pool_load_cancelled:
+ *
+ * Test that a cancelled load keeps the previous data of the pool.
+ */
+static void
+test_pool_load_cancelled ()
+{
+	g_autoptr(AsPool) pool = NULL;
+	g_autoptr(GCancellable) cancellable = NULL;
+	g_autoptr(GPtrArray) result = NULL;
+	g_autoptr(GError) error = NULL;
+
+	pool = test_get_sampledata_pool (FALSE);
+	as_pool_load (pool, NULL, &error);
+	g_assert_no_error (error);
+	result = as_pool_get_components (pool);
+	g_assert_cmpint (result->len, ==, 19);
+	g_clear_pointer (&result, g_ptr_array_unref);
+
+	cancellable = g_cancellable_new ();
+	g_cancellable_cancel (cancellable);
+	g_assert (!as_pool_load (pool, cancellable, &error));
+	g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+
+	result = as_pool_get_components (pool);
+	g_assert_cmpint (result->len, ==, 19);
+	g_clear_pointer (&result, g_ptr_array_unref);
+	result = as_pool_search (pool, "kig");
+	g_assert_cmpint (result->len, ==, 1);
+}
+
 /**
  * main:
  */
@@ -518,7 +1645,19 @@ main (int argc, char **argv)
 	g_test_add_func ("/AppStream/PoolRead", test_pool_read);
 	g_test_add_func ("/AppStream/Cache/Basic", test_cache_simple);
 	g_test_add_func ("/AppStream/Cache/Complex", test_cache_complex);
+	g_test_add_func ("/AppStream/Cache/Locales", test_cache_locales);
+	g_test_add_func ("/AppStream/Cache/LocalesStemming", test_cache_locales_stemming);
+	g_test_add_func ("/AppStream/Cache/LoadFields", test_cache_load_fields);
+	g_test_add_func ("/AppStream/Cache/LazyDescriptions", test_cache_lazy_descriptions);
+	g_test_add_func ("/AppStream/Cache/CompactMedia", test_cache_compact_media);
+	g_test_add_func ("/AppStream/PoolMemoryUsage", test_pool_memory_usage);
+	g_test_add_func ("/AppStream/Cache/LocalFiles", test_cache_local_files);
+	g_test_add_func ("/AppStream/Cache/Shards", test_cache_shards);
 	g_test_add_func ("/AppStream/Merges", test_merge_components);
+	g_test_add_func ("/AppStream/PoolNeedsReload", test_pool_needs_reload);
+	g_test_add_func ("/AppStream/PoolAddonGraph", test_pool_addon_graph);
+	g_test_add_func ("/AppStream/PoolOverlay", test_pool_overlay);
+	g_test_add_func ("/AppStream/PoolLoadCancelled", test_pool_load_cancelled);
 
 	ret = g_test_run ();
 	g_free (datadir);
@@ -0,0 +1,178 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2018 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include "appstream.h"
+#include "as-test-utils.h"
+#include "../tools/ascli-actions-mdata.h"
+#include "../tools/ascli-actions-server.h"
+
+static gchar *datadir = NULL;
+
+typedef struct {
+	GMainLoop		*loop;
+	const gchar		*socket_path;
+	GSocketConnection	*conn;
+	GString			*reply;
+	GError			*error;
+	GError			*query_error;
+} ServerTestClient;
+
+/**
+ * test_server_quit_cb:
+ */
+static gboolean
+test_server_quit_cb (gpointer user_data)
+{
+	g_main_loop_quit ((GMainLoop*) user_data);
+	return G_SOURCE_REMOVE;
+}
+
+/**
+ * test_server_client_thread:
+ *
+ * Send queries to the server, while the main thread dispatches
+ * its connections.
+ */
+static gpointer
+test_server_client_thread (gpointer user_data)
+{
+	ServerTestClient *client = (ServerTestClient*) user_data;
+
+	client->conn = ascli_server_connect (client->socket_path, &client->error);
+	if (client->conn != NULL) {
+		if (ascli_server_query (client->conn, "get org.inkscape.Inkscape", client->reply, &client->error))
+			ascli_server_query (client->conn, "frobnicate foo", client->reply, &client->query_error);
+	}
+
+	g_main_context_invoke (NULL, test_server_quit_cb, client->loop);
+	return NULL;
+}
+
+/**
+ * test_server_roundtrip:
+ *
+ * Answer queries via a Unix socket, and shut down while
+ * a client is still connected.
+ */
+static void
+test_server_roundtrip ()
+{
+	g_autoptr(AsPool) pool = NULL;
+	g_autoptr(GMainLoop) loop = NULL;
+	g_autoptr(GString) expected = g_string_new (NULL);
+	g_autoptr(GString) reply = g_string_new (NULL);
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *mdata_dir = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autofree gchar *socket_path = NULL;
+	g_autofree gchar *query = g_strdup ("get org.inkscape.Inkscape");
+	AscliServer *server;
+	ServerTestClient client = { 0 };
+	GThread *thread;
+	AsPoolFlags flags;
+	gboolean ret;
+
+	mdata_dir = g_build_filename (datadir, "collection", NULL);
+	pool = as_pool_new ();
+	as_pool_clear_metadata_locations (pool);
+	as_pool_add_metadata_location (pool, mdata_dir);
+	as_pool_set_locale (pool, "C");
+	as_pool_set_cache_flags (pool, AS_CACHE_FLAG_NONE);
+	flags = as_pool_get_flags (pool);
+	as_flags_remove (flags, AS_POOL_FLAG_READ_DESKTOP_FILES);
+	as_flags_remove (flags, AS_POOL_FLAG_READ_METAINFO);
+	as_pool_set_flags (pool, flags);
+	as_pool_load (pool, NULL, &error);
+	g_assert_no_error (error);
+
+	/* the server must reply exactly what a local batch query produces */
+	ret = ascli_batch_answer_query (pool, query, expected, &error);
+	g_assert_no_error (error);
+	g_assert (ret);
+	g_assert (g_str_has_prefix (expected->str, "get org.inkscape.Inkscape\torg.inkscape.Inkscape\t"));
+
+	tmpdir = g_dir_make_tmp ("as-unittest-XXXXXX", &error);
+	g_assert_no_error (error);
+	socket_path = g_build_filename (tmpdir, "query.socket", NULL);
+
+	server = ascli_server_new (pool, FALSE);
+	ascli_server_start (server, socket_path, &error);
+	g_assert_no_error (error);
+
+	loop = g_main_loop_new (NULL, FALSE);
+	client.loop = loop;
+	client.socket_path = socket_path;
+	client.reply = reply;
+	thread = g_thread_new ("query-client", test_server_client_thread, &client);
+	g_main_loop_run (loop);
+	g_thread_join (thread);
+
+	g_assert_no_error (client.error);
+	g_assert_nonnull (client.conn);
+	g_assert_cmpstr (reply->str, ==, expected->str);
+	g_assert_error (client.query_error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT);
+	g_clear_error (&client.query_error);
+
+	/* the client is still connected, this must not leave its thread behind */
+	ascli_server_shutdown (server);
+	g_assert (!g_file_test (socket_path, G_FILE_TEST_EXISTS));
+
+	g_string_truncate (reply, 0);
+	ret = ascli_server_query (client.conn, "get org.inkscape.Inkscape", reply, &error);
+	g_assert (!ret);
+	g_assert_nonnull (error);
+	g_assert_cmpstr (reply->str, ==, "");
+
+	g_object_unref (client.conn);
+	g_remove (tmpdir);
+}
+
+int
+main (int argc, char **argv)
+{
+	int ret;
+
+	if (argc == 0) {
+		g_error ("No test directory specified!");
+		return 1;
+	}
+
+	datadir = argv[1];
+	g_assert (datadir != NULL);
+	datadir = g_build_filename (datadir, "samples", NULL);
+	g_assert (g_file_test (datadir, G_FILE_TEST_EXISTS) != FALSE);
+
+	g_setenv ("G_MESSAGES_DEBUG", "all", TRUE);
+	g_test_init (&argc, &argv, NULL);
+
+	/* only critical and error are fatal */
+	g_log_set_fatal_mask (NULL, G_LOG_LEVEL_ERROR | G_LOG_LEVEL_CRITICAL);
+
+	g_test_add_func ("/AppStream/CLI/ServerRoundtrip", test_server_roundtrip);
+
+	ret = g_test_run ();
+	g_free (datadir);
+
+	return ret;
+}
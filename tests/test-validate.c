@@ -19,13 +19,327 @@
  */
 
 #include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+#include <string.h>
 #include "appstream.h"
 #include "as-component-private.h"
+#include "as-utils-private.h"
+#include "as-validator-private.h"
 
 #include "as-test-utils.h"
 
 static gchar *datadir = NULL;
 
+/**
+ * _as_sort_strings_cb:
+ */
+static gint
+_as_sort_strings_cb (gconstpointer a, gconstpointer b)
+{
+	return g_strcmp0 (*((const gchar **) a), *((const gchar **) b));
+}
+
+/**
+ * _as_validator_issues_to_string:
+ *
+ * Create a textual representation of all issues found by a validator,
+ * sorted if @sort is set or in the order the validator reports them otherwise.
+ */
+static gchar*
+_as_validator_issues_to_string (AsValidator *validator, gboolean sort)
+{
+	GList *issues;
+	GList *l;
+	g_autoptr(GPtrArray) lines = NULL;
+	GString *str;
+	guint i;
+
+	lines = g_ptr_array_new_with_free_func (g_free);
+	issues = as_validator_get_issues (validator);
+	for (l = issues; l != NULL; l = l->next) {
+		AsValidatorIssue *issue = AS_VALIDATOR_ISSUE (l->data);
+		g_autofree gchar *location = as_validator_issue_get_location (issue);
+
+		g_ptr_array_add (lines, g_strdup_printf ("%s: %s",
+							 location,
+							 as_validator_issue_get_message (issue)));
+	}
+	g_list_free (issues);
+	if (sort)
+		g_ptr_array_sort (lines, _as_sort_strings_cb);
+
+	str = g_string_new ("");
+	for (i = 0; i < lines->len; i++)
+		g_string_append_printf (str, "%s\n", (const gchar*) g_ptr_array_index (lines, i));
+	return g_string_free (str, FALSE);
+}
+
+/**
+ * test_validate_tree_parallel:
+ *
+ * Test that validating a tree in parallel yields the same
+ * report as a sequential validation.
+ */
+static void
+test_validate_tree_parallel (void)
+{
+	g_autofree gchar *tmpdir = NULL;
+	g_autofree gchar *mi_dir = NULL;
+	g_autofree gchar *src_fname = NULL;
+	g_autofree gchar *src_data = NULL;
+	g_autofree gchar *report_serial = NULL;
+	g_autofree gchar *report_parallel = NULL;
+	g_autoptr(AsValidator) validator = NULL;
+	g_autoptr(AsValidator) validator_parallel = NULL;
+	GError *error = NULL;
+	guint i;
+
+	tmpdir = g_dir_make_tmp ("as-validate-XXXXXX", &error);
+	g_assert_no_error (error);
+	mi_dir = g_build_filename (tmpdir, "usr", "share", "metainfo", NULL);
+	g_assert_cmpint (g_mkdir_with_parents (mi_dir, 0755), ==, 0);
+
+	src_fname = g_build_filename (datadir, "appdata.xml", NULL);
+	g_file_get_contents (src_fname, &src_data, NULL, &error);
+	g_assert_no_error (error);
+
+	/* create a couple of files, including some with broken names */
+	for (i = 0; i < 16; i++) {
+		g_autofree gchar *bname = NULL;
+		g_autofree gchar *fname = NULL;
+
+		if (i % 2 == 0)
+			bname = g_strdup_printf ("org.example.App%u.metainfo.xml", i);
+		else
+			bname = g_strdup_printf ("firefox%u.appdata.xml", i);
+		fname = g_build_filename (mi_dir, bname, NULL);
+		g_file_set_contents (fname, src_data, -1, &error);
+		g_assert_no_error (error);
+	}
+
+	validator = as_validator_new ();
+	as_validator_set_check_urls (validator, FALSE);
+
+	as_validator_set_max_jobs (validator, 1);
+	as_validator_validate_tree (validator, tmpdir);
+	report_serial = _as_validator_issues_to_string (validator, FALSE);
+	g_assert_cmpstr (report_serial, !=, "");
+
+	/* the issues must be reported in the same order, not just be the same */
+	validator_parallel = as_validator_new ();
+	as_validator_set_check_urls (validator_parallel, FALSE);
+	as_validator_set_max_jobs (validator_parallel, 4);
+	as_validator_validate_tree (validator_parallel, tmpdir);
+	report_parallel = _as_validator_issues_to_string (validator_parallel, FALSE);
+
+	g_assert_cmpstr (report_serial, ==, report_parallel);
+
+	as_utils_delete_dir_recursive (tmpdir);
+}
+
+/**
+ * AsTestHttpServer:
+ *
+ * A tiny HTTP server serving only "/ok*" paths, to test URL checks.
+ */
+typedef struct {
+	GSocket		*socket;
+	GCancellable	*cancellable;
+	GThread		*thread;
+	guint		port;
+	gint		requests;
+} AsTestHttpServer;
+
+/**
+ * as_test_http_server_thread:
+ */
+static gpointer
+as_test_http_server_thread (AsTestHttpServer *server)
+{
+	while (TRUE) {
+		g_autoptr(GSocket) conn = NULL;
+		gchar buffer[4096];
+		gssize len;
+		const gchar *response;
+
+		conn = g_socket_accept (server->socket, server->cancellable, NULL);
+		if (conn == NULL)
+			break;
+
+		len = g_socket_receive (conn, buffer, sizeof (buffer) - 1, NULL, NULL);
+		if (len <= 0)
+			continue;
+		buffer[len] = '\0';
+		g_atomic_int_inc (&server->requests);
+
+		if (g_str_has_prefix (buffer, "GET /ok"))
+			response = "HTTP/1.0 200 OK\r\nContent-Length: 2\r\nConnection: close\r\n\r\nok";
+		else
+			response = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+		g_socket_send (conn, response, strlen (response), NULL, NULL);
+		g_socket_close (conn, NULL);
+	}
+
+	return NULL;
+}
+
+/**
+ * as_test_http_server_new:
+ */
+static AsTestHttpServer*
+as_test_http_server_new (void)
+{
+	AsTestHttpServer *server;
+	g_autoptr(GSocketAddress) addr = NULL;
+	g_autoptr(GSocketAddress) local_addr = NULL;
+	GError *error = NULL;
+
+	server = g_new0 (AsTestHttpServer, 1);
+	server->socket = g_socket_new (G_SOCKET_FAMILY_IPV4,
+				       G_SOCKET_TYPE_STREAM,
+				       G_SOCKET_PROTOCOL_TCP,
+				       &error);
+	g_assert_no_error (error);
+
+	addr = g_inet_socket_address_new_from_string ("127.0.0.1", 0);
+	g_socket_bind (server->socket, addr, TRUE, &error);
+	g_assert_no_error (error);
+	g_socket_listen (server->socket, &error);
+	g_assert_no_error (error);
+
+	local_addr = g_socket_get_local_address (server->socket, &error);
+	g_assert_no_error (error);
+	server->port = g_inet_socket_address_get_port (G_INET_SOCKET_ADDRESS (local_addr));
+
+	server->cancellable = g_cancellable_new ();
+	server->thread = g_thread_new ("http-server",
+				       (GThreadFunc) as_test_http_server_thread,
+				       server);
+	return server;
+}
+
+/**
+ * as_test_http_server_free:
+ */
+static void
+as_test_http_server_free (AsTestHttpServer *server)
+{
+	g_cancellable_cancel (server->cancellable);
+	g_thread_join (server->thread);
+	g_object_unref (server->cancellable);
+	g_socket_close (server->socket, NULL);
+	g_object_unref (server->socket);
+	g_free (server);
+}
+
+/**
+ * test_validate_urls:
+ *
+ * Test checking remote URLs against a local HTTP server.
+ */
+static void
+test_validate_urls (void)
+{
+	AsTestHttpServer *server;
+	g_autoptr(AsValidator) validator = NULL;
+	g_autoptr(AsValidator) validator_shared = NULL;
+	g_autofree gchar *data = NULL;
+	g_autofree gchar *report = NULL;
+	g_autofree gchar *tmpdir = NULL;
+	g_autofree gchar *cache_fname = NULL;
+	g_autofree gchar *cache_data = NULL;
+	g_autofree gchar *ok_url = NULL;
+	g_autofree gchar *missing_url = NULL;
+	GError *error = NULL;
+
+	if (!g_file_test ("/usr/bin/curl", G_FILE_TEST_EXISTS)) {
+		g_test_skip ("curl is not available");
+		return;
+	}
+
+	server = as_test_http_server_new ();
+	ok_url = g_strdup_printf ("http://127.0.0.1:%u/ok", server->port);
+	missing_url = g_strdup_printf ("http://127.0.0.1:%u/missing", server->port);
+
+	data = g_strdup_printf ("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+				"<component>\n"
+				"  <id>org.example.Test</id>\n"
+				"  <name>Test</name>\n"
+				"  <summary>A test component</summary>\n"
+				"  <metadata_license>CC0-1.0</metadata_license>\n"
+				"  <url type=\"homepage\">%s</url>\n"
+				"  <url type=\"bugtracker\">%s</url>\n"
+				"  <url type=\"help\">%s</url>\n"
+				"  <url type=\"faq\">%s</url>\n"
+				"</component>\n",
+				ok_url, ok_url, missing_url, missing_url);
+
+	tmpdir = g_dir_make_tmp ("as-validate-XXXXXX", &error);
+	g_assert_no_error (error);
+	cache_fname = g_build_filename (tmpdir, "urls.cache", NULL);
+
+	validator = as_validator_new ();
+	as_validator_set_check_urls (validator, TRUE);
+	as_validator_set_max_jobs (validator, 4);
+	as_validator_set_url_cache (validator, cache_fname, 3600);
+	as_validator_validate_data (validator, data);
+	report = _as_validator_issues_to_string (validator, TRUE);
+
+	/* each distinct URL is only requested once */
+	g_assert_cmpint (g_atomic_int_get (&server->requests), ==, 2);
+	g_assert (g_strstr_len (report, -1, missing_url) != NULL);
+	g_assert (g_strstr_len (report, -1, ok_url) == NULL);
+	g_clear_pointer (&report, g_free);
+
+	/* only the reachable URL was persisted */
+	g_file_get_contents (cache_fname, &cache_data, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (g_strstr_len (cache_data, -1, ok_url) != NULL);
+	g_assert (g_strstr_len (cache_data, -1, missing_url) == NULL);
+
+	/* a second run reuses the result for the reachable URL, but checks the failed one again */
+	as_validator_clear_issues (validator);
+	as_validator_validate_data (validator, data);
+	report = _as_validator_issues_to_string (validator, TRUE);
+	g_assert_cmpint (g_atomic_int_get (&server->requests), ==, 3);
+	g_assert (g_strstr_len (report, -1, missing_url) != NULL);
+	g_assert (g_strstr_len (report, -1, ok_url) == NULL);
+	g_clear_pointer (&report, g_free);
+	g_clear_object (&validator);
+
+	/* results are not shared with other validators, unless they use the same cache file */
+	validator = as_validator_new ();
+	as_validator_set_check_urls (validator, TRUE);
+	as_validator_validate_data (validator, data);
+	g_assert_cmpint (g_atomic_int_get (&server->requests), ==, 5);
+	g_clear_object (&validator);
+
+	validator = as_validator_new ();
+	as_validator_set_check_urls (validator, TRUE);
+	as_validator_set_url_cache (validator, cache_fname, 3600);
+	as_validator_validate_data (validator, data);
+	g_assert_cmpint (g_atomic_int_get (&server->requests), ==, 6);
+	g_clear_object (&validator);
+
+	/* validators sharing their results check each URL only once, including failed ones */
+	validator = as_validator_new ();
+	as_validator_set_check_urls (validator, TRUE);
+	validator_shared = as_validator_new ();
+	as_validator_set_check_urls (validator_shared, TRUE);
+	as_validator_share_url_checks (validator_shared, validator);
+	as_validator_validate_data (validator, data);
+	as_validator_validate_data (validator_shared, data);
+	g_assert_cmpint (g_atomic_int_get (&server->requests), ==, 8);
+	report = _as_validator_issues_to_string (validator_shared, TRUE);
+	g_assert (g_strstr_len (report, -1, missing_url) != NULL);
+	g_assert (g_strstr_len (report, -1, ok_url) == NULL);
+
+	g_remove (cache_fname);
+	g_rmdir (tmpdir);
+	as_test_http_server_free (server);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -46,6 +360,9 @@ main (int argc, char **argv)
 	/* only critical and error are fatal */
 	g_log_set_fatal_mask (NULL, G_LOG_LEVEL_ERROR | G_LOG_LEVEL_CRITICAL);
 
+	g_test_add_func ("/AppStream/Validate/TreeParallel", test_validate_tree_parallel);
+	g_test_add_func ("/AppStream/Validate/URLs", test_validate_urls);
+
 	ret = g_test_run ();
 	g_free (datadir);
 	return ret;
@@ -20,6 +20,7 @@
 
 #include <glib.h>
 #include <glib/gprintf.h>
+#include <glib/gstdio.h>
 
 #include "appstream.h"
 #include "as-xml.h"
@@ -1374,6 +1375,165 @@ test_xml_write_agreements (void)
 	g_assert (as_test_compare_lines (res, xmldata_agreements));
 }
 
+/**
+ * test_xml_stream_collection_to_str:
+ *
+ * Helper to stream the collection data of @metad into a string.
+ */
+static gchar*
+test_xml_stream_collection_to_str (AsMetadata *metad)
+{
+	g_autoptr(GOutputStream) stream = NULL;
+	g_autoptr(GError) error = NULL;
+
+	stream = g_memory_output_stream_new_resizable ();
+	as_metadata_components_to_collection_stream (metad, stream, AS_FORMAT_KIND_XML, FALSE, &error);
+	g_assert_no_error (error);
+
+	/* terminate the string */
+	g_output_stream_write_all (stream, "", 1, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_output_stream_close (stream, NULL, &error);
+	g_assert_no_error (error);
+
+	return g_memory_output_stream_steal_data (G_MEMORY_OUTPUT_STREAM (stream));
+}
+
+/**
+ * test_xml_write_collection_stream:
+ *
+ * Test if streaming collection data generates the same output as
+ * serializing it in memory.
+ */
+static void
+test_xml_write_collection_stream (void)
+{
+	g_autoptr(AsMetadata) metad = NULL;
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *path = NULL;
+	g_autofree gchar *expected = NULL;
+	g_autofree gchar *streamed = NULL;
+	g_autofree gchar *expected_nohdr = NULL;
+	g_autofree gchar *streamed_nohdr = NULL;
+
+	metad = as_metadata_new ();
+	as_metadata_set_locale (metad, "ALL");
+	as_metadata_set_format_style (metad, AS_FORMAT_STYLE_COLLECTION);
+
+	path = g_build_filename (datadir, "appstream-dxml.xml", NULL);
+	file = g_file_new_for_path (path);
+	as_metadata_parse_file (metad, file, AS_FORMAT_KIND_XML, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (as_metadata_get_components (metad)->len, >, 1);
+
+	/* with root node, including attributes which need escaping */
+	as_metadata_set_origin (metad, "tëst & \"origin\"");
+	as_metadata_set_architecture (metad, "amd64");
+	expected = as_metadata_components_to_collection (metad, AS_FORMAT_KIND_XML, &error);
+	g_assert_no_error (error);
+	streamed = test_xml_stream_collection_to_str (metad);
+	g_assert_cmpstr (streamed, ==, expected);
+
+	/* without root node */
+	as_metadata_set_write_header (metad, FALSE);
+	expected_nohdr = as_metadata_components_to_collection (metad, AS_FORMAT_KIND_XML, &error);
+	g_assert_no_error (error);
+	streamed_nohdr = test_xml_stream_collection_to_str (metad);
+	g_assert_cmpstr (streamed_nohdr, ==, expected_nohdr);
+}
+
+/**
+ * test_xml_write_collection_stream_large:
+ *
+ * Test if streaming a collection that is large enough to be serialized
+ * in multiple parallel batches generates the same output as serializing it in memory.
+ */
+static void
+test_xml_write_collection_stream_large (void)
+{
+	g_autoptr(AsMetadata) metad = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *expected = NULL;
+	g_autofree gchar *streamed = NULL;
+	guint i;
+
+	metad = as_metadata_new ();
+	as_metadata_set_locale (metad, "C");
+	as_metadata_set_format_style (metad, AS_FORMAT_STYLE_COLLECTION);
+	as_metadata_set_origin (metad, "test");
+
+	for (i = 0; i < 1500; i++) {
+		g_autoptr(AsComponent) cpt = NULL;
+		g_autofree gchar *cid = NULL;
+		g_autofree gchar *desc = NULL;
+
+		cpt = as_component_new ();
+		cid = g_strdup_printf ("org.example.Test%u", i);
+		desc = g_strdup_printf ("<p>Component number %u – with ünïcode &amp; markup.</p>", i);
+		as_component_set_kind (cpt, AS_COMPONENT_KIND_DESKTOP_APP);
+		as_component_set_id (cpt, cid);
+		as_component_set_name (cpt, cid, "C");
+		as_component_set_summary (cpt, "Generated test component", "C");
+		as_component_set_description (cpt, desc, "C");
+		as_component_add_category (cpt, "Utility");
+		as_metadata_add_component (metad, cpt);
+	}
+
+	expected = as_metadata_components_to_collection (metad, AS_FORMAT_KIND_XML, &error);
+	g_assert_no_error (error);
+	streamed = test_xml_stream_collection_to_str (metad);
+	g_assert_cmpstr (streamed, ==, expected);
+}
+
+/**
+ * test_xml_save_collection_compressed:
+ *
+ * Test writing compressed collection data to a file.
+ */
+static void
+test_xml_save_collection_compressed (void)
+{
+	g_autoptr(AsMetadata) metad = NULL;
+	g_autoptr(AsMetadata) metad2 = NULL;
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *path = NULL;
+	g_autofree gchar *expected = NULL;
+	g_autofree gchar *data = NULL;
+	const gchar *fname = "/tmp/as-unittest-collection.xml.gz";
+
+	metad = as_metadata_new ();
+	as_metadata_set_locale (metad, "ALL");
+	as_metadata_set_format_style (metad, AS_FORMAT_STYLE_COLLECTION);
+
+	path = g_build_filename (datadir, "appstream-dxml.xml", NULL);
+	file = g_file_new_for_path (path);
+	as_metadata_parse_file (metad, file, AS_FORMAT_KIND_XML, &error);
+	g_assert_no_error (error);
+	g_clear_object (&file);
+
+	as_metadata_save_collection (metad, fname, AS_FORMAT_KIND_XML, &error);
+	g_assert_no_error (error);
+	expected = as_metadata_components_to_collection (metad, AS_FORMAT_KIND_XML, &error);
+	g_assert_no_error (error);
+
+	/* read the data back */
+	metad2 = as_metadata_new ();
+	as_metadata_set_locale (metad2, "ALL");
+	as_metadata_set_format_style (metad2, AS_FORMAT_STYLE_COLLECTION);
+	file = g_file_new_for_path (fname);
+	as_metadata_parse_file (metad2, file, AS_FORMAT_KIND_XML, &error);
+	g_assert_no_error (error);
+	g_assert_cmpint (as_metadata_get_components (metad2)->len, ==, as_metadata_get_components (metad)->len);
+
+	data = as_metadata_components_to_collection (metad2, AS_FORMAT_KIND_XML, &error);
+	g_assert_no_error (error);
+	g_assert_cmpstr (data, ==, expected);
+
+	g_remove (fname);
+}
+
 /**
  * main:
  */
@@ -1433,6 +1593,9 @@ main (int argc, char **argv)
 	g_test_add_func ("/XML/Write/Agreements", test_xml_write_agreements);
 
 	g_test_add_func ("/XML/Write/MetainfoToCollection", test_appstream_write_metainfo_to_collection);
+	g_test_add_func ("/XML/Write/CollectionStream", test_xml_write_collection_stream);
+	g_test_add_func ("/XML/Write/CollectionStreamLarge", test_xml_write_collection_stream_large);
+	g_test_add_func ("/XML/Write/CollectionCompressed", test_xml_save_collection_compressed);
 
 	ret = g_test_run ();
 	g_free (datadir);
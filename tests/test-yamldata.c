@@ -988,6 +988,100 @@ test_yaml_read_agreements (void)
 	g_assert_cmpstr (as_agreement_section_get_name (sect), ==, "Einführung");
 }
 
+/**
+ * test_yaml_write_collection_stream:
+ *
+ * Test if streaming YAML collection data generates the same output as
+ * serializing it in memory.
+ */
+static void
+test_yaml_write_collection_stream (void)
+{
+	g_autoptr(AsMetadata) mdata = NULL;
+	g_autoptr(GFile) file = NULL;
+	g_autoptr(GOutputStream) stream = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *path = NULL;
+	g_autofree gchar *expected = NULL;
+	g_autofree gchar *streamed = NULL;
+
+	mdata = as_metadata_new ();
+	as_metadata_set_locale (mdata, "ALL");
+	as_metadata_set_format_style (mdata, AS_FORMAT_STYLE_COLLECTION);
+
+	path = g_build_filename (datadir, "dep11-0.8.yml", NULL);
+	file = g_file_new_for_path (path);
+	as_metadata_parse_file (mdata, file, AS_FORMAT_KIND_YAML, &error);
+	g_assert_no_error (error);
+
+	expected = as_metadata_components_to_collection (mdata, AS_FORMAT_KIND_YAML, &error);
+	g_assert_no_error (error);
+
+	stream = g_memory_output_stream_new_resizable ();
+	as_metadata_components_to_collection_stream (mdata, stream, AS_FORMAT_KIND_YAML, FALSE, &error);
+	g_assert_no_error (error);
+	g_output_stream_write_all (stream, "", 1, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_output_stream_close (stream, NULL, &error);
+	g_assert_no_error (error);
+
+	streamed = g_memory_output_stream_steal_data (G_MEMORY_OUTPUT_STREAM (stream));
+	g_assert_cmpstr (streamed, ==, expected);
+}
+
+/**
+ * test_yaml_write_collection_stream_large:
+ *
+ * Test if streaming a YAML collection that is large enough to be serialized
+ * in multiple parallel batches generates the same output as serializing it in memory.
+ */
+static void
+test_yaml_write_collection_stream_large (void)
+{
+	g_autoptr(AsMetadata) mdata = NULL;
+	g_autoptr(GOutputStream) stream = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *expected = NULL;
+	g_autofree gchar *streamed = NULL;
+	guint i;
+
+	mdata = as_metadata_new ();
+	as_metadata_set_locale (mdata, "C");
+	as_metadata_set_format_style (mdata, AS_FORMAT_STYLE_COLLECTION);
+	as_metadata_set_origin (mdata, "test");
+
+	for (i = 0; i < 1500; i++) {
+		g_autoptr(AsComponent) cpt = NULL;
+		g_autofree gchar *cid = NULL;
+		g_autofree gchar *desc = NULL;
+
+		cpt = as_component_new ();
+		cid = g_strdup_printf ("org.example.Test%u", i);
+		desc = g_strdup_printf ("<p>Component number %u – with ünïcode &amp; markup.</p>", i);
+		as_component_set_kind (cpt, AS_COMPONENT_KIND_DESKTOP_APP);
+		as_component_set_id (cpt, cid);
+		as_component_set_name (cpt, cid, "C");
+		as_component_set_summary (cpt, "Generated test component", "C");
+		as_component_set_description (cpt, desc, "C");
+		as_component_add_category (cpt, "Utility");
+		as_metadata_add_component (mdata, cpt);
+	}
+
+	expected = as_metadata_components_to_collection (mdata, AS_FORMAT_KIND_YAML, &error);
+	g_assert_no_error (error);
+
+	stream = g_memory_output_stream_new_resizable ();
+	as_metadata_components_to_collection_stream (mdata, stream, AS_FORMAT_KIND_YAML, FALSE, &error);
+	g_assert_no_error (error);
+	g_output_stream_write_all (stream, "", 1, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_output_stream_close (stream, NULL, &error);
+	g_assert_no_error (error);
+
+	streamed = g_memory_output_stream_steal_data (G_MEMORY_OUTPUT_STREAM (stream));
+	g_assert_cmpstr (streamed, ==, expected);
+}
+
 /**
  * main:
  */
@@ -1038,6 +1132,9 @@ main (int argc, char **argv)
 	g_test_add_func ("/YAML/Read/Agreements", test_yaml_read_agreements);
 	g_test_add_func ("/YAML/Write/Agreements", test_yaml_write_agreements);
 
+	g_test_add_func ("/YAML/Write/CollectionStream", test_yaml_write_collection_stream);
+	g_test_add_func ("/YAML/Write/CollectionStreamLarge", test_yaml_write_collection_stream_large);
+
 	ret = g_test_run ();
 	g_free (datadir);
 	return ret;
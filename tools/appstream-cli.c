@@ -30,6 +30,7 @@
 #include "ascli-actions-validate.h"
 #include "ascli-actions-pkgmgr.h"
 #include "ascli-actions-misc.h"
+#include "ascli-actions-server.h"
 
 #define ASCLI_BIN_NAME "appstreamcli"
 
@@ -103,6 +104,8 @@ const GOptionEntry find_options[] = {
 /* used by validate_options */
 static gboolean optn_pedantic = FALSE;
 static gboolean optn_nonet = FALSE;
+static gint optn_jobs = 1;
+static gchar *optn_url_cache = NULL;
 
 /**
  * General options for validation.
@@ -122,11 +125,40 @@ const GOptionEntry validate_options[] = {
 		G_OPTION_ARG_NONE,
 		&optn_nonet,
 		NULL, NULL },
+	{ "jobs", 'j', 0,
+		G_OPTION_ARG_INT,
+		&optn_jobs,
+		/* TRANSLATORS: ascli flag description for: --jobs (used by the "validate" and "validate-tree" commands) */
+		N_("Number of files to validate in parallel (0 to use all processors)."), "N" },
+	{ "url-cache", (gchar) 0, 0,
+		G_OPTION_ARG_FILENAME,
+		&optn_url_cache,
+		/* TRANSLATORS: ascli flag description for: --url-cache (used by the "validate" and "validate-tree" commands) */
+		N_("Remember reachable remote URLs in FILE for a day, so they are not checked again."), "FILE" },
 	{ NULL }
 };
 
-/* only used by the "refresh --force" command */
+/* used by server_options */
+static gchar *optn_socket = NULL;
+
+/**
+ * Options for talking to a query server.
+ */
+const GOptionEntry server_options[] = {
+	{ "socket", 0, 0,
+		G_OPTION_ARG_FILENAME,
+		&optn_socket,
+		/* TRANSLATORS: ascli flag description for: --socket (used by the "serve" and "batch" commands) */
+		N_("Unix socket of the query server."), "PATH" },
+	{ NULL }
+};
+
+/* only used by the "refresh" command */
 static gboolean optn_force = FALSE;
+static gchar *optn_locales = NULL;
+
+/* only used by the "status" command */
+static gboolean optn_memory = FALSE;
 
 /*** HELPER METHODS ***/
 
@@ -233,6 +265,12 @@ as_client_run_refresh_cache (char **argv, int argc)
 			/* TRANSLATORS: ascli flag description for: --force */
 			_("Enforce a cache refresh."),
 			NULL },
+		{ "locales", (gchar) 0, 0,
+			G_OPTION_ARG_STRING,
+			&optn_locales,
+			/* TRANSLATORS: ascli flag description for: --locales (part of the refresh subcommand) */
+			_("Comma-separated list of locales to refresh the cache for, in a single pass."),
+			"LOCALES" },
 		{ NULL }
 	};
 
@@ -246,6 +284,7 @@ as_client_run_refresh_cache (char **argv, int argc)
 
 	return ascli_refresh_cache (optn_cachepath,
 					optn_datapath,
+					optn_locales,
 					optn_force);
 }
 
@@ -307,6 +346,68 @@ as_client_run_get (char **argv, int argc)
 					optn_no_cache);
 }
 
+/**
+ * as_client_run_batch:
+ *
+ * Answer many queries read from a file or stdin.
+ */
+static int
+as_client_run_batch (char **argv, int argc)
+{
+	g_autoptr(GOptionContext) opt_context = NULL;
+	gint ret;
+	const gchar *fname = NULL;
+	const gchar *command = "batch";
+
+	opt_context = as_client_new_subcommand_option_context (command, data_collection_options);
+	g_option_context_add_main_entries (opt_context, server_options, NULL);
+
+	ret = as_client_option_context_parse (opt_context, command, &argc, &argv);
+	if (ret != 0)
+		return ret;
+
+	if (argc > 2)
+		fname = argv[2];
+	if (argc > 3) {
+		as_client_print_help_hint (command, argv[3]);
+		return 1;
+	}
+
+	return ascli_batch_query (optn_cachepath,
+				  fname,
+				  optn_socket,
+				  optn_no_cache);
+}
+
+/**
+ * as_client_run_serve:
+ *
+ * Keep the metadata pool loaded and answer queries from other processes.
+ */
+static int
+as_client_run_serve (char **argv, int argc)
+{
+	g_autoptr(GOptionContext) opt_context = NULL;
+	gint ret;
+	const gchar *command = "serve";
+
+	opt_context = as_client_new_subcommand_option_context (command, data_collection_options);
+	g_option_context_add_main_entries (opt_context, server_options, NULL);
+
+	ret = as_client_option_context_parse (opt_context, command, &argc, &argv);
+	if (ret != 0)
+		return ret;
+
+	if (argc > 2) {
+		as_client_print_help_hint (command, argv[2]);
+		return 1;
+	}
+
+	return ascli_serve (optn_cachepath,
+			    optn_socket,
+			    optn_no_cache);
+}
+
 /**
  * as_client_run_dump:
  *
@@ -387,10 +488,17 @@ as_client_run_validate (char **argv, int argc)
 	if (ret != 0)
 		return ret;
 
+	if (optn_jobs < 0) {
+		ascli_print_stderr (_("The number of parallel jobs must not be negative."));
+		return 1;
+	}
+
 	return ascli_validate_files (&argv[2],
 				     argc-2,
 				     optn_pedantic,
-				     !optn_nonet);
+				     !optn_nonet,
+				     optn_url_cache,
+				     (guint) optn_jobs);
 }
 
 /**
@@ -415,9 +523,16 @@ as_client_run_validate_tree (char **argv, int argc)
 	if (argc > 2)
 		value = argv[2];
 
+	if (optn_jobs < 0) {
+		ascli_print_stderr (_("The number of parallel jobs must not be negative."));
+		return 1;
+	}
+
 	return ascli_validate_tree (value,
 				    optn_pedantic,
-				    !optn_nonet);
+				    !optn_nonet,
+				    optn_url_cache,
+				    (guint) optn_jobs);
 }
 
 /**
@@ -491,14 +606,32 @@ as_client_run_remove (char **argv, int argc)
 static int
 as_client_run_status (char **argv, int argc)
 {
+	g_autoptr(GOptionContext) opt_context = NULL;
+	gint ret;
 	const gchar *command = "status";
 
+	const GOptionEntry status_options[] = {
+		{ "memory", (gchar) 0, 0,
+			G_OPTION_ARG_NONE,
+			&optn_memory,
+			/* TRANSLATORS: ascli flag description for: --memory (part of the status subcommand) */
+			_("Show how much memory the loaded metadata uses."),
+			NULL },
+		{ NULL }
+	};
+
+	opt_context = as_client_new_subcommand_option_context (command, status_options);
+	ret = as_client_option_context_parse (opt_context,
+					      command, &argc, &argv);
+	if (ret != 0)
+		return ret;
+
 	if (argc > 2) {
-		as_client_print_help_hint (command, argv[3]);
+		as_client_print_help_hint (command, argv[2]);
 		return 1;
 	}
 
-	return ascli_show_status ();
+	return ascli_show_status (optn_memory);
 }
 
 /**
@@ -695,6 +828,8 @@ as_client_get_summary ()
 	g_string_append_printf (string, "  %s - %s\n", "what-provides TYPE VALUE", _("Get components which provide the given item."));
 	g_string_append_printf (string, "    %s - %s\n", "TYPE ", _("An item type (e.g. lib, bin, python3, …)"));
 	g_string_append_printf (string, "    %s - %s\n", "VALUE", _("Value of the item that should be found."));
+	g_string_append_printf (string, "  %s - %s\n", "batch [FILE]    ", _("Answer get, search and what-provides queries read line by line from FILE or stdin."));
+	g_string_append_printf (string, "  %s - %s\n", "serve           ", _("Keep the metadata loaded and answer batch queries sent to a local socket."));
 	g_string_append (string, "\n");
 	g_string_append_printf (string, "  %s - %s\n", "dump COMPONENT-ID", _("Dump raw XML metadata for a component matching the ID."));
 	g_string_append_printf (string, "  %s - %s\n", "refresh-cache    ", _("Rebuild the component metadata cache."));
@@ -818,6 +953,10 @@ as_client_run (char **argv, int argc)
 		return as_client_run_refresh_cache (argv, argc);
 	} else if (g_strcmp0 (command, "get") == 0) {
 		return as_client_run_get (argv, argc);
+	} else if (g_strcmp0 (command, "batch") == 0) {
+		return as_client_run_batch (argv, argc);
+	} else if (g_strcmp0 (command, "serve") == 0) {
+		return as_client_run_serve (argv, argc);
 	} else if (g_strcmp0 (command, "dump") == 0) {
 		return as_client_run_dump (argv, argc);
 	} else if (g_strcmp0 (command, "what-provides") == 0) {
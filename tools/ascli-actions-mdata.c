@@ -23,21 +23,39 @@
 #include <config.h>
 #include <glib/gi18n-lib.h>
 #include <stdio.h>
+#include <errno.h>
 #include <glib/gstdio.h>
 
 #include "ascli-utils.h"
+#include "ascli-actions-server.h"
 #include "as-utils-private.h"
 
 /**
  * ascli_refresh_cache:
  */
 int
-ascli_refresh_cache (const gchar *cachepath, const gchar *datapath, gboolean forced)
+ascli_refresh_cache (const gchar *cachepath, const gchar *datapath, const gchar *locales, gboolean forced)
 {
 	g_autoptr(AsPool) dpool = NULL;
 	g_autoptr(GError) error = NULL;
+	g_auto(GStrv) locales_strv = NULL;
 	gboolean ret = FALSE;
 
+	if (locales != NULL) {
+		if (cachepath != NULL) {
+			/* TRANSLATORS: The --locales and --cachepath flags of "appstreamcli refresh" were used together */
+			g_printerr ("%s\n", _("Caches for multiple locales can only be generated in the system cache location."));
+			return 1;
+		}
+
+		locales_strv = g_strsplit (locales, ",", -1);
+		if ((locales_strv[0] == NULL) || (locales_strv[0][0] == '\0')) {
+			/* TRANSLATORS: The --locales flag of "appstreamcli refresh" was empty */
+			g_printerr ("%s\n", _("You need to specify at least one locale."));
+			return 1;
+		}
+	}
+
 	dpool = as_pool_new ();
 	if (datapath != NULL) {
 		AsPoolFlags flags;
@@ -56,7 +74,9 @@ ascli_refresh_cache (const gchar *cachepath, const gchar *datapath, gboolean for
 		as_pool_set_cache_flags (dpool, AS_CACHE_FLAG_NONE);
 	}
 
-	if (cachepath == NULL) {
+	if (locales_strv != NULL) {
+		ret = as_pool_refresh_cache_for_locales (dpool, locales_strv, forced, &error);
+	} else if (cachepath == NULL) {
 		ret = as_pool_refresh_cache (dpool, forced, &error);
 	} else {
 		as_pool_load (dpool, NULL, &error);
@@ -91,7 +111,7 @@ ascli_refresh_cache (const gchar *cachepath, const gchar *datapath, gboolean for
 /**
  * ascli_data_pool_new_and_open:
  */
-static AsPool*
+AsPool*
 ascli_data_pool_new_and_open (const gchar *cachepath, gboolean no_cache, GError **error)
 {
 	AsPool *dpool;
@@ -232,6 +252,183 @@ ascli_what_provides (const gchar *cachepath, const gchar *kind_str, const gchar
 	return 0;
 }
 
+/**
+ * ascli_batch_append_result:
+ *
+ * Format query results as tab-separated lines of the form
+ * "QUERY	COMPONENT-ID	KIND	PACKAGES".
+ */
+static void
+ascli_batch_append_result (GString *out, const gchar *query, GPtrArray *result)
+{
+	guint i;
+
+	if (result == NULL || result->len == 0) {
+		g_string_append_printf (out, "%s\t\t\t\n", query);
+		return;
+	}
+
+	for (i = 0; i < result->len; i++) {
+		AsComponent *cpt = AS_COMPONENT (g_ptr_array_index (result, i));
+		g_autofree gchar *pkgs_str = NULL;
+
+		if (as_component_get_pkgnames (cpt) != NULL)
+			pkgs_str = g_strjoinv (",", as_component_get_pkgnames (cpt));
+		g_string_append_printf (out, "%s\t%s\t%s\t%s\n",
+					query,
+					as_component_get_id (cpt),
+					as_component_kind_to_string (as_component_get_kind (cpt)),
+					pkgs_str == NULL? "" : pkgs_str);
+	}
+}
+
+/**
+ * ascli_batch_answer_query:
+ * @dpool: The pool to query.
+ * @query: A single query line, will be normalized in place.
+ * @out: String to append the result lines to.
+ * @error: A #GError or %NULL.
+ *
+ * Run a single line of a batch query against the pool.
+ * Empty lines and comments produce no output.
+ *
+ * Returns: %TRUE if the query was valid.
+ */
+gboolean
+ascli_batch_answer_query (AsPool *dpool, gchar *query, GString *out, GError **error)
+{
+	g_autoptr(GPtrArray) result = NULL;
+	g_auto(GStrv) parts = NULL;
+	const gchar *command;
+
+	/* tabs are our field separator, don't allow them in queries */
+	g_strdelimit (query, "\t\r\n", ' ');
+	g_strstrip (query);
+	if (query[0] == '\0' || query[0] == '#')
+		return TRUE;
+
+	parts = g_strsplit (query, " ", 2);
+	command = parts[0];
+	if (parts[1] != NULL)
+		g_strstrip (parts[1]);
+
+	if (as_str_empty (parts[1])) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_INVALID_ARGUMENT,
+			     /* TRANSLATORS: A line in an appstreamcli batch query lacked the value to query for */
+			     _("No value given for query '%s'."), command);
+		return FALSE;
+	}
+
+	if (g_strcmp0 (command, "get") == 0) {
+		result = as_pool_get_components_by_id (dpool, parts[1]);
+	} else if (g_strcmp0 (command, "search") == 0) {
+		result = as_pool_search (dpool, parts[1]);
+	} else if (g_strcmp0 (command, "what-provides") == 0) {
+		g_auto(GStrv) pparts = NULL;
+		AsProvidedKind kind;
+
+		pparts = g_strsplit (parts[1], " ", 2);
+		kind = as_provided_kind_from_string (pparts[0]);
+		if (kind == AS_PROVIDED_KIND_UNKNOWN || as_str_empty (pparts[1])) {
+			g_set_error (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_INVALID_ARGUMENT,
+				     /* TRANSLATORS: A what-provides line in an appstreamcli batch query was malformed */
+				     _("Invalid what-provides query '%s'."), parts[1]);
+			return FALSE;
+		}
+		result = as_pool_get_components_by_provided_item (dpool, kind, g_strstrip (pparts[1]));
+	} else {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_INVALID_ARGUMENT,
+			     /* TRANSLATORS: A line in an appstreamcli batch query used an unknown command */
+			     _("Unknown query command '%s'."), command);
+		return FALSE;
+	}
+
+	ascli_batch_append_result (out, query, result);
+	return TRUE;
+}
+
+/**
+ * ascli_batch_query:
+ *
+ * Answer many get/search/what-provides queries, read line by line
+ * from a file or stdin, using a single loaded pool.
+ * If @socket_path is set, the queries are forwarded to a running
+ * "appstreamcli serve" instance instead of loading the pool locally.
+ */
+int
+ascli_batch_query (const gchar *cachepath, const gchar *fname, const gchar *socket_path, gboolean no_cache)
+{
+	g_autoptr(AsPool) dpool = NULL;
+	g_autoptr(GSocketConnection) conn = NULL;
+	g_autoptr(GString) out = NULL;
+	g_autoptr(GError) error = NULL;
+	FILE *input;
+	gchar *line = NULL;
+	size_t line_len = 0;
+	guint line_no = 0;
+	gboolean ret = TRUE;
+
+	if (fname == NULL || g_strcmp0 (fname, "-") == 0) {
+		input = stdin;
+	} else {
+		input = g_fopen (fname, "r");
+		if (input == NULL) {
+			/* TRANSLATORS: appstreamcli was unable to open a file with batch queries */
+			ascli_print_stderr (_("Unable to open '%s': %s"), fname, g_strerror (errno));
+			return 1;
+		}
+	}
+
+	if (socket_path == NULL)
+		dpool = ascli_data_pool_new_and_open (cachepath, no_cache, &error);
+	else
+		conn = ascli_server_connect (socket_path, &error);
+	if (error != NULL) {
+		g_printerr ("%s\n", error->message);
+		if (input != stdin)
+			fclose (input);
+		return 1;
+	}
+
+	out = g_string_new (NULL);
+	while (getline (&line, &line_len, input) != -1) {
+		g_autoptr(GError) query_error = NULL;
+		gboolean query_ret;
+
+		line_no++;
+		g_string_truncate (out, 0);
+		if (conn == NULL)
+			query_ret = ascli_batch_answer_query (dpool, line, out, &query_error);
+		else
+			query_ret = ascli_server_query (conn, line, out, &query_error);
+
+		if (!query_ret) {
+			/* the connection to the server failed, no need to continue */
+			if (!g_error_matches (query_error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT)) {
+				g_printerr ("%s\n", query_error->message);
+				ret = FALSE;
+				break;
+			}
+			/* TRANSLATORS: A line in an appstreamcli batch query was invalid, the second placeholder is the reason */
+			ascli_print_stderr (_("Line %u: %s"), line_no, query_error->message);
+			ret = FALSE;
+			continue;
+		}
+		g_print ("%s", out->str);
+	}
+	g_free (line);
+	if (input != stdin)
+		fclose (input);
+
+	return ret? 0 : 3;
+}
+
 /**
  * ascli_dump_component:
  *
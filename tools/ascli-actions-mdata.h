@@ -26,6 +26,10 @@
 
 G_BEGIN_DECLS
 
+AsPool		*ascli_data_pool_new_and_open (const gchar *cachepath,
+						gboolean no_cache,
+						GError **error);
+
 int		ascli_what_provides (const gchar *cachepath,
 					const gchar *kind_str,
 					const gchar *item,
@@ -41,8 +45,19 @@ int		ascli_get_component (const gchar *cachepath,
 					gboolean detailed,
 					gboolean no_cache);
 
+gboolean	ascli_batch_answer_query (AsPool *dpool,
+						gchar *query,
+						GString *out,
+						GError **error);
+
+int		ascli_batch_query (const gchar *cachepath,
+					const gchar *fname,
+					const gchar *socket_path,
+					gboolean no_cache);
+
 int		ascli_refresh_cache (const gchar *cachepath,
 					const gchar *datapath,
+					const gchar *locales,
 					gboolean forced);
 
 int		ascli_dump_component (const gchar *cachepath,
@@ -27,13 +27,42 @@
 #include "as-settings-private.h"
 #include "ascli-utils.h"
 
+/**
+ * ascli_show_memory_usage:
+ *
+ * Print the memory used by the data of a pool.
+ */
+static void
+ascli_show_memory_usage (AsPool *pool)
+{
+	g_autofree gchar *total = NULL;
+	guint64 usage[AS_POOL_MEMORY_KIND_LAST];
+	guint i;
+
+	as_pool_get_memory_usage_all (pool, usage);
+
+	/* TRANSLATORS: Memory usage section in the status report of ascli */
+	ascli_print_highlight (_("Memory usage:"));
+	for (i = AS_POOL_MEMORY_KIND_TOTAL + 1; i < AS_POOL_MEMORY_KIND_LAST; i++) {
+		g_autofree gchar *size = NULL;
+
+		size = g_format_size (usage[i]);
+		ascli_print_stdout ("  - %-12s %s", as_pool_memory_kind_to_string ((AsPoolMemoryKind) i), size);
+	}
+
+	total = g_format_size (usage[AS_POOL_MEMORY_KIND_TOTAL]);
+	/* TRANSLATORS: Total memory used by the metadata pool, in the status report of ascli */
+	ascli_print_stdout (_("Total: %s"), total);
+}
+
 /**
  * ascli_show_status:
+ * @show_memory: Whether to display the memory used by the metadata pool.
  *
  * Print various interesting status information.
  */
 int
-ascli_show_status (void)
+ascli_show_status (gboolean show_memory)
 {
 	guint i;
 	g_autoptr(AsPool) dpool = NULL;
@@ -153,6 +182,11 @@ ascli_show_status (void)
 		 * ascli_print_stdout (_("The system metadata cache exists."));
 		 * ascli_print_stdout (_("The system metadata cache does not exist."));
 		 */
+
+		if (show_memory) {
+			g_print ("\n");
+			ascli_show_memory_usage (dpool);
+		}
 	} else {
 		ascli_print_stderr (_("Error while loading the metadata pool: %s"), error->message);
 	}
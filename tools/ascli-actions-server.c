@@ -0,0 +1,491 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2018 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+#include "ascli-actions-server.h"
+
+#include <string.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <glib/gi18n-lib.h>
+#include <glib/gstdio.h>
+#include <glib-unix.h>
+#include <gio/gunixsocketaddress.h>
+
+#include "ascli-utils.h"
+#include "ascli-actions-mdata.h"
+#include "as-pool-private.h"
+
+/*
+ * Messages exchanged with the server are framed by a 32bit big-endian
+ * length, followed by the payload.
+ * A request contains a single query line in the format used by the
+ * "batch" command, the reply is either "OK\n" followed by the result
+ * lines, or "ERROR\n" followed by a message describing the problem.
+ */
+#define ASCLI_SERVER_MAX_FRAME_SIZE	(16 * 1024 * 1024)
+#define ASCLI_SERVER_MAX_THREADS	4
+
+struct _AscliServer {
+	GSocketService	*service;
+	gchar		*socket_path;
+
+	AsPool		*pool;
+	GMutex		mutex;
+	GCond		cond;
+	GPtrArray	*clients; /* of GSocketConnection */
+	gboolean	check_reload;
+	gint64		last_check;
+};
+
+/**
+ * ascli_server_default_socket_path:
+ *
+ * Returns: The socket used if none was set explicitly.
+ */
+gchar*
+ascli_server_default_socket_path (void)
+{
+	return g_build_filename (g_get_user_runtime_dir (), "appstream-query.socket", NULL);
+}
+
+/**
+ * ascli_server_read_frame:
+ *
+ * Read a single message from @stream.
+ *
+ * Returns: The NUL-terminated payload, or %NULL on error or if the
+ * peer closed the connection.
+ */
+static gchar*
+ascli_server_read_frame (GInputStream *stream, GError **error)
+{
+	guint32 len_be;
+	guint32 len;
+	gsize bytes_read;
+	g_autofree gchar *data = NULL;
+
+	if (!g_input_stream_read_all (stream, &len_be, sizeof (len_be), &bytes_read, NULL, error))
+		return NULL;
+	if (bytes_read == 0)
+		return NULL;
+	if (bytes_read != sizeof (len_be)) {
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_CONNECTION_CLOSED,
+				     _("Connection closed unexpectedly."));
+		return NULL;
+	}
+
+	len = GUINT32_FROM_BE (len_be);
+	if (len > ASCLI_SERVER_MAX_FRAME_SIZE) {
+		g_set_error (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_INVALID_DATA,
+			     _("Message of %u bytes exceeds the size limit."), len);
+		return NULL;
+	}
+
+	data = g_malloc (len + 1);
+	if (!g_input_stream_read_all (stream, data, len, &bytes_read, NULL, error))
+		return NULL;
+	if (bytes_read != len) {
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_CONNECTION_CLOSED,
+				     _("Connection closed unexpectedly."));
+		return NULL;
+	}
+	data[len] = '\0';
+
+	return g_steal_pointer (&data);
+}
+
+/**
+ * ascli_server_write_frame:
+ *
+ * Write a single message to @stream.
+ */
+static gboolean
+ascli_server_write_frame (GOutputStream *stream, const gchar *data, gsize len, GError **error)
+{
+	guint32 len_be = GUINT32_TO_BE ((guint32) len);
+
+	if (!g_output_stream_write_all (stream, &len_be, sizeof (len_be), NULL, NULL, error))
+		return FALSE;
+	return g_output_stream_write_all (stream, data, len, NULL, NULL, error);
+}
+
+/**
+ * ascli_server_check_reload:
+ *
+ * Reload the pool if its data changed on disk.
+ * The server mutex must be held.
+ */
+static void
+ascli_server_check_reload (AscliServer *server)
+{
+	gint64 now;
+	g_autoptr(GError) error = NULL;
+
+	if (!server->check_reload)
+		return;
+
+	/* don't stat the data locations for every single query */
+	now = g_get_monotonic_time ();
+	if (now - server->last_check < G_USEC_PER_SEC)
+		return;
+	server->last_check = now;
+
+	if (!as_pool_needs_reload (server->pool))
+		return;
+
+	g_debug ("AppStream metadata changed, reloading.");
+	if (!as_pool_load (server->pool, NULL, &error))
+		g_warning ("Problem while reloading metadata: %s", error != NULL? error->message : "unknown error");
+}
+
+/**
+ * ascli_server_run_cb:
+ *
+ * Answer queries of a single client, until it disconnects.
+ */
+static gboolean
+ascli_server_run_cb (GThreadedSocketService *service,
+		     GSocketConnection *conn,
+		     GObject *source_object,
+		     gpointer user_data)
+{
+	AscliServer *server = (AscliServer*) user_data;
+	GInputStream *istream = g_io_stream_get_input_stream (G_IO_STREAM (conn));
+	GOutputStream *ostream = g_io_stream_get_output_stream (G_IO_STREAM (conn));
+	g_autoptr(GString) reply = g_string_new (NULL);
+
+	/* register the client, so a shutdown can disconnect it and wait for us */
+	g_mutex_lock (&server->mutex);
+	if (server->pool == NULL) {
+		g_mutex_unlock (&server->mutex);
+		return TRUE;
+	}
+	g_ptr_array_add (server->clients, g_object_ref (conn));
+	g_mutex_unlock (&server->mutex);
+
+	while (TRUE) {
+		g_autofree gchar *query = NULL;
+		g_autoptr(GError) error = NULL;
+		gboolean ret = FALSE;
+
+		query = ascli_server_read_frame (istream, &error);
+		if (query == NULL) {
+			if (error != NULL)
+				g_debug ("Dropping client: %s", error->message);
+			break;
+		}
+
+		g_string_assign (reply, "OK\n");
+		g_mutex_lock (&server->mutex);
+		if (server->pool != NULL) {
+			ascli_server_check_reload (server);
+			ret = ascli_batch_answer_query (server->pool, query, reply, &error);
+		} else {
+			g_set_error_literal (&error,
+					     G_IO_ERROR,
+					     G_IO_ERROR_CLOSED,
+					     _("The server is shutting down."));
+		}
+		g_mutex_unlock (&server->mutex);
+
+		if (!ret) {
+			g_string_assign (reply, "ERROR\n");
+			g_string_append (reply, error->message);
+		}
+
+		if (!ascli_server_write_frame (ostream, reply->str, reply->len, &error)) {
+			g_debug ("Dropping client: %s", error->message);
+			break;
+		}
+	}
+
+	g_mutex_lock (&server->mutex);
+	g_ptr_array_remove (server->clients, conn);
+	g_cond_broadcast (&server->cond);
+	g_mutex_unlock (&server->mutex);
+
+	return TRUE;
+}
+
+/**
+ * ascli_server_free_cb:
+ *
+ * Free the server data once the "run" handler can no longer be invoked.
+ */
+static void
+ascli_server_free_cb (gpointer data, GClosure *closure)
+{
+	AscliServer *server = (AscliServer*) data;
+
+	g_mutex_clear (&server->mutex);
+	g_cond_clear (&server->cond);
+	g_ptr_array_unref (server->clients);
+	g_free (server->socket_path);
+	g_free (server);
+}
+
+/**
+ * ascli_server_new:
+ * @pool: The loaded pool to answer queries with.
+ * @check_reload: %TRUE if @pool should be reloaded when its data changes.
+ *
+ * Create a new query server. Use ascli_server_start() to
+ * accept clients.
+ */
+AscliServer*
+ascli_server_new (AsPool *pool, gboolean check_reload)
+{
+	AscliServer *server = g_new0 (AscliServer, 1);
+
+	g_mutex_init (&server->mutex);
+	g_cond_init (&server->cond);
+	server->clients = g_ptr_array_new_with_free_func (g_object_unref);
+	server->pool = g_object_ref (pool);
+	server->check_reload = check_reload;
+	server->last_check = g_get_monotonic_time ();
+
+	/* the signal handler owns the server data, so threads which are
+	 * still about to emit "run" never see it freed */
+	server->service = g_threaded_socket_service_new (ASCLI_SERVER_MAX_THREADS);
+	g_signal_connect_data (server->service,
+			       "run",
+			       G_CALLBACK (ascli_server_run_cb),
+			       server,
+			       ascli_server_free_cb,
+			       0);
+
+	return server;
+}
+
+/**
+ * ascli_server_start:
+ * @server: An #AscliServer.
+ * @socket_path: The Unix socket to listen on.
+ * @error: A #GError or %NULL.
+ *
+ * Start accepting clients. Connections are dispatched from the
+ * thread-default main context, which must be running.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+ascli_server_start (AscliServer *server, const gchar *socket_path, GError **error)
+{
+	g_autoptr(GSocketAddress) address = NULL;
+
+	address = g_unix_socket_address_new (socket_path);
+	if (!g_socket_listener_add_address (G_SOCKET_LISTENER (server->service),
+					    address,
+					    G_SOCKET_TYPE_STREAM,
+					    G_SOCKET_PROTOCOL_DEFAULT,
+					    NULL,
+					    NULL,
+					    error))
+		return FALSE;
+	server->socket_path = g_strdup (socket_path);
+
+	g_socket_service_start (server->service);
+	return TRUE;
+}
+
+/**
+ * ascli_server_shutdown:
+ * @server: An #AscliServer.
+ *
+ * Stop accepting clients, disconnect all clients which are
+ * still connected and wait for their threads to finish.
+ * The server is freed and must not be used afterwards.
+ */
+void
+ascli_server_shutdown (AscliServer *server)
+{
+	g_autoptr(AsPool) pool = NULL;
+	GSocketService *service = server->service;
+	guint i;
+
+	g_socket_service_stop (service);
+	g_socket_listener_close (G_SOCKET_LISTENER (service));
+	if (server->socket_path != NULL)
+		g_unlink (server->socket_path);
+
+	/* let clients which are still connected know that we are gone,
+	 * and wait until all threads are done with the pool */
+	g_mutex_lock (&server->mutex);
+	pool = g_steal_pointer (&server->pool);
+	for (i = 0; i < server->clients->len; i++) {
+		GSocketConnection *conn = G_SOCKET_CONNECTION (g_ptr_array_index (server->clients, i));
+		g_socket_shutdown (g_socket_connection_get_socket (conn), TRUE, TRUE, NULL);
+	}
+	while (server->clients->len > 0)
+		g_cond_wait (&server->cond, &server->mutex);
+	g_mutex_unlock (&server->mutex);
+
+	/* frees the server data, possibly only once a thread which
+	 * picked up a late connection has returned from our handler */
+	g_signal_handlers_disconnect_by_data (service, server);
+	g_object_unref (service);
+}
+
+/**
+ * ascli_server_quit_cb:
+ */
+static gboolean
+ascli_server_quit_cb (gpointer user_data)
+{
+	g_main_loop_quit ((GMainLoop*) user_data);
+	return G_SOURCE_REMOVE;
+}
+
+/**
+ * ascli_serve:
+ *
+ * Keep a loaded pool in memory and answer queries sent to
+ * a Unix socket, until we are terminated.
+ */
+int
+ascli_serve (const gchar *cachepath, const gchar *socket_path, gboolean no_cache)
+{
+	AscliServer *server;
+	g_autoptr(AsPool) dpool = NULL;
+	g_autoptr(GSocketConnection) conn = NULL;
+	g_autoptr(GMainLoop) loop = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar *default_path = NULL;
+	struct stat sb;
+
+	if (socket_path == NULL) {
+		default_path = ascli_server_default_socket_path ();
+		socket_path = default_path;
+	}
+
+	/* don't take over the socket of a running server, but remove stale ones */
+	conn = ascli_server_connect (socket_path, NULL);
+	if (conn != NULL) {
+		/* TRANSLATORS: "appstreamcli serve" was run while another server was using the socket */
+		ascli_print_stderr (_("A query server is already listening on '%s'."), socket_path);
+		return 1;
+	}
+	if (lstat (socket_path, &sb) == 0) {
+		if (!S_ISSOCK (sb.st_mode)) {
+			ascli_print_stderr (_("Refusing to replace '%s': Not a socket."), socket_path);
+			return 1;
+		}
+		g_unlink (socket_path);
+	}
+
+	dpool = ascli_data_pool_new_and_open (cachepath, no_cache, &error);
+	if (error != NULL) {
+		g_printerr ("%s\n", error->message);
+		return 1;
+	}
+
+	/* explicitly selected cache files are never reloaded */
+	server = ascli_server_new (dpool, cachepath == NULL);
+	if (!ascli_server_start (server, socket_path, &error)) {
+		g_printerr ("%s\n", error->message);
+		ascli_server_shutdown (server);
+		return 1;
+	}
+
+	loop = g_main_loop_new (NULL, FALSE);
+	g_unix_signal_add (SIGINT, ascli_server_quit_cb, loop);
+	g_unix_signal_add (SIGTERM, ascli_server_quit_cb, loop);
+
+	/* TRANSLATORS: Printed by "appstreamcli serve" once it accepts queries */
+	ascli_print_stdout (_("Listening for queries on '%s'."), socket_path);
+	fflush (stdout);
+
+	g_main_loop_run (loop);
+
+	ascli_server_shutdown (server);
+	return 0;
+}
+
+/**
+ * ascli_server_connect:
+ *
+ * Connect to a running query server.
+ */
+GSocketConnection*
+ascli_server_connect (const gchar *socket_path, GError **error)
+{
+	g_autoptr(GSocketClient) client = NULL;
+	g_autoptr(GSocketAddress) address = NULL;
+
+	client = g_socket_client_new ();
+	address = g_unix_socket_address_new (socket_path);
+
+	return g_socket_client_connect (client, G_SOCKET_CONNECTABLE (address), NULL, error);
+}
+
+/**
+ * ascli_server_query:
+ *
+ * Send a query line to the server and append its result lines to @out.
+ * Invalid queries are reported as %G_IO_ERROR_INVALID_ARGUMENT.
+ */
+gboolean
+ascli_server_query (GSocketConnection *conn, const gchar *query, GString *out, GError **error)
+{
+	GInputStream *istream = g_io_stream_get_input_stream (G_IO_STREAM (conn));
+	GOutputStream *ostream = g_io_stream_get_output_stream (G_IO_STREAM (conn));
+	g_autofree gchar *reply = NULL;
+	GError *tmp_error = NULL;
+
+	if (!ascli_server_write_frame (ostream, query, strlen (query), error))
+		return FALSE;
+
+	reply = ascli_server_read_frame (istream, &tmp_error);
+	if (reply == NULL) {
+		if (tmp_error != NULL)
+			g_propagate_error (error, tmp_error);
+		else
+			g_set_error_literal (error,
+					     G_IO_ERROR,
+					     G_IO_ERROR_CONNECTION_CLOSED,
+					     _("The query server closed the connection."));
+		return FALSE;
+	}
+
+	if (g_str_has_prefix (reply, "OK\n")) {
+		g_string_append (out, reply + 3);
+		return TRUE;
+	}
+	if (g_str_has_prefix (reply, "ERROR\n")) {
+		g_set_error_literal (error,
+				     G_IO_ERROR,
+				     G_IO_ERROR_INVALID_ARGUMENT,
+				     reply + 6);
+		return FALSE;
+	}
+
+	g_set_error_literal (error,
+			     G_IO_ERROR,
+			     G_IO_ERROR_INVALID_DATA,
+			     _("Received a malformed reply from the query server."));
+	return FALSE;
+}
@@ -0,0 +1,55 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*-
+ *
+ * Copyright (C) 2018 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU General Public License Version 2
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __ASCLI_ACTIONS_SERVER_H
+#define __ASCLI_ACTIONS_SERVER_H
+
+#include <glib-object.h>
+#include <gio/gio.h>
+#include <appstream.h>
+
+G_BEGIN_DECLS
+
+typedef struct _AscliServer AscliServer;
+
+gchar			*ascli_server_default_socket_path (void);
+
+AscliServer		*ascli_server_new (AsPool *pool,
+					  gboolean check_reload);
+gboolean		ascli_server_start (AscliServer *server,
+					    const gchar *socket_path,
+					    GError **error);
+void			ascli_server_shutdown (AscliServer *server);
+
+int			ascli_serve (const gchar *cachepath,
+					const gchar *socket_path,
+					gboolean no_cache);
+
+GSocketConnection	*ascli_server_connect (const gchar *socket_path,
+						GError **error);
+
+gboolean		ascli_server_query (GSocketConnection *conn,
+						const gchar *query,
+						GString *out,
+						GError **error);
+
+G_END_DECLS
+
+#endif /* __ASCLI_ACTIONS_SERVER_H */
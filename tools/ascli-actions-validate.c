@@ -26,6 +26,10 @@
 #include <appstream.h>
 
 #include "ascli-utils.h"
+#include "as-validator-private.h"
+
+/* time in seconds for which reachable URLs are remembered in the URL cache */
+#define ASCLI_URL_CACHE_MAX_AGE (24 * 60 * 60)
 
 /**
  * importance_to_print_string:
@@ -125,47 +129,92 @@ process_report (GList *issues, gboolean pedantic, gulong *error_count, gulong *w
 }
 
 /**
- * ascli_validate_file:
+ * AscliValidateJob:
+ *
+ * Validation of a single file, possibly running on a worker thread.
+ */
+typedef struct {
+	gchar		*fname;
+	gboolean	use_net;
+	AsValidator	*url_validator;
+
+	AsValidator	*validator;
+	gboolean	valid;
+	gboolean	done;
+} AscliValidateJob;
+
+/**
+ * AscliValidateJobQueue:
+ *
+ * Used to wait for individual jobs to finish.
+ */
+typedef struct {
+	GMutex		mutex;
+	GCond		cond;
+} AscliValidateJobQueue;
+
+/**
+ * ascli_validate_job_free:
+ **/
+static void
+ascli_validate_job_free (AscliValidateJob *job)
+{
+	g_free (job->fname);
+	if (job->validator != NULL)
+		g_object_unref (job->validator);
+	g_free (job);
+}
+
+/**
+ * ascli_validate_job_run:
+ **/
+static void
+ascli_validate_job_run (AscliValidateJob *job, AscliValidateJobQueue *queue)
+{
+	g_autoptr(GFile) file = NULL;
+
+	file = g_file_new_for_path (job->fname);
+	if (g_file_query_exists (file, NULL)) {
+		job->validator = as_validator_new ();
+		as_validator_set_check_urls (job->validator, job->use_net);
+		as_validator_share_url_checks (job->validator, job->url_validator);
+
+		job->valid = as_validator_validate_file (job->validator, file);
+	}
+
+	g_mutex_lock (&queue->mutex);
+	job->done = TRUE;
+	g_cond_broadcast (&queue->cond);
+	g_mutex_unlock (&queue->mutex);
+}
+
+/**
+ * ascli_validate_job_report:
+ *
+ * Print the report of a finished validation job.
  **/
 static gboolean
-ascli_validate_file (gchar *fname, gboolean pedantic, gboolean use_net, gulong *error_count, gulong *warning_count, gulong *info_count, gulong *pedantic_count)
+ascli_validate_job_report (AscliValidateJob *job, gboolean pedantic, gulong *error_count, gulong *warning_count, gulong *info_count, gulong *pedantic_count)
 {
-	GFile *file;
 	gboolean ret;
-	gboolean errors_found = FALSE;
-	AsValidator *validator;
 	GList *issues;
 
-	file = g_file_new_for_path (fname);
-	if (!g_file_query_exists (file, NULL)) {
-		g_print ("File '%s' does not exist.", fname);
+	if (job->validator == NULL) {
+		g_print ("File '%s' does not exist.", job->fname);
 		g_print ("\n");
-		g_object_unref (file);
 		return FALSE;
 	}
 
-	validator = as_validator_new ();
-	as_validator_set_check_urls (validator, use_net);
-
-	ret = as_validator_validate_file (validator, file);
-	if (!ret)
-		errors_found = TRUE;
-	issues = as_validator_get_issues (validator);
-
+	issues = as_validator_get_issues (job->validator);
 	ret = process_report (issues,
 			      pedantic,
 			      error_count,
 			      warning_count,
 			      info_count,
 			      pedantic_count);
-	if (!ret)
-		errors_found = TRUE;
-
 	g_list_free (issues);
-	g_object_unref (file);
-	g_object_unref (validator);
 
-	return !errors_found;
+	return job->valid && ret;
 }
 
 /**
@@ -210,7 +259,7 @@ ascli_validate_print_stats (gulong error_count, gulong warning_count, gulong inf
  * ascli_validate_files:
  */
 gint
-ascli_validate_files (gchar **argv, gint argc, gboolean pedantic, gboolean use_net)
+ascli_validate_files (gchar **argv, gint argc, gboolean pedantic, gboolean use_net, const gchar *url_cache, guint jobs)
 {
 	gint i;
 	gboolean ret = TRUE;
@@ -218,25 +267,77 @@ ascli_validate_files (gchar **argv, gint argc, gboolean pedantic, gboolean use_n
 	gulong warning_count = 0;
 	gulong info_count = 0;
 	gulong pedantic_count = 0;
+	GThreadPool *pool = NULL;
+	AscliValidateJobQueue queue;
+	g_autoptr(GPtrArray) vjobs = NULL;
+	g_autoptr(AsValidator) url_validator = NULL;
 
 	if (argc < 1) {
 		g_print ("%s\n", _("You need to specify a file to validate!"));
 		return 1;
 	}
 
+	if (jobs == 0)
+		jobs = g_get_num_processors ();
+	if (jobs > (guint) argc)
+		jobs = (guint) argc;
+
+	g_mutex_init (&queue.mutex);
+	g_cond_init (&queue.cond);
+
+	/* all files share their URL check results, so an URL is only checked once per run */
+	url_validator = as_validator_new ();
+	as_validator_set_url_cache (url_validator, url_cache, ASCLI_URL_CACHE_MAX_AGE);
+
+	vjobs = g_ptr_array_new_with_free_func ((GDestroyNotify) ascli_validate_job_free);
+	for (i = 0; i < argc; i++) {
+		AscliValidateJob *job = g_new0 (AscliValidateJob, 1);
+		job->fname = g_strdup (argv[i]);
+		job->use_net = use_net;
+		job->url_validator = url_validator;
+		g_ptr_array_add (vjobs, job);
+	}
+
+	if (jobs > 1) {
+		pool = g_thread_pool_new ((GFunc) ascli_validate_job_run,
+					  &queue,
+					  (gint) jobs,
+					  TRUE,
+					  NULL);
+		for (i = 0; i < argc; i++)
+			g_thread_pool_push (pool, g_ptr_array_index (vjobs, i), NULL);
+	}
+
+	/* print reports in the order the files were given, as soon as they are available */
 	for (i = 0; i < argc; i++) {
-		gboolean tmp_ret;
-		tmp_ret = ascli_validate_file (argv[i],
+		AscliValidateJob *job = (AscliValidateJob*) g_ptr_array_index (vjobs, i);
+
+		if (pool == NULL) {
+			ascli_validate_job_run (job, &queue);
+		} else {
+			g_mutex_lock (&queue.mutex);
+			while (!job->done)
+				g_cond_wait (&queue.cond, &queue.mutex);
+			g_mutex_unlock (&queue.mutex);
+		}
+
+		if (!ascli_validate_job_report (job,
 						pedantic,
-						use_net,
 						&error_count,
 						&warning_count,
 						&info_count,
-						&pedantic_count);
-		if (!tmp_ret)
+						&pedantic_count))
 			ret = FALSE;
+
+		/* release the memory of this job early */
+		g_clear_object (&job->validator);
 	}
 
+	if (pool != NULL)
+		g_thread_pool_free (pool, FALSE, TRUE);
+	g_mutex_clear (&queue.mutex);
+	g_cond_clear (&queue.cond);
+
 	if (ret) {
 		if ((error_count == 0) && (warning_count == 0) &&
 		    (info_count == 0) && (pedantic_count == 0)) {
@@ -267,7 +368,7 @@ ascli_validate_files (gchar **argv, gint argc, gboolean pedantic, gboolean use_n
  * ascli_validate_tree:
  */
 gint
-ascli_validate_tree (const gchar *root_dir, gboolean pedantic, gboolean use_net)
+ascli_validate_tree (const gchar *root_dir, gboolean pedantic, gboolean use_net, const gchar *url_cache, guint jobs)
 {
 	gboolean no_errors = TRUE;
 	AsValidator *validator;
@@ -284,6 +385,8 @@ ascli_validate_tree (const gchar *root_dir, gboolean pedantic, gboolean use_net)
 
 	validator = as_validator_new ();
 	as_validator_set_check_urls (validator, use_net);
+	as_validator_set_max_jobs (validator, jobs);
+	as_validator_set_url_cache (validator, url_cache, ASCLI_URL_CACHE_MAX_AGE);
 
 	as_validator_validate_tree (validator, root_dir);
 	issues = as_validator_get_issues (validator);
@@ -28,11 +28,15 @@ G_BEGIN_DECLS
 gint			ascli_validate_files (gchar **argv,
 						gint argc,
 						gboolean pedantic,
-						gboolean use_net);
+						gboolean use_net,
+						const gchar *url_cache,
+						guint jobs);
 
 gint			ascli_validate_tree (const gchar *root_dir,
 						gboolean pedantic,
-						gboolean use_net);
+						gboolean use_net,
+						const gchar *url_cache,
+						guint jobs);
 
 G_END_DECLS
 
@@ -316,9 +316,7 @@ ascli_print_component (AsComponent *cpt, gboolean show_detailed)
 		}
 
 		/* long description */
-		str = as_markup_convert_simple (as_component_get_description (cpt), NULL);
-		ascli_print_key_value (_("Description"), str, FALSE);
-		g_free (str);
+		ascli_print_key_value (_("Description"), as_component_get_description_plain (cpt), FALSE);
 
 		/* some simple screenshot information */
 		sshot_array = as_component_get_screenshots (cpt);